@@ -0,0 +1,1353 @@
+#define TE_DEBUG
+#define TE_DEBUG_LEVEL_WARNING
+#include "tinyengine.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h> // fork(); rmdir();
+#include <sys/wait.h> // waitpid();
+#include <dirent.h> // opendir(); readdir();
+
+// usage: bench startup
+//        bench decode <image.png|image.qoi>...
+//        bench scene [nodes]
+//        bench damage
+//        bench cull [sprites]
+//        bench batch [quads]
+//        bench suite [frames] > results.json
+//        bench compare <baseline.json> <results.json> [threshold_percent]
+//        bench record [frames] [output.y4m]
+//        bench ecs [entities] [sprites] [threads]
+//        bench tilemap [size]
+//        bench overdraw [sprites]
+//        bench resolution [target_ms] [sprites]
+//        bench hud [widgets]
+//        bench windows [cycles]
+//
+// Everything but cull and compare opens a window, run it under xvfb-run on machines without a display.
+// The suite scenes are fully deterministic, so two runs on the same machine and driver are comparable.
+
+static te_bool_u8 bench_openWindow(tinyengine_windowContext** window, te_u32 width, te_u32 height) {
+	*window = tinyengine_createWindow();
+	if(!*window) { return TE_FALSE; }
+	tinyengine_setWindowTitle(*window,"tinyengine bench");
+	tinyengine_setWindowSize(*window,width,height);
+	tinyengine_showWindow(*window);
+	tinyengine_makeCurrent(*window);
+	if(!_tinyengine_gl3_init()) { return TE_FALSE; }
+	if(!_tinyengine_gl3_createWindowRenderContext(*window)) { return TE_FALSE; }
+	_tinyengine_gl3_updateView(*window,width,height);
+	return TE_TRUE;
+}
+
+// Time from engine init until the first frame has been presented
+static int bench_startupPass(const char* label, const char* cacheDirectory) {
+	te_f64 start = tinyengine_getTime();
+
+	if(!tinyengine_init()) { return -1; }
+	_tinyengine_gl3_setShaderCacheDirectory(cacheDirectory);
+
+	tinyengine_windowContext* window;
+	if(!bench_openWindow(&window,640,360)) { return -1; }
+
+	_tinyengine_gl3_startFrame(window);
+	_tinyengine_gl3_drawRectangle2D(window, 10, 10, 200, 100, (te_v4_f32){1.0f,0.0f,0.0f,1.0f});
+	_tinyengine_gl3_endFrame(window);
+	tinyengine_swapBuffers(window);
+	glFinish();
+
+	te_f64 elapsed = tinyengine_getTime() - start;
+
+	printf("{\"scene\":\"startup\",\"cache\":\"%s\",\"time_to_first_frame_ms\":%.3f,\"program_binary\":%s,\"parallel_compile\":%s,\"cache_hits\":%u,\"cache_misses\":%u,"
+		"\"compile_latency_ms\":{\"flat\":%.3f,\"sprite\":%.3f,\"text\":%.3f}}\n",
+		label, elapsed * 1000.0, te_gl3_state.hasProgramBinary ? "true" : "false", te_gl3_state.hasParallelShaderCompile ? "true" : "false",
+		te_gl3_state.shaderCacheHits, te_gl3_state.shaderCacheMisses,
+		te_gl3_state.flatProgram.compileLatency * 1000.0, te_gl3_state.spriteProgram.compileLatency * 1000.0, te_gl3_state.textProgram.compileLatency * 1000.0);
+	fflush(stdout);
+
+	tinyengine_terminate();
+	return 0;
+}
+
+static int bench_startup() {
+	char cacheDirectory[] = "/tmp/tinyengine_bench_XXXXXX";
+	if(mkdtemp(cacheDirectory) == NULL) { fprintf(stderr, "could not create cache directory\n"); return -1; }
+
+	// Keep the driver's own shader cache out of the measurement
+	setenv("MESA_SHADER_CACHE_DISABLE", "true", 1);
+
+	// Each pass runs in its own process so nothing survives in memory between them
+	const char* labels[] = { "cold", "warm" };
+	int result = 0;
+	for(int i = 0; i < 2; i++) {
+		pid_t child = fork();
+		if(child == 0) { exit(bench_startupPass(labels[i], cacheDirectory) == 0 ? 0 : 1); }
+		int status = 0;
+		waitpid(child, &status, 0);
+		if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) { result = -1; }
+	}
+
+	DIR* directory = opendir(cacheDirectory);
+	if(directory) {
+		struct dirent* entry;
+		char path[600];
+		while((entry = readdir(directory)) != NULL) {
+			if(entry->d_name[0] == '.') { continue; }
+			snprintf(path, sizeof(path), "%s/%s", cacheDirectory, entry->d_name);
+			remove(path);
+		}
+		closedir(directory);
+	}
+	rmdir(cacheDirectory);
+
+	return result;
+}
+
+// Streams the file through the loader thread and PBO staging until it is uploaded
+static te_bool_u8 bench_streamFile(const char* path) {
+	te_u32 handle = _tinyengine_gl3_streamTextureFile(path);
+	if(handle == 0) { return TE_FALSE; }
+	while(!_tinyengine_gl3_isTextureReady(handle)) {
+		_tinyengine_gl3_updateTextureStreaming();
+		_tinyengine_gl3_streamedTexture* entry = _tinyengine_gl3_lookupStreamedTexture(handle);
+		if(entry == NULL || (entry->status == TE_GL3_STREAM_FAILED && entry->pixelBuffer == 0)) { _tinyengine_gl3_releaseStreamedTexture(handle); return TE_FALSE; }
+	}
+	_tinyengine_gl3_releaseStreamedTexture(handle);
+	return TE_TRUE;
+}
+
+// Decode throughput from a file mapping, once into CPU memory and once through the streaming path into
+// mapped pixel buffer objects and up to the texture, which is what textures loaded at runtime pay
+static int bench_decode(int count, char** paths) {
+	if(count == 0) { fprintf(stderr, "usage: bench decode <image>...\n"); return -1; }
+
+	if(!tinyengine_init()) { return -1; }
+	tinyengine_windowContext* window;
+	if(!bench_openWindow(&window,64,64)) { return -1; }
+	_tinyengine_gl3_setTextureUploadBudget((size_t) -1);
+
+	int result = 0;
+	for(int i = 0; i < count; i++) {
+		tinyengine_mappedFile file;
+		if(!tinyengine_mapFile(paths[i], &file)) { result = -1; continue; }
+
+		te_u32 width, height;
+		size_t size = tinyengine_imageDecodeSize(file.data, file.size);
+		if(size == 0 || !tinyengine_imageInfo(file.data, file.size, &width, &height)) {
+			fprintf(stderr, "%s: unsupported image\n", paths[i]);
+			tinyengine_unmapFile(&file);
+			result = -1;
+			continue;
+		}
+
+		te_u8* pixels = malloc(size);
+		te_bool_u8 decoded = tinyengine_decodeImage(file.data, file.size, pixels, size); // warm up, faults in both buffers
+
+		// Repeat until at least a quarter second has passed
+		te_u32 iterations = 0;
+		te_f64 start = tinyengine_getTime();
+		te_f64 elapsed = 0.0;
+		while(decoded && (elapsed < 0.25 || iterations < 3)) {
+			decoded = tinyengine_decodeImage(file.data, file.size, pixels, size);
+			iterations++;
+			elapsed = tinyengine_getTime() - start;
+		}
+
+		te_bool_u8 streamed = decoded && bench_streamFile(paths[i]); // warm up, allocates the PBO and texture storage
+		te_u32 streamIterations = 0;
+		start = tinyengine_getTime();
+		te_f64 streamElapsed = 0.0;
+		while(streamed && (streamElapsed < 0.25 || streamIterations < 3)) {
+			streamed = bench_streamFile(paths[i]);
+			streamIterations++;
+			streamElapsed = tinyengine_getTime() - start;
+		}
+
+		if(decoded && streamed) {
+			te_f64 seconds = elapsed / iterations;
+			te_f64 streamSeconds = streamElapsed / streamIterations;
+			te_f64 megabytes = (te_f64) width * height * 4 / (1024.0 * 1024.0);
+			printf("{\"scene\":\"decode\",\"file\":\"%s\",\"width\":%u,\"height\":%u,\"encoded_bytes\":%zu,\"iterations\":%u,\"decode_ms\":%.3f,\"mb_per_s\":%.1f,"
+				"\"stream_iterations\":%u,\"stream_ms\":%.3f,\"stream_mb_per_s\":%.1f}\n",
+				paths[i], width, height, file.size, iterations, seconds * 1000.0, megabytes / seconds,
+				streamIterations, streamSeconds * 1000.0, megabytes / streamSeconds);
+		} else {
+			fprintf(stderr, "%s: %s failed\n", paths[i], decoded ? "streaming" : "decode");
+			result = -1;
+		}
+
+		free(pixels);
+		tinyengine_unmapFile(&file);
+	}
+
+	tinyengine_terminate();
+	return result;
+}
+
+// 16x16 checkerboard for sprite scenes, variants differ in colour
+static te_GLuint bench_checkerTexture(tinyengine_windowContext* window, te_u32 variant) {
+	te_u8 pixels[16 * 16 * 4];
+	for(te_u32 i = 0; i < 16 * 16; i++) {
+		te_u8 on = ((i % 16) / 4 + (i / 64)) & 1;
+		pixels[i * 4 + 0] = on ? 255 : 40;
+		pixels[i * 4 + 1] = (te_u8)(120 + variant * 37);
+		pixels[i * 4 + 2] = on ? 40 : 255;
+		pixels[i * 4 + 3] = 255;
+	}
+	return _tinyengine_gl3_loadTextureRGB(window, 16, 16, 4, pixels);
+}
+
+// Scene submission cost, CPU time spent issuing a frame (swap and GPU wait excluded)
+typedef struct bench_frameStats_t {
+	te_f64 firstMs;
+	te_f64 steadyMs;
+	size_t bytesUploaded;
+	te_u32 drawCalls;
+	te_u32 nodesRebuilt;
+} bench_frameStats;
+
+static void bench_sceneFrame(tinyengine_windowContext* window, _tinyengine_gl3_scene* scene, te_u32 nodeCount, te_GLuint texture, te_f64* cpuMs) {
+	_tinyengine_gl3_startFrame(window);
+	te_f64 start = tinyengine_getTime();
+	if(scene) {
+		_tinyengine_gl3_drawScene(window, scene);
+	} else {
+		// The same content submitted immediate mode, for reference
+		for(te_u32 i = 0; i < nodeCount; i++) {
+			te_f32 x = (te_f32)((i * 37) % 1260), y = (te_f32)((i * 53) % 700);
+			if(i % 4 == 0) { _tinyengine_gl3_drawSprite(window, texture, x, y, 16, 16, 1.0f, 16, 16, 0, 0); }
+			else { _tinyengine_gl3_drawRectangle2D(window, x, y, 12, 12, (te_v4_f32){(i % 7) / 7.0f, (i % 5) / 5.0f, 0.5f, 1.0f}); }
+		}
+	}
+	*cpuMs = (tinyengine_getTime() - start) * 1000.0;
+	_tinyengine_gl3_endFrame(window);
+	tinyengine_swapBuffers(window);
+	glFinish();
+}
+
+static void bench_sceneRun(tinyengine_windowContext* window, _tinyengine_gl3_scene* scene, te_u32 nodeCount, te_GLuint texture, const te_u32* nodes, te_u32 dirtyPerFrame, bench_frameStats* stats) {
+	const te_u32 frames = 300;
+	bench_sceneFrame(window, scene, nodeCount, texture, &stats->firstMs);
+
+	te_f64 total = 0.0;
+	stats->bytesUploaded = 0;
+	stats->nodesRebuilt = 0;
+	te_u32 batchDrawCalls = te_gl3_state.batchDrawCalls;
+	for(te_u32 frame = 0; frame < frames; frame++) {
+		if(scene) {
+			for(te_u32 i = 0; i < dirtyPerFrame; i++) {
+				te_u32 index = (frame * 7919 + i * 104729) % nodeCount;
+				_tinyengine_gl3_setSceneNodePosition(scene, nodes[index], (te_f32)((index * 37 + frame) % 1260), (te_f32)((index * 53) % 700));
+			}
+		}
+		te_f64 cpuMs;
+		bench_sceneFrame(window, scene, nodeCount, texture, &cpuMs);
+		total += cpuMs;
+		if(scene) {
+			stats->bytesUploaded += scene->bytesUploaded;
+			stats->nodesRebuilt += scene->nodesRebuilt;
+		}
+	}
+	stats->steadyMs = total / frames;
+	stats->bytesUploaded /= frames;
+	stats->nodesRebuilt /= frames;
+	stats->drawCalls = scene ? scene->drawCalls : (te_gl3_state.batchDrawCalls - batchDrawCalls) / frames;
+}
+
+static int bench_scene(te_u32 nodeCount) {
+	if(!tinyengine_init()) { return -1; }
+
+	tinyengine_windowContext* window;
+	if(!bench_openWindow(&window,1280,720)) { return -1; }
+
+	te_GLuint texture = bench_checkerTexture(window, 0);
+
+	// Rectangles and sprites on separate layers, so the whole scene is two batches
+	_tinyengine_gl3_scene* scene = _tinyengine_gl3_createScene();
+	te_u32* nodes = malloc(nodeCount * sizeof(te_u32));
+	if(!scene || !nodes) { return -1; }
+	for(te_u32 i = 0; i < nodeCount; i++) {
+		te_f32 x = (te_f32)((i * 37) % 1260), y = (te_f32)((i * 53) % 700);
+		if(i % 4 == 0) {
+			nodes[i] = _tinyengine_gl3_addSceneSprite(scene, 0, texture, x, y, 16, 16, 16, 16, 0, 0);
+			_tinyengine_gl3_setSceneNodeLayer(scene, nodes[i], 1);
+		} else {
+			nodes[i] = _tinyengine_gl3_addSceneRectangle(scene, 0, x, y, 12, 12, (te_v4_f32){(i % 7) / 7.0f, (i % 5) / 5.0f, 0.5f, 1.0f});
+		}
+	}
+
+	struct { const char* mode; _tinyengine_gl3_scene* scene; te_u32 dirty; } runs[] = {
+		{ "retained_static", scene, 0 },
+		{ "retained_dirty_1pct", scene, nodeCount / 100 },
+		{ "immediate", NULL, 0 },
+	};
+	for(te_u32 i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+		bench_frameStats stats;
+		bench_sceneRun(window, runs[i].scene, nodeCount, texture, nodes, runs[i].dirty, &stats);
+		printf("{\"scene\":\"scene\",\"mode\":\"%s\",\"nodes\":%u,\"first_frame_cpu_ms\":%.3f,\"steady_cpu_ms\":%.4f,\"bytes_uploaded_per_frame\":%zu,\"nodes_rebuilt_per_frame\":%u,\"draw_calls\":%u}\n",
+			runs[i].mode, nodeCount, stats.firstMs, stats.steadyMs, stats.bytesUploaded, stats.nodesRebuilt, stats.drawCalls);
+		fflush(stdout);
+	}
+
+	free(nodes);
+	_tinyengine_gl3_destroyScene(scene);
+	tinyengine_terminate();
+	return 0;
+}
+
+// Dashboard-like frame: a static scene with one small animated widget, full repaint against damage tracking
+static int bench_damage() {
+	if(!tinyengine_init()) { return -1; }
+
+	tinyengine_windowContext* window;
+	if(!bench_openWindow(&window,1280,720)) { return -1; }
+
+	_tinyengine_gl3_scene* scene = _tinyengine_gl3_createScene();
+	if(!scene) { return -1; }
+	_tinyengine_gl3_addSceneRectangle(scene, 0, 0, 0, 1280, 720, (te_v4_f32){0.1f, 0.1f, 0.12f, 1.0f});
+	for(te_u32 i = 0; i < 2000; i++) {
+		_tinyengine_gl3_addSceneRectangle(scene, 0, (te_f32)((i * 37) % 1240), (te_f32)((i * 53) % 690), 40, 30, (te_v4_f32){(i % 7) / 7.0f, (i % 5) / 5.0f, 0.5f, 0.5f});
+	}
+	te_u32 widget = _tinyengine_gl3_addSceneRectangle(scene, 0, 600, 340, 16, 16, (te_v4_f32){1.0f, 1.0f, 1.0f, 1.0f});
+
+	const te_u32 frames = 300;
+	for(te_u32 tracking = 0; tracking < 2; tracking++) {
+		tinyengine_setDamageTracking(window, tracking);
+
+		te_f64 total = 0.0;
+		te_u64 pixels = 0;
+		for(te_u32 frame = 0; frame < frames; frame++) {
+			_tinyengine_gl3_setSceneNodePosition(scene, widget, 600.0f + (frame % 64), 340.0f);
+
+			te_f64 start = tinyengine_getTime();
+			_tinyengine_gl3_damageScene(window, scene);
+			_tinyengine_gl3_startFrame(window);
+			_tinyengine_gl3_drawScene(window, scene);
+			_tinyengine_gl3_endFrame(window);
+			glFinish();
+			total += tinyengine_getTime() - start;
+
+			te_i32 x, y, width, height;
+			if(tinyengine_getRedrawRect(window, &x, &y, &width, &height)) { pixels += (te_u64) width * height; }
+			tinyengine_swapBuffers(window);
+		}
+
+		printf("{\"scene\":\"damage\",\"tracking\":%s,\"buffer_age\":%s,\"frame_ms\":%.4f,\"repainted_pixels_per_frame\":%llu,\"window_pixels\":%u}\n",
+			tracking ? "true" : "false", tinyengine_state.x11state.hasBufferAge ? "true" : "false", total * 1000.0 / frames, (unsigned long long)(pixels / frames), 1280 * 720);
+		fflush(stdout);
+	}
+
+	_tinyengine_gl3_destroyScene(scene);
+	tinyengine_terminate();
+	return 0;
+}
+
+// Camera query over a large world, no window or GL involved. The world is sized for about 5k sprites per 1280x720 view.
+static int bench_cull(te_u32 spriteCount) {
+	const te_f32 viewWidth = 1280.0f, viewHeight = 720.0f;
+	te_f32 worldSize = sqrtf((te_f32) spriteCount / 5000.0f * viewWidth * viewHeight);
+
+	tinyengine_spatialGrid grid;
+	if(!tinyengine_createSpatialGrid(&grid, 128.0f)) { return -1; }
+
+	te_u32* items = malloc(spriteCount * sizeof(te_u32));
+	te_f32* positions = malloc(spriteCount * 2 * sizeof(te_f32));
+	te_u32* visible = malloc(spriteCount * sizeof(te_u32));
+	if(!items || !positions || !visible) { return -1; }
+
+	te_u32 random = 0x12345678;
+	te_f64 start = tinyengine_getTime();
+	for(te_u32 i = 0; i < spriteCount; i++) {
+		random = random * 1664525u + 1013904223u;
+		positions[i * 2 + 0] = (random >> 8) * (1.0f / 16777216.0f) * worldSize;
+		random = random * 1664525u + 1013904223u;
+		positions[i * 2 + 1] = (random >> 8) * (1.0f / 16777216.0f) * worldSize;
+		items[i] = tinyengine_insertSpatialItem(&grid, positions[i * 2], positions[i * 2 + 1], 16.0f, 16.0f, i);
+	}
+	te_f64 insertSeconds = tinyengine_getTime() - start;
+
+	// The camera pans across the world, a tenth of the sprites drift each frame
+	const te_u32 frames = 1000;
+	te_u32 movers = spriteCount / 10;
+	te_f64 querySeconds = 0.0, moveSeconds = 0.0;
+	te_u64 visibleTotal = 0;
+	for(te_u32 frame = 0; frame < frames; frame++) {
+		start = tinyengine_getTime();
+		for(te_u32 i = 0; i < movers; i++) {
+			te_u32 index = (frame * movers + i) % spriteCount;
+			positions[index * 2] += 1.5f;
+			tinyengine_moveSpatialItem(&grid, items[index], positions[index * 2], positions[index * 2 + 1], 16.0f, 16.0f);
+		}
+		moveSeconds += tinyengine_getTime() - start;
+
+		te_f32 cameraX = (worldSize - viewWidth) * (frame % 100) / 100.0f;
+		te_f32 cameraY = (worldSize - viewHeight) * (frame % 37) / 37.0f;
+		start = tinyengine_getTime();
+		visibleTotal += tinyengine_querySpatialGrid(&grid, cameraX, cameraY, viewWidth, viewHeight, visible, spriteCount);
+		querySeconds += tinyengine_getTime() - start;
+	}
+
+	printf("{\"scene\":\"cull\",\"sprites\":%u,\"cells\":%u,\"insert_ms\":%.3f,\"visible_avg\":%llu,\"query_us\":%.2f,\"moves_per_frame\":%u,\"move_ms\":%.3f}\n",
+		spriteCount, grid.cellCount, insertSeconds * 1000.0, (unsigned long long)(visibleTotal / frames), querySeconds * 1000000.0 / frames, movers, moveSeconds * 1000.0 / frames);
+
+	free(items);
+	free(positions);
+	free(visible);
+	tinyengine_destroySpatialGrid(&grid);
+	return 0;
+}
+
+// A source rectangle reaching past the checker texture has to tile it. The tiled sprite is compared against
+// the same area cut from a texture with the repeats laid out on the CPU, drawn next to it.
+static te_bool_u8 bench_tiledSpriteMatches(tinyengine_windowContext* window, te_GLuint texture) {
+	const te_i32 sourceX = 8, sourceY = 8, width = 48, height = 40;
+	te_u8 unrolled[48 * 40 * 4];
+	for(te_i32 y = 0; y < height; y++) {
+		for(te_i32 x = 0; x < width; x++) {
+			// Sprite rows count down from the top of the texture, texture rows up from the bottom
+			te_i32 column = (sourceX + x) & 15;
+			te_i32 row = (15 - (sourceY + (height - 1 - y))) & 15;
+			te_u8 on = (column / 4 + row / 4) & 1;
+			te_u8* pixel = unrolled + (y * width + x) * 4;
+			pixel[0] = on ? 255 : 40;
+			pixel[1] = 120;
+			pixel[2] = on ? 40 : 255;
+			pixel[3] = 255;
+		}
+	}
+	te_GLuint reference = _tinyengine_gl3_loadTextureRGB(window, width, height, 4, unrolled);
+
+	_tinyengine_gl3_startFrame(window);
+	_tinyengine_gl3_drawSprite(window, texture, 0, 0, width, height, 1.0f, 16, 16, sourceX, sourceY);
+	_tinyengine_gl3_drawSprite(window, reference, 64, 0, width, height, 1.0f, width, height, 0, 0);
+	_tinyengine_gl3_endFrame(window);
+
+	te_u8 drawn[2][48 * 40 * 4];
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, window->render2D.viewHeight - height, width, height, GL_RGBA, GL_UNSIGNED_BYTE, drawn[0]);
+	glReadPixels(64, window->render2D.viewHeight - height, width, height, GL_RGBA, GL_UNSIGNED_BYTE, drawn[1]);
+	tinyengine_swapBuffers(window);
+	glDeleteTextures(1, &reference);
+
+	for(te_u32 i = 0; i < sizeof(drawn[0]); i++) {
+		if(abs((te_i32) drawn[0][i] - (te_i32) drawn[1][i]) > 2) { fprintf(stderr, "tiled sprite differs at pixel %u\n", i / 4); return TE_FALSE; }
+	}
+	return TE_TRUE;
+}
+
+// Immediate mode throughput: tinted sprites from one texture, every quad a different colour, all batched
+static int bench_batch(te_u32 quadCount) {
+	if(!tinyengine_init()) { return -1; }
+
+	tinyengine_windowContext* window;
+	if(!bench_openWindow(&window,1280,720)) { return -1; }
+	te_GLuint texture = bench_checkerTexture(window, 0);
+
+	const te_u32 frames = 300;
+	te_f64 cpuSeconds = 0.0, frameSeconds = 0.0;
+	te_u32 drawCalls = te_gl3_state.batchDrawCalls;
+	te_u64 bytes = te_gl3_state.batchBytes;
+	for(te_u32 frame = 0; frame < frames; frame++) {
+		te_f64 start = tinyengine_getTime();
+		_tinyengine_gl3_startFrame(window);
+		for(te_u32 i = 0; i < quadCount; i++) {
+			te_f32 x = (te_f32)((i * 37 + frame) % 1260), y = (te_f32)((i * 53) % 700);
+			te_v4_f32 tint = { (i % 7) / 7.0f, (i % 5) / 5.0f, (i % 3) / 3.0f, 0.75f };
+			_tinyengine_gl3_drawSpriteTinted(window, texture, x, y, 16, 16, 1.0f, 16, 16, 0, 0, tint);
+		}
+		_tinyengine_gl3_endFrame(window);
+		cpuSeconds += tinyengine_getTime() - start;
+		glFinish();
+		frameSeconds += tinyengine_getTime() - start;
+		tinyengine_swapBuffers(window);
+	}
+
+	te_bool_u8 tiled = bench_tiledSpriteMatches(window, texture);
+
+	// Two independent triangles in a float layout carrying the same tint would need 192 bytes per quad
+	printf("{\"scene\":\"batch\",\"quads\":%u,\"bytes_per_quad\":%zu,\"float_bytes_per_quad\":%zu,\"draw_calls\":%u,\"bytes_uploaded_per_frame\":%llu,"
+		"\"submit_cpu_ms\":%.3f,\"frame_ms\":%.3f,\"quads_per_s\":%.0f,\"tiled_sprite_matches\":%s}\n",
+		quadCount, 4 * sizeof(_tinyengine_gl3_vertex2D), (size_t)(6 * 8 * sizeof(te_f32)), (te_gl3_state.batchDrawCalls - drawCalls) / frames,
+		(unsigned long long)((te_gl3_state.batchBytes - bytes) / frames), cpuSeconds * 1000.0 / frames, frameSeconds * 1000.0 / frames, quadCount * frames / frameSeconds,
+		tiled ? "true" : "false");
+	fflush(stdout);
+
+	tinyengine_terminate();
+	return tiled ? 0 : -1;
+}
+
+//// Window churn
+
+#define BENCH_CHURN_WINDOWS 8
+
+typedef struct bench_churnWindow_t {
+	tinyengine_windowContext* window; // NULL once destroyed
+	tinyengine_windowHandle handle;
+	Window x11WindowID;
+} bench_churnWindow;
+
+// Opens and closes windows in a shuffled order and checks the registry after every step: handles of closed
+// windows resolve to NULL, their X11 ids are gone from the lookup table, freed slots are handed out again
+// with the next generation and the live count matches. Exits non zero on the first cycle that fails.
+static int bench_windows(te_u32 cycles) {
+	if(!tinyengine_init()) { return -1; }
+	tinyengine_windowRegistry* registry = &tinyengine_state.windowRegistry;
+
+	bench_churnWindow open[BENCH_CHURN_WINDOWS];
+	memset(open, 0, sizeof(open));
+	bench_churnWindow closed[BENCH_CHURN_WINDOWS];
+	te_u32 closedCount = 0;
+	te_u32 random = 12345, failures = 0, reused = 0;
+
+	for(te_u32 cycle = 0; cycle < cycles && failures == 0; cycle++) {
+		// Fill every empty place, the first few cycles with a render context so its teardown is covered too
+		for(te_u32 i = 0; i < BENCH_CHURN_WINDOWS; i++) {
+			if(open[i].window) { continue; }
+			tinyengine_windowContext* window;
+			if(cycle < 4) {
+				if(!bench_openWindow(&window, 160, 90)) { return -1; }
+				_tinyengine_gl3_startFrame(window);
+				_tinyengine_gl3_drawRectangle2D(window, 10, 10, 50, 20, (te_v4_f32){1.0f, 0.0f, 0.0f, 1.0f});
+				_tinyengine_gl3_endFrame(window);
+				tinyengine_swapBuffers(window);
+			} else {
+				window = tinyengine_createWindow();
+				if(!window) { return -1; }
+			}
+			open[i].window = window;
+			open[i].handle = window->handle;
+			open[i].x11WindowID = window->platform.x11WindowID;
+
+			// A slot freed earlier has to come back with the generation after the one it was closed with
+			te_u32 slot = _TE_WINDOW_HANDLE_SLOT(window->handle);
+			for(te_u32 c = 0; c < closedCount; c++) {
+				if(_TE_WINDOW_HANDLE_SLOT(closed[c].handle) != slot) { continue; }
+				te_u32 expected = _TE_WINDOW_HANDLE_GENERATION(closed[c].handle) == 0xFFFF ? 1 : _TE_WINDOW_HANDLE_GENERATION(closed[c].handle) + 1;
+				if(_TE_WINDOW_HANDLE_GENERATION(window->handle) != expected) {
+					fprintf(stderr, "cycle %u: slot %u reused with generation %u, expected %u\n", cycle, slot, _TE_WINDOW_HANDLE_GENERATION(window->handle), expected);
+					failures++;
+				}
+				closed[c] = closed[--closedCount];
+				reused++;
+				break;
+			}
+		}
+		if(closedCount != 0) { fprintf(stderr, "cycle %u: %u freed slots were not reused\n", cycle, closedCount); failures++; }
+		if(registry->length != BENCH_CHURN_WINDOWS) { fprintf(stderr, "cycle %u: registry holds %u windows\n", cycle, registry->length); failures++; }
+		if(registry->capacity > BENCH_CHURN_WINDOWS) { fprintf(stderr, "cycle %u: registry grew to %u slots\n", cycle, registry->capacity); failures++; }
+		tinyengine_pollEvents();
+
+		// Close a shuffled half, looking each one up first so the lookup cache holds it
+		for(te_u32 n = 0; n < BENCH_CHURN_WINDOWS / 2; n++) {
+			random = random * 1103515245u + 12345u;
+			te_u32 i = (random >> 16) % BENCH_CHURN_WINDOWS;
+			while(open[i].window == NULL) { i = (i + 1) % BENCH_CHURN_WINDOWS; }
+			if(_tinyengine_x11_translateWindowIDToWindowContext(open[i].x11WindowID) != open[i].window) { fprintf(stderr, "cycle %u: live window id not found\n", cycle); failures++; }
+			tinyengine_destroyWindow(open[i].window);
+			open[i].window = NULL;
+			closed[closedCount++] = open[i];
+		}
+
+		for(te_u32 c = 0; c < closedCount; c++) {
+			if(tinyengine_getWindow(closed[c].handle) != NULL) { fprintf(stderr, "cycle %u: stale handle %08x still resolves\n", cycle, closed[c].handle); failures++; }
+			if(_tinyengine_x11_findWindowID(closed[c].x11WindowID) != NULL) { fprintf(stderr, "cycle %u: destroyed X11 id %lu still found\n", cycle, closed[c].x11WindowID); failures++; }
+		}
+		for(te_u32 i = 0; i < BENCH_CHURN_WINDOWS; i++) {
+			if(open[i].window && tinyengine_getWindow(open[i].handle) != open[i].window) { fprintf(stderr, "cycle %u: live handle %08x does not resolve\n", cycle, open[i].handle); failures++; }
+		}
+		if(tinyengine_getWindow(0) != NULL) { fprintf(stderr, "cycle %u: handle 0 resolves\n", cycle); failures++; }
+		tinyengine_pollEvents();
+	}
+
+	printf("{\"scene\":\"windows\",\"cycles\":%u,\"windows\":%u,\"slots_reused\":%u,\"registry_slots\":%u,\"failures\":%u}\n",
+		cycles, BENCH_CHURN_WINDOWS, reused, registry->capacity, failures);
+
+	tinyengine_terminate();
+	return failures == 0 ? 0 : -1;
+}
+
+//// Suite
+
+// Canned scenes with fixed content and frame counts. Frame time runs from startFrame until the GPU is done,
+// the swap is left out so vsync and compositors don't show up in it.
+
+#define BENCH_SUITE_TEXTURES 8
+
+typedef struct bench_suiteAssets_t {
+	te_GLuint textures[BENCH_SUITE_TEXTURES];
+	_tinyengine_gl3_bitmapGlyphCache font;
+} bench_suiteAssets;
+
+typedef void (*bench_suiteDraw)(tinyengine_windowContext* window, bench_suiteAssets* assets, te_u32 frame);
+
+// Monospace 8x8 blocks in a 128x128 atlas, enough to exercise the text path without a font file
+static void bench_syntheticFont(tinyengine_windowContext* window, _tinyengine_gl3_bitmapGlyphCache* font) {
+	static te_u8 pixels[128 * 128 * 4];
+	for(te_u32 glyph = 0; glyph < 96; glyph++) {
+		te_u32 cellX = (glyph % 16) * 8, cellY = (glyph / 16) * 8;
+		for(te_u32 y = 1; y < 7; y++) {
+			for(te_u32 x = 1; x < 7; x++) {
+				te_u8* pixel = pixels + ((cellY + y) * 128 + cellX + x) * 4;
+				te_u8 on = ((glyph * 7 + x * 3 + y * 5) % 4) != 0;
+				pixel[0] = pixel[1] = pixel[2] = 255;
+				pixel[3] = on ? 255 : 0;
+			}
+		}
+		_tinyengine_gl3_bitmapBakedCharcter* character = &font->characterData[glyph];
+		character->x0 = (te_u16) cellX;
+		character->y0 = (te_u16) cellY;
+		character->x1 = (te_u16)(cellX + 8);
+		character->y1 = (te_u16)(cellY + 8);
+		character->xoff = 0.0f;
+		character->yoff = 0.0f;
+		character->xadvance = 8.0f;
+	}
+	font->resolution = 128;
+	font->textureID = _tinyengine_gl3_loadTextureRGB(window, 128, 128, 4, pixels);
+}
+
+static void bench_suiteRects(tinyengine_windowContext* window, bench_suiteAssets* assets, te_u32 frame) {
+	for(te_u32 i = 0; i < 20000; i++) {
+		te_f32 x = (te_f32)((i * 37 + frame * 3) % 1260), y = (te_f32)((i * 53 + frame) % 700);
+		_tinyengine_gl3_drawRectangle2D(window, x, y, 12, 12, (te_v4_f32){(i % 7) / 7.0f, (i % 5) / 5.0f, (i % 3) / 3.0f, 0.8f});
+	}
+}
+
+// Textures change every 256 sprites, the way a game draws runs of the same sheet
+static void bench_suiteSprites(tinyengine_windowContext* window, bench_suiteAssets* assets, te_u32 frame) {
+	for(te_u32 i = 0; i < 20000; i++) {
+		te_f32 x = (te_f32)((i * 37 + frame * 3) % 1260), y = (te_f32)((i * 53 + frame) % 700);
+		_tinyengine_gl3_drawSprite(window, assets->textures[(i / 256) % BENCH_SUITE_TEXTURES], x, y, 16, 16, 1.0f, 16, 16, 0, 0);
+	}
+}
+
+// Source rectangles reaching past the texture, every sprite is cut into one quad per repeat
+static void bench_suiteTiled(tinyengine_windowContext* window, bench_suiteAssets* assets, te_u32 frame) {
+	for(te_u32 i = 0; i < 2000; i++) {
+		te_f32 x = (te_f32)((i * 37 + frame * 3) % 1220), y = (te_f32)((i * 53 + frame) % 660);
+		_tinyengine_gl3_drawSprite(window, assets->textures[(i / 256) % BENCH_SUITE_TEXTURES], x, y, 60, 60, 1.0f, 16, 16, (te_f32)(i % 16), (te_f32)(frame % 16));
+	}
+}
+
+static void bench_suiteText(tinyengine_windowContext* window, bench_suiteAssets* assets, te_u32 frame) {
+	char line[161];
+	for(te_u32 row = 0; row < 80; row++) {
+		for(te_u32 column = 0; column < 160; column++) { line[column] = (char)(32 + (row * 31 + column * 7 + frame) % 95); }
+		line[160] = '\0';
+		_tinyengine_gl3_drawText(window, &assets->font, line, 0.0f, (te_f32)(row * 9), 1.0f, (te_v3_f32){0.9f, 0.9f, (row % 4) / 4.0f});
+	}
+}
+
+// Panels, icons and labels interleaved, every widget switches program twice
+static void bench_suiteUI(tinyengine_windowContext* window, bench_suiteAssets* assets, te_u32 frame) {
+	char label[32];
+	for(te_u32 i = 0; i < 600; i++) {
+		te_f32 x = (te_f32)((i % 30) * 42), y = (te_f32)((i / 30) * 36);
+		te_f32 highlight = (i == frame % 600) ? 1.0f : 0.3f;
+		_tinyengine_gl3_drawRectangle2D(window, x, y, 40, 34, (te_v4_f32){0.15f, 0.15f, 0.2f, 0.9f});
+		_tinyengine_gl3_drawRectangle2D(window, x, y, 40, 2, (te_v4_f32){highlight, highlight, 0.2f, 1.0f});
+		_tinyengine_gl3_drawSprite(window, assets->textures[i % BENCH_SUITE_TEXTURES], x + 2, y + 4, 16, 16, 1.0f, 16, 16, 0, 0);
+		snprintf(label, sizeof(label), "%u:%u", i, (frame + i) % 1000);
+		_tinyengine_gl3_drawText(window, &assets->font, label, x + 2, y + 24, 1.0f, (te_v3_f32){1.0f, 1.0f, 1.0f});
+	}
+}
+
+static int bench_compareDouble(const void* a, const void* b) {
+	te_f64 x = *(const te_f64*) a, y = *(const te_f64*) b;
+	return (x > y) - (x < y);
+}
+
+// Nearest rank on sorted samples
+static te_f64 bench_percentile(const te_f64* sorted, te_u32 count, te_f64 percent) {
+	te_u32 rank = (te_u32) ceil(percent / 100.0 * count);
+	return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static void bench_suiteReport(const char* scene, te_f64* frameMs, te_u32 frames, te_u32 drawCalls, te_u64 bytesUploaded) {
+	qsort(frameMs, frames, sizeof(te_f64), bench_compareDouble);
+	printf("{\"scene\":\"%s\",\"frames\":%u,\"frame_ms_p50\":%.4f,\"frame_ms_p90\":%.4f,\"frame_ms_p99\":%.4f,\"frame_ms_max\":%.4f,\"draw_calls\":%u,\"bytes_uploaded_per_frame\":%llu}\n",
+		scene, frames, bench_percentile(frameMs, frames, 50.0), bench_percentile(frameMs, frames, 90.0), bench_percentile(frameMs, frames, 99.0), frameMs[frames - 1],
+		drawCalls / frames, (unsigned long long)(bytesUploaded / frames));
+	fflush(stdout);
+}
+
+static void bench_suiteRun(tinyengine_windowContext* window, bench_suiteAssets* assets, const char* scene, bench_suiteDraw draw, te_u32 frames, te_f64* frameMs) {
+	// One untimed frame so program linking and first uploads stay out of the numbers
+	_tinyengine_gl3_startFrame(window);
+	draw(window, assets, frames);
+	_tinyengine_gl3_endFrame(window);
+	tinyengine_swapBuffers(window);
+	glFinish();
+
+	te_u32 drawCalls = te_gl3_state.batchDrawCalls;
+	te_u64 bytes = te_gl3_state.batchBytes + te_gl3_state.textureStream.bytesUploaded;
+	for(te_u32 frame = 0; frame < frames; frame++) {
+		te_f64 start = tinyengine_getTime();
+		_tinyengine_gl3_startFrame(window);
+		draw(window, assets, frame);
+		_tinyengine_gl3_endFrame(window);
+		glFinish();
+		frameMs[frame] = (tinyengine_getTime() - start) * 1000.0;
+		tinyengine_swapBuffers(window);
+		tinyengine_pollEvents();
+	}
+	bench_suiteReport(scene, frameMs, frames, te_gl3_state.batchDrawCalls - drawCalls, te_gl3_state.batchBytes + te_gl3_state.textureStream.bytesUploaded - bytes);
+}
+
+// Window and render context creation up to the first presented frame, then teardown
+static te_bool_u8 bench_suiteWindows(tinyengine_windowContext* main, te_u32 iterations, te_f64* frameMs) {
+	for(te_u32 i = 0; i < iterations; i++) {
+		te_f64 start = tinyengine_getTime();
+		tinyengine_windowContext* window;
+		if(!bench_openWindow(&window, 320, 180)) { return TE_FALSE; }
+		_tinyengine_gl3_startFrame(window);
+		_tinyengine_gl3_drawRectangle2D(window, 10, 10, 100, 50, (te_v4_f32){1.0f, 0.0f, 0.0f, 1.0f});
+		_tinyengine_gl3_endFrame(window);
+		tinyengine_swapBuffers(window);
+		glFinish();
+		tinyengine_destroyWindow(window);
+		tinyengine_pollEvents();
+		frameMs[i] = (tinyengine_getTime() - start) * 1000.0;
+	}
+	tinyengine_makeCurrent(main);
+	bench_suiteReport("windows", frameMs, iterations, 0, 0);
+	return TE_TRUE;
+}
+
+static int bench_suite(te_u32 frames) {
+	if(frames == 0) { frames = 1; }
+	if(!tinyengine_init()) { return -1; }
+
+	tinyengine_windowContext* window;
+	if(!bench_openWindow(&window,1280,720)) { return -1; }
+
+	bench_suiteAssets assets;
+	memset(&assets, 0, sizeof(assets));
+	for(te_u32 i = 0; i < BENCH_SUITE_TEXTURES; i++) { assets.textures[i] = bench_checkerTexture(window, i); }
+	bench_syntheticFont(window, &assets.font);
+
+	te_f64* frameMs = malloc(frames * sizeof(te_f64));
+	if(!frameMs) { return -1; }
+
+	struct { const char* scene; bench_suiteDraw draw; } scenes[] = {
+		{ "rects", &bench_suiteRects },
+		{ "sprites", &bench_suiteSprites },
+		{ "tiled", &bench_suiteTiled },
+		{ "text", &bench_suiteText },
+		{ "ui", &bench_suiteUI },
+	};
+	for(te_u32 i = 0; i < sizeof(scenes) / sizeof(scenes[0]); i++) {
+		bench_suiteRun(window, &assets, scenes[i].scene, scenes[i].draw, frames, frameMs);
+	}
+
+	int result = bench_suiteWindows(window, frames < 30 ? frames : 30, frameMs) ? 0 : -1;
+
+	free(frameMs);
+	tinyengine_terminate();
+	return result;
+}
+
+// The ui scene at 1080p with and without frame recording. Frame time stops after endFrame without a glFinish,
+// what matters is how long the render thread is held up, the readback itself overlaps the next frames.
+static int bench_record(te_u32 frames, const char* path) {
+	if(frames == 0) { frames = 1; }
+	if(!tinyengine_init()) { return -1; }
+
+	tinyengine_windowContext* window;
+	if(!bench_openWindow(&window,1920,1080)) { return -1; }
+
+	bench_suiteAssets assets;
+	memset(&assets, 0, sizeof(assets));
+	for(te_u32 i = 0; i < BENCH_SUITE_TEXTURES; i++) { assets.textures[i] = bench_checkerTexture(window, i); }
+	bench_syntheticFont(window, &assets.font);
+
+	te_f64* frameMs[2] = { malloc(frames * sizeof(te_f64)), malloc(frames * sizeof(te_f64)) };
+	if(!frameMs[0] || !frameMs[1]) { return -1; }
+
+	for(te_u32 pass = 0; pass < 2; pass++) {
+		if(pass == 1 && !_tinyengine_gl3_startRecording(window, path, TE_RECORD_Y4M, 60)) { return -1; }
+		for(te_u32 frame = 0; frame < frames; frame++) {
+			te_f64 start = tinyengine_getTime();
+			_tinyengine_gl3_startFrame(window);
+			bench_suiteUI(window, &assets, frame);
+			_tinyengine_gl3_endFrame(window);
+			frameMs[pass][frame] = (tinyengine_getTime() - start) * 1000.0;
+			tinyengine_swapBuffers(window);
+			tinyengine_pollEvents();
+		}
+	}
+
+	te_f64 recordMs = te_gl3_state.recorder.gpuThreadSeconds * 1000.0 / frames;
+	_tinyengine_gl3_stopRecording();
+
+	qsort(frameMs[0], frames, sizeof(te_f64), bench_compareDouble);
+	qsort(frameMs[1], frames, sizeof(te_f64), bench_compareDouble);
+	te_f64 base50 = bench_percentile(frameMs[0], frames, 50.0), base99 = bench_percentile(frameMs[0], frames, 99.0);
+	te_f64 record50 = bench_percentile(frameMs[1], frames, 50.0), record99 = bench_percentile(frameMs[1], frames, 99.0);
+	printf("{\"scene\":\"record\",\"frames\":%u,\"width\":1920,\"height\":1080,\"frame_ms_p50\":%.4f,\"frame_ms_p99\":%.4f,\"recording_frame_ms_p50\":%.4f,\"recording_frame_ms_p99\":%.4f,"
+		"\"overhead_ms_p50\":%.4f,\"record_call_ms\":%.4f,\"frames_written\":%u,\"frames_dropped\":%u}\n",
+		frames, base50, base99, record50, record99, record50 - base50, recordMs, te_gl3_state.recorder.framesWritten, te_gl3_state.recorder.framesDropped);
+
+	free(frameMs[0]);
+	free(frameMs[1]);
+	tinyengine_terminate();
+	return 0;
+}
+
+//// Entities
+
+// Every entity moves and bounces inside the window, a slice of them also has a sprite. Move and tint write
+// different components and share a phase, bounce then writes the velocities both read.
+
+typedef struct bench_velocity_t {
+	te_f32 x;
+	te_f32 y;
+} bench_velocity;
+
+static te_u32 bench_velocityComponent;
+
+static void bench_ecsMove(tinyengine_world* world, const tinyengine_entityChunk* chunk, void* user) {
+	tinyengine_transform* transforms = tinyengine_getChunkComponents(chunk, TE_COMPONENT_TRANSFORM);
+	const bench_velocity* velocities = tinyengine_getChunkComponents(chunk, bench_velocityComponent);
+	for(te_u32 i = 0; i < chunk->count; i++) {
+		transforms[i].x += velocities[i].x;
+		transforms[i].y += velocities[i].y;
+	}
+}
+
+static void bench_ecsBounce(tinyengine_world* world, const tinyengine_entityChunk* chunk, void* user) {
+	const tinyengine_transform* transforms = tinyengine_getChunkComponents(chunk, TE_COMPONENT_TRANSFORM);
+	bench_velocity* velocities = tinyengine_getChunkComponents(chunk, bench_velocityComponent);
+	for(te_u32 i = 0; i < chunk->count; i++) {
+		if((transforms[i].x < 0.0f && velocities[i].x < 0.0f) || (transforms[i].x > 1264.0f && velocities[i].x > 0.0f)) { velocities[i].x = -velocities[i].x; }
+		if((transforms[i].y < 0.0f && velocities[i].y < 0.0f) || (transforms[i].y > 704.0f && velocities[i].y > 0.0f)) { velocities[i].y = -velocities[i].y; }
+	}
+}
+
+static void bench_ecsTint(tinyengine_world* world, const tinyengine_entityChunk* chunk, void* user) {
+	tinyengine_sprite* sprites = tinyengine_getChunkComponents(chunk, TE_COMPONENT_SPRITE);
+	te_u8 pulse = (te_u8)(160 + (*(const te_u32*) user % 96));
+	for(te_u32 i = 0; i < chunk->count; i++) { sprites[i].color[1] = pulse; }
+}
+
+static int bench_ecs(te_u32 entityCount, te_u32 spriteCount, te_u32 threads) {
+	if(!tinyengine_init()) { return -1; }
+
+	tinyengine_windowContext* window;
+	if(!bench_openWindow(&window,1280,720)) { return -1; }
+
+	tinyengine_world world;
+	if(!tinyengine_createWorld(&world, threads) || !tinyengine_registerComponent(&world, sizeof(bench_velocity), &bench_velocityComponent)) { return -1; }
+
+	te_GLuint textures[BENCH_SUITE_TEXTURES];
+	for(te_u32 i = 0; i < BENCH_SUITE_TEXTURES; i++) { textures[i] = bench_checkerTexture(window, i); }
+
+	// Sprites are created per texture so each texture is one run through the batch
+	te_f64 start = tinyengine_getTime();
+	tinyengine_componentMask moving = TE_COMPONENT(TE_COMPONENT_TRANSFORM) | TE_COMPONENT(bench_velocityComponent);
+	for(te_u32 i = 0; i < entityCount; i++) {
+		te_bool_u8 drawn = i < spriteCount;
+		tinyengine_entity entity = tinyengine_createEntity(&world, drawn ? moving | TE_COMPONENT(TE_COMPONENT_SPRITE) : moving);
+		if(!entity) { return -1; }
+		tinyengine_transform* transform = tinyengine_getComponent(&world, entity, TE_COMPONENT_TRANSFORM);
+		bench_velocity* velocity = tinyengine_getComponent(&world, entity, bench_velocityComponent);
+		transform->x = (te_f32)((i * 37) % 1264);
+		transform->y = (te_f32)((i * 53) % 704);
+		velocity->x = (te_f32)((te_i32)(i % 7) - 3) * 0.5f;
+		velocity->y = (te_f32)((te_i32)(i % 5) - 2) * 0.5f;
+		if(drawn) {
+			te_u32 texture = i * BENCH_SUITE_TEXTURES / spriteCount;
+			tinyengine_setSprite(tinyengine_getComponent(&world, entity, TE_COMPONENT_SPRITE), textures[texture], 16, 16, 0, 0, 16, 16);
+		}
+	}
+	te_f64 createMs = (tinyengine_getTime() - start) * 1000.0;
+
+	te_u32 frame = 0;
+	tinyengine_system systems[] = {
+		{ moving, 0, TE_COMPONENT(TE_COMPONENT_TRANSFORM), &bench_ecsMove, NULL },
+		{ TE_COMPONENT(TE_COMPONENT_SPRITE), 0, TE_COMPONENT(TE_COMPONENT_SPRITE), &bench_ecsTint, &frame },
+		{ moving, 0, TE_COMPONENT(bench_velocityComponent), &bench_ecsBounce, NULL },
+	};
+
+	te_u32 frames = 300;
+	te_f64* updateMs = malloc(frames * sizeof(te_f64));
+	te_f64* drawMs = malloc(frames * sizeof(te_f64));
+	te_f64* frameMs = malloc(frames * sizeof(te_f64));
+	if(!updateMs || !drawMs || !frameMs) { return -1; }
+
+	te_u32 drawCalls = te_gl3_state.batchDrawCalls;
+	for(frame = 0; frame < frames; frame++) {
+		te_f64 frameStart = tinyengine_getTime();
+		tinyengine_runSystems(&world, systems, sizeof(systems) / sizeof(systems[0]));
+		te_f64 drawStart = tinyengine_getTime();
+		_tinyengine_gl3_startFrame(window);
+		_tinyengine_gl3_drawEntities(window, &world);
+		_tinyengine_gl3_endFrame(window);
+		glFinish();
+		te_f64 end = tinyengine_getTime();
+		updateMs[frame] = (drawStart - frameStart) * 1000.0;
+		drawMs[frame] = (end - drawStart) * 1000.0;
+		frameMs[frame] = (end - frameStart) * 1000.0;
+		tinyengine_swapBuffers(window);
+		tinyengine_pollEvents();
+	}
+
+	qsort(updateMs, frames, sizeof(te_f64), bench_compareDouble);
+	qsort(drawMs, frames, sizeof(te_f64), bench_compareDouble);
+	qsort(frameMs, frames, sizeof(te_f64), bench_compareDouble);
+	printf("{\"scene\":\"ecs\",\"entities\":%u,\"sprites\":%u,\"threads\":%u,\"archetypes\":%u,\"create_ms\":%.2f,\"update_ms_p50\":%.4f,\"update_ms_p99\":%.4f,"
+		"\"draw_ms_p50\":%.4f,\"draw_ms_p99\":%.4f,\"frame_ms_p50\":%.4f,\"frame_ms_p99\":%.4f,\"draw_calls\":%u}\n",
+		entityCount, spriteCount, world.threadCount, world.archetypeCount, createMs,
+		bench_percentile(updateMs, frames, 50.0), bench_percentile(updateMs, frames, 99.0), bench_percentile(drawMs, frames, 50.0), bench_percentile(drawMs, frames, 99.0),
+		bench_percentile(frameMs, frames, 50.0), bench_percentile(frameMs, frames, 99.0), (te_gl3_state.batchDrawCalls - drawCalls) / frames);
+
+	free(updateMs);
+	free(drawMs);
+	free(frameMs);
+	tinyengine_destroyWorld(&world);
+	tinyengine_terminate();
+	return 0;
+}
+
+//// Tilemap
+
+// A size x size map of 16 pixel tiles in two layers, ground everywhere and sparse decoration, scrolled
+// diagonally through the camera. Each frame also changes one tile in view. The same view is then drawn
+// tile by tile through the immediate batch for comparison.
+
+#define BENCH_TILE 16.0f
+
+// 4x4 cells of 16x16, each cell a different shade
+static te_GLuint bench_tilesetTexture(tinyengine_windowContext* window) {
+	static te_u8 pixels[64 * 64 * 4];
+	for(te_u32 y = 0; y < 64; y++) {
+		for(te_u32 x = 0; x < 64; x++) {
+			te_u8* pixel = pixels + (y * 64 + x) * 4;
+			te_u32 cell = (y / 16) * 4 + x / 16;
+			pixel[0] = (te_u8)(cell * 16);
+			pixel[1] = (te_u8)(255 - cell * 12);
+			pixel[2] = ((x ^ y) & 4) ? 200 : 60;
+			pixel[3] = 255;
+		}
+	}
+	return _tinyengine_gl3_loadTextureRGB(window, 64, 64, 4, pixels);
+}
+
+static te_u16 bench_groundTile(te_u32 x, te_u32 y) { return (te_u16)(1 + (x * 7 + y * 13) % 8); }
+static te_u16 bench_decorTile(te_u32 x, te_u32 y) { return ((x * 31 + y * 17) % 11 == 0) ? (te_u16)(9 + (x + y) % 8) : 0; }
+
+static void bench_tilemapCamera(tinyengine_windowContext* window, te_u32 frame, te_u32 size) {
+	te_f32 span = size * BENCH_TILE - 1280.0f;
+	te_f32 offset = (te_f32)((frame * 24) % (te_u32)(span > 1.0f ? span : 1.0f));
+	_tinyengine_gl3_setCamera(window, 640.0f + offset, 360.0f + offset * 0.5f, 1.0f, 0.0f);
+	_tinyengine_gl3_setWorldSpace(window, TE_TRUE);
+}
+
+static int bench_tilemap(te_u32 size) {
+	if(size == 0) { return -1; }
+	if(!tinyengine_init()) { return -1; }
+
+	tinyengine_windowContext* window;
+	if(!bench_openWindow(&window,1280,720)) { return -1; }
+	te_GLuint tileset = bench_tilesetTexture(window);
+
+	_tinyengine_gl3_tilemap* map = _tinyengine_gl3_createTilemap(0.0f, 0.0f, size, size, BENCH_TILE, BENCH_TILE);
+	if(!map) { return -1; }
+	te_u32 ground = _tinyengine_gl3_addTilemapLayer(map, tileset, 4, 4);
+	te_u32 decor = _tinyengine_gl3_addTilemapLayer(map, tileset, 4, 4);
+	te_u16* row = malloc(size * sizeof(te_u16));
+	if(ground == TE_GL3_TILEMAP_MAX_LAYERS || decor == TE_GL3_TILEMAP_MAX_LAYERS || !row) { return -1; }
+	for(te_u32 y = 0; y < size; y++) {
+		for(te_u32 x = 0; x < size; x++) { row[x] = bench_groundTile(x, y); }
+		_tinyengine_gl3_setTiles(map, ground, 0, y, size, 1, row);
+		for(te_u32 x = 0; x < size; x++) { row[x] = bench_decorTile(x, y); }
+		_tinyengine_gl3_setTiles(map, decor, 0, y, size, 1, row);
+	}
+	free(row);
+
+	const te_u32 frames = 300;
+	te_f64 mapCpu = 0.0, mapFrame = 0.0;
+	te_u64 mapDrawCalls = 0, mapChunksBuilt = 0, mapBytes = 0;
+	for(te_u32 frame = 0; frame < frames; frame++) {
+		te_f64 start = tinyengine_getTime();
+		_tinyengine_gl3_startFrame(window);
+		bench_tilemapCamera(window, frame, size);
+		te_f32 x, y, width, height;
+		_tinyengine_gl3_getVisibleRect(window, &x, &y, &width, &height);
+		te_u32 column = (te_u32)((x + width * 0.5f) / BENCH_TILE), line = (te_u32)((y + height * 0.5f) / BENCH_TILE);
+		_tinyengine_gl3_setTile(map, decor, column, line, (te_u16)(9 + frame % 8));
+		_tinyengine_gl3_drawTilemap(window, map);
+		_tinyengine_gl3_setWorldSpace(window, TE_FALSE);
+		_tinyengine_gl3_endFrame(window);
+		mapCpu += tinyengine_getTime() - start;
+		glFinish();
+		mapFrame += tinyengine_getTime() - start;
+		mapDrawCalls += map->drawCalls;
+		mapChunksBuilt += map->chunksBuilt;
+		mapBytes += map->bytesUploaded;
+		tinyengine_swapBuffers(window);
+		tinyengine_pollEvents();
+	}
+
+	// Immediate mode only ever sees the tiles in view, the rest of the map costs it nothing
+	te_f64 spriteCpu = 0.0, spriteFrame = 0.0;
+	te_u32 drawCalls = te_gl3_state.batchDrawCalls;
+	te_u64 bytes = te_gl3_state.batchBytes;
+	for(te_u32 frame = 0; frame < frames; frame++) {
+		te_f64 start = tinyengine_getTime();
+		_tinyengine_gl3_startFrame(window);
+		bench_tilemapCamera(window, frame, size);
+		te_f32 x, y, width, height;
+		_tinyengine_gl3_getVisibleRect(window, &x, &y, &width, &height);
+		te_u32 column0 = x > 0.0f ? (te_u32)(x / BENCH_TILE) : 0, row0 = y > 0.0f ? (te_u32)(y / BENCH_TILE) : 0;
+		te_u32 column1 = (te_u32)((x + width) / BENCH_TILE) + 1, row1 = (te_u32)((y + height) / BENCH_TILE) + 1;
+		if(column1 > size) { column1 = size; }
+		if(row1 > size) { row1 = size; }
+		for(te_u32 layer = 0; layer < 2; layer++) {
+			for(te_u32 tileY = row0; tileY < row1; tileY++) {
+				for(te_u32 tileX = column0; tileX < column1; tileX++) {
+					te_u16 tile = _tinyengine_gl3_getTile(map, layer == 0 ? ground : decor, tileX, tileY);
+					if(tile == 0) { continue; }
+					te_u32 cell = tile - 1;
+					_tinyengine_gl3_drawSprite(window, tileset, tileX * BENCH_TILE, tileY * BENCH_TILE, BENCH_TILE, BENCH_TILE, 1.0f, 64, 64, (cell % 4) * 16, (cell / 4) * 16);
+				}
+			}
+		}
+		_tinyengine_gl3_setWorldSpace(window, TE_FALSE);
+		_tinyengine_gl3_endFrame(window);
+		spriteCpu += tinyengine_getTime() - start;
+		glFinish();
+		spriteFrame += tinyengine_getTime() - start;
+		tinyengine_swapBuffers(window);
+		tinyengine_pollEvents();
+	}
+
+	printf("{\"scene\":\"tilemap\",\"mode\":\"chunks\",\"tiles\":%u,\"draw_calls\":%llu,\"chunks_built_per_frame\":%.2f,\"bytes_uploaded_per_frame\":%llu,\"submit_cpu_ms\":%.3f,\"frame_ms\":%.3f}\n",
+		size * size, (unsigned long long)(mapDrawCalls / frames), (te_f64) mapChunksBuilt / frames, (unsigned long long)(mapBytes / frames), mapCpu * 1000.0 / frames, mapFrame * 1000.0 / frames);
+	printf("{\"scene\":\"tilemap\",\"mode\":\"sprites\",\"tiles\":%u,\"draw_calls\":%u,\"bytes_uploaded_per_frame\":%llu,\"submit_cpu_ms\":%.3f,\"frame_ms\":%.3f}\n",
+		size * size, (te_gl3_state.batchDrawCalls - drawCalls) / frames, (unsigned long long)((te_gl3_state.batchBytes - bytes) / frames), spriteCpu * 1000.0 / frames, spriteFrame * 1000.0 / frames);
+	fflush(stdout);
+
+	_tinyengine_gl3_destroyTilemap(map);
+	tinyengine_terminate();
+	return 0;
+}
+
+//// Overdraw
+
+// Fill rate bound stack of large sprites in eight layers, one in eight of them tinted translucent. Drawn in
+// painter's order through the immediate batch, then through the layered pass, with the overdraw counter on.
+
+static void bench_overdrawSprite(te_u32 i, te_i32* layer, te_f32* x, te_f32* y, te_f32* size, te_v4_f32* tint) {
+	*layer = (te_i32)(i % 8);
+	*size = (te_f32)(128 + (i * 29) % 256);
+	*x = (te_f32)((i * 397) % 1280) - *size * 0.5f;
+	*y = (te_f32)((i * 211) % 720) - *size * 0.5f;
+	te_f32 alpha = i % 8 == 7 ? 0.5f : 1.0f;
+	*tint = (te_v4_f32){ 0.5f + (i % 5) * 0.1f, 0.5f + (i % 3) * 0.2f, 1.0f, alpha };
+}
+
+static void bench_overdrawRun(tinyengine_windowContext* window, te_GLuint* textures, te_u32 spriteCount, te_bool_u8 layered, te_u32 frames, te_f64* frameMs) {
+	_tinyengine_gl3_setOverdrawCounter(window);
+	for(te_u32 frame = 0; frame < frames; frame++) {
+		te_f64 start = tinyengine_getTime();
+		_tinyengine_gl3_startFrame(window);
+		if(layered) {
+			_tinyengine_gl3_beginLayers(window);
+			for(te_u32 i = 0; i < spriteCount; i++) {
+				te_i32 layer; te_f32 x, y, size; te_v4_f32 tint;
+				bench_overdrawSprite(i, &layer, &x, &y, &size, &tint);
+				_tinyengine_gl3_drawLayerSprite(window, layer, textures[i % BENCH_SUITE_TEXTURES], x, y, size, size, 1.0f, size, size, 0, 0, tint, TE_LAYER_AUTO);
+			}
+			_tinyengine_gl3_endLayers(window);
+		} else {
+			for(te_i32 pass = 0; pass < 8; pass++) {
+				for(te_u32 i = 0; i < spriteCount; i++) {
+					te_i32 layer; te_f32 x, y, size; te_v4_f32 tint;
+					bench_overdrawSprite(i, &layer, &x, &y, &size, &tint);
+					if(layer != pass) { continue; }
+					_tinyengine_gl3_drawSpriteTinted(window, textures[i % BENCH_SUITE_TEXTURES], x, y, size, size, 1.0f, size, size, 0, 0, tint);
+				}
+			}
+		}
+		_tinyengine_gl3_endFrame(window);
+		glFinish();
+		frameMs[frame] = (tinyengine_getTime() - start) * 1000.0;
+		tinyengine_swapBuffers(window);
+		tinyengine_pollEvents();
+	}
+}
+
+static int bench_overdraw(te_u32 spriteCount) {
+	if(!tinyengine_init()) { return -1; }
+
+	tinyengine_windowContext* window;
+	if(!bench_openWindow(&window,1280,720)) { return -1; }
+
+	te_GLuint textures[BENCH_SUITE_TEXTURES];
+	for(te_u32 i = 0; i < BENCH_SUITE_TEXTURES; i++) { textures[i] = bench_checkerTexture(window, i); }
+
+	const te_u32 frames = 120;
+	te_f64* frameMs = malloc(frames * sizeof(te_f64));
+	if(!frameMs) { return -1; }
+
+	const char* modes[2] = { "painter", "layered" };
+	for(te_u32 mode = 0; mode < 2; mode++) {
+		te_u32 drawCalls = te_gl3_state.batchDrawCalls;
+		bench_overdrawRun(window, textures, spriteCount, mode == 1, frames, frameMs);
+		te_f32 overdraw;
+		_tinyengine_gl3_getOverdraw(NULL, &overdraw);
+		te_u32 calls = mode == 1 ? te_gl3_state.layers.drawCalls : (te_gl3_state.batchDrawCalls - drawCalls) / frames;
+
+		qsort(frameMs, frames, sizeof(te_f64), bench_compareDouble);
+		printf("{\"scene\":\"overdraw\",\"mode\":\"%s\",\"sprites\":%u,\"opaque\":%u,\"overdraw\":%.2f,\"draw_calls\":%u,\"frame_ms_p50\":%.4f,\"frame_ms_p99\":%.4f}\n",
+			modes[mode], spriteCount, mode == 1 ? te_gl3_state.layers.opaqueCount : 0, overdraw, calls,
+			bench_percentile(frameMs, frames, 50.0), bench_percentile(frameMs, frames, 99.0));
+		fflush(stdout);
+	}
+
+	_tinyengine_gl3_setOverdrawCounter(NULL);
+	free(frameMs);
+	tinyengine_terminate();
+	return 0;
+}
+
+//// Dynamic resolution
+
+// The painter's order overdraw scene with a text line on top, at native resolution and then with the scale
+// following the target frame time. The sprite count grows halfway through to stand in for a load spike.
+static int bench_resolution(te_f32 targetMs, te_u32 spriteCount) {
+	if(!tinyengine_init()) { return -1; }
+
+	tinyengine_windowContext* window;
+	if(!bench_openWindow(&window,1280,720)) { return -1; }
+
+	te_GLuint textures[BENCH_SUITE_TEXTURES];
+	for(te_u32 i = 0; i < BENCH_SUITE_TEXTURES; i++) { textures[i] = bench_checkerTexture(window, i); }
+	_tinyengine_gl3_bitmapGlyphCache font;
+	memset(&font, 0, sizeof(font));
+	bench_syntheticFont(window, &font);
+
+	const te_u32 frames = 240;
+	te_f64* frameMs = malloc(frames * sizeof(te_f64));
+	if(!frameMs) { return -1; }
+
+	const char* modes[2] = { "native", "dynamic" };
+	for(te_u32 mode = 0; mode < 2; mode++) {
+		if(mode == 1) { _tinyengine_gl3_setDynamicResolution(window, targetMs, 0.5f, 1.0f, TE_UPSCALE_SHARPEN); }
+		te_f64 scaleSum = 0.0;
+		for(te_u32 frame = 0; frame < frames; frame++) {
+			te_u32 count = frame < frames / 2 ? spriteCount : spriteCount * 2;
+			te_f64 start = tinyengine_getTime();
+			_tinyengine_gl3_startFrame(window);
+			scaleSum += _tinyengine_gl3_getResolutionScale(window);
+			for(te_u32 i = 0; i < count; i++) {
+				te_i32 layer; te_f32 x, y, size; te_v4_f32 tint;
+				bench_overdrawSprite(i, &layer, &x, &y, &size, &tint);
+				_tinyengine_gl3_drawSpriteTinted(window, textures[i % BENCH_SUITE_TEXTURES], x, y, size, size, 1.0f, size, size, 0, 0, tint);
+			}
+			_tinyengine_gl3_drawText(window, &font, "dynamic resolution", 16.0f, 16.0f, 2.0f, (te_v3_f32){ 1.0f, 1.0f, 1.0f });
+			_tinyengine_gl3_endFrame(window);
+			glFinish();
+			frameMs[frame] = (tinyengine_getTime() - start) * 1000.0;
+			tinyengine_swapBuffers(window);
+			tinyengine_pollEvents();
+		}
+
+		qsort(frameMs, frames, sizeof(te_f64), bench_compareDouble);
+		printf("{\"scene\":\"resolution\",\"mode\":\"%s\",\"target_ms\":%.2f,\"sprites\":%u,\"scale_mean\":%.3f,\"scale_last\":%.3f,\"frame_ms_p50\":%.4f,\"frame_ms_p99\":%.4f}\n",
+			modes[mode], targetMs, spriteCount, scaleSum / frames, _tinyengine_gl3_getResolutionScale(window), bench_percentile(frameMs, frames, 50.0), bench_percentile(frameMs, frames, 99.0));
+		fflush(stdout);
+	}
+
+	free(frameMs);
+	tinyengine_terminate();
+	return 0;
+}
+
+//// Cached layers
+
+// A panel of widgets and labels whose score changes once a second, drawn every frame as it is and then
+// through a cached layer keyed on the score
+static void bench_hudPanel(tinyengine_windowContext* window, _tinyengine_gl3_bitmapGlyphCache* font, te_u32 widgets, te_u32 score) {
+	char label[64];
+	for(te_u32 i = 0; i < widgets; i++) {
+		te_f32 x = (te_f32)((i % 16) * 24), y = (te_f32)(40 + (i / 16) * 24);
+		_tinyengine_gl3_drawRectangle2D(window, x + 2, y + 2, 20, 20, (te_v4_f32){ (i % 7) / 7.0f, (i % 5) / 5.0f, 0.6f, 0.9f });
+		if(i % 8 == 0) {
+			snprintf(label, sizeof(label), "%u", (i * 13 + score) % 1000);
+			_tinyengine_gl3_drawText(window, font, label, x + 4, y + 6, 1.0f, (te_v3_f32){ 1.0f, 1.0f, 1.0f });
+		}
+	}
+	snprintf(label, sizeof(label), "score %u", score);
+	_tinyengine_gl3_drawText(window, font, label, 4.0f, 4.0f, 2.0f, (te_v3_f32){ 1.0f, 1.0f, 0.5f });
+}
+
+static int bench_hud(te_u32 widgets) {
+	if(!tinyengine_init()) { return -1; }
+
+	tinyengine_windowContext* window;
+	if(!bench_openWindow(&window,1280,720)) { return -1; }
+
+	_tinyengine_gl3_bitmapGlyphCache font;
+	memset(&font, 0, sizeof(font));
+	bench_syntheticFont(window, &font);
+
+	const te_u32 frames = 300;
+	te_f64* frameMs = malloc(frames * sizeof(te_f64));
+	if(!frameMs) { return -1; }
+	te_u32 panelHeight = 40 + ((widgets + 15) / 16) * 24;
+
+	const char* modes[2] = { "immediate", "cached" };
+	for(te_u32 mode = 0; mode < 2; mode++) {
+		_tinyengine_gl3_cachedLayer hud;
+		memset(&hud, 0, sizeof(hud));
+		te_u32 drawCalls = te_gl3_state.batchDrawCalls;
+		te_u32 targets = te_gl3_state.renderTargetsCreated;
+
+		for(te_u32 frame = 0; frame < frames; frame++) {
+			te_u32 score = frame / 60;
+			te_f64 start = tinyengine_getTime();
+			_tinyengine_gl3_startFrame(window);
+			_tinyengine_gl3_drawRectangle2D(window, 0, 0, 1280, 720, (te_v4_f32){ 0.1f, 0.2f, 0.3f, 1.0f });
+			if(mode == 0) {
+				bench_hudPanel(window, &font, widgets, score);
+			} else {
+				if(_tinyengine_gl3_beginCachedLayer(window, &hud, 384, panelHeight, _tinyengine_fnv1a64(TE_FNV1A64_SEED, &score, sizeof(score)))) {
+					bench_hudPanel(window, &font, widgets, score);
+					_tinyengine_gl3_endCachedLayer(window, &hud);
+				}
+				_tinyengine_gl3_drawCachedLayer(window, &hud, 0.0f, 0.0f);
+			}
+			_tinyengine_gl3_endFrame(window);
+			glFinish();
+			frameMs[frame] = (tinyengine_getTime() - start) * 1000.0;
+			tinyengine_swapBuffers(window);
+			tinyengine_pollEvents();
+		}
+
+		qsort(frameMs, frames, sizeof(te_f64), bench_compareDouble);
+		printf("{\"scene\":\"hud\",\"mode\":\"%s\",\"widgets\":%u,\"redraws\":%u,\"render_targets_created\":%u,\"draw_calls\":%u,\"frame_ms_p50\":%.4f,\"frame_ms_p99\":%.4f}\n",
+			modes[mode], widgets, mode == 0 ? frames : hud.redraws, te_gl3_state.renderTargetsCreated - targets, (te_gl3_state.batchDrawCalls - drawCalls) / frames,
+			bench_percentile(frameMs, frames, 50.0), bench_percentile(frameMs, frames, 99.0));
+		fflush(stdout);
+		_tinyengine_gl3_destroyCachedLayer(&hud);
+	}
+
+	free(frameMs);
+	tinyengine_terminate();
+	return 0;
+}
+
+//// Compare
+
+// Only reads the flat one line objects this tool prints
+static te_bool_u8 bench_jsonNumber(const char* line, const char* key, te_f64* value) {
+	char pattern[64];
+	snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+	const char* found = strstr(line, pattern);
+	if(!found) { return TE_FALSE; }
+	char* end;
+	*value = strtod(found + strlen(pattern), &end);
+	return end != found + strlen(pattern);
+}
+
+static te_bool_u8 bench_jsonString(const char* line, const char* key, char* value, size_t size) {
+	char pattern[64];
+	snprintf(pattern, sizeof(pattern), "\"%s\":\"", key);
+	const char* found = strstr(line, pattern);
+	if(!found) { return TE_FALSE; }
+	found += strlen(pattern);
+	const char* end = strchr(found, '"');
+	if(!end || (size_t)(end - found) >= size) { return TE_FALSE; }
+	memcpy(value, found, end - found);
+	value[end - found] = '\0';
+	return TE_TRUE;
+}
+
+// Result lines are keyed by scene and mode, where a mode is present
+static te_bool_u8 bench_resultKey(const char* line, char* key, size_t size) {
+	char scene[64], mode[64];
+	if(!bench_jsonString(line, "scene", scene, sizeof(scene))) { return TE_FALSE; }
+	if(bench_jsonString(line, "mode", mode, sizeof(mode))) { snprintf(key, size, "%s/%s", scene, mode); }
+	else { snprintf(key, size, "%s", scene); }
+	return TE_TRUE;
+}
+
+static te_bool_u8 bench_findResult(FILE* file, const char* key, char* line, size_t size) {
+	char other[160];
+	rewind(file);
+	while(fgets(line, (int) size, file)) {
+		if(bench_resultKey(line, other, sizeof(other)) && strcmp(other, key) == 0) { return TE_TRUE; }
+	}
+	return TE_FALSE;
+}
+
+// Fails when any lower-is-better metric grew past the threshold
+static int bench_compare(const char* baselinePath, const char* resultsPath, te_f64 threshold) {
+	static const char* metrics[] = { "frame_ms_p50", "frame_ms_p90", "frame_ms_p99", "steady_cpu_ms", "draw_calls", "bytes_uploaded_per_frame" };
+
+	FILE* baseline = fopen(baselinePath, "r");
+	FILE* results = fopen(resultsPath, "r");
+	if(!baseline || !results) {
+		fprintf(stderr, "could not open %s\n", baseline ? resultsPath : baselinePath);
+		if(baseline) { fclose(baseline); }
+		if(results) { fclose(results); }
+		return -1;
+	}
+
+	char line[1024], reference[1024], key[160];
+	te_u32 regressions = 0, compared = 0;
+	while(fgets(line, sizeof(line), results)) {
+		if(!bench_resultKey(line, key, sizeof(key))) { continue; }
+		if(!bench_findResult(baseline, key, reference, sizeof(reference))) {
+			printf("%-24s not in baseline\n", key);
+			continue;
+		}
+		for(te_u32 i = 0; i < sizeof(metrics) / sizeof(metrics[0]); i++) {
+			te_f64 before, after;
+			if(!bench_jsonNumber(reference, metrics[i], &before) || !bench_jsonNumber(line, metrics[i], &after)) { continue; }
+			te_f64 change = before > 0.0 ? (after - before) / before * 100.0 : (after > 0.0 ? 100.0 : 0.0);
+			te_bool_u8 regressed = change > threshold;
+			printf("%-24s %-26s %12.4f -> %12.4f %+7.1f%%%s\n", key, metrics[i], before, after, change, regressed ? "  REGRESSION" : "");
+			regressions += regressed;
+			compared++;
+		}
+	}
+
+	fclose(baseline);
+	fclose(results);
+	printf("%u metrics compared, %u regressed past %.1f%%\n", compared, regressions, threshold);
+	return regressions ? -1 : 0;
+}
+
+int main(int argc, char** argv) {
+	const char* scene = argc > 1 ? argv[1] : "startup";
+
+	if(strcmp(scene,"startup") == 0) { return bench_startup() == 0 ? 0 : 1; }
+	if(strcmp(scene,"decode") == 0) { return bench_decode(argc - 2, argv + 2) == 0 ? 0 : 1; }
+	if(strcmp(scene,"cull") == 0) { return bench_cull(argc > 2 ? (te_u32) atoi(argv[2]) : 1000000) == 0 ? 0 : 1; }
+	if(strcmp(scene,"damage") == 0) { return bench_damage() == 0 ? 0 : 1; }
+	if(strcmp(scene,"suite") == 0) { return bench_suite(argc > 2 ? (te_u32) atoi(argv[2]) : 300) == 0 ? 0 : 1; }
+	if(strcmp(scene,"compare") == 0) {
+		if(argc < 4) { fprintf(stderr, "usage: bench compare <baseline.json> <results.json> [threshold_percent]\n"); return 1; }
+		return bench_compare(argv[2], argv[3], argc > 4 ? atof(argv[4]) : 10.0) == 0 ? 0 : 1;
+	}
+	if(strcmp(scene,"record") == 0) { return bench_record(argc > 2 ? (te_u32) atoi(argv[2]) : 600, argc > 3 ? argv[3] : "/dev/null") == 0 ? 0 : 1; }
+	if(strcmp(scene,"ecs") == 0) {
+		te_u32 entities = argc > 2 ? (te_u32) atoi(argv[2]) : 1000000;
+		te_u32 sprites = argc > 3 ? (te_u32) atoi(argv[3]) : 100000;
+		return bench_ecs(entities, sprites < entities ? sprites : entities, argc > 4 ? (te_u32) atoi(argv[4]) : 0) == 0 ? 0 : 1;
+	}
+	if(strcmp(scene,"resolution") == 0) { return bench_resolution(argc > 2 ? (te_f32) atof(argv[2]) : 8.0f, argc > 3 ? (te_u32) atoi(argv[3]) : 4000) == 0 ? 0 : 1; }
+	if(strcmp(scene,"hud") == 0) { return bench_hud(argc > 2 ? (te_u32) atoi(argv[2]) : 256) == 0 ? 0 : 1; }
+	if(strcmp(scene,"overdraw") == 0) { return bench_overdraw(argc > 2 ? (te_u32) atoi(argv[2]) : 2000) == 0 ? 0 : 1; }
+	if(strcmp(scene,"tilemap") == 0) { return bench_tilemap(argc > 2 ? (te_u32) atoi(argv[2]) : 1024) == 0 ? 0 : 1; }
+	if(strcmp(scene,"batch") == 0) { return bench_batch(argc > 2 ? (te_u32) atoi(argv[2]) : 100000) == 0 ? 0 : 1; }
+	if(strcmp(scene,"scene") == 0) { return bench_scene(argc > 2 ? (te_u32) atoi(argv[2]) : 10000) == 0 ? 0 : 1; }
+	if(strcmp(scene,"windows") == 0) { return bench_windows(argc > 2 ? (te_u32) atoi(argv[2]) : 200) == 0 ? 0 : 1; }
+
+	fprintf(stderr, "unknown scene %s\n", scene);
+	return 1;
+}
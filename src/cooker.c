@@ -0,0 +1,476 @@
+#define TE_DEBUG
+#define TE_DEBUG_LEVEL_WARNING
+#include "tinyengine.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// usage: cooker [-f rgba8|bc1|bc3|etc2|etc2a] [-l levels] <image.png|image.qoi> <texture.tetx>
+//   Premultiplies alpha, builds the mip chain and encodes every level for _tinyengine_gl3_loadCookedTexture().
+//   -l limits the number of mip levels, 1 disables mipmaps. The default is the full chain down to 1x1.
+
+typedef struct cooker_image_t {
+	te_u32 width;
+	te_u32 height;
+	te_u8* pixels; // premultiplied RGBA8
+} cooker_image;
+
+static te_u32 cooker_clamp(te_i32 value) {
+	return value < 0 ? 0 : (value > 255 ? 255 : (te_u32) value);
+}
+
+// Box filter on premultiplied pixels, odd edges fold the last row or column in
+static cooker_image cooker_downsample(const cooker_image* source) {
+	cooker_image result;
+	result.width = source->width > 1 ? source->width / 2 : 1;
+	result.height = source->height > 1 ? source->height / 2 : 1;
+	result.pixels = malloc((size_t) result.width * result.height * 4);
+
+	for(te_u32 y = 0; y < result.height; y++) {
+		te_u32 y0 = y * 2 < source->height ? y * 2 : source->height - 1;
+		te_u32 y1 = y0 + 1 < source->height ? y0 + 1 : y0;
+		for(te_u32 x = 0; x < result.width; x++) {
+			te_u32 x0 = x * 2 < source->width ? x * 2 : source->width - 1;
+			te_u32 x1 = x0 + 1 < source->width ? x0 + 1 : x0;
+			for(te_u32 c = 0; c < 4; c++) {
+				te_u32 sum = source->pixels[((size_t) y0 * source->width + x0) * 4 + c] + source->pixels[((size_t) y0 * source->width + x1) * 4 + c]
+					+ source->pixels[((size_t) y1 * source->width + x0) * 4 + c] + source->pixels[((size_t) y1 * source->width + x1) * 4 + c];
+				result.pixels[((size_t) y * result.width + x) * 4 + c] = (te_u8)((sum + 2) / 4);
+			}
+		}
+	}
+
+	return result;
+}
+
+// Copies a 4x4 block, clamping at the image edge
+static void cooker_fetchBlock(const cooker_image* image, te_u32 blockX, te_u32 blockY, te_u8 block[16][4]) {
+	for(te_u32 y = 0; y < 4; y++) {
+		te_u32 sy = blockY * 4 + y < image->height ? blockY * 4 + y : image->height - 1;
+		for(te_u32 x = 0; x < 4; x++) {
+			te_u32 sx = blockX * 4 + x < image->width ? blockX * 4 + x : image->width - 1;
+			memcpy(block[y * 4 + x], image->pixels + ((size_t) sy * image->width + sx) * 4, 4);
+		}
+	}
+}
+
+static te_u32 cooker_colorError(const te_u8* a, const te_u8* b) {
+	te_i32 r = (te_i32) a[0] - b[0];
+	te_i32 g = (te_i32) a[1] - b[1];
+	te_i32 bl = (te_i32) a[2] - b[2];
+	return (te_u32)(r * r + g * g + bl * bl);
+}
+
+//// BC1 / BC3
+
+static te_u16 cooker_to565(const te_u8* color) {
+	return (te_u16)(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255));
+}
+
+static void cooker_from565(te_u16 value, te_u8* color) {
+	te_u32 r = (value >> 11) & 31;
+	te_u32 g = (value >> 5) & 63;
+	te_u32 b = value & 31;
+	color[0] = (te_u8)((r << 3) | (r >> 2));
+	color[1] = (te_u8)((g << 2) | (g >> 4));
+	color[2] = (te_u8)((b << 3) | (b >> 2));
+	color[3] = 255;
+}
+
+static void cooker_write16(te_u8* out, te_u16 value) {
+	out[0] = (te_u8)(value & 0xFF);
+	out[1] = (te_u8)(value >> 8);
+}
+
+// Endpoints are the extremes along the bounding box diagonal, good enough for sprites and UI
+static void cooker_encodeColorBlock(te_u8 block[16][4], te_bool_u8 punchThrough, te_u8* out) {
+	te_u8 low[3] = { 255, 255, 255 };
+	te_u8 high[3] = { 0, 0, 0 };
+	te_bool_u8 transparent = TE_FALSE;
+	for(te_u32 i = 0; i < 16; i++) {
+		if(punchThrough && block[i][3] < 128) { transparent = TE_TRUE; continue; }
+		for(te_u32 c = 0; c < 3; c++) {
+			if(block[i][c] < low[c]) { low[c] = block[i][c]; }
+			if(block[i][c] > high[c]) { high[c] = block[i][c]; }
+		}
+	}
+	if(low[0] > high[0]) { memset(low, 0, 3); memset(high, 0, 3); } // fully transparent
+
+	// Pick the block pixels furthest apart along the diagonal as endpoints
+	te_i32 axis[3] = { high[0] - low[0], high[1] - low[1], high[2] - low[2] };
+	te_i32 minProjection = 0x7FFFFFFF;
+	te_i32 maxProjection = -0x7FFFFFFF;
+	te_u8 minColor[4] = { low[0], low[1], low[2], 255 };
+	te_u8 maxColor[4] = { high[0], high[1], high[2], 255 };
+	for(te_u32 i = 0; i < 16; i++) {
+		if(punchThrough && block[i][3] < 128) { continue; }
+		te_i32 projection = block[i][0] * axis[0] + block[i][1] * axis[1] + block[i][2] * axis[2];
+		if(projection < minProjection) { minProjection = projection; memcpy(minColor, block[i], 3); }
+		if(projection > maxProjection) { maxProjection = projection; memcpy(maxColor, block[i], 3); }
+	}
+
+	te_u16 color0 = cooker_to565(maxColor);
+	te_u16 color1 = cooker_to565(minColor);
+
+	// color0 > color1 selects four colors, the reverse three colors and transparent black
+	te_bool_u8 threeColor = punchThrough && transparent;
+	if(threeColor ? color0 > color1 : color0 < color1) { te_u16 swap = color0; color0 = color1; color1 = swap; }
+
+	te_u8 palette[4][4];
+	cooker_from565(color0, palette[0]);
+	cooker_from565(color1, palette[1]);
+	for(te_u32 c = 0; c < 3; c++) {
+		if(threeColor) {
+			palette[2][c] = (te_u8)((palette[0][c] + palette[1][c]) / 2);
+			palette[3][c] = 0;
+		} else {
+			palette[2][c] = (te_u8)((2 * palette[0][c] + palette[1][c]) / 3);
+			palette[3][c] = (te_u8)((palette[0][c] + 2 * palette[1][c]) / 3);
+		}
+	}
+
+	te_u32 indices = 0;
+	for(te_u32 i = 0; i < 16; i++) {
+		te_u32 best = 0;
+		if(threeColor && block[i][3] < 128) {
+			best = 3;
+		} else {
+			te_u32 bestError = 0xFFFFFFFF;
+			for(te_u32 p = 0; p < (threeColor ? 3u : 4u); p++) {
+				te_u32 error = cooker_colorError(block[i], palette[p]);
+				if(error < bestError) { bestError = error; best = p; }
+			}
+		}
+		indices |= best << (i * 2);
+	}
+
+	// color0 == color1 would read as three color mode in BC1, every index then points at color0 anyway
+	if(color0 == color1 && !threeColor) { indices = 0; }
+
+	cooker_write16(out, color0);
+	cooker_write16(out + 2, color1);
+	out[4] = (te_u8)(indices & 0xFF);
+	out[5] = (te_u8)((indices >> 8) & 0xFF);
+	out[6] = (te_u8)((indices >> 16) & 0xFF);
+	out[7] = (te_u8)(indices >> 24);
+}
+
+static void cooker_encodeBC3AlphaBlock(te_u8 block[16][4], te_u8* out) {
+	te_u8 low = 255;
+	te_u8 high = 0;
+	for(te_u32 i = 0; i < 16; i++) {
+		if(block[i][3] < low) { low = block[i][3]; }
+		if(block[i][3] > high) { high = block[i][3]; }
+	}
+
+	// alpha0 > alpha1 selects eight interpolated values
+	te_u32 palette[8];
+	palette[0] = high;
+	palette[1] = low;
+	for(te_u32 i = 1; i < 7; i++) { palette[i + 1] = ((7 - i) * high + i * low) / 7; }
+
+	te_u64 indices = 0;
+	for(te_u32 i = 0; i < 16; i++) {
+		te_u32 best = 0;
+		te_u32 bestError = 0xFFFFFFFF;
+		for(te_u32 p = 0; p < 8; p++) {
+			te_i32 difference = (te_i32) block[i][3] - (te_i32) palette[p];
+			te_u32 error = (te_u32)(difference * difference);
+			if(error < bestError) { bestError = error; best = p; }
+		}
+		indices |= (te_u64) best << (i * 3);
+	}
+	if(high == low) { indices = 0; }
+
+	out[0] = high;
+	out[1] = low;
+	for(te_u32 i = 0; i < 6; i++) { out[2 + i] = (te_u8)((indices >> (i * 8)) & 0xFF); }
+}
+
+//// ETC2, color blocks use the ETC1 compatible individual and differential modes
+
+static const te_i32 cooker_etcModifiers[8][2] = { {2,8}, {5,17}, {9,29}, {13,42}, {18,60}, {24,80}, {33,106}, {47,183} };
+
+// Pixel index bits (msb lsb): 00 +small, 01 +large, 10 -small, 11 -large
+static te_i32 cooker_etcModifier(te_u32 table, te_u32 index) {
+	te_i32 value = cooker_etcModifiers[table][index & 1];
+	return index & 2 ? -value : value;
+}
+
+static void cooker_writeBigEndian64(te_u8* out, te_u64 value) {
+	for(te_u32 i = 0; i < 8; i++) { out[i] = (te_u8)(value >> (56 - i * 8)); }
+}
+
+// Pixels in ETC blocks are numbered column major
+static te_bool_u8 cooker_etcInSecondHalf(te_u32 x, te_u32 y, te_bool_u8 flip) {
+	return flip ? y >= 2 : x >= 2;
+}
+
+// Best table and pixel indices for one half block around base, returns the error
+static te_u32 cooker_etcFitHalf(te_u8 block[16][4], te_bool_u8 flip, te_u32 half, const te_i32* base, te_u32* tableOut, te_u32 indices[16]) {
+	te_u32 bestError = 0xFFFFFFFF;
+	te_u32 bestIndices[16] = {0};
+
+	for(te_u32 table = 0; table < 8; table++) {
+		te_u32 error = 0;
+		te_u32 tableIndices[16] = {0};
+		for(te_u32 y = 0; y < 4; y++) {
+			for(te_u32 x = 0; x < 4; x++) {
+				if(cooker_etcInSecondHalf(x, y, flip) != half) { continue; }
+				const te_u8* pixel = block[y * 4 + x];
+				te_u32 pixelBest = 0xFFFFFFFF;
+				for(te_u32 index = 0; index < 4; index++) {
+					te_i32 modifier = cooker_etcModifier(table, index);
+					te_u8 candidate[3] = { (te_u8) cooker_clamp(base[0] + modifier), (te_u8) cooker_clamp(base[1] + modifier), (te_u8) cooker_clamp(base[2] + modifier) };
+					te_u32 pixelError = cooker_colorError(pixel, candidate);
+					if(pixelError < pixelBest) { pixelBest = pixelError; tableIndices[x * 4 + y] = index; }
+				}
+				error += pixelBest;
+			}
+		}
+		if(error < bestError) {
+			bestError = error;
+			*tableOut = table;
+			memcpy(bestIndices, tableIndices, sizeof(bestIndices));
+		}
+	}
+
+	for(te_u32 y = 0; y < 4; y++) {
+		for(te_u32 x = 0; x < 4; x++) {
+			if(cooker_etcInSecondHalf(x, y, flip) == half) { indices[x * 4 + y] = bestIndices[x * 4 + y]; }
+		}
+	}
+	return bestError;
+}
+
+static void cooker_encodeETCColorBlock(te_u8 block[16][4], te_u8* out) {
+	te_u64 bestBlock = 0;
+	te_u32 bestError = 0xFFFFFFFF;
+
+	for(te_u32 flip = 0; flip < 2; flip++) {
+		te_u32 average[2][3] = {{0}};
+		for(te_u32 y = 0; y < 4; y++) {
+			for(te_u32 x = 0; x < 4; x++) {
+				te_u32 half = cooker_etcInSecondHalf(x, y, (te_bool_u8) flip);
+				for(te_u32 c = 0; c < 3; c++) { average[half][c] += block[y * 4 + x][c]; }
+			}
+		}
+
+		te_i32 quantized5[2][3];
+		te_i32 quantized4[2][3];
+		for(te_u32 half = 0; half < 2; half++) {
+			for(te_u32 c = 0; c < 3; c++) {
+				te_u32 mean = (average[half][c] + 4) / 8;
+				quantized5[half][c] = (te_i32)((mean * 31 + 127) / 255);
+				quantized4[half][c] = (te_i32)((mean * 15 + 127) / 255);
+			}
+		}
+
+		te_bool_u8 differential = TE_TRUE;
+		for(te_u32 c = 0; c < 3; c++) {
+			te_i32 delta = quantized5[1][c] - quantized5[0][c];
+			if(delta < -4 || delta > 3) { differential = TE_FALSE; }
+		}
+
+		te_i32 base[2][3];
+		for(te_u32 half = 0; half < 2; half++) {
+			for(te_u32 c = 0; c < 3; c++) {
+				if(differential) {
+					base[half][c] = (quantized5[half][c] << 3) | (quantized5[half][c] >> 2);
+				} else {
+					base[half][c] = (quantized4[half][c] << 4) | quantized4[half][c];
+				}
+			}
+		}
+
+		te_u32 tables[2];
+		te_u32 indices[16] = {0};
+		te_u32 error = cooker_etcFitHalf(block, (te_bool_u8) flip, 0, base[0], &tables[0], indices)
+			+ cooker_etcFitHalf(block, (te_bool_u8) flip, 1, base[1], &tables[1], indices);
+		if(error >= bestError) { continue; }
+		bestError = error;
+
+		te_u64 bits = 0;
+		if(differential) {
+			for(te_u32 c = 0; c < 3; c++) {
+				te_u64 delta = (te_u64)((quantized5[1][c] - quantized5[0][c]) & 7);
+				bits |= ((te_u64) quantized5[0][c] << (59 - c * 8)) | (delta << (56 - c * 8));
+			}
+		} else {
+			for(te_u32 c = 0; c < 3; c++) {
+				bits |= ((te_u64) quantized4[0][c] << (60 - c * 8)) | ((te_u64) quantized4[1][c] << (56 - c * 8));
+			}
+		}
+		bits |= (te_u64) tables[0] << 37 | (te_u64) tables[1] << 34 | (te_u64) differential << 33 | (te_u64) flip << 32;
+		for(te_u32 i = 0; i < 16; i++) {
+			bits |= (te_u64)((indices[i] >> 1) & 1) << (16 + i);
+			bits |= (te_u64)(indices[i] & 1) << i;
+		}
+		bestBlock = bits;
+	}
+
+	cooker_writeBigEndian64(out, bestBlock);
+}
+
+static const te_i32 cooker_eacModifiers[16][8] = {
+	{-3,-6,-9,-15,2,5,8,14}, {-3,-7,-10,-13,2,6,9,12}, {-2,-5,-8,-13,1,4,7,12}, {-2,-4,-6,-13,1,3,5,12},
+	{-3,-6,-8,-12,2,5,7,11}, {-3,-7,-9,-11,2,6,8,10}, {-4,-7,-8,-11,3,6,7,10}, {-3,-5,-8,-11,2,4,7,10},
+	{-2,-6,-8,-10,1,5,7,9}, {-2,-5,-8,-10,1,4,7,9}, {-2,-4,-8,-10,1,3,7,9}, {-2,-5,-7,-10,1,4,6,9},
+	{-3,-4,-7,-10,2,3,6,9}, {-1,-2,-3,-10,0,1,2,9}, {-4,-6,-8,-9,3,5,7,8}, {-3,-5,-7,-9,2,4,6,8}
+};
+
+// Searches table and multiplier around the block's alpha range
+static void cooker_encodeEACAlphaBlock(te_u8 block[16][4], te_u8* out) {
+	te_i32 low = 255;
+	te_i32 high = 0;
+	for(te_u32 i = 0; i < 16; i++) {
+		if(block[i][3] < low) { low = block[i][3]; }
+		if(block[i][3] > high) { high = block[i][3]; }
+	}
+
+	te_u64 bestBlock = 0;
+	te_u32 bestError = 0xFFFFFFFF;
+	for(te_u32 table = 0; table < 16 && bestError > 0; table++) {
+		te_i32 spread = cooker_eacModifiers[table][7] - cooker_eacModifiers[table][3];
+		for(te_i32 multiplier = 1; multiplier < 16 && bestError > 0; multiplier++) {
+			te_i32 center = (low + high + 1) / 2 - ((cooker_eacModifiers[table][7] + cooker_eacModifiers[table][3]) * multiplier) / 2;
+			if(spread * multiplier + 2 * multiplier < high - low) { continue; }
+			for(te_i32 base = center - 2; base <= center + 2; base++) {
+				if(base < 0 || base > 255) { continue; }
+				te_u32 error = 0;
+				te_u64 indices = 0;
+				for(te_u32 y = 0; y < 4; y++) {
+					for(te_u32 x = 0; x < 4; x++) {
+						te_i32 alpha = block[y * 4 + x][3];
+						te_u32 best = 0;
+						te_u32 pixelBest = 0xFFFFFFFF;
+						for(te_u32 index = 0; index < 8; index++) {
+							te_i32 difference = alpha - (te_i32) cooker_clamp(base + cooker_eacModifiers[table][index] * multiplier);
+							te_u32 pixelError = (te_u32)(difference * difference);
+							if(pixelError < pixelBest) { pixelBest = pixelError; best = index; }
+						}
+						error += pixelBest;
+						indices |= (te_u64) best << (45 - (x * 4 + y) * 3);
+					}
+				}
+				if(error < bestError) {
+					bestError = error;
+					bestBlock = (te_u64) base << 56 | (te_u64) multiplier << 52 | (te_u64) table << 48 | indices;
+				}
+			}
+		}
+	}
+
+	// Constant alpha, table 13 has an exact zero modifier
+	if(low == high) { bestBlock = (te_u64) low << 56 | (te_u64) 1 << 52 | (te_u64) 13 << 48 | 0x924924924924ull; }
+
+	cooker_writeBigEndian64(out, bestBlock);
+}
+
+static te_u8* cooker_encodeLevel(const cooker_image* image, te_u32 format, size_t size) {
+	te_u8* out = malloc(size);
+	if(format == TE_TEXTURE_FORMAT_RGBA8) { memcpy(out, image->pixels, size); return out; }
+
+	size_t blockSize = format == TE_TEXTURE_FORMAT_BC3 || format == TE_TEXTURE_FORMAT_ETC2_RGBA8 ? 16 : 8;
+	te_u32 blocksX = (image->width + 3) / 4;
+	te_u32 blocksY = (image->height + 3) / 4;
+	te_u8 block[16][4];
+
+	for(te_u32 by = 0; by < blocksY; by++) {
+		for(te_u32 bx = 0; bx < blocksX; bx++) {
+			te_u8* destination = out + ((size_t) by * blocksX + bx) * blockSize;
+			cooker_fetchBlock(image, bx, by, block);
+			switch(format) {
+				case TE_TEXTURE_FORMAT_BC1: cooker_encodeColorBlock(block, TE_TRUE, destination); break;
+				case TE_TEXTURE_FORMAT_BC3: cooker_encodeBC3AlphaBlock(block, destination); cooker_encodeColorBlock(block, TE_FALSE, destination + 8); break;
+				case TE_TEXTURE_FORMAT_ETC2_RGB8: cooker_encodeETCColorBlock(block, destination); break;
+				case TE_TEXTURE_FORMAT_ETC2_RGBA8: cooker_encodeEACAlphaBlock(block, destination); cooker_encodeETCColorBlock(block, destination + 8); break;
+			}
+		}
+	}
+	return out;
+}
+
+static te_bool_u8 cooker_parseFormat(const char* name, te_u32* format) {
+	static const char* names[] = { "rgba8", "bc1", "bc3", "etc2", "etc2a" };
+	static const te_u32 formats[] = { TE_TEXTURE_FORMAT_RGBA8, TE_TEXTURE_FORMAT_BC1, TE_TEXTURE_FORMAT_BC3, TE_TEXTURE_FORMAT_ETC2_RGB8, TE_TEXTURE_FORMAT_ETC2_RGBA8 };
+	for(te_u32 i = 0; i < 5; i++) {
+		if(strcmp(name, names[i]) == 0) { *format = formats[i]; return TE_TRUE; }
+	}
+	return TE_FALSE;
+}
+
+int main(int argc, char** argv) {
+	te_u32 format = TE_TEXTURE_FORMAT_RGBA8;
+	te_u32 maxLevels = TE_COOKED_TEXTURE_MAX_LEVELS;
+
+	int argument = 1;
+	for(; argument + 1 < argc && argv[argument][0] == '-'; argument += 2) {
+		if(strcmp(argv[argument], "-f") == 0 && cooker_parseFormat(argv[argument + 1], &format)) { continue; }
+		if(strcmp(argv[argument], "-l") == 0 && atoi(argv[argument + 1]) > 0) { maxLevels = (te_u32) atoi(argv[argument + 1]); continue; }
+		break;
+	}
+	if(argc - argument != 2) { fprintf(stderr, "usage: cooker [-f rgba8|bc1|bc3|etc2|etc2a] [-l levels] <image> <texture.tetx>\n"); return 1; }
+	const char* input = argv[argument];
+	const char* output = argv[argument + 1];
+
+	tinyengine_mappedFile file;
+	if(!tinyengine_mapFile(input, &file)) { return 1; }
+
+	cooker_image levels[TE_COOKED_TEXTURE_MAX_LEVELS];
+	size_t decodeSize = tinyengine_imageDecodeSize(file.data, file.size);
+	if(decodeSize == 0 || !tinyengine_imageInfo(file.data, file.size, &levels[0].width, &levels[0].height)) { fprintf(stderr, "%s: unsupported image\n", input); return 1; }
+	if(levels[0].width > (1 << 16) || levels[0].height > (1 << 16)) { fprintf(stderr, "%s: too large\n", input); return 1; }
+
+	levels[0].pixels = malloc(decodeSize);
+	if(!tinyengine_decodeImage(file.data, file.size, levels[0].pixels, decodeSize)) { fprintf(stderr, "%s: decode failed\n", input); return 1; }
+	tinyengine_unmapFile(&file);
+	tinyengine_premultiplyAlpha(levels[0].pixels, (size_t) levels[0].width * levels[0].height);
+
+	te_u32 levelCount = 1;
+	while(levelCount < maxLevels && (levels[levelCount - 1].width > 1 || levels[levelCount - 1].height > 1)) {
+		levels[levelCount] = cooker_downsample(&levels[levelCount - 1]);
+		levelCount++;
+	}
+
+	_tinyengine_cookedTextureHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "TETX", 4);
+	header.version = TE_COOKED_TEXTURE_VERSION;
+	header.format = format;
+	header.width = levels[0].width;
+	header.height = levels[0].height;
+	header.levelCount = levelCount;
+	header.flags = TE_COOKED_TEXTURE_PREMULTIPLIED;
+
+	_tinyengine_cookedTextureLevel table[TE_COOKED_TEXTURE_MAX_LEVELS];
+	te_u8* data[TE_COOKED_TEXTURE_MAX_LEVELS];
+	size_t offset = sizeof(header) + levelCount * sizeof(_tinyengine_cookedTextureLevel);
+	size_t uncompressed = 0;
+	for(te_u32 i = 0; i < levelCount; i++) {
+		offset = (offset + 15) & ~(size_t) 15;
+		table[i].offset = offset;
+		table[i].size = tinyengine_textureLevelSize(format, levels[i].width, levels[i].height);
+		data[i] = cooker_encodeLevel(&levels[i], format, (size_t) table[i].size);
+		offset += (size_t) table[i].size;
+		uncompressed += (size_t) levels[i].width * levels[i].height * 4;
+	}
+
+	FILE* out = fopen(output, "wb");
+	if(!out) { fprintf(stderr, "%s: could not write\n", output); return 1; }
+	static const te_u8 padding[16] = {0};
+	size_t written = fwrite(&header, 1, sizeof(header), out);
+	written += fwrite(table, 1, levelCount * sizeof(_tinyengine_cookedTextureLevel), out);
+	for(te_u32 i = 0; i < levelCount; i++) {
+		written += fwrite(padding, 1, (size_t) table[i].offset - written, out);
+		written += fwrite(data[i], 1, (size_t) table[i].size, out);
+		free(data[i]);
+		free(levels[i].pixels);
+	}
+	if(fclose(out) != 0 || written != offset) { fprintf(stderr, "%s: could not write\n", output); return 1; }
+
+	printf("%s: %ux%u, %u levels, %zu bytes of texture data, %.1fx smaller than rgba8 with mipmaps\n",
+		output, header.width, header.height, levelCount, offset, (double) uncompressed / (double) offset);
+	return 0;
+}
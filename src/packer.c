@@ -0,0 +1,316 @@
+#define TE_DEBUG
+#define TE_DEBUG_LEVEL_WARNING
+#include "tinyengine.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h> // opendir(); readdir();
+
+// usage: packer [-z] <archive> <file|directory>...
+//   Files keep the name they were given, files found in a directory are named relative to it.
+//   -z stores assets LZ4 compressed when that saves at least an eighth of their size.
+
+typedef struct packer_asset_t {
+	char* name;
+	char* path;
+	te_u8* data;
+	size_t size;
+	te_u8* stored;
+	size_t storedSize;
+	te_u8 compression;
+} packer_asset;
+
+typedef struct packer_t {
+	packer_asset* assets;
+	te_u32 count;
+	te_u32 capacity;
+	te_bool_u8 compress;
+} packer;
+
+static char* packer_copyString(const char* string) {
+	size_t length = strlen(string);
+	char* copy = malloc(length + 1);
+	memcpy(copy, string, length + 1);
+	return copy;
+}
+
+static te_bool_u8 packer_readFile(const char* path, te_u8** data, size_t* size) {
+	FILE* file = fopen(path, "rb");
+	if(!file) { return TE_FALSE; }
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if(length < 0) { fclose(file); return TE_FALSE; }
+
+	*size = (size_t) length;
+	*data = malloc(*size ? *size : 1);
+	te_bool_u8 read = fread(*data, 1, *size, file) == *size;
+	fclose(file);
+	if(!read) { free(*data); }
+	return read;
+}
+
+static te_bool_u8 packer_add(packer* pack, const char* name, const char* path) {
+	if(strlen(name) >= 0xFFFF) { fprintf(stderr, "%s: name too long\n", name); return TE_FALSE; }
+
+	for(te_u32 i = 0; i < pack->count; i++) {
+		if(strcmp(pack->assets[i].name, name) == 0) { fprintf(stderr, "%s: duplicate name\n", name); return TE_FALSE; }
+	}
+
+	if(pack->count == pack->capacity) {
+		pack->capacity = pack->capacity ? pack->capacity * 2 : 256;
+		pack->assets = realloc(pack->assets, pack->capacity * sizeof(packer_asset));
+	}
+
+	packer_asset* asset = &pack->assets[pack->count];
+	memset(asset, 0, sizeof(packer_asset));
+	if(!packer_readFile(path, &asset->data, &asset->size)) { fprintf(stderr, "%s: could not read\n", path); return TE_FALSE; }
+	if(asset->size > 0xFFFFFFFFu) { fprintf(stderr, "%s: too large\n", path); free(asset->data); return TE_FALSE; }
+	asset->name = packer_copyString(name);
+	asset->path = packer_copyString(path);
+	pack->count++;
+	return TE_TRUE;
+}
+
+// Directories are walked recursively, prefix is the name relative to the directory given on the command line
+static te_bool_u8 packer_addDirectory(packer* pack, const char* path, const char* prefix) {
+	DIR* directory = opendir(path);
+	if(!directory) { return TE_FALSE; }
+
+	te_bool_u8 result = TE_TRUE;
+	struct dirent* entry;
+	while((entry = readdir(directory)) != NULL) {
+		if(entry->d_name[0] == '.') { continue; }
+
+		char childPath[4096];
+		char childName[4096];
+		snprintf(childPath, sizeof(childPath), "%s/%s", path, entry->d_name);
+		snprintf(childName, sizeof(childName), "%s%s%s", prefix, prefix[0] ? "/" : "", entry->d_name);
+
+		DIR* child = opendir(childPath);
+		if(child) {
+			closedir(child);
+			if(!packer_addDirectory(pack, childPath, childName)) { result = TE_FALSE; }
+		} else if(!packer_add(pack, childName, childPath)) {
+			result = TE_FALSE;
+		}
+	}
+	closedir(directory);
+	return result;
+}
+
+//// LZ4 block compression, greedy with a single hash table, good enough for an offline tool
+
+#define PACKER_LZ4_HASH_BITS 16
+#define PACKER_LZ4_MIN_MATCH 4
+#define PACKER_LZ4_LAST_LITERALS 5 // the format ends with at least this many literals
+#define PACKER_LZ4_MATCH_LIMIT 12 // no match may start closer to the end than this
+
+static te_u32 packer_read32(const te_u8* data) {
+	te_u32 value;
+	memcpy(&value, data, 4);
+	return value;
+}
+
+static te_u8* packer_lz4WriteLength(te_u8* out, size_t length) {
+	while(length >= 255) { *out++ = 255; length -= 255; }
+	*out++ = (te_u8) length;
+	return out;
+}
+
+static te_u8* packer_lz4WriteSequence(te_u8* out, const te_u8* literals, size_t literalCount, size_t offset, size_t matchLength) {
+	te_u8* token = out++;
+	*token = (te_u8)((literalCount >= 15 ? 15 : literalCount) << 4);
+	if(literalCount >= 15) { out = packer_lz4WriteLength(out, literalCount - 15); }
+	memcpy(out, literals, literalCount);
+	out += literalCount;
+
+	if(matchLength == 0) { return out; }
+
+	*out++ = (te_u8)(offset & 0xFF);
+	*out++ = (te_u8)(offset >> 8);
+	matchLength -= PACKER_LZ4_MIN_MATCH;
+	*token |= (te_u8)(matchLength >= 15 ? 15 : matchLength);
+	if(matchLength >= 15) { out = packer_lz4WriteLength(out, matchLength - 15); }
+	return out;
+}
+
+static size_t packer_lz4Bound(size_t size) {
+	return size + size / 255 + 16;
+}
+
+static size_t packer_lz4Compress(const te_u8* source, size_t size, te_u8* destination) {
+	static te_u32 table[1 << PACKER_LZ4_HASH_BITS];
+	memset(table, 0xFF, sizeof(table));
+
+	te_u8* out = destination;
+	size_t anchor = 0;
+	size_t position = 0;
+
+	if(size > PACKER_LZ4_MATCH_LIMIT) {
+		size_t matchEnd = size - PACKER_LZ4_MATCH_LIMIT;
+		while(position < matchEnd) {
+			te_u32 sequence = packer_read32(source + position);
+			te_u32 hash = (sequence * 2654435761u) >> (32 - PACKER_LZ4_HASH_BITS);
+			te_u32 candidate = table[hash];
+			table[hash] = (te_u32) position;
+
+			if(candidate == 0xFFFFFFFFu || position - candidate > 0xFFFF || packer_read32(source + candidate) != sequence) {
+				position++;
+				continue;
+			}
+
+			size_t length = PACKER_LZ4_MIN_MATCH;
+			size_t limit = size - PACKER_LZ4_LAST_LITERALS;
+			while(position + length < limit && source[candidate + length] == source[position + length]) { length++; }
+
+			out = packer_lz4WriteSequence(out, source + anchor, position - anchor, position - candidate, length);
+			position += length;
+			anchor = position;
+		}
+	}
+
+	out = packer_lz4WriteSequence(out, source + anchor, size - anchor, 0, 0);
+	return (size_t)(out - destination);
+}
+
+static void packer_compress(packer_asset* asset, te_bool_u8 allowed) {
+	asset->stored = asset->data;
+	asset->storedSize = asset->size;
+	asset->compression = TE_ARCHIVE_RAW;
+	if(!allowed || asset->size < 64) { return; }
+
+	te_u8* compressed = malloc(packer_lz4Bound(asset->size));
+	size_t compressedSize = packer_lz4Compress(asset->data, asset->size, compressed);
+
+	// Keep the round trip honest, a broken archive is worse than a larger one
+	te_u8* check = malloc(asset->size);
+	te_bool_u8 intact = tinyengine_lz4Decompress(compressed, compressedSize, check, asset->size) == asset->size && memcmp(check, asset->data, asset->size) == 0;
+	free(check);
+
+	if(intact && compressedSize <= asset->size - asset->size / 8) {
+		asset->stored = compressed;
+		asset->storedSize = compressedSize;
+		asset->compression = TE_ARCHIVE_LZ4;
+	} else {
+		if(!intact) { fprintf(stderr, "%s: compression round trip failed, stored raw\n", asset->name); }
+		free(compressed);
+	}
+}
+
+//// Archive writer
+
+static size_t packer_align(size_t value, size_t alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static te_bool_u8 packer_write(packer* pack, const char* path) {
+	te_u32 bucketCount = 1;
+	while(bucketCount < pack->count * 2) { bucketCount <<= 1; }
+	if(bucketCount <= pack->count) { bucketCount <<= 1; }
+
+	_tinyengine_archiveEntry* entries = calloc(pack->count ? pack->count : 1, sizeof(_tinyengine_archiveEntry));
+	te_u32* buckets = calloc(bucketCount, sizeof(te_u32));
+
+	size_t namesSize = 0;
+	for(te_u32 i = 0; i < pack->count; i++) { namesSize += strlen(pack->assets[i].name) + 1; }
+	char* names = malloc(namesSize ? namesSize : 1);
+
+	_tinyengine_archiveHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "TEPK", 4);
+	header.version = TE_ARCHIVE_VERSION;
+	header.entryCount = pack->count;
+	header.bucketCount = bucketCount;
+	header.entriesOffset = packer_align(sizeof(header), 16);
+	header.bucketsOffset = packer_align(header.entriesOffset + (size_t) pack->count * sizeof(_tinyengine_archiveEntry), 16);
+	header.namesOffset = header.bucketsOffset + (size_t) bucketCount * sizeof(te_u32);
+	header.namesSize = namesSize;
+
+	size_t nameCursor = 0;
+	size_t dataCursor = packer_align(header.namesOffset + namesSize, 16);
+	size_t end = header.namesOffset + namesSize;
+	for(te_u32 i = 0; i < pack->count; i++) {
+		packer_asset* asset = &pack->assets[i];
+		_tinyengine_archiveEntry* entry = &entries[i];
+		size_t nameLength = strlen(asset->name);
+
+		memcpy(names + nameCursor, asset->name, nameLength + 1);
+		entry->hash = _tinyengine_fnv1a64(TE_FNV1A64_SEED, asset->name, nameLength);
+		entry->nameOffset = (te_u32) nameCursor;
+		entry->nameLength = (te_u16) nameLength;
+		entry->offset = dataCursor;
+		entry->size = (te_u32) asset->size;
+		entry->storedSize = (te_u32) asset->storedSize;
+		entry->compression = asset->compression;
+		nameCursor += nameLength + 1;
+		end = dataCursor + asset->storedSize;
+		dataCursor = packer_align(end, 16);
+
+		te_u32 bucket = (te_u32) entry->hash & (bucketCount - 1);
+		while(buckets[bucket] != 0) { bucket = (bucket + 1) & (bucketCount - 1); }
+		buckets[bucket] = i + 1;
+	}
+
+	te_bool_u8 result = TE_FALSE;
+	FILE* file = fopen(path, "wb");
+	if(file) {
+		static const te_u8 padding[16] = {0};
+		size_t written = 0;
+		written += fwrite(&header, 1, sizeof(header), file);
+		written += fwrite(padding, 1, header.entriesOffset - written, file);
+		written += fwrite(entries, 1, (size_t) pack->count * sizeof(_tinyengine_archiveEntry), file);
+		written += fwrite(padding, 1, header.bucketsOffset - written, file);
+		written += fwrite(buckets, 1, (size_t) bucketCount * sizeof(te_u32), file);
+		written += fwrite(names, 1, namesSize, file);
+		for(te_u32 i = 0; i < pack->count; i++) {
+			written += fwrite(padding, 1, entries[i].offset - written, file);
+			written += fwrite(pack->assets[i].stored, 1, pack->assets[i].storedSize, file);
+		}
+		result = fclose(file) == 0 && written == end;
+	}
+
+	free(entries);
+	free(buckets);
+	free(names);
+	return result;
+}
+
+int main(int argc, char** argv) {
+	packer pack;
+	memset(&pack, 0, sizeof(pack));
+
+	int argument = 1;
+	if(argument < argc && strcmp(argv[argument], "-z") == 0) { pack.compress = TE_TRUE; argument++; }
+	if(argc - argument < 2) { fprintf(stderr, "usage: packer [-z] <archive> <file|directory>...\n"); return 1; }
+
+	const char* output = argv[argument++];
+	for(; argument < argc; argument++) {
+		const char* input = argv[argument];
+		while(input[0] == '.' && input[1] == '/') { input += 2; }
+
+		DIR* directory = opendir(input);
+		te_bool_u8 added;
+		if(directory) {
+			closedir(directory);
+			added = packer_addDirectory(&pack, input, "");
+		} else {
+			added = packer_add(&pack, input, input);
+		}
+		if(!added) { return 1; }
+	}
+
+	size_t rawTotal = 0;
+	size_t storedTotal = 0;
+	for(te_u32 i = 0; i < pack.count; i++) {
+		packer_compress(&pack.assets[i], pack.compress);
+		rawTotal += pack.assets[i].size;
+		storedTotal += pack.assets[i].storedSize;
+	}
+
+	if(!packer_write(&pack, output)) { fprintf(stderr, "%s: could not write\n", output); return 1; }
+
+	printf("%s: %u assets, %zu bytes raw, %zu bytes stored\n", output, pack.count, rawTotal, storedTotal);
+	return 0;
+}
@@ -0,0 +1,233 @@
+#define TE_DEBUG
+#define TE_DEBUG_LEVEL_WARNING
+#include "tinyengine.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// usage: replay [-n loops] <capture.tecp>
+//   Re-issues a capture from _tinyengine_gl3_startCapture() as fast as possible and prints frame time
+//   percentiles in the same JSON shape as bench, so `bench compare` works on two replays of one capture.
+//   Needs a display, use xvfb-run on machines without one.
+
+typedef struct replay_texture_t {
+	te_u32 captured;
+	te_GLuint texture;
+	size_t record; // offset of the contents in the capture, so looping does not upload them again
+} replay_texture;
+
+typedef struct replay_state_t {
+	tinyengine_windowContext* windows[TE_CAPTURE_MAX_WINDOWS];
+	_tinyengine_gl3_bitmapGlyphCache fonts[TE_CAPTURE_MAX_FONTS];
+	replay_texture* textures;
+	te_u32 textureCount;
+
+	te_f64* frameMs;
+	te_u32 frameCount;
+	te_u32 frameCapacity;
+	te_f64 frameStart;
+} replay_state;
+
+static tinyengine_windowContext* replay_window(replay_state* state, te_u32 index) {
+	if(index >= TE_CAPTURE_MAX_WINDOWS) { return NULL; }
+	if(state->windows[index]) { return state->windows[index]; }
+
+	tinyengine_windowContext* window = tinyengine_createWindow();
+	if(!window) { return NULL; }
+	tinyengine_setWindowTitle(window,"tinyengine replay");
+	tinyengine_setWindowSize(window,1280,720);
+	tinyengine_showWindow(window);
+	tinyengine_makeCurrent(window);
+	if(!_tinyengine_gl3_init() || !_tinyengine_gl3_createWindowRenderContext(window)) { return NULL; }
+	_tinyengine_gl3_updateView(window,1280,720);
+
+	state->windows[index] = window;
+	return window;
+}
+
+static te_GLuint replay_lookupTexture(replay_state* state, te_u32 captured) {
+	for(te_u32 i = 0; i < state->textureCount; i++) {
+		if(state->textures[i].captured == captured) { return state->textures[i].texture; }
+	}
+	return 0;
+}
+
+// Captured pixels are premultiplied already, so they go up as they are. A texture recorded again under a name
+// seen before was reloaded or updated, its contents are replaced in place so fonts referring to it follow.
+static void replay_uploadTexture(replay_state* state, te_u32 captured, te_u32 width, te_u32 height, const te_u8* pixels, size_t record) {
+	replay_texture* entry = NULL;
+	for(te_u32 i = 0; i < state->textureCount; i++) {
+		if(state->textures[i].captured == captured) { entry = &state->textures[i]; break; }
+	}
+	if(entry == NULL) {
+		state->textures = realloc(state->textures, (state->textureCount + 1) * sizeof(replay_texture));
+		entry = &state->textures[state->textureCount++];
+		entry->captured = captured;
+		entry->texture = 0;
+	} else if(entry->record == record) {
+		return;
+	}
+	entry->record = record;
+	if(!width || !height) { return; }
+
+	if(entry->texture == 0) { te_gl3.glGenTextures(1, &entry->texture); }
+	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, entry->texture);
+	te_gl3.glTexImage2D(TE_GL_TEXTURE_2D, 0, TE_GL_RGBA, width, height, 0, TE_GL_RGBA, TE_GL_UNSIGNED_BYTE, pixels);
+	te_gl3.glGenerateMipmap(TE_GL_TEXTURE_2D);
+}
+
+static void replay_endFrame(replay_state* state, tinyengine_windowContext* window) {
+	_tinyengine_gl3_endFrame(window);
+	glFinish();
+	if(state->frameCount == state->frameCapacity) {
+		state->frameCapacity = state->frameCapacity ? state->frameCapacity * 2 : 1024;
+		state->frameMs = realloc(state->frameMs, state->frameCapacity * sizeof(te_f64));
+	}
+	state->frameMs[state->frameCount++] = (tinyengine_getTime() - state->frameStart) * 1000.0;
+	tinyengine_swapBuffers(window);
+	tinyengine_pollEvents();
+}
+
+// Runs every record once, returns false on a malformed capture
+static te_bool_u8 replay_run(replay_state* state, const te_u8* data, size_t size) {
+	size_t offset = sizeof(_tinyengine_gl3_captureHeader);
+	while(offset < size) {
+		if(size - offset < 2) { return TE_FALSE; }
+		te_u8 opcode = data[offset];
+		te_u8 windowIndex = data[offset + 1];
+		if(opcode == 0 || opcode >= TE_CAPTURE_OPCODE_COUNT) { fprintf(stderr, "unknown opcode %u at %zu\n", opcode, offset); return TE_FALSE; }
+		offset += 2;
+
+		_tinyengine_captureWord words[16];
+		size_t wordBytes = TE_CAPTURE_WORDS[opcode] * sizeof(_tinyengine_captureWord);
+		if(size - offset < wordBytes) { return TE_FALSE; }
+		memcpy(words, data + offset, wordBytes);
+		offset += wordBytes;
+
+		// Commands without a window still carry index 0, only look it up when needed
+		tinyengine_windowContext* window = NULL;
+		if(opcode != TE_CAPTURE_TEXTURE && opcode != TE_CAPTURE_FONT) {
+			window = replay_window(state, windowIndex);
+			if(!window) { return TE_FALSE; }
+		}
+
+		switch(opcode) {
+			case TE_CAPTURE_FRAME_START:
+				state->frameStart = tinyengine_getTime();
+				_tinyengine_gl3_startFrame(window);
+				break;
+			case TE_CAPTURE_FRAME_END:
+				replay_endFrame(state, window);
+				break;
+			case TE_CAPTURE_VIEW:
+				tinyengine_setWindowSize(window, words[0].u, words[1].u);
+				_tinyengine_gl3_updateView(window, words[0].u, words[1].u);
+				break;
+			case TE_CAPTURE_CAMERA:
+				_tinyengine_gl3_setCamera(window, words[0].f, words[1].f, words[2].f, words[3].f);
+				break;
+			case TE_CAPTURE_WORLD_SPACE:
+				_tinyengine_gl3_setWorldSpace(window, (te_bool_u8) words[0].u);
+				break;
+			case TE_CAPTURE_RECTANGLE:
+				_tinyengine_gl3_drawRectangle2D(window, words[0].f, words[1].f, words[2].f, words[3].f, (te_v4_f32){ words[4].f, words[5].f, words[6].f, words[7].f });
+				break;
+			case TE_CAPTURE_SPRITE:
+				_tinyengine_gl3_drawSpriteTinted(window, replay_lookupTexture(state, words[0].u), words[1].f, words[2].f, words[3].f, words[4].f, words[5].f,
+					words[6].f, words[7].f, words[8].f, words[9].f, (te_v4_f32){ words[10].f, words[11].f, words[12].f, words[13].f });
+				break;
+			case TE_CAPTURE_TEXT: {
+				te_u32 length = words[7].u;
+				if(size - offset < length) { return TE_FALSE; }
+				char text[1024];
+				if(length >= sizeof(text)) { length = sizeof(text) - 1; }
+				memcpy(text, data + offset, length);
+				text[length] = '\0';
+				offset += words[7].u;
+				if(words[0].u >= TE_CAPTURE_MAX_FONTS) { break; } // the capture ran out of font slots
+				_tinyengine_gl3_drawText(window, &state->fonts[words[0].u], text, words[1].f, words[2].f, words[3].f, (te_v3_f32){ words[4].f, words[5].f, words[6].f });
+				break;
+			}
+			case TE_CAPTURE_TEXTURE: {
+				size_t pixelBytes = (size_t) words[1].u * words[2].u * 4;
+				if(size - offset < pixelBytes) { return TE_FALSE; }
+				if(!state->windows[0] && !replay_window(state, 0)) { return TE_FALSE; } // textures need a context
+				replay_uploadTexture(state, words[0].u, words[1].u, words[2].u, data + offset, offset);
+				offset += pixelBytes;
+				break;
+			}
+			case TE_CAPTURE_FONT: {
+				_tinyengine_gl3_bitmapGlyphCache* font = &state->fonts[words[0].u < TE_CAPTURE_MAX_FONTS ? words[0].u : 0];
+				if(size - offset < sizeof(font->characterData)) { return TE_FALSE; }
+				memcpy(font->characterData, data + offset, sizeof(font->characterData));
+				font->resolution = words[1].u;
+				font->textureID = replay_lookupTexture(state, words[2].u);
+				offset += sizeof(font->characterData);
+				break;
+			}
+		}
+	}
+	return TE_TRUE;
+}
+
+static int replay_compareDouble(const void* a, const void* b) {
+	te_f64 x = *(const te_f64*) a, y = *(const te_f64*) b;
+	return (x > y) - (x < y);
+}
+
+static te_f64 replay_percentile(const te_f64* sorted, te_u32 count, te_f64 percent) {
+	te_u32 rank = (te_u32) ceil(percent / 100.0 * count);
+	return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+int main(int argc, char** argv) {
+	te_u32 loops = 1;
+	int argument = 1;
+	if(argument + 1 < argc && strcmp(argv[argument], "-n") == 0) {
+		loops = atoi(argv[argument + 1]) > 0 ? (te_u32) atoi(argv[argument + 1]) : 1;
+		argument += 2;
+	}
+	if(argc - argument != 1) { fprintf(stderr, "usage: replay [-n loops] <capture.tecp>\n"); return 1; }
+	const char* path = argv[argument];
+
+	tinyengine_mappedFile file;
+	if(!tinyengine_mapFile(path, &file)) { return 1; }
+
+	const _tinyengine_gl3_captureHeader* header = (const _tinyengine_gl3_captureHeader*) file.data;
+	if(file.size < sizeof(*header) || memcmp(header->magic, "TECP", 4) != 0 || header->version != TE_CAPTURE_VERSION) {
+		fprintf(stderr, "%s: not a capture or wrong version\n", path);
+		return 1;
+	}
+
+	if(!tinyengine_init()) { return 1; }
+
+	replay_state state;
+	memset(&state, 0, sizeof(state));
+
+	te_u32 drawCalls = 0;
+	te_u64 bytes = 0;
+	for(te_u32 loop = 0; loop < loops; loop++) {
+		// The first pass also uploads every texture, so it is left out of the numbers when looping
+		if(loop == 1) {
+			state.frameCount = 0;
+			drawCalls = te_gl3_state.batchDrawCalls;
+			bytes = te_gl3_state.batchBytes;
+		}
+		if(!replay_run(&state, file.data, file.size)) { fprintf(stderr, "%s: truncated or corrupt capture\n", path); return 1; }
+	}
+
+	if(state.frameCount > 0) {
+		qsort(state.frameMs, state.frameCount, sizeof(te_f64), replay_compareDouble);
+		printf("{\"scene\":\"replay\",\"capture\":\"%s\",\"frames\":%u,\"frame_ms_p50\":%.4f,\"frame_ms_p90\":%.4f,\"frame_ms_p99\":%.4f,\"frame_ms_max\":%.4f,\"draw_calls\":%u,\"bytes_uploaded_per_frame\":%llu}\n",
+			path, state.frameCount, replay_percentile(state.frameMs, state.frameCount, 50.0), replay_percentile(state.frameMs, state.frameCount, 90.0),
+			replay_percentile(state.frameMs, state.frameCount, 99.0), state.frameMs[state.frameCount - 1],
+			(te_gl3_state.batchDrawCalls - drawCalls) / state.frameCount, (unsigned long long)((te_gl3_state.batchBytes - bytes) / state.frameCount));
+	}
+
+	free(state.frameMs);
+	free(state.textures);
+	tinyengine_unmapFile(&file);
+	tinyengine_terminate();
+	return 0;
+}
@@ -61,6 +61,20 @@ extern "C" {
 
 /* END COMPILE TIME PLATFORM DETECTION */
 
+/* COMPILE TIME SIMD DETECTION */
+
+// Optional vector paths, define TE_NO_SIMD to force the scalar code
+#if !defined(TE_NO_SIMD)
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define TE_SSE2
+	#endif
+	#if defined(__SSSE3__)
+		#define TE_SSSE3
+	#endif
+#endif
+
+/* END COMPILE TIME SIMD DETECTION */
+
 /* STANDARD TYPE DEFINITIONS */
 
 #include <stdint.h>
@@ -111,6 +125,10 @@ typedef struct te_vector2_f32		te_v2_f32;
 	#define TE_PTHREADS
 #endif
 
+#if defined(TE_PTHREADS)
+	#include <pthread.h> // pthread_t; pthread_mutex_t; pthread_cond_t;
+#endif
+
 /* END THREADING HEADER */
 
 /* NVIDIA OPTIMUS SELECT MAGIC NUMBER */
@@ -201,6 +219,9 @@ typedef struct te_vector2_f32		te_v2_f32;
 	typedef struct _tinyengine_platformWindowContext_t {
 		Window			x11WindowID;
 		GLXContext	glxContext;
+		Colormap		colormap;
+		te_u32			width;
+		te_u32			height;
 	} _tinyengine_platformWindowContext;
 
 #elif defined(TE_WIN32)
@@ -226,20 +247,58 @@ typedef struct te_vector2_f32		te_v2_f32;
 #endif
 
 #if defined(TE_WIN32) || defined(TE_LINUX)
+ #define TE_UPSCALE_BILINEAR 0
+ #define TE_UPSCALE_SHARPEN 1
+
+ #define TE_RESOLUTION_QUERIES 4
+
+ // Offscreen target whose size follows the measured frame time, see _tinyengine_gl3_setDynamicResolution()
+ typedef struct _tinyengine_dynamicResolution_t {
+	 te_f32 targetMs; // 0 when off
+	 te_f32 minScale;
+	 te_f32 maxScale;
+	 te_u32 filter;
+	 te_f32 sharpness;
+
+	 te_f32 scale; // of the next frame
+	 te_f32 frameMs; // smoothed scene time the scale is adjusted against
+	 te_bool_u8 active; // the current frame draws offscreen
+
+	 te_u32 target; // pooled render target holding the view at the largest scale
+	 te_u32 renderWidth;
+	 te_u32 renderHeight;
+
+	 // GPU time of the scene with timer queries, otherwise the interval between frames
+	 te_u32 queries[TE_RESOLUTION_QUERIES];
+	 te_u32 issued;
+	 te_u32 collected;
+	 te_f64 lastFrameStart;
+ } _tinyengine_dynamicResolution;
+
+ // Shaders and buffers live in the shared gl3 state, VAOs are container objects so each window keeps its own
  typedef struct _tinyengine_render2DWindowContext_t {
-	 te_f32 projectionMatrix[16];
+	 te_f32 projectionMatrix[16]; // screen or camera, whichever space draws use
+
+	 // Camera centre and zoom for world space, see _tinyengine_gl3_setCamera()
+	 te_f32 cameraX;
+	 te_f32 cameraY;
+	 te_f32 cameraZoom; // 0 until a camera is set, world space is then screen space
+	 te_f32 cameraRotation;
+	 te_bool_u8 worldSpace;
 
-	 te_u32 textShader;
-	 te_u32 textVAO;
-	 te_u32 textVBO;
+	 // Area the projection shows, in the current space, for culling
+	 te_u32 viewWidth;
+	 te_u32 viewHeight;
+	 te_f32 visibleX0, visibleY0;
+	 te_f32 visibleX1, visibleY1;
 
-	 te_u32 spriteShader;
-	 te_u32 spriteVBO;
-	 te_u32 spriteVAO;
+	 te_u32 batchVAO;
+	 te_u32 layerVAO; // created with the window's first layered pass
 
-	 te_u32 flatShader;
-	 te_u32 flatVBO;
-	 te_u32 flatVAO;
+	 // Screen and world projection blocks, when uniform buffers are available
+	 te_u32 viewBuffer;
+
+	 _tinyengine_dynamicResolution resolution;
  } _tinyengine_render2DWindowContext;
 #else
 typedef struct _tinyengine_render2DWindowContext_t {
@@ -247,7 +306,83 @@ typedef struct _tinyengine_render2DWindowContext_t {
 } _tinyengine_render2DWindowContext;
 #endif
 
+// Generational handle: low 16 bits are the registry slot, high 16 bits the slot generation. 0 is never valid.
+typedef te_u32 tinyengine_windowHandle;
+
+// Frames of damage kept to bring older back buffers up to date, ages beyond this redraw everything
+#ifndef TE_DAMAGE_HISTORY
+	#define TE_DAMAGE_HISTORY 4
+#endif
+
+// Window pixels, top left origin, empty when x1 <= x0 or y1 <= y0
+typedef struct _tinyengine_damageRect_t {
+	te_i32 x0, y0;
+	te_i32 x1, y1;
+} _tinyengine_damageRect;
+
+// See tinyengine_setDamageTracking()
+typedef struct _tinyengine_windowDamage_t {
+	te_bool_u8 enabled;
+	te_bool_u8 partialPresent;
+	te_bool_u8 backBufferCurrent; // the last present copied a region, so the back buffer still holds that frame
+	te_u32 width; // view size, set by the renderer
+	te_u32 height;
+	te_u32 framesTracked;
+	_tinyengine_damageRect pending; // reported since the renderer started the current frame, repainted next frame
+	_tinyengine_damageRect frame; // taken from pending when the current frame started, goes to history on present
+	_tinyengine_damageRect history[TE_DAMAGE_HISTORY]; // damage of previous frames, most recent first
+	_tinyengine_damageRect redraw; // area repainted this frame
+} _tinyengine_windowDamage;
+
+// 1 ms buckets of input to present latency, the last one also counts everything longer
+#ifndef TE_LATENCY_BUCKETS
+	#define TE_LATENCY_BUCKETS 64
+#endif
+
+// Swaps waiting for their present time, must be a power of two
+#define TE_LATENCY_PENDING 8
+
+// Where present times come from, best last
+#define TE_PRESENT_TIME_SWAP_CALL 0 // when the swap call returned, the frame is on screen some time after
+#define TE_PRESENT_TIME_SYNC_CONTROL 1 // GLX_OML_sync_control
+#define TE_PRESENT_TIME_SWAP_EVENT 2 // GLX_INTEL_swap_event
+
+typedef struct _tinyengine_latencySwap_t {
+	te_u64 swap; // swap count this present completes, the GLX swap buffer count (SBC)
+	te_f64 input; // oldest input event the frame consumed
+	te_f64 swapTime; // when the swap was issued, in case no present time ever comes
+} _tinyengine_latencySwap;
+
+// See tinyengine_getLatencyStats()
+typedef struct _tinyengine_windowLatency_t {
+	te_f64 oldestInput; // earliest input since the last present, 0 when none
+	te_u64 swaps;
+	_tinyengine_latencySwap pending[TE_LATENCY_PENDING];
+	te_u32 pendingHead;
+	te_u32 pendingTail;
+
+	te_u32 histogram[TE_LATENCY_BUCKETS];
+	te_u32 frames;
+	te_f64 totalMs;
+	te_f64 maxMs;
+	te_f64 lastMs;
+	te_u8 source;
+} _tinyengine_windowLatency;
+
+// Presented frames that consumed input, each measured from its oldest input event to the present
+typedef struct tinyengine_latencyStats_t {
+	te_u32 frames;
+	te_f64 lastMs;
+	te_f64 meanMs;
+	te_f64 p50Ms; // upper edge of the bucket
+	te_f64 p99Ms;
+	te_f64 maxMs;
+	te_u8 source; // TE_PRESENT_TIME_*, of the last frame
+	te_u32 histogram[TE_LATENCY_BUCKETS];
+} tinyengine_latencyStats;
+
 typedef struct tinyengine_windowContext_t{
+	tinyengine_windowHandle handle;
 	te_bool_u8 closeRequested;
 	void(*characterCallback)(struct tinyengine_windowContext_t*,te_u32);
 	void(*keyCallback)(struct tinyengine_windowContext_t*,te_i32,te_i32,te_i32);
@@ -255,6 +390,8 @@ typedef struct tinyengine_windowContext_t{
 	void(*closeCallback)(struct tinyengine_windowContext_t*);
 	_tinyengine_platformWindowContext platform;
 	_tinyengine_render2DWindowContext render2D;
+	_tinyengine_windowDamage damage;
+	_tinyengine_windowLatency latency;
 } tinyengine_windowContext;
 
 typedef void (*tinyengine_windowCharacterCallback)(tinyengine_windowContext*,te_u32);
@@ -262,6 +399,240 @@ typedef void (*tinyengine_windowKeyCallback)(tinyengine_windowContext*,te_i32,te
 typedef void (*tinyengine_windowFrameCallback)(tinyengine_windowContext*,te_f64,te_u32,te_u32);
 typedef void (*tinyengine_windowCloseCallback)(tinyengine_windowContext*);
 
+// Events are translated from the window system into this compact form and
+// queued in a preallocated ring, see tinyengine_pollEvents()
+
+#define TE_RELEASE 0
+#define TE_PRESS 1
+
+typedef enum tinyengine_eventType_t {
+	TE_EVENT_NONE = 0,
+	TE_EVENT_KEY,
+	TE_EVENT_CHARACTER,
+	TE_EVENT_RESIZE,
+	TE_EVENT_CLOSE,
+	TE_EVENT_MOUSE_MOVE,
+	TE_EVENT_MOUSE_BUTTON,
+	TE_EVENT_FOCUS
+} tinyengine_eventType;
+
+typedef struct tinyengine_event_t {
+	te_u8 type;
+	tinyengine_windowContext* window;
+	te_f64 time; // tinyengine_getTime() base, when the window system says it happened or else when it was translated
+	union {
+		struct { te_i32 key; te_i32 scancode; te_i32 action; } key;
+		struct { te_u32 codepoint; } character;
+		struct { te_u32 width; te_u32 height; } resize;
+		struct { te_i32 x; te_i32 y; } mouseMove;
+		struct { te_i32 button; te_i32 action; te_i32 x; te_i32 y; } mouseButton;
+		struct { te_bool_u8 focused; } focus;
+	};
+} tinyengine_event;
+
+// Read only view of a whole file, see tinyengine_mapFile()
+typedef struct tinyengine_mappedFile_t {
+	const te_u8* data;
+	size_t size;
+	void* platformFile;
+	void* platformMapping;
+} tinyengine_mappedFile;
+
+#define TE_TEXTURE_FORMAT_RGBA8 0
+#define TE_TEXTURE_FORMAT_BC1 1 // 1 bit alpha
+#define TE_TEXTURE_FORMAT_BC3 2
+#define TE_TEXTURE_FORMAT_ETC2_RGB8 3
+#define TE_TEXTURE_FORMAT_ETC2_RGBA8 4
+
+#define TE_COOKED_TEXTURE_MAX_LEVELS 17
+
+// Parsed cooked texture, the levels point into the container memory
+typedef struct tinyengine_cookedTexture_t {
+	te_u32 format;
+	te_u32 width;
+	te_u32 height;
+	te_u32 levelCount;
+	te_bool_u8 premultiplied;
+	const te_u8* levels[TE_COOKED_TEXTURE_MAX_LEVELS];
+	size_t levelSizes[TE_COOKED_TEXTURE_MAX_LEVELS];
+} tinyengine_cookedTexture;
+
+// Open asset archive, see tinyengine_openArchive()
+typedef struct tinyengine_archive_t {
+	tinyengine_mappedFile file;
+	const te_u8* entries;
+	const te_u32* buckets;
+	const char* names;
+	te_u64 namesSize;
+	te_u32 entryCount;
+	te_u32 bucketMask;
+} tinyengine_archive;
+
+// Points into the archive mapping, valid until the archive is closed
+typedef struct tinyengine_asset_t {
+	const char* name;
+	const te_u8* data; // compressed when compression is not TE_ARCHIVE_RAW, see tinyengine_readAsset()
+	size_t size;
+	size_t storedSize;
+	te_u8 compression;
+} tinyengine_asset;
+
+typedef struct _tinyengine_spatialEntry_t {
+	te_f32 x0, y0, x1, y1;
+	te_u32 value;
+	te_u32 item;
+} _tinyengine_spatialEntry;
+
+typedef struct _tinyengine_spatialCell_t {
+	te_i32 x, y;
+	_tinyengine_spatialEntry* entries;
+	te_u32 count;
+	te_u32 capacity;
+} _tinyengine_spatialCell;
+
+typedef struct _tinyengine_spatialItem_t {
+	te_u32 cell; // cell index + 1, 0 for a free slot
+	te_u32 index; // entry within the cell, next free slot + 1 when free
+} _tinyengine_spatialItem;
+
+// Loose uniform grid of world space rectangles, see tinyengine_createSpatialGrid()
+typedef struct tinyengine_spatialGrid_t {
+	te_f32 cellSize;
+	te_f32 inverseCellSize;
+	te_f32 maxWidth; // largest item so far, queries reach back this far
+	te_f32 maxHeight;
+
+	_tinyengine_spatialCell* cells;
+	te_u32 cellCount;
+	te_u32 cellCapacity;
+	te_u32* buckets; // cell index + 1, 0 is empty
+	te_u32 bucketMask;
+
+	_tinyengine_spatialItem* items;
+	te_u32 itemCount; // slots ever handed out
+	te_u32 itemCapacity;
+	te_u32 freeItem; // slot + 1, 0 when none
+	te_u32 length;
+} tinyengine_spatialGrid;
+
+// Entity handle: low 24 bits are the slot + 1, high 8 bits the slot generation. 0 is never valid.
+typedef te_u32 tinyengine_entity;
+
+#define TE_MAX_ENTITIES 0xFFFFFE
+#define TE_MAX_COMPONENTS 64
+
+// Storage unit of an archetype, one allocation holding an array per component
+#ifndef TE_ENTITY_CHUNK_BYTES
+	#define TE_ENTITY_CHUNK_BYTES (16 * 1024)
+#endif
+
+typedef te_u64 tinyengine_componentMask;
+#define TE_COMPONENT(_id) ((tinyengine_componentMask) 1 << (_id))
+
+// Registered by every world, drawn by _tinyengine_gl3_drawEntities()
+#define TE_COMPONENT_TRANSFORM 0
+#define TE_COMPONENT_SPRITE 1
+
+typedef struct tinyengine_transform_t {
+	te_f32 x;
+	te_f32 y;
+	te_f32 scale; // of the sprite size
+} tinyengine_transform;
+
+// Already in the batch vertex format, see tinyengine_setSprite()
+typedef struct tinyengine_sprite_t {
+	te_u32 texture;
+	te_f32 width;
+	te_f32 height;
+	te_u16 u0, v0;
+	te_u16 u1, v1;
+	te_u8 color[4];
+} tinyengine_sprite;
+
+typedef struct _tinyengine_entityChunk_t {
+	te_u8* data; // entity handles, then one array per component in the archetype
+	te_u32 count;
+} _tinyengine_entityChunk;
+
+// Every entity with exactly the same components. Chunks are kept full except for the last.
+typedef struct _tinyengine_archetype_t {
+	tinyengine_componentMask mask;
+	te_u32 chunkCapacity; // entities per chunk
+	te_u32 chunkBytes;
+	te_u32 offsets[TE_MAX_COMPONENTS]; // of each component array in a chunk, by component id
+	_tinyengine_entityChunk* chunks;
+	te_u32 chunkCount;
+	te_u32 chunksAllocated;
+	te_u32 length;
+} _tinyengine_archetype;
+
+typedef struct _tinyengine_entitySlot_t {
+	te_u32 archetype; // index + 1, 0 for a free slot
+	te_u32 chunk; // next free slot + 1 when free
+	te_u32 row;
+	te_u8 generation;
+} _tinyengine_entitySlot;
+
+// Entities in one chunk, the arrays stay valid until entities are created, destroyed or change components
+typedef struct tinyengine_entityChunk_t {
+	const _tinyengine_archetype* archetype;
+	te_u8* data;
+	const tinyengine_entity* entities;
+	te_u32 count;
+} tinyengine_entityChunk;
+
+// Chunks of every archetype with all of include and none of exclude, see tinyengine_nextEntityChunk()
+typedef struct tinyengine_entityQuery_t {
+	tinyengine_componentMask include;
+	tinyengine_componentMask exclude;
+	te_u32 archetype;
+	te_u32 chunk;
+} tinyengine_entityQuery;
+
+struct tinyengine_world_t;
+typedef void (*tinyengine_systemFunction)(struct tinyengine_world_t* world, const tinyengine_entityChunk* chunk, void* user);
+
+// Runs once per matching chunk. include must name every component the system reads.
+typedef struct tinyengine_system_t {
+	tinyengine_componentMask include;
+	tinyengine_componentMask exclude;
+	tinyengine_componentMask writes; // subset of include
+	tinyengine_systemFunction function;
+	void* user;
+} tinyengine_system;
+
+typedef struct _tinyengine_entityWork_t {
+	te_u32 system;
+	te_u32 archetype;
+	te_u32 chunk;
+} _tinyengine_entityWork;
+
+// Archetype entity storage, see tinyengine_createWorld()
+typedef struct tinyengine_world_t {
+	te_u32 componentSizes[TE_MAX_COMPONENTS]; // 0 for ids not registered
+	te_u32 componentCount;
+
+	_tinyengine_archetype* archetypes;
+	te_u32 archetypeCount;
+	te_u32 archetypeCapacity;
+
+	_tinyengine_entitySlot* slots;
+	te_u32 slotCount; // slots ever handed out
+	te_u32 slotCapacity;
+	te_u32 freeSlot; // slot + 1, 0 when none
+	te_u32 length;
+
+	_tinyengine_entityWork* work;
+	te_u32 workCapacity;
+	te_u32 threadCount; // including the calling thread
+	struct _tinyengine_entityWorkers_t* workers; // started on the first parallel run
+} tinyengine_world;
+
+// Must be a power of two
+#ifndef TE_EVENT_QUEUE_CAPACITY
+	#define TE_EVENT_QUEUE_CAPACITY 1024
+#endif
+
 /* END ENGINE STRUCTURE DEF */
 
 /* ENGINE FUNCTION DEF */
@@ -269,6 +640,72 @@ typedef void (*tinyengine_windowCloseCallback)(tinyengine_windowContext*);
 te_bool_u8	tinyengine_init();
 void				tinyengine_terminate();
 
+void				tinyengine_pollEvents();
+void				tinyengine_dispatchEvents();
+te_u32			tinyengine_drainEvents(tinyengine_event* events, te_u32 maxEvents);
+
+void				tinyengine_setManualEventDrain(te_bool_u8 enabled);
+
+te_bool_u8	tinyengine_recordInput(const char* path);
+te_bool_u8	tinyengine_replayInput(const char* path);
+void				tinyengine_stopInputLog();
+te_bool_u8	tinyengine_isReplayingInput();
+te_u32			tinyengine_getInputFrame();
+
+tinyengine_windowContext*	tinyengine_getWindow(tinyengine_windowHandle handle);
+
+void				tinyengine_setDamageTracking(tinyengine_windowContext* window, te_bool_u8 enabled);
+void				tinyengine_setPartialPresent(tinyengine_windowContext* window, te_bool_u8 enabled);
+void				tinyengine_addWindowDamage(tinyengine_windowContext* window, te_i32 x, te_i32 y, te_i32 width, te_i32 height);
+void				tinyengine_damageWindow(tinyengine_windowContext* window);
+te_bool_u8	tinyengine_getRedrawRect(tinyengine_windowContext* window, te_i32* x, te_i32* y, te_i32* width, te_i32* height);
+
+void				tinyengine_getLatencyStats(tinyengine_windowContext* window, tinyengine_latencyStats* stats);
+void				tinyengine_resetLatencyStats(tinyengine_windowContext* window);
+
+te_f64			tinyengine_getTime();
+
+te_bool_u8	tinyengine_mapFile(const char* path, tinyengine_mappedFile* file);
+void				tinyengine_unmapFile(tinyengine_mappedFile* file);
+
+te_bool_u8	tinyengine_imageInfo(const te_u8* data, size_t size, te_u32* width, te_u32* height);
+size_t			tinyengine_imageDecodeSize(const te_u8* data, size_t size);
+te_bool_u8	tinyengine_decodeImage(const te_u8* data, size_t size, te_u8* pixels, size_t pixelsSize);
+void				tinyengine_premultiplyAlpha(te_u8* pixels, size_t count);
+
+size_t			tinyengine_textureLevelSize(te_u32 format, te_u32 width, te_u32 height);
+te_bool_u8	tinyengine_parseCookedTexture(const te_u8* data, size_t size, tinyengine_cookedTexture* texture);
+
+te_bool_u8	tinyengine_openArchive(const char* path, tinyengine_archive* archive);
+void				tinyengine_closeArchive(tinyengine_archive* archive);
+te_bool_u8	tinyengine_findAsset(const tinyengine_archive* archive, const char* name, tinyengine_asset* asset);
+te_u32			tinyengine_getAssetCount(const tinyengine_archive* archive);
+te_bool_u8	tinyengine_getAssetByIndex(const tinyengine_archive* archive, te_u32 index, tinyengine_asset* asset);
+te_bool_u8	tinyengine_readAsset(const tinyengine_asset* asset, te_u8* destination, size_t destinationSize);
+size_t			tinyengine_lz4Decompress(const te_u8* source, size_t sourceSize, te_u8* destination, size_t destinationSize);
+
+te_bool_u8	tinyengine_createSpatialGrid(tinyengine_spatialGrid* grid, te_f32 cellSize);
+void				tinyengine_destroySpatialGrid(tinyengine_spatialGrid* grid);
+te_u32			tinyengine_insertSpatialItem(tinyengine_spatialGrid* grid, te_f32 x, te_f32 y, te_f32 width, te_f32 height, te_u32 value);
+void				tinyengine_moveSpatialItem(tinyengine_spatialGrid* grid, te_u32 item, te_f32 x, te_f32 y, te_f32 width, te_f32 height);
+void				tinyengine_removeSpatialItem(tinyengine_spatialGrid* grid, te_u32 item);
+te_u32			tinyengine_querySpatialGrid(const tinyengine_spatialGrid* grid, te_f32 x, te_f32 y, te_f32 width, te_f32 height, te_u32* values, te_u32 maxValues);
+
+te_bool_u8	tinyengine_createWorld(tinyengine_world* world, te_u32 threadCount);
+void				tinyengine_destroyWorld(tinyengine_world* world);
+te_bool_u8	tinyengine_registerComponent(tinyengine_world* world, te_u32 size, te_u32* component);
+tinyengine_entity	tinyengine_createEntity(tinyengine_world* world, tinyengine_componentMask components);
+void				tinyengine_destroyEntity(tinyengine_world* world, tinyengine_entity entity);
+te_bool_u8	tinyengine_isEntityAlive(const tinyengine_world* world, tinyengine_entity entity);
+te_bool_u8	tinyengine_addComponents(tinyengine_world* world, tinyengine_entity entity, tinyengine_componentMask components);
+te_bool_u8	tinyengine_removeComponents(tinyengine_world* world, tinyengine_entity entity, tinyengine_componentMask components);
+void*				tinyengine_getComponent(const tinyengine_world* world, tinyengine_entity entity, te_u32 component);
+void				tinyengine_beginEntityQuery(tinyengine_entityQuery* query, tinyengine_componentMask include, tinyengine_componentMask exclude);
+te_bool_u8	tinyengine_nextEntityChunk(const tinyengine_world* world, tinyengine_entityQuery* query, tinyengine_entityChunk* chunk);
+void*				tinyengine_getChunkComponents(const tinyengine_entityChunk* chunk, te_u32 component);
+void				tinyengine_runSystems(tinyengine_world* world, const tinyengine_system* systems, te_u32 systemCount);
+void				tinyengine_setSprite(tinyengine_sprite* sprite, te_u32 texture, te_f32 textureWidth, te_f32 textureHeight, te_f32 x, te_f32 y, te_f32 width, te_f32 height);
+
 /* END ENGINE FUNCTION DEF */
 
 /* ENGINE IMPLEMENTATION */
@@ -288,32 +725,76 @@ void				tinyengine_terminate();
 
 		Atom wm_size_hints;
 		Atom wm_delete_window;
-		XContext windowPointerContextID;
+		// Open addressing table from X11 window id to window registry slot, 0 marks an empty bucket
+		Window* windowTableKeys;
+		te_u16* windowTableSlots;
+		te_u32 windowTableCapacity;
+		te_u32 windowTableLength;
+
+		// Consecutive events almost always target the same window
+		Window lastWindowID;
+		struct tinyengine_windowContext_t* lastWindowContext;
 
 		te_bool_u8 trapErrors;
 		te_bool_u8 errorCaught;
 		te_u8 lastErrorCode;
 		int (*nativeErrorHandler)(Display *, XErrorEvent *);
 
+		// Every window uses the same visual, so one context is made current on each of them in turn
+		GLXContext sharedContext;
+
+		// Damage tracking, see tinyengine_setDamageTracking()
+		te_bool_u8 hasBufferAge;
+		void (*glXCopySubBufferMESA)(Display*, GLXDrawable, int, int, int, int);
+
+		// Present times, see tinyengine_getLatencyStats()
+		int swapCompleteEvent; // event type of GLX_INTEL_swap_event, 0 without it
+		Bool (*glXGetSyncValuesOML)(Display*, GLXDrawable, int64_t*, int64_t*, int64_t*);
+		Bool (*glXWaitForSbcOML)(Display*, GLXDrawable, int64_t, int64_t*, int64_t*, int64_t*);
+
 	}	tinyengine_x11_state;
 #elif defined(TE_WIN32)
 	// TODO: Should this string be moved into the state?
 	const char* tinyengine_win32_className = "tinyengineWin32";
 	typedef struct tinyengine_win32_state_t {
-		te_u8 _nothing; // TODO: included to avoid empty struct errors for now
+		// Every window uses the same pixel format, so one context is made current on each of them in turn
+		HGLRC sharedContext;
 	} tinyengine_win32_state;
 #endif
 
-typedef struct tinyengine_windowContextList_node_t{
-	tinyengine_windowContext* value;
-	struct tinyengine_windowContextList_node_t* next;
-} tinyengine_windowContextList_node;
-
-typedef struct {
-	tinyengine_windowContextList_node* head;
-	tinyengine_windowContextList_node* tail;
-	size_t length;
-} tinyengine_windowContextList;
+#define TE_MAX_WINDOWS 0xFFFF
+
+// Slot map of every live window, freed slots are recycled with a bumped generation
+typedef struct tinyengine_windowRegistry_t {
+	tinyengine_windowContext** windows; // NULL for free slots
+	te_u16* generations;
+	te_u16* freeSlots;
+	te_u32 freeLength;
+	te_u32 capacity; // slots ever handed out
+	te_u32 allocated;
+	te_u32 length; // live windows
+} tinyengine_windowRegistry;
+
+typedef struct tinyengine_eventQueue_t {
+	tinyengine_event events[TE_EVENT_QUEUE_CAPACITY];
+	te_u32 head; // read cursor, masked on access
+	te_u32 tail; // write cursor, masked on access
+	te_u32 dropped;
+	te_bool_u8 manualDrain;
+} tinyengine_eventQueue;
+
+// See tinyengine_recordInput() and tinyengine_replayInput()
+#include <stdio.h> // FILE
+
+typedef struct _tinyengine_inputLog_t {
+	FILE* recording;
+	tinyengine_mappedFile replay;
+	size_t replayOffset;
+	te_bool_u8 replaying;
+	te_bool_u8 injecting;
+	te_u32 frame; // polls since recording or replay started
+	te_f64 start;
+} _tinyengine_inputLog;
 
 struct tinyengine_state_t {
 
@@ -322,8 +803,12 @@ struct tinyengine_state_t {
 // Window
 	#if defined(TE_LINUX)
 		tinyengine_x11_state x11state;
+	#elif defined(TE_WIN32)
+		tinyengine_win32_state win32state;
 	#endif
-	tinyengine_windowContextList windowContextList;
+	tinyengine_windowRegistry windowRegistry;
+	tinyengine_eventQueue eventQueue;
+	_tinyengine_inputLog inputLog;
 // Debug
 	// TODO: Implement other threading methods
 	#if defined(TE_PTHREADS) && defined(TE_DEBUG_OUTPUT_ENABLED)
@@ -518,1330 +1003,7901 @@ void _tinyengine_linux_registerSignalHandlers() {
 
 #endif
 
-//// Window System
-
-#include <stdlib.h> // malloc(); free();
-
-void _tinyengine_pushWindowContext(tinyengine_windowContext* value) {
-	tinyengine_windowContextList_node* node = (tinyengine_windowContextList_node*)malloc(sizeof(tinyengine_windowContextList_node));
-	node->next = NULL;
-	node->value = value;
-	if(tinyengine_state.windowContextList.head == NULL){
-		tinyengine_state.windowContextList.head = node;
-		tinyengine_state.windowContextList.tail = node;
-		tinyengine_state.windowContextList.length = 1;
-	} else {
-		tinyengine_state.windowContextList.tail->next = node;
-		tinyengine_state.windowContextList.length++;
-		tinyengine_state.windowContextList.tail = node;
-	}
-}
-
-void _tinyengine_removeWindowContext(tinyengine_windowContext* window) {
-	tinyengine_windowContextList_node* node = tinyengine_state.windowContextList.head;
-	tinyengine_windowContextList_node* prev = NULL;
-	while(node != NULL) {
-		if(node->value == window){
-			if(prev == NULL) {
-				tinyengine_state.windowContextList.head = NULL;
-				tinyengine_state.windowContextList.tail = NULL;
-				tinyengine_state.windowContextList.length = 0;
-				return;
-			}
+//// Time
 
-			if(node->next == NULL) { tinyengine_state.windowContextList.tail = prev; }
+#if defined(TE_WIN32)
+	te_f64 tinyengine_getTime() {
+		static LARGE_INTEGER frequency = {0};
+		if(frequency.QuadPart == 0) { QueryPerformanceFrequency(&frequency); }
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+		return (te_f64) counter.QuadPart / (te_f64) frequency.QuadPart;
+	}
+#else
+	#include <time.h> // clock_gettime(); CLOCK_MONOTONIC;
+	// Monotonic seconds, only meaningful as a difference
+	te_f64 tinyengine_getTime() {
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return (te_f64) now.tv_sec + (te_f64) now.tv_nsec * 1e-9;
+	}
+#endif
 
-			prev->next = node->next;
-			tinyengine_state.windowContextList.length--;
-			free(node);
+//// Hashing
 
-			return;
-		}
-		prev = node;
-		node = node->next;
+te_u64 _tinyengine_fnv1a64(te_u64 hash, const void* data, size_t length) {
+	const te_u8* bytes = (const te_u8*) data;
+	for(size_t i = 0; i < length; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001B3ull;
 	}
+	return hash;
 }
 
-// TODO: decide on the windowing system in header, not by platform alone, allow override
-#if defined(TE_LINUX)
-
-// TODO: Load xlib,gtx,and other x11 extensions by dynamic loader instead of static link
-// TODO: Maybe be compatable with windows version of xserver?
+#define TE_FNV1A64_SEED 0xCBF29CE484222325ull
 
+//// File Mapping
 
-// TODO: should make these trap calls thread safe if I can
-void _tinyengine_x11_enableErrorTrap() {
-	tinyengine_state.x11state.errorCaught = TE_FALSE;
-	tinyengine_state.x11state.lastErrorCode = 0;
-	tinyengine_state.x11state.trapErrors = TE_TRUE;
-}
+#if defined(TE_WIN32)
 
-void _tinyengine_x11_disableErrorTrap() {
-	XSync(tinyengine_state.x11state.display,TE_FALSE);
-	tinyengine_state.x11state.trapErrors = TE_FALSE;
-}
+te_bool_u8 tinyengine_mapFile(const char* path, tinyengine_mappedFile* file) {
+	memset(file, 0, sizeof(tinyengine_mappedFile));
 
-int _tinyengine_x11_errorHandler(Display* display, XErrorEvent* event) {
+	HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(handle == INVALID_HANDLE_VALUE) { TE_ERROR("Could not open %s\n", path); return TE_FALSE; }
 
-	#if defined(TE_DEBUG_OUTPUT_ENABLED)
-		char messageBuffer[100];
-		XGetErrorText(display, event->error_code, &messageBuffer[0], 100);
-	#endif
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(handle, &size) || size.QuadPart == 0) { CloseHandle(handle); return TE_FALSE; }
 
-	if(tinyengine_state.x11state.display != display) {
-		TE_WARN("Caught XError on unregistered display: %s",&messageBuffer[0]);
-		return 0;
-	}
+	HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(mapping == NULL) { CloseHandle(handle); return TE_FALSE; }
 
-	if(tinyengine_state.x11state.trapErrors){
-		tinyengine_state.x11state.lastErrorCode = event->error_code;
-		tinyengine_state.x11state.errorCaught = TE_TRUE;
-		TE_ERROR("Caught X11 Error: %s\n",&messageBuffer[0]);
-	}else{
-		// TODO: handle potientially fatal xlib errors and pass information into render loop
-		TE_ERROR("X11 Error: %s\n",&messageBuffer[0]);
-		exit(-1);
-	}
+	file->data = (const te_u8*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if(file->data == NULL) { CloseHandle(mapping); CloseHandle(handle); return TE_FALSE; }
 
-	return 0; // TODO: Find out what this return means
+	file->size = (size_t) size.QuadPart;
+	file->platformFile = handle;
+	file->platformMapping = mapping;
+	return TE_TRUE;
 }
 
-tinyengine_windowContext* _tinyengine_x11_translateWindowIDToWindowContext(Window windowID) {
-	XPointer windowContext = NULL;
-	if(XFindContext(tinyengine_state.x11state.display, windowID, tinyengine_state.x11state.windowPointerContextID, &windowContext) == 0 && windowContext != NULL) {
-		return (tinyengine_windowContext*) windowContext;
-	}else{
-		TE_ERROR("Could not translate window id %i to windowContext pointer!\n",windowID);
-		return NULL;
-	}
+void tinyengine_unmapFile(tinyengine_mappedFile* file) {
+	if(file->data) { UnmapViewOfFile(file->data); }
+	if(file->platformMapping) { CloseHandle(file->platformMapping); }
+	if(file->platformFile) { CloseHandle(file->platformFile); }
+	memset(file, 0, sizeof(tinyengine_mappedFile));
 }
 
-te_bool_u8 _tinyengine_x11_createWindow(tinyengine_windowContext* window) {
+#else
 
-	Window root = DefaultRootWindow(tinyengine_state.x11state.display);
+#include <sys/mman.h> // mmap(); munmap(); madvise();
+#include <sys/stat.h> // fstat();
+#include <fcntl.h> // open();
+#include <unistd.h> // close();
 
-	XSetWindowAttributes windowAttributes = {};
-	windowAttributes.colormap = XCreateColormap(tinyengine_state.x11state.display, root, tinyengine_state.x11state.visualFormat->visual, AllocNone);
-	windowAttributes.event_mask = ExposureMask | KeyPressMask | KeyReleaseMask;
+te_bool_u8 tinyengine_mapFile(const char* path, tinyengine_mappedFile* file) {
+	memset(file, 0, sizeof(tinyengine_mappedFile));
 
-	_tinyengine_x11_enableErrorTrap();
+	int descriptor = open(path, O_RDONLY);
+	if(descriptor < 0) { TE_ERROR("Could not open %s\n", path); return TE_FALSE; }
 
-	window->platform.x11WindowID = XCreateWindow(
-		tinyengine_state.x11state.display, root,
-		0,0,300,300,0, // posX, posY, width, height, border
-		tinyengine_state.x11state.visualFormat->depth,InputOutput,tinyengine_state.x11state.visualFormat->visual,
-		CWColormap | CWEventMask,&windowAttributes
-	);
+	struct stat info;
+	if(fstat(descriptor, &info) != 0 || info.st_size == 0) { close(descriptor); return TE_FALSE; }
 
-	_tinyengine_x11_disableErrorTrap();
+	void* data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	// The mapping keeps its own reference to the file
+	close(descriptor);
+	if(data == MAP_FAILED) { TE_ERROR("Could not map %s\n", path); return TE_FALSE; }
 
-	if(tinyengine_state.x11state.errorCaught) {
-		TE_ERROR("Error while creating window.\n");
-		return TE_FALSE;
-	}
+	// Decoders read front to back, let the kernel read ahead
+	madvise(data, (size_t) info.st_size, MADV_SEQUENTIAL);
 
-	XSaveContext(tinyengine_state.x11state.display,window->platform.x11WindowID,tinyengine_state.x11state.windowPointerContextID,(XPointer) window);
+	file->data = (const te_u8*) data;
+	file->size = (size_t) info.st_size;
+	return TE_TRUE;
+}
 
-	XSetWMProtocols(tinyengine_state.x11state.display, window->platform.x11WindowID, &(tinyengine_state.x11state.wm_delete_window), 1);
+void tinyengine_unmapFile(tinyengine_mappedFile* file) {
+	if(file->data) { munmap((void*) file->data, file->size); }
+	memset(file, 0, sizeof(tinyengine_mappedFile));
+}
 
-	// TODO: Do I need a context for each window? Or can they all share?
-	window->platform.glxContext = glXCreateContext(tinyengine_state.x11state.display, tinyengine_state.x11state.visualFormat, NULL, GL_TRUE);
+#endif
 
-	return TE_TRUE;
-}
+//// Image Decoding
 
-void _tinyengine_x11_destroyWindow(tinyengine_windowContext* window){
+// PNG and QOI are decoded straight from memory (usually a file mapping) into the caller's pixel buffer,
+// normally the mapped staging memory of a streamed texture. Output is always RGBA8.
+//
+// The destination is only ever written, front to back and never read, since staging memory is mapped
+// write only and may be uncached. PNG inflates and unfilters in CPU scratch memory and copies finished
+// rows out, so the destination is exactly width * height * 4 bytes.
 
-}
+#if defined(TE_SSE2)
+	#include <emmintrin.h> // _mm_add_epi8(); _mm_loadu_si128(); _mm_storeu_si128();
+#endif
+#if defined(TE_SSSE3)
+	#include <tmmintrin.h> // _mm_shuffle_epi8();
+#endif
 
-void _tinyengine_x11_setWindowMaxSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
-	XSizeHints* hints = XAllocSizeHints();
-	long returnedHints;
-	XGetWMNormalHints(tinyengine_state.x11state.display, window->platform.x11WindowID, hints, &returnedHints);
-	hints->flags |= PMaxSize;
-	hints->max_width = width;
-	hints->max_height = height;
-	XSetWMNormalHints(tinyengine_state.x11state.display, window->platform.x11WindowID, hints);
-	XFree(hints);
+te_u32 _tinyengine_readBigEndian32(const te_u8* data) {
+	return ((te_u32)data[0] << 24) | ((te_u32)data[1] << 16) | ((te_u32)data[2] << 8) | (te_u32)data[3];
 }
 
-void _tinyengine_x11_setWindowMinSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
-	XSizeHints* hints = XAllocSizeHints();
-	long returnedHints;
-	XGetWMNormalHints(tinyengine_state.x11state.display, window->platform.x11WindowID, hints, &returnedHints);
-	hints->flags |= PMinSize;
-	hints->min_width = width;
-	hints->min_height = height;
-	XSetWMNormalHints(tinyengine_state.x11state.display, window->platform.x11WindowID, hints);
-	XFree(hints);
+// Inflate
+
+#define _TE_ZFAST_BITS 9
+#define _TE_ZFAST_MASK ((1 << _TE_ZFAST_BITS) - 1)
+
+typedef struct _tinyengine_zhuffman_t {
+	te_u16 fast[1 << _TE_ZFAST_BITS]; // (length << 9) | symbol, 0 for codes longer than the fast bits
+	te_u16 firstCode[16];
+	te_i32 maxCode[17];
+	te_u16 firstSymbol[16];
+	te_u8 size[288];
+	te_u16 value[288];
+} _tinyengine_zhuffman;
+
+typedef struct _tinyengine_zstream_t {
+	// Compressed input, PNG splits it over consecutive IDAT chunks which are walked in place
+	const te_u8* cursor;
+	const te_u8* end;
+	const te_u8* nextChunk;
+	const te_u8* fileEnd;
+	te_bool_u8 overrun;
+
+	te_u32 bits;
+	te_i32 bitCount;
+
+	te_u8* out;
+	te_u8* outStart;
+	te_u8* outEnd;
+
+	_tinyengine_zhuffman length;
+	_tinyengine_zhuffman distance;
+} _tinyengine_zstream;
+
+static const te_u16 _tinyengine_zlengthBase[31] = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258,0,0 };
+static const te_u8 _tinyengine_zlengthExtra[31] = { 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0,0,0 };
+static const te_u16 _tinyengine_zdistanceBase[32] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577,0,0 };
+static const te_u8 _tinyengine_zdistanceExtra[32] = { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13,0,0 };
+
+te_u8 _tinyengine_zstream_nextByte(_tinyengine_zstream* z) {
+	while(z->cursor >= z->end) {
+		// Hop to the next IDAT chunk, image data ends at the first chunk of any other type
+		if(z->nextChunk == NULL || z->nextChunk + 12 > z->fileEnd) { z->overrun = TE_TRUE; return 0; }
+		te_u32 length = _tinyengine_readBigEndian32(z->nextChunk);
+		const te_u8* data = z->nextChunk + 8;
+		if(memcmp(z->nextChunk + 4, "IDAT", 4) != 0 || length > (size_t)(z->fileEnd - data)) { z->overrun = TE_TRUE; return 0; }
+		z->cursor = data;
+		z->end = data + length;
+		z->nextChunk = data + length + 4;
+	}
+	return *z->cursor++;
 }
 
-void _tinyengine_x11_setWindowAspectRatio(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
-	XSizeHints* hints = XAllocSizeHints();
-	long returnedHints;
-	XGetWMNormalHints(tinyengine_state.x11state.display, window->platform.x11WindowID, hints, &returnedHints);
-	hints->flags |= PAspect;
-	hints->min_aspect.x = hints->max_aspect.x = width;
-	hints->min_aspect.y = hints->max_aspect.y = height;
-	XSetWMNormalHints(tinyengine_state.x11state.display, window->platform.x11WindowID, hints);
-	XFree(hints);
+void _tinyengine_zstream_fill(_tinyengine_zstream* z) {
+	while(z->bitCount <= 24) {
+		z->bits |= (te_u32) _tinyengine_zstream_nextByte(z) << z->bitCount;
+		z->bitCount += 8;
+	}
 }
 
-void _tinyengine_x11_setWindowSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
-	XResizeWindow(tinyengine_state.x11state.display, window->platform.x11WindowID, width, height);
+te_u32 _tinyengine_zstream_receive(_tinyengine_zstream* z, te_i32 count) {
+	if(z->bitCount < count) { _tinyengine_zstream_fill(z); }
+	te_u32 value = z->bits & ((1u << count) - 1);
+	z->bits >>= count;
+	z->bitCount -= count;
+	return value;
 }
 
-void _tinyengine_x11_setWindowTitle(tinyengine_windowContext* window, const char* title) {
-	XStoreName(tinyengine_state.x11state.display, window->platform.x11WindowID, title);
+te_u32 _tinyengine_bitReverse(te_u32 value, te_i32 bits) {
+	value = ((value & 0xAAAA) >> 1) | ((value & 0x5555) << 1);
+	value = ((value & 0xCCCC) >> 2) | ((value & 0x3333) << 2);
+	value = ((value & 0xF0F0) >> 4) | ((value & 0x0F0F) << 4);
+	value = ((value & 0xFF00) >> 8) | ((value & 0x00FF) << 8);
+	return value >> (16 - bits);
 }
 
-void _tinyengine_x11_showWindow(tinyengine_windowContext* window){
-	XMapWindow(tinyengine_state.x11state.display, window->platform.x11WindowID);
-}
+te_bool_u8 _tinyengine_zhuffman_build(_tinyengine_zhuffman* huffman, const te_u8* sizeList, te_i32 count) {
+	te_i32 nextCode[16];
+	te_i32 sizes[17] = {0};
+
+	memset(huffman->fast, 0, sizeof(huffman->fast));
+	for(te_i32 i = 0; i < count; i++) { sizes[sizeList[i]]++; }
+	sizes[0] = 0;
+	for(te_i32 i = 1; i < 16; i++) { if(sizes[i] > (1 << i)) { return TE_FALSE; } }
+
+	te_i32 code = 0;
+	te_i32 symbol = 0;
+	for(te_i32 i = 1; i < 16; i++) {
+		nextCode[i] = code;
+		huffman->firstCode[i] = (te_u16) code;
+		huffman->firstSymbol[i] = (te_u16) symbol;
+		code += sizes[i];
+		if(sizes[i] && code - 1 >= (1 << i)) { return TE_FALSE; }
+		huffman->maxCode[i] = code << (16 - i); // preshifted for the slow path compare
+		code <<= 1;
+		symbol += sizes[i];
+	}
+	huffman->maxCode[16] = 0x10000;
 
-void _tinyengine_x11_pollDisplayEvents() {
+	for(te_i32 i = 0; i < count; i++) {
+		te_i32 size = sizeList[i];
+		if(size == 0) { continue; }
 
-	while(XPending(tinyengine_state.x11state.display)){
+		te_i32 index = nextCode[size] - huffman->firstCode[size] + huffman->firstSymbol[size];
+		huffman->size[index] = (te_u8) size;
+		huffman->value[index] = (te_u16) i;
 
-		XEvent event;
-		XNextEvent(tinyengine_state.x11state.display,&event);
+		if(size <= _TE_ZFAST_BITS) {
+			te_u16 fast = (te_u16)((size << 9) | i);
+			for(te_i32 j = _tinyengine_bitReverse(nextCode[size], size); j < (1 << _TE_ZFAST_BITS); j += (1 << size)) { huffman->fast[j] = fast; }
+		}
+		nextCode[size]++;
+	}
 
-		switch(event.type) {
+	return TE_TRUE;
+}
 
-			case ClientMessage:
-			{
-				tinyengine_windowContext* window = _tinyengine_x11_translateWindowIDToWindowContext(event.xclient.window);
-				if(window == NULL) { TE_WARN("ClientMessage event for unregistered window!\n"); break; }
-				if (event.xclient.data.l[0] == tinyengine_state.x11state.wm_delete_window) {
-					window->closeRequested = TE_TRUE;
-					window->closeCallback(window);
-				}
-			} break;
+te_i32 _tinyengine_zhuffman_decode(_tinyengine_zstream* z, _tinyengine_zhuffman* huffman) {
+	if(z->bitCount < 16) { _tinyengine_zstream_fill(z); }
 
-			case KeyPress: case KeyRelease:
-			{
+	te_u32 fast = huffman->fast[z->bits & _TE_ZFAST_MASK];
+	if(fast) {
+		te_i32 size = fast >> 9;
+		z->bits >>= size;
+		z->bitCount -= size;
+		return fast & 511;
+	}
 
-				tinyengine_windowContext* window = _tinyengine_x11_translateWindowIDToWindowContext(event.xkey.window);
-				if(window == NULL) { TE_WARN("KeyMessage event for unregistered window!\n"); break; }
+	// Codes longer than the fast table, compare against the canonical ranges
+	te_i32 key = _tinyengine_bitReverse(z->bits, 16);
+	te_i32 size = _TE_ZFAST_BITS + 1;
+	while(size < 16 && key >= huffman->maxCode[size]) { size++; }
+	if(size >= 16) { return -1; }
 
-				char buf[2];
-				KeySym ks;
-				XComposeStatus comp;
+	te_i32 index = (key >> (16 - size)) - huffman->firstCode[size] + huffman->firstSymbol[size];
+	if(index >= 288 || huffman->size[index] != size) { return -1; }
+
+	z->bits >>= size;
+	z->bitCount -= size;
+	return huffman->value[index];
+}
 
-				te_i32 len = XLookupString(&event.xkey, buf, 1, &ks, &comp);
-				if (event.type == KeyRelease && len > 0) { window->characterCallback(window,buf[0]); }
+te_bool_u8 _tinyengine_zstream_dynamicTables(_tinyengine_zstream* z) {
+	static const te_u8 order[19] = { 16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 };
+
+	te_i32 literalCount = _tinyengine_zstream_receive(z, 5) + 257;
+	te_i32 distanceCount = _tinyengine_zstream_receive(z, 5) + 1;
+	te_i32 codeLengthCount = _tinyengine_zstream_receive(z, 4) + 4;
+
+	te_u8 codeLengthSizes[19] = {0};
+	for(te_i32 i = 0; i < codeLengthCount; i++) { codeLengthSizes[order[i]] = (te_u8) _tinyengine_zstream_receive(z, 3); }
+
+	_tinyengine_zhuffman codeLength;
+	if(!_tinyengine_zhuffman_build(&codeLength, codeLengthSizes, 19)) { return TE_FALSE; }
+
+	te_u8 lengths[286 + 32];
+	te_i32 total = literalCount + distanceCount;
+	te_i32 n = 0;
+	while(n < total) {
+		te_i32 symbol = _tinyengine_zhuffman_decode(z, &codeLength);
+		if(symbol < 0 || symbol >= 19) { return TE_FALSE; }
+
+		if(symbol < 16) { lengths[n++] = (te_u8) symbol; continue; }
+
+		te_u8 fill = 0;
+		te_i32 repeat;
+		if(symbol == 16) {
+			if(n == 0) { return TE_FALSE; }
+			repeat = _tinyengine_zstream_receive(z, 2) + 3;
+			fill = lengths[n - 1];
+		} else if(symbol == 17) {
+			repeat = _tinyengine_zstream_receive(z, 3) + 3;
+		} else {
+			repeat = _tinyengine_zstream_receive(z, 7) + 11;
+		}
+		if(total - n < repeat) { return TE_FALSE; }
+		memset(lengths + n, fill, repeat);
+		n += repeat;
+	}
 
-				// TODO: translate x11 key codes to universal keycodes
+	return _tinyengine_zhuffman_build(&z->length, lengths, literalCount)
+		&& _tinyengine_zhuffman_build(&z->distance, lengths + literalCount, distanceCount);
+}
 
-			}	break;
+te_bool_u8 _tinyengine_zstream_huffmanBlock(_tinyengine_zstream* z) {
+	te_u8* out = z->out;
 
-			default: break;
+	for(;;) {
+		te_i32 symbol = _tinyengine_zhuffman_decode(z, &z->length);
 
+		if(symbol < 256) {
+			if(symbol < 0 || out >= z->outEnd) { return TE_FALSE; }
+			*out++ = (te_u8) symbol;
+			continue;
 		}
 
+		if(symbol == 256) { z->out = out; return TE_TRUE; }
+
+		symbol -= 257;
+		if(symbol >= 29) { return TE_FALSE; }
+		te_i32 length = _tinyengine_zlengthBase[symbol];
+		if(_tinyengine_zlengthExtra[symbol]) { length += _tinyengine_zstream_receive(z, _tinyengine_zlengthExtra[symbol]); }
+
+		symbol = _tinyengine_zhuffman_decode(z, &z->distance);
+		if(symbol < 0 || symbol >= 30) { return TE_FALSE; }
+		te_i32 distance = _tinyengine_zdistanceBase[symbol];
+		if(_tinyengine_zdistanceExtra[symbol]) { distance += _tinyengine_zstream_receive(z, _tinyengine_zdistanceExtra[symbol]); }
+
+		if(out - z->outStart < distance || z->outEnd - out < length) { return TE_FALSE; }
+
+		// Back references can overlap their own output
+		const te_u8* source = out - distance;
+		if(distance == 1) {
+			memset(out, *source, length);
+			out += length;
+		} else if(distance >= length) {
+			memcpy(out, source, length);
+			out += length;
+		} else {
+			while(length--) { *out++ = *source++; }
+		}
 	}
 }
 
-te_bool_u8 _tinyengine_x11_init() {
-
-	// TODO: make everything a local variable then just assign them all to the x11state at the end? (is this worst?)
+te_bool_u8 _tinyengine_zstream_storedBlock(_tinyengine_zstream* z) {
+	// Drop to the byte boundary, the header and payload are whole bytes
+	_tinyengine_zstream_receive(z, z->bitCount & 7);
 
-	tinyengine_state.x11state.nativeErrorHandler = XSetErrorHandler(&_tinyengine_x11_errorHandler);
-	tinyengine_state.x11state.windowPointerContextID = XUniqueContext();
-	tinyengine_state.x11state.display = XOpenDisplay(NULL);
+	te_u32 length = _tinyengine_zstream_receive(z, 16);
+	te_u32 inverse = _tinyengine_zstream_receive(z, 16);
+	if((length ^ 0xFFFF) != inverse) { return TE_FALSE; }
+	if((size_t)(z->outEnd - z->out) < length) { return TE_FALSE; }
 
-	if(tinyengine_state.x11state.display == NULL) {
-		TE_ERROR("Could not connect to X11 server!\n");
-		return TE_FALSE;
+	// Bytes already pulled into the bit buffer come first
+	while(length > 0 && z->bitCount > 0) {
+		*z->out++ = (te_u8) _tinyengine_zstream_receive(z, 8);
+		length--;
+	}
+	while(length > 0) {
+		if(z->cursor >= z->end) { *z->out++ = _tinyengine_zstream_nextByte(z); length--; continue; }
+		size_t span = (size_t)(z->end - z->cursor);
+		if(span > length) { span = length; }
+		memcpy(z->out, z->cursor, span);
+		z->out += span;
+		z->cursor += span;
+		length -= (te_u32) span;
 	}
 
-	TE_LOG("X11 window manager loaded.\n");
-	TE_LOG("X11 display connected on %s\n",XDisplayString(tinyengine_state.x11state.display));
-	TE_LOG("X11 Display Version: %i.%i\n",XProtocolVersion(tinyengine_state.x11state.display),XProtocolRevision(tinyengine_state.x11state.display));
-	TE_LOG("X11 Vendor: %s\n",XServerVendor(tinyengine_state.x11state.display));
+	return !z->overrun;
+}
 
-	te_i32 glxAttributes[] = { GLX_RGBA, GLX_DEPTH_SIZE, 24, GLX_DOUBLEBUFFER, None };
-	tinyengine_state.x11state.visualFormat = glXChooseVisual(tinyengine_state.x11state.display, 0, glxAttributes);
+te_bool_u8 _tinyengine_zstream_inflate(_tinyengine_zstream* z) {
+	static te_u8 fixedLengths[288 + 32];
+	static te_bool_u8 fixedReady = TE_FALSE;
 
-	if(tinyengine_state.x11state.visualFormat == NULL) {
-		TE_ERROR("GLX could not find any compatable OpenGL visual format for display!\n");
-		return TE_FALSE;
-	}
+	// zlib header, compression method must be deflate without a preset dictionary
+	te_u32 cmf = _tinyengine_zstream_receive(z, 8);
+	te_u32 flags = _tinyengine_zstream_receive(z, 8);
+	if((cmf * 256 + flags) % 31 != 0 || (cmf & 15) != 8 || (flags & 32)) { return TE_FALSE; }
 
-	tinyengine_state.x11state.wm_delete_window = XInternAtom(tinyengine_state.x11state.display, "WM_DELETE_WINDOW", False);
+	te_u32 final;
+	do {
+		final = _tinyengine_zstream_receive(z, 1);
+		te_u32 type = _tinyengine_zstream_receive(z, 2);
 
-	tinyengine_state.x11state.wm_size_hints = XInternAtom(tinyengine_state.x11state.display, "WM_SIZE_HINTS", False);
+		if(type == 0) {
+			if(!_tinyengine_zstream_storedBlock(z)) { return TE_FALSE; }
+			continue;
+		}
+
+		if(type == 1) {
+			if(!fixedReady) {
+				memset(fixedLengths, 8, 144);
+				memset(fixedLengths + 144, 9, 112);
+				memset(fixedLengths + 256, 7, 24);
+				memset(fixedLengths + 280, 8, 8);
+				memset(fixedLengths + 288, 5, 32);
+				fixedReady = TE_TRUE;
+			}
+			if(!_tinyengine_zhuffman_build(&z->length, fixedLengths, 288)) { return TE_FALSE; }
+			if(!_tinyengine_zhuffman_build(&z->distance, fixedLengths + 288, 32)) { return TE_FALSE; }
+		} else if(type == 2) {
+			if(!_tinyengine_zstream_dynamicTables(z)) { return TE_FALSE; }
+		} else {
+			return TE_FALSE;
+		}
+
+		if(!_tinyengine_zstream_huffmanBlock(z)) { return TE_FALSE; }
+	} while(!final);
 
 	return TE_TRUE;
 }
 
-void _tinyengine_x11_terminate() {
+// PNG
+
+typedef struct _tinyengine_png_t {
+	te_u32 width;
+	te_u32 height;
+	te_u8 colorType;
+	te_u8 channels; // bytes per pixel in the filtered stream
+	const te_u8* palette;
+	te_u32 paletteSize;
+	const te_u8* transparency;
+	te_u32 transparencySize;
+	const te_u8* firstData; // first IDAT chunk header
+} _tinyengine_png;
+
+static const te_u8 _tinyengine_pngSignature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+te_bool_u8 _tinyengine_png_parse(const te_u8* data, size_t size, _tinyengine_png* png, te_bool_u8 headerOnly) {
+	memset(png, 0, sizeof(_tinyengine_png));
+
+	if(size < 8 + 25 || memcmp(data, _tinyengine_pngSignature, 8) != 0) { return TE_FALSE; }
+
+	const te_u8* chunk = data + 8;
+	const te_u8* end = data + size;
+
+	while(chunk + 12 <= end) {
+		te_u32 length = _tinyengine_readBigEndian32(chunk);
+		const te_u8* type = chunk + 4;
+		const te_u8* body = chunk + 8;
+		if(length > (size_t)(end - body) - 4) { return TE_FALSE; }
+
+		if(memcmp(type, "IHDR", 4) == 0) {
+			if(length < 13) { return TE_FALSE; }
+			png->width = _tinyengine_readBigEndian32(body);
+			png->height = _tinyengine_readBigEndian32(body + 4);
+			te_u8 depth = body[8];
+			png->colorType = body[9];
+			// Only 8 bit, non interlaced images are supported
+			if(depth != 8 || body[10] != 0 || body[11] != 0 || body[12] != 0) { TE_ERROR("Unsupported PNG format (depth %u, interlace %u)\n", depth, body[12]); return TE_FALSE; }
+			switch(png->colorType) {
+				case 0: png->channels = 1; break; // gray
+				case 2: png->channels = 3; break; // rgb
+				case 3: png->channels = 1; break; // palette
+				case 4: png->channels = 2; break; // gray alpha
+				case 6: png->channels = 4; break; // rgba
+				default: return TE_FALSE;
+			}
+			if(png->width == 0 || png->height == 0 || png->width > (1 << 24) || png->height > (1 << 24)) { return TE_FALSE; }
+			if(headerOnly) { return TE_TRUE; }
+		} else if(memcmp(type, "PLTE", 4) == 0) {
+			png->palette = body;
+			png->paletteSize = length / 3;
+		} else if(memcmp(type, "tRNS", 4) == 0) {
+			png->transparency = body;
+			png->transparencySize = length;
+		} else if(memcmp(type, "IDAT", 4) == 0) {
+			if(png->channels == 0) { return TE_FALSE; }
+			if(png->colorType == 3 && png->palette == NULL) { return TE_FALSE; }
+			png->firstData = chunk;
+			return TE_TRUE;
+		} else if(memcmp(type, "IEND", 4) == 0) {
+			break;
+		}
+
+		chunk = body + length + 4;
+	}
 
+	return TE_FALSE;
 }
 
-void _tinyengine_glx_makeCurrent(tinyengine_windowContext* window){
-	glXMakeCurrent(tinyengine_state.x11state.display, window->platform.x11WindowID, window->platform.glxContext);
+size_t _tinyengine_png_decodeSize(const _tinyengine_png* png) {
+	return (size_t) png->width * png->height * 4;
 }
 
-void _tinyengine_glx_swapBuffers(tinyengine_windowContext* window) {
-	glXSwapBuffers(tinyengine_state.x11state.display, window->platform.x11WindowID);
+te_u8 _tinyengine_paeth(te_i32 a, te_i32 b, te_i32 c) {
+	te_i32 p = a + b - c;
+	te_i32 pa = p > a ? p - a : a - p;
+	te_i32 pb = p > b ? p - b : b - p;
+	te_i32 pc = p > c ? p - c : c - p;
+	if(pa <= pb && pa <= pc) { return (te_u8) a; }
+	if(pb <= pc) { return (te_u8) b; }
+	return (te_u8) c;
 }
 
-#elif defined(TE_WIN32)
-// TODO: tinyengine_win32 descripes the platform, need a new name for the windowing system specificly
+void _tinyengine_png_unfilterRow(te_u8 filter, const te_u8* raw, te_u8* row, const te_u8* prior, size_t length, te_u32 channels) {
+	size_t i = 0;
+	switch(filter) {
+		case 1: // sub
+			memcpy(row, raw, channels);
+			for(i = channels; i < length; i++) { row[i] = raw[i] + row[i - channels]; }
+			break;
+		case 2: // up
+			#if defined(TE_SSE2)
+				for(; i + 16 <= length; i += 16) {
+					__m128i sum = _mm_add_epi8(_mm_loadu_si128((const __m128i*)(raw + i)), _mm_loadu_si128((const __m128i*)(prior + i)));
+					_mm_storeu_si128((__m128i*)(row + i), sum);
+				}
+			#endif
+			for(; i < length; i++) { row[i] = raw[i] + prior[i]; }
+			break;
+		case 3: // average
+			for(i = 0; i < channels; i++) { row[i] = raw[i] + (prior[i] >> 1); }
+			for(; i < length; i++) { row[i] = raw[i] + ((row[i - channels] + prior[i]) >> 1); }
+			break;
+		case 4: // paeth
+			for(i = 0; i < channels; i++) { row[i] = raw[i] + prior[i]; }
+			for(; i < length; i++) { row[i] = raw[i] + _tinyengine_paeth(row[i - channels], prior[i], prior[i - channels]); }
+			break;
+		default: // none
+			memcpy(row, raw, length);
+			break;
+	}
+}
 
-#define _TE_WINSTYLE WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_THICKFRAME
+void _tinyengine_png_expandRow(const _tinyengine_png* png, const te_u8* row, te_u8* out) {
+	te_u32 width = png->width;
+	te_u32 x = 0;
 
-LRESULT CALLBACK _tinyengine_win32_eventCallback(HWND hWindow, UINT Message, WPARAM wParam, LPARAM lParam) {
+	switch(png->colorType) {
+		case 6:
+			memcpy(out, row, (size_t) width * 4);
+			break;
+		case 2:
+			#if defined(TE_SSSE3)
+			{
+				// Four pixels per shuffle, alpha is or'ed in afterwards
+				const __m128i shuffle = _mm_setr_epi8(0,1,2,-1, 3,4,5,-1, 6,7,8,-1, 9,10,11,-1);
+				const __m128i alpha = _mm_set1_epi32((te_i32) 0xFF000000);
+				for(; x + 6 <= width; x += 4) {
+					__m128i pixels = _mm_loadu_si128((const __m128i*)(row + x * 3));
+					_mm_storeu_si128((__m128i*)(out + x * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+				}
+			}
+			#endif
+			for(; x < width; x++) {
+				out[x * 4 + 0] = row[x * 3 + 0];
+				out[x * 4 + 1] = row[x * 3 + 1];
+				out[x * 4 + 2] = row[x * 3 + 2];
+				out[x * 4 + 3] = 255;
+			}
+			break;
+		case 0:
+			for(; x < width; x++) {
+				out[x * 4 + 0] = out[x * 4 + 1] = out[x * 4 + 2] = row[x];
+				out[x * 4 + 3] = 255;
+			}
+			break;
+		case 4:
+			for(; x < width; x++) {
+				out[x * 4 + 0] = out[x * 4 + 1] = out[x * 4 + 2] = row[x * 2];
+				out[x * 4 + 3] = row[x * 2 + 1];
+			}
+			break;
+		case 3:
+			for(; x < width; x++) {
+				te_u32 index = row[x];
+				if(index < png->paletteSize) {
+					out[x * 4 + 0] = png->palette[index * 3 + 0];
+					out[x * 4 + 1] = png->palette[index * 3 + 1];
+					out[x * 4 + 2] = png->palette[index * 3 + 2];
+				} else {
+					out[x * 4 + 0] = out[x * 4 + 1] = out[x * 4 + 2] = 0;
+				}
+				out[x * 4 + 3] = index < png->transparencySize ? png->transparency[index] : 255;
+			}
+			break;
+	}
+}
 
-	tinyengine_windowContext* window = GetPropA(hWindow,"tinyengine");
-	if(!window && Message == WM_CREATE) { window = (tinyengine_windowContext*) ((LPCREATESTRUCTA)lParam)->lpCreateParams; }
-	if(!window) { return DefWindowProc(hWindow,Message,wParam,lParam); }
+te_bool_u8 _tinyengine_png_decode(const te_u8* data, size_t size, te_u8* pixels, size_t pixelsSize, te_bool_u8 premultiply) {
+	_tinyengine_png png;
+	if(!_tinyengine_png_parse(data, size, &png, TE_FALSE)) { return TE_FALSE; }
+
+	size_t decodeSize = _tinyengine_png_decodeSize(&png);
+	if(pixelsSize < decodeSize) { return TE_FALSE; }
+
+	size_t stride = (size_t) png.width * png.channels;
+	size_t filteredSize = (size_t) png.height * (1 + stride);
+
+	// Inflate into scratch memory, back references read the output window so it can not be the destination
+	te_u8* filtered = malloc(filteredSize + 2 * stride + (size_t) png.width * 4);
+	_tinyengine_zstream* z = malloc(sizeof(_tinyengine_zstream));
+	if(filtered == NULL || z == NULL) { free(filtered); free(z); return TE_FALSE; }
+	memset(z, 0, sizeof(_tinyengine_zstream));
+	z->nextChunk = png.firstData;
+	z->fileEnd = data + size;
+	z->outStart = z->out = filtered;
+	z->outEnd = filtered + filteredSize;
+
+	te_bool_u8 inflated = _tinyengine_zstream_inflate(z) && z->out == z->outEnd;
+	free(z);
+	if(!inflated) { free(filtered); TE_ERROR("Corrupt PNG image data\n"); return TE_FALSE; }
+
+	// Unfiltering needs the previous row, two scratch rows behind the filtered data are all that is kept.
+	// Premultiplied rows are expanded into a last scratch row first, premultiplying has to read them back.
+	te_u8* prior = filtered + filteredSize;
+	te_u8* row = prior + stride;
+	te_u8* expanded = row + stride;
+	memset(prior, 0, stride);
+
+	for(te_u32 y = 0; y < png.height; y++) {
+		const te_u8* raw = filtered + (size_t) y * (1 + stride);
+		if(raw[0] > 4) { free(filtered); TE_ERROR("Corrupt PNG filter type\n"); return TE_FALSE; }
+
+		_tinyengine_png_unfilterRow(raw[0], raw + 1, row, prior, stride, png.channels);
+		te_u8* out = pixels + (size_t) y * png.width * 4;
+		if(premultiply) {
+			_tinyengine_png_expandRow(&png, row, expanded);
+			tinyengine_premultiplyAlpha(expanded, png.width);
+			memcpy(out, expanded, (size_t) png.width * 4);
+		} else {
+			_tinyengine_png_expandRow(&png, row, out);
+		}
 
-	switch(Message) {
-		case WM_CREATE: window->platform.windowReady = TE_TRUE; return 0;
-		case WM_CLOSE: window->closeRequested = TE_TRUE; window->closeCallback(window); return 0;
-		case WM_DESTROY: window->closeRequested = TE_TRUE; window->closeCallback(window); return 0;
+		te_u8* swap = prior;
+		prior = row;
+		row = swap;
+	}
 
-		case WM_MOUSEACTIVATE: break;
-		case WM_CAPTURECHANGED: break;
+	free(filtered);
+	return TE_TRUE;
+}
 
-		case WM_SETFOCUS: break;
-		case WM_KILLFOCUS: break;
+// QOI
 
-		case WM_SYSCOMMAND: break;
+#define _TE_QOI_HEADER_SIZE 14
 
-		case WM_INPUTLANGCHANGE: break;
+te_bool_u8 _tinyengine_qoi_info(const te_u8* data, size_t size, te_u32* width, te_u32* height) {
+	if(size < _TE_QOI_HEADER_SIZE + 8 || memcmp(data, "qoif", 4) != 0) { return TE_FALSE; }
+	*width = _tinyengine_readBigEndian32(data + 4);
+	*height = _tinyengine_readBigEndian32(data + 8);
+	return *width > 0 && *height > 0 && *width <= (1 << 24) && *height <= (1 << 24);
+}
 
-		// TODO: Use this for char input instead of keyrelease?
-		case WM_CHAR: break;
-		case WM_SYSCHAR: break;
-		case WM_UNICHAR: break;
+te_bool_u8 _tinyengine_qoi_decode(const te_u8* data, size_t size, te_u8* pixels, size_t pixelsSize, te_bool_u8 premultiply) {
+	te_u32 width, height;
+	if(!_tinyengine_qoi_info(data, size, &width, &height)) { return TE_FALSE; }
+
+	size_t count = (size_t) width * height;
+	if(pixelsSize < count * 4) { return TE_FALSE; }
+
+	te_u8 index[64][4];
+	memset(index, 0, sizeof(index));
+	te_u8 pixel[4] = { 0, 0, 0, 255 };
+	te_u8 written[4] = { 0, 0, 0, 255 }; // pixel as it goes out, premultiplied if asked for
+
+	const te_u8* cursor = data + _TE_QOI_HEADER_SIZE;
+	const te_u8* end = data + size - 8; // end marker
+	te_u8* out = pixels;
+	te_u8* outEnd = pixels + count * 4;
+
+	while(out < outEnd) {
+		if(cursor >= end) { return TE_FALSE; }
+		te_u8 op = *cursor++;
+
+		if(op == 0xFE) { // rgb
+			if(end - cursor < 3) { return TE_FALSE; }
+			pixel[0] = cursor[0]; pixel[1] = cursor[1]; pixel[2] = cursor[2];
+			cursor += 3;
+		} else if(op == 0xFF) { // rgba
+			if(end - cursor < 4) { return TE_FALSE; }
+			memcpy(pixel, cursor, 4);
+			cursor += 4;
+		} else if((op & 0xC0) == 0x00) { // index
+			memcpy(pixel, index[op], 4);
+		} else if((op & 0xC0) == 0x40) { // diff
+			pixel[0] += ((op >> 4) & 3) - 2;
+			pixel[1] += ((op >> 2) & 3) - 2;
+			pixel[2] += (op & 3) - 2;
+		} else if((op & 0xC0) == 0x80) { // luma
+			if(cursor >= end) { return TE_FALSE; }
+			te_u8 second = *cursor++;
+			te_i32 green = (op & 0x3F) - 32;
+			pixel[0] += green - 8 + ((second >> 4) & 0x0F);
+			pixel[1] += green;
+			pixel[2] += green - 8 + (second & 0x0F);
+		} else { // run
+			te_u32 run = (op & 0x3F) + 1;
+			if((size_t)(outEnd - out) < (size_t) run * 4) { return TE_FALSE; }
+			while(run--) { memcpy(out, written, 4); out += 4; }
+			continue;
+		}
 
-		case WM_KEYDOWN: break;
-		case WM_SYSKEYDOWN: break;
-		case WM_KEYUP: break;
-		case WM_SYSKEYUP: break;
+		memcpy(index[(pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) & 63], pixel, 4);
+		memcpy(written, pixel, 4);
+		if(premultiply) { tinyengine_premultiplyAlpha(written, 1); }
+		memcpy(out, written, 4);
+		out += 4;
+	}
 
-		case WM_LBUTTONDOWN: break;
-		case WM_RBUTTONDOWN: break;
-		case WM_MBUTTONDOWN: break;
-		case WM_XBUTTONDOWN: break;
-		case WM_LBUTTONUP: break;
-		case WM_RBUTTONUP: break;
-		case WM_MBUTTONUP: break;
-		case WM_XBUTTONUP: break;
+	return TE_TRUE;
+}
 
-		case WM_MOUSEMOVE: break;
+// Generic entry points
 
-		case WM_INPUT: break;
+te_bool_u8 tinyengine_imageInfo(const te_u8* data, size_t size, te_u32* width, te_u32* height) {
+	_tinyengine_png png;
+	if(_tinyengine_png_parse(data, size, &png, TE_TRUE)) {
+		*width = png.width;
+		*height = png.height;
+		return TE_TRUE;
+	}
+	return _tinyengine_qoi_info(data, size, width, height);
+}
 
-		case WM_ERASEBKGND: return TRUE;
+size_t tinyengine_imageDecodeSize(const te_u8* data, size_t size) {
+	_tinyengine_png png;
+	if(_tinyengine_png_parse(data, size, &png, TE_TRUE)) { return _tinyengine_png_decodeSize(&png); }
 
+	te_u32 width, height;
+	if(_tinyengine_qoi_info(data, size, &width, &height)) { return (size_t) width * height * 4; }
+	return 0;
+}
 
-		case WM_SIZING: // TODO: Seems to be busted on wine?
-			{
-				if(window->platform.aspectRatioWidth == 0 || window->platform.aspectRatioHeight == 0) {break;}
-				int edge = wParam;
-				RECT* size = (RECT*) lParam;
+// Premultiplies while the pixels are written, for destinations that must not be read back
+te_bool_u8 _tinyengine_decodeImage(const te_u8* data, size_t size, te_u8* pixels, size_t pixelsSize, te_bool_u8 premultiply) {
+	if(size >= 8 && memcmp(data, _tinyengine_pngSignature, 8) == 0) { return _tinyengine_png_decode(data, size, pixels, pixelsSize, premultiply); }
+	if(size >= 4 && memcmp(data, "qoif", 4) == 0) { return _tinyengine_qoi_decode(data, size, pixels, pixelsSize, premultiply); }
+	TE_ERROR("Unknown image format\n");
+	return TE_FALSE;
+}
 
-				RECT reportedSize;
-				RECT adjustedSize;
+te_bool_u8 tinyengine_decodeImage(const te_u8* data, size_t size, te_u8* pixels, size_t pixelsSize) {
+	return _tinyengine_decodeImage(data, size, pixels, pixelsSize, TE_FALSE);
+}
 
-				// TODO: Should probably just memcpy this
-				GetClientRect(window->platform.win32window, &reportedSize);
-				GetClientRect(window->platform.win32window, &adjustedSize);
-				AdjustWindowRect(&adjustedSize,_TE_WINSTYLE,0);
+// RGBA8 in place, the renderer blends premultiplied colors
+void tinyengine_premultiplyAlpha(te_u8* pixels, size_t count) {
+	for(size_t i = 0; i < count; i++) {
+		te_u32 alpha = pixels[i * 4 + 3];
+		if(alpha == 255) { continue; }
+		// Exact rounding of c * a / 255
+		for(te_u32 c = 0; c < 3; c++) {
+			te_u32 value = pixels[i * 4 + c] * alpha + 128;
+			pixels[i * 4 + c] = (te_u8)((value + (value >> 8)) >> 8);
+		}
+	}
+}
 
-				te_i32 widthOffset = (reportedSize.right - reportedSize.left) - (adjustedSize.right - adjustedSize.left);
-				te_i32 heightOffset = (reportedSize.bottom - reportedSize.top) - (reportedSize.bottom - reportedSize.top);
+//// Cooked Textures
+
+// GPU ready texture container written by the cooker tool (cooker.c). Pixels are premultiplied and every
+// mip level is stored in the upload format, so loading is one glTexImage2D or glCompressedTexImage2D per
+// level straight from the file mapping, with no decode or mipmap generation.
+//
+// Layout: header | levels[levelCount] | 16 byte aligned level data, largest level first
+
+#define TE_COOKED_TEXTURE_VERSION 1
+
+#define TE_COOKED_TEXTURE_PREMULTIPLIED 0x1
+
+typedef struct _tinyengine_cookedTextureHeader_t {
+	char magic[4]; // TETX
+	te_u32 version;
+	te_u32 format; // TE_TEXTURE_FORMAT_*
+	te_u32 width;
+	te_u32 height;
+	te_u32 levelCount;
+	te_u32 flags;
+	te_u32 reserved;
+} _tinyengine_cookedTextureHeader;
+
+typedef struct _tinyengine_cookedTextureLevel_t {
+	te_u64 offset;
+	te_u64 size;
+} _tinyengine_cookedTextureLevel;
+
+// Bytes of one mip level, 4x4 blocks for the compressed formats
+size_t tinyengine_textureLevelSize(te_u32 format, te_u32 width, te_u32 height) {
+	size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+	switch(format) {
+		case TE_TEXTURE_FORMAT_RGBA8: return (size_t) width * height * 4;
+		case TE_TEXTURE_FORMAT_BC1: return blocks * 8;
+		case TE_TEXTURE_FORMAT_BC3: return blocks * 16;
+		case TE_TEXTURE_FORMAT_ETC2_RGB8: return blocks * 8;
+		case TE_TEXTURE_FORMAT_ETC2_RGBA8: return blocks * 16;
+	}
+	return 0;
+}
 
-				const float ratio = (float) window->platform.aspectRatioWidth / (float) window->platform.aspectRatioHeight;
+// Validates the whole container, the level pointers point into data
+te_bool_u8 tinyengine_parseCookedTexture(const te_u8* data, size_t size, tinyengine_cookedTexture* texture) {
+	memset(texture, 0, sizeof(tinyengine_cookedTexture));
 
-				if (edge == WMSZ_LEFT  || edge == WMSZ_BOTTOMLEFT || edge == WMSZ_RIGHT || edge == WMSZ_BOTTOMRIGHT) {
-		        size->bottom = size->top + heightOffset + (int) ((size->right - size->left - widthOffset) / ratio);
-		    } else if (edge == WMSZ_TOPLEFT || edge == WMSZ_TOPRIGHT) {
-		        size->top = size->bottom - heightOffset - (int) ((size->right - size->left - widthOffset) / ratio);
-		    } else if (edge == WMSZ_TOP || edge == WMSZ_BOTTOM) {
-		        size->right = size->left + widthOffset + (int) ((size->bottom - size->top - heightOffset) * ratio);
-		    }
+	if(size < sizeof(_tinyengine_cookedTextureHeader)) { return TE_FALSE; }
+	const _tinyengine_cookedTextureHeader* header = (const _tinyengine_cookedTextureHeader*) data;
+	if(memcmp(header->magic, "TETX", 4) != 0 || header->version != TE_COOKED_TEXTURE_VERSION) { return TE_FALSE; }
+	if(header->width == 0 || header->height == 0 || header->width > (1 << 16) || header->height > (1 << 16)) { return TE_FALSE; }
+	if(header->levelCount == 0 || header->levelCount > TE_COOKED_TEXTURE_MAX_LEVELS) { return TE_FALSE; }
+	if(tinyengine_textureLevelSize(header->format, 1, 1) == 0) { return TE_FALSE; }
 
-				return TRUE;
-			}
-			break;
-		case WM_GETMINMAXINFO: // TODO: Seems to be busted in wine?
-			{
-				MINMAXINFO* info = (MINMAXINFO*) lParam;
+	const _tinyengine_cookedTextureLevel* levels = (const _tinyengine_cookedTextureLevel*)(data + sizeof(_tinyengine_cookedTextureHeader));
+	if(size - sizeof(_tinyengine_cookedTextureHeader) < header->levelCount * sizeof(_tinyengine_cookedTextureLevel)) { return TE_FALSE; }
 
-				RECT reportedSize;
-				RECT adjustedSize;
+	for(te_u32 i = 0; i < header->levelCount; i++) {
+		te_u32 width = header->width >> i ? header->width >> i : 1;
+		te_u32 height = header->height >> i ? header->height >> i : 1;
+		if(levels[i].size != tinyengine_textureLevelSize(header->format, width, height)) { return TE_FALSE; }
+		if(levels[i].offset > size || levels[i].size > size - levels[i].offset) { return TE_FALSE; }
 
-				// TODO: Should probably just memcpy this
-				GetClientRect(window->platform.win32window, &reportedSize);
-				GetClientRect(window->platform.win32window, &adjustedSize);
-				AdjustWindowRect(&adjustedSize,_TE_WINSTYLE,0);
+		texture->levels[i] = data + levels[i].offset;
+		texture->levelSizes[i] = (size_t) levels[i].size;
+	}
 
-				te_i32 widthOffset = (reportedSize.right - reportedSize.left) - (adjustedSize.right - adjustedSize.left);
-				te_i32 heightOffset = (reportedSize.bottom - reportedSize.top) - (reportedSize.bottom - reportedSize.top);
+	texture->format = header->format;
+	texture->width = header->width;
+	texture->height = header->height;
+	texture->levelCount = header->levelCount;
+	texture->premultiplied = (header->flags & TE_COOKED_TEXTURE_PREMULTIPLIED) != 0;
+	return TE_TRUE;
+}
 
-				if(window->platform.minWidth > 0 && window->platform.minHeight > 0 ){
-					info->ptMinTrackSize.x = window->platform.minWidth + widthOffset;
-          info->ptMinTrackSize.y = window->platform.minHeight + heightOffset;
-				}
+//// Asset Archive
+
+// Read only pack of named blobs, built by the packer tool (packer.c) and used straight from a file mapping.
+//
+// Layout, all offsets from the start of the file:
+//   header | entries[entryCount] | buckets[bucketCount] | names | 16 byte aligned blobs
+// Buckets are an open addressed table of entry index + 1 (0 is empty) keyed by the FNV-1a hash of the
+// name, at most half full, so a lookup is a hash and usually a single probe.
+
+#define TE_ARCHIVE_VERSION 1
+
+#define TE_ARCHIVE_RAW 0
+#define TE_ARCHIVE_LZ4 1
+
+typedef struct _tinyengine_archiveHeader_t {
+	char magic[4]; // TEPK
+	te_u32 version;
+	te_u32 entryCount;
+	te_u32 bucketCount; // power of two
+	te_u64 entriesOffset;
+	te_u64 bucketsOffset;
+	te_u64 namesOffset;
+	te_u64 namesSize;
+} _tinyengine_archiveHeader;
+
+typedef struct _tinyengine_archiveEntry_t {
+	te_u64 hash;
+	te_u64 offset;
+	te_u32 storedSize;
+	te_u32 size;
+	te_u32 nameOffset; // into the names block, names are null terminated
+	te_u16 nameLength;
+	te_u8 compression;
+	te_u8 reserved;
+} _tinyengine_archiveEntry;
+
+te_bool_u8 _tinyengine_archive_rangeValid(const tinyengine_archive* archive, te_u64 offset, te_u64 length) {
+	return offset <= archive->file.size && length <= archive->file.size - offset;
+}
 
-				if(window->platform.maxWidth > 0 && window->platform.maxHeight > 0 ){
-					info->ptMaxTrackSize.x = window->platform.maxWidth + widthOffset;
-          info->ptMaxTrackSize.y = window->platform.maxHeight + heightOffset;
-				}
+te_bool_u8 tinyengine_openArchive(const char* path, tinyengine_archive* archive) {
+	memset(archive, 0, sizeof(tinyengine_archive));
 
-				break;
-				return 0;
-			}
-			TE_LOG("TE1\n");
-			break;
+	if(!tinyengine_mapFile(path, &archive->file)) { return TE_FALSE; }
+
+	#if !defined(TE_WIN32)
+		// Lookups jump around, read ahead would only pull in neighbouring assets
+		madvise((void*) archive->file.data, archive->file.size, MADV_RANDOM);
+	#endif
+
+	const _tinyengine_archiveHeader* header = (const _tinyengine_archiveHeader*) archive->file.data;
+	te_bool_u8 valid = archive->file.size >= sizeof(_tinyengine_archiveHeader)
+		&& memcmp(header->magic, "TEPK", 4) == 0
+		&& header->version == TE_ARCHIVE_VERSION
+		&& header->bucketCount > header->entryCount
+		&& (header->bucketCount & (header->bucketCount - 1)) == 0
+		&& (header->entriesOffset & 7) == 0 && (header->bucketsOffset & 3) == 0
+		&& _tinyengine_archive_rangeValid(archive, header->entriesOffset, (te_u64) header->entryCount * sizeof(_tinyengine_archiveEntry))
+		&& _tinyengine_archive_rangeValid(archive, header->bucketsOffset, (te_u64) header->bucketCount * sizeof(te_u32))
+		&& _tinyengine_archive_rangeValid(archive, header->namesOffset, header->namesSize);
+
+	if(!valid) {
+		TE_ERROR("%s is not a valid asset archive\n", path);
+		tinyengine_unmapFile(&archive->file);
+		return TE_FALSE;
 	}
 
-	return DefWindowProc(hWindow,Message,wParam,lParam);
+	archive->entries = archive->file.data + header->entriesOffset;
+	archive->buckets = (const te_u32*)(archive->file.data + header->bucketsOffset);
+	archive->names = (const char*)(archive->file.data + header->namesOffset);
+	archive->namesSize = header->namesSize;
+	archive->entryCount = header->entryCount;
+	archive->bucketMask = header->bucketCount - 1;
+
+	TE_LOG("Opened archive %s with %u assets\n", path, archive->entryCount);
+
+	return TE_TRUE;
 }
 
-void _tinyengine_win32_pollEvents() {
-	MSG message;
+void tinyengine_closeArchive(tinyengine_archive* archive) {
+	tinyengine_unmapFile(&archive->file);
+	memset(archive, 0, sizeof(tinyengine_archive));
+}
 
-	while(PeekMessageA(&message,0,0,0,PM_REMOVE)){
-		//GetMessage(&message,0,0,0);
-		TranslateMessage(&message);
-		DispatchMessage(&message);
-	}
+// Entries are checked when found rather than all at open, so opening touches only the header
+te_bool_u8 _tinyengine_archive_fillAsset(const tinyengine_archive* archive, const _tinyengine_archiveEntry* entry, tinyengine_asset* asset) {
+	if(!_tinyengine_archive_rangeValid(archive, entry->offset, entry->storedSize)) { return TE_FALSE; }
+	if(entry->nameOffset >= archive->namesSize || entry->nameLength >= archive->namesSize - entry->nameOffset) { return TE_FALSE; }
+	if(entry->compression > TE_ARCHIVE_LZ4) { return TE_FALSE; }
+	if(entry->compression == TE_ARCHIVE_RAW && entry->storedSize != entry->size) { return TE_FALSE; }
+
+	asset->name = archive->names + entry->nameOffset;
+	asset->data = archive->file.data + entry->offset;
+	asset->size = entry->size;
+	asset->storedSize = entry->storedSize;
+	asset->compression = entry->compression;
+	return TE_TRUE;
 }
 
-void _tinyengine_win32_setWindowSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
+te_bool_u8 tinyengine_findAsset(const tinyengine_archive* archive, const char* name, tinyengine_asset* asset) {
+	memset(asset, 0, sizeof(tinyengine_asset));
+	if(archive->entryCount == 0) { return TE_FALSE; }
 
+	size_t length = strlen(name);
+	te_u64 hash = _tinyengine_fnv1a64(TE_FNV1A64_SEED, name, length);
+	const _tinyengine_archiveEntry* entries = (const _tinyengine_archiveEntry*) archive->entries;
 
-	RECT adjustedSize = {0,0,width,height};
-	AdjustWindowRect(&adjustedSize,_TE_WINSTYLE,0);
-	width = adjustedSize.right - adjustedSize.left;
-	height = adjustedSize.bottom - adjustedSize.top;
+	// A corrupt table may have no empty bucket, so the probe never visits more buckets than there are
+	te_u32 bucket = (te_u32) hash & archive->bucketMask;
+	for(te_u32 probe = 0; probe <= archive->bucketMask; probe++, bucket = (bucket + 1) & archive->bucketMask) {
+		te_u32 index = archive->buckets[bucket];
+		if(index == 0 || index > archive->entryCount) { return TE_FALSE; }
 
-	SetWindowPos(
-		window->platform.win32window,
-		HWND_TOP,0,0,
-		width, height,
-		SWP_NOACTIVATE | SWP_NOOWNERZORDER | SWP_NOMOVE | SWP_NOZORDER
-	);
-}
+		const _tinyengine_archiveEntry* entry = &entries[index - 1];
+		if(entry->hash != hash || entry->nameLength != length) { continue; }
+		if(entry->nameOffset >= archive->namesSize || length >= archive->namesSize - entry->nameOffset) { return TE_FALSE; }
+		if(memcmp(archive->names + entry->nameOffset, name, length) != 0) { continue; }
 
-void _tinyengine_win32_forceSizeUpdate(tinyengine_windowContext* window) {
-	RECT size;
-	GetWindowRect(window->platform.win32window, &size);
-	MoveWindow(window->platform.win32window,size.left, size.top, size.right - size.left, size.bottom - size.top, TRUE);
+		return _tinyengine_archive_fillAsset(archive, entry, asset);
+	}
+	return TE_FALSE;
 }
 
-void _tinyengine_win32_setWindowMaxSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
-	window->platform.maxWidth = width;
-	window->platform.maxHeight = height;
-	_tinyengine_win32_forceSizeUpdate(window);
+te_u32 tinyengine_getAssetCount(const tinyengine_archive* archive) {
+	return archive->entryCount;
 }
 
-void _tinyengine_win32_setWindowMinSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
-	window->platform.minWidth = width;
-	window->platform.minHeight = height;
-	_tinyengine_win32_forceSizeUpdate(window);
+te_bool_u8 tinyengine_getAssetByIndex(const tinyengine_archive* archive, te_u32 index, tinyengine_asset* asset) {
+	memset(asset, 0, sizeof(tinyengine_asset));
+	if(index >= archive->entryCount) { return TE_FALSE; }
+	return _tinyengine_archive_fillAsset(archive, &((const _tinyengine_archiveEntry*) archive->entries)[index], asset);
 }
 
-void _tinyengine_win32_setWindowAspectRatio(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
-	window->platform.aspectRatioWidth = width;
-	window->platform.aspectRatioHeight = height;
-	_tinyengine_win32_forceSizeUpdate(window);
-}
+// LZ4 block format, returns the decompressed size or 0 on malformed input or a short destination
+size_t tinyengine_lz4Decompress(const te_u8* source, size_t sourceSize, te_u8* destination, size_t destinationSize) {
+	const te_u8* in = source;
+	const te_u8* inEnd = source + sourceSize;
+	te_u8* out = destination;
+	te_u8* outEnd = destination + destinationSize;
+
+	while(in < inEnd) {
+		te_u8 token = *in++;
+
+		size_t literals = token >> 4;
+		if(literals == 15) {
+			te_u8 extra;
+			do {
+				if(in >= inEnd) { return 0; }
+				extra = *in++;
+				literals += extra;
+			} while(extra == 255);
+		}
+		if((size_t)(inEnd - in) < literals || (size_t)(outEnd - out) < literals) { return 0; }
+		memcpy(out, in, literals);
+		in += literals;
+		out += literals;
+
+		// The last sequence is literals only
+		if(in == inEnd) { break; }
+
+		if(inEnd - in < 2) { return 0; }
+		size_t offset = (size_t) in[0] | ((size_t) in[1] << 8);
+		in += 2;
+		if(offset == 0 || offset > (size_t)(out - destination)) { return 0; }
+
+		size_t length = (token & 15);
+		if(length == 15) {
+			te_u8 extra;
+			do {
+				if(in >= inEnd) { return 0; }
+				extra = *in++;
+				length += extra;
+			} while(extra == 255);
+		}
+		length += 4;
+		if((size_t)(outEnd - out) < length) { return 0; }
+
+		// Matches can overlap their own output
+		const te_u8* match = out - offset;
+		if(offset >= length) {
+			memcpy(out, match, length);
+			out += length;
+		} else {
+			while(length--) { *out++ = *match++; }
+		}
+	}
 
-void _tinyengine_win32_getWindowSize(tinyengine_windowContext* window, te_u32* width, te_u32* height) {
-	RECT adjustedSize;
-	GetClientRect(window->platform.win32window, &adjustedSize);
-	AdjustWindowRect(&adjustedSize,_TE_WINSTYLE,0);
-	*width = adjustedSize.right - adjustedSize.left;
-	*height = adjustedSize.bottom - adjustedSize.top;
+	return (size_t)(out - destination);
 }
 
-void _tinyengine_win32_setWindowTitle(tinyengine_windowContext* window, const char* title) {
-	SetWindowTextA(window->platform.win32window, title);
+// Raw assets are copied, prefer asset.data directly for those
+te_bool_u8 tinyengine_readAsset(const tinyengine_asset* asset, te_u8* destination, size_t destinationSize) {
+	if(destinationSize < asset->size) { return TE_FALSE; }
+	if(asset->compression == TE_ARCHIVE_RAW) { memcpy(destination, asset->data, asset->size); return TE_TRUE; }
+	return tinyengine_lz4Decompress(asset->data, asset->storedSize, destination, asset->size) == asset->size;
 }
 
-void _tinyengine_win32_showWindow(tinyengine_windowContext* window) {
-	ShowWindow(window->platform.win32window, SW_SHOWNA);
-}
+//// Spatial Grid
 
-te_bool_u8 _tinyengine_win32_createWindow(tinyengine_windowContext* window){
+// Loose uniform grid for culling large worlds. Each item lives in the one cell holding its top left corner,
+// so moving it is an in place update until it crosses a cell border. Queries widen the rectangle up and
+// left by the largest item seen. Cells are found through a hash of their coordinates, so the world has no
+// bounds and empty space costs nothing. Entries keep a copy of the bounds, a query reads cells linearly.
+// Item ids are slot + 1 and are reused after removal.
 
-	// TODO: Load modern GL pipelines
+#include <math.h> // floorf();
 
-	HINSTANCE Instance = GetModuleHandle(NULL);
+te_bool_u8 tinyengine_createSpatialGrid(tinyengine_spatialGrid* grid, te_f32 cellSize) {
+	memset(grid, 0, sizeof(tinyengine_spatialGrid));
+	if(!(cellSize > 0.0f)) { return TE_FALSE; }
+	grid->cellSize = cellSize;
+	grid->inverseCellSize = 1.0f / cellSize;
+	return TE_TRUE;
+}
 
-	RECT adjustedSize = {0,0,300,300};
-	AdjustWindowRect(&adjustedSize,_TE_WINSTYLE,0);
+void tinyengine_destroySpatialGrid(tinyengine_spatialGrid* grid) {
+	for(te_u32 i = 0; i < grid->cellCount; i++) { free(grid->cells[i].entries); }
+	free(grid->cells);
+	free(grid->buckets);
+	free(grid->items);
+	memset(grid, 0, sizeof(tinyengine_spatialGrid));
+}
 
-	int winWidth = adjustedSize.right - adjustedSize.left;
-	int winHeight = adjustedSize.bottom - adjustedSize.top;
+static inline te_i32 _tinyengine_spatialCoordinate(const tinyengine_spatialGrid* grid, te_f32 position) {
+	te_f32 cell = floorf(position * grid->inverseCellSize);
+	if(cell < -1073741824.0f) { return -1073741824; }
+	if(cell > 1073741824.0f) { return 1073741824; }
+	return (te_i32) cell;
+}
 
-	window->platform.win32window = CreateWindowExA(0,tinyengine_win32_className,"tinyengine",_TE_WINSTYLE,CW_USEDEFAULT,CW_USEDEFAULT,winWidth,winHeight,NULL,NULL,Instance,window);
+static inline te_u32 _tinyengine_spatialHash(te_i32 x, te_i32 y) {
+	return ((te_u32) x * 0x9E3779B1u) ^ ((te_u32) y * 0x85EBCA77u);
+}
 
-	if(!window->platform.win32window) {
-		#if defined(TE_DEBUG_OUTPUT_ENABLED)
-			DWORD errorCode = GetLastError();
-			LPSTR errorMessage = NULL;
-			FormatMessageA(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
-	                                 NULL, errorCode, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), (LPSTR)&errorMessage, 0, NULL);
-			TE_ERROR("Error while creating window: %s",errorMessage);
-		#endif
-		return TE_FALSE;
+// Cell index + 1, 0 when the cell does not exist
+static inline te_u32 _tinyengine_findSpatialCell(const tinyengine_spatialGrid* grid, te_i32 x, te_i32 y) {
+	if(grid->buckets == NULL) { return 0; }
+	for(te_u32 bucket = _tinyengine_spatialHash(x, y) & grid->bucketMask;; bucket = (bucket + 1) & grid->bucketMask) {
+		te_u32 cell = grid->buckets[bucket];
+		if(cell == 0) { return 0; }
+		if(grid->cells[cell - 1].x == x && grid->cells[cell - 1].y == y) { return cell; }
 	}
+}
 
-	SetPropA(window->platform.win32window, "tinyengine", window);
-
-	// TODO: Is this even neccesary?
-	UINT_PTR timeout = SetTimer(NULL,0,1000,NULL);
-	while(!window->platform.windowReady){
-		MSG message;
-		GetMessageA(&message,0,0,0);
-		if(message.message == WM_TIMER && message.wParam == timeout) {
-			TE_ERROR("Timeout while waiting for windowCreate event!\n");
-			return TE_FALSE;
+te_u32 _tinyengine_addSpatialCell(tinyengine_spatialGrid* grid, te_i32 x, te_i32 y) {
+	// Buckets stay at most half full
+	if((grid->cellCount + 1) * 2 > grid->bucketMask + 1 || grid->buckets == NULL) {
+		te_u32 bucketCount = grid->buckets ? (grid->bucketMask + 1) * 2 : 256;
+		te_u32* buckets = calloc(bucketCount, sizeof(te_u32));
+		if(buckets == NULL) { return 0; }
+		for(te_u32 i = 0; i < grid->cellCount; i++) {
+			te_u32 bucket = _tinyengine_spatialHash(grid->cells[i].x, grid->cells[i].y) & (bucketCount - 1);
+			while(buckets[bucket] != 0) { bucket = (bucket + 1) & (bucketCount - 1); }
+			buckets[bucket] = i + 1;
 		}
-		TranslateMessage(&message);
-		DispatchMessage(&message);
+		free(grid->buckets);
+		grid->buckets = buckets;
+		grid->bucketMask = bucketCount - 1;
 	}
-	KillTimer(NULL,timeout);
-
-	window->platform.win32deviceContext = GetDC(window->platform.win32window);
-
-	PIXELFORMATDESCRIPTOR pfd = {
-		sizeof(PIXELFORMATDESCRIPTOR),
-		1,
-		PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER, //Flags
-		PFD_TYPE_RGBA,        // The kind of framebuffer. RGBA or palette.
-		32,                   // Colordepth of the framebuffer.
-		0, 0, 0, 0, 0, 0,
-		0,
-		0,
-		0,
-		0, 0, 0, 0,
-		24,                   // Number of bits for the depthbuffer
-		8,                    // Number of bits for the stencilbuffer
-		0,                    // Number of Aux buffers in the framebuffer.
-		PFD_MAIN_PLANE,
-		0,
-		0, 0, 0
-	};
 
+	if(grid->cellCount == grid->cellCapacity) {
+		te_u32 capacity = grid->cellCapacity ? grid->cellCapacity * 2 : 128;
+		_tinyengine_spatialCell* cells = realloc(grid->cells, capacity * sizeof(_tinyengine_spatialCell));
+		if(cells == NULL) { return 0; }
+		grid->cells = cells;
+		grid->cellCapacity = capacity;
+	}
 
+	_tinyengine_spatialCell* cell = &grid->cells[grid->cellCount++];
+	memset(cell, 0, sizeof(_tinyengine_spatialCell));
+	cell->x = x;
+	cell->y = y;
 
-	int pixelFormat = ChoosePixelFormat(window->platform.win32deviceContext,&pfd);
-	SetPixelFormat(window->platform.win32deviceContext,pixelFormat,&pfd);
+	te_u32 bucket = _tinyengine_spatialHash(x, y) & grid->bucketMask;
+	while(grid->buckets[bucket] != 0) { bucket = (bucket + 1) & grid->bucketMask; }
+	grid->buckets[bucket] = grid->cellCount;
+	return grid->cellCount;
+}
 
-	window->platform.win32openGLcontext = wglCreateContext(window->platform.win32deviceContext);
+te_bool_u8 _tinyengine_linkSpatialItem(tinyengine_spatialGrid* grid, te_u32 slot, te_f32 x, te_f32 y, te_f32 width, te_f32 height, te_u32 value) {
+	te_i32 cellX = _tinyengine_spatialCoordinate(grid, x);
+	te_i32 cellY = _tinyengine_spatialCoordinate(grid, y);
+	te_u32 cellIndex = _tinyengine_findSpatialCell(grid, cellX, cellY);
+	if(cellIndex == 0 && (cellIndex = _tinyengine_addSpatialCell(grid, cellX, cellY)) == 0) { return TE_FALSE; }
+
+	_tinyengine_spatialCell* cell = &grid->cells[cellIndex - 1];
+	if(cell->count == cell->capacity) {
+		te_u32 capacity = cell->capacity ? cell->capacity * 2 : 8;
+		_tinyengine_spatialEntry* entries = realloc(cell->entries, capacity * sizeof(_tinyengine_spatialEntry));
+		if(entries == NULL) { return TE_FALSE; }
+		cell->entries = entries;
+		cell->capacity = capacity;
+	}
 
+	_tinyengine_spatialEntry* entry = &cell->entries[cell->count];
+	entry->x0 = x;
+	entry->y0 = y;
+	entry->x1 = x + width;
+	entry->y1 = y + height;
+	entry->value = value;
+	entry->item = slot;
+	grid->items[slot].cell = cellIndex;
+	grid->items[slot].index = cell->count++;
+
+	if(width > grid->maxWidth) { grid->maxWidth = width; }
+	if(height > grid->maxHeight) { grid->maxHeight = height; }
 	return TE_TRUE;
 }
 
-void _tinyengine_win32_destroyWindow() {}
+void _tinyengine_unlinkSpatialItem(tinyengine_spatialGrid* grid, te_u32 slot) {
+	_tinyengine_spatialItem* item = &grid->items[slot];
+	_tinyengine_spatialCell* cell = &grid->cells[item->cell - 1];
 
-te_bool_u8 _tinyengine_win32_init() {
-	HINSTANCE Instance = GetModuleHandle(NULL);
-	WNDCLASSEXA winClassParams = {0};
-	winClassParams.cbSize = sizeof(WNDCLASSEX);
-	winClassParams.style = CS_OWNDC;
-	winClassParams.lpfnWndProc = _tinyengine_win32_eventCallback;
-	winClassParams.hInstance = Instance;
-	//	winClass.hIcon = ; TODO: Implement Window Icon
-	winClassParams.hCursor = LoadCursor(NULL, IDC_ARROW);
-	winClassParams.lpszClassName = tinyengine_win32_className;
-	RegisterClassExA(&winClassParams);
-	TE_LOG("win32 windows manager loaded.\n");
-	return TE_TRUE;
+	// Swap remove, the last entry takes the hole
+	cell->count--;
+	if(item->index != cell->count) {
+		cell->entries[item->index] = cell->entries[cell->count];
+		grid->items[cell->entries[item->index].item].index = item->index;
+	}
 }
 
-void _tinyengine_win32_terminate() {
+// Returns an item id for move and remove, 0 on failure. value is what queries report.
+te_u32 tinyengine_insertSpatialItem(tinyengine_spatialGrid* grid, te_f32 x, te_f32 y, te_f32 width, te_f32 height, te_u32 value) {
+	te_u32 slot;
+	if(grid->freeItem != 0) {
+		slot = grid->freeItem - 1;
+		grid->freeItem = grid->items[slot].index;
+	} else {
+		if(grid->itemCount == 0xFFFFFFFE) { return 0; }
+		if(grid->itemCount == grid->itemCapacity) {
+			te_u32 capacity = grid->itemCapacity ? grid->itemCapacity * 2 : 1024;
+			_tinyengine_spatialItem* items = realloc(grid->items, capacity * sizeof(_tinyengine_spatialItem));
+			if(items == NULL) { return 0; }
+			grid->items = items;
+			grid->itemCapacity = capacity;
+		}
+		slot = grid->itemCount++;
+	}
 
+	if(!_tinyengine_linkSpatialItem(grid, slot, x, y, width, height, value)) {
+		grid->items[slot].cell = 0;
+		grid->items[slot].index = grid->freeItem;
+		grid->freeItem = slot + 1;
+		return 0;
+	}
+	grid->length++;
+	return slot + 1;
 }
 
-void _tinyengine_wgl_makeCurrent(tinyengine_windowContext* window) {
-	wglMakeCurrent (window->platform.win32deviceContext, window->platform.win32openGLcontext);
+void tinyengine_moveSpatialItem(tinyengine_spatialGrid* grid, te_u32 item, te_f32 x, te_f32 y, te_f32 width, te_f32 height) {
+	if(item == 0 || item > grid->itemCount || grid->items[item - 1].cell == 0) { return; }
+	te_u32 slot = item - 1;
+	_tinyengine_spatialCell* cell = &grid->cells[grid->items[slot].cell - 1];
+	_tinyengine_spatialEntry* entry = &cell->entries[grid->items[slot].index];
+
+	// Staying in the same cell is the common case for small movements
+	if(_tinyengine_spatialCoordinate(grid, x) == cell->x && _tinyengine_spatialCoordinate(grid, y) == cell->y) {
+		entry->x0 = x;
+		entry->y0 = y;
+		entry->x1 = x + width;
+		entry->y1 = y + height;
+		if(width > grid->maxWidth) { grid->maxWidth = width; }
+		if(height > grid->maxHeight) { grid->maxHeight = height; }
+		return;
+	}
+
+	te_u32 value = entry->value;
+	_tinyengine_unlinkSpatialItem(grid, slot);
+	if(!_tinyengine_linkSpatialItem(grid, slot, x, y, width, height, value)) {
+		TE_ERROR("Could not move spatial item, it was removed!\n");
+		grid->items[slot].cell = 0;
+		grid->items[slot].index = grid->freeItem;
+		grid->freeItem = slot + 1;
+		grid->length--;
+	}
 }
 
-void _tinyengine_wgl_swapBuffers(tinyengine_windowContext* window) {
-	SwapBuffers(window->platform.win32deviceContext);
+void tinyengine_removeSpatialItem(tinyengine_spatialGrid* grid, te_u32 item) {
+	if(item == 0 || item > grid->itemCount || grid->items[item - 1].cell == 0) { return; }
+	te_u32 slot = item - 1;
+	_tinyengine_unlinkSpatialItem(grid, slot);
+	grid->items[slot].cell = 0;
+	grid->items[slot].index = grid->freeItem;
+	grid->freeItem = slot + 1;
+	grid->length--;
 }
 
-#else // empty window system
+// Writes the values of up to maxValues items overlapping the rectangle, returns how many overlap in total
+te_u32 tinyengine_querySpatialGrid(const tinyengine_spatialGrid* grid, te_f32 x, te_f32 y, te_f32 width, te_f32 height, te_u32* values, te_u32 maxValues) {
+	te_f32 x1 = x + width;
+	te_f32 y1 = y + height;
+	te_i32 cellX0 = _tinyengine_spatialCoordinate(grid, x - grid->maxWidth);
+	te_i32 cellY0 = _tinyengine_spatialCoordinate(grid, y - grid->maxHeight);
+	te_i32 cellX1 = _tinyengine_spatialCoordinate(grid, x1);
+	te_i32 cellY1 = _tinyengine_spatialCoordinate(grid, y1);
+
+	// Zoomed far out the rectangle spans more cells than exist, then walking the cell list is cheaper
+	te_u64 span = (te_u64)((te_i64) cellX1 - cellX0 + 1) * (te_u64)((te_i64) cellY1 - cellY0 + 1);
+	te_bool_u8 walkCells = span > grid->cellCount;
+
+	te_u32 found = 0;
+	te_i32 cellX = cellX0, cellY = cellY0;
+	for(te_u32 next = 0;;) {
+		const _tinyengine_spatialCell* cell;
+		if(walkCells) {
+			if(next == grid->cellCount) { break; }
+			cell = &grid->cells[next++];
+			if(cell->x < cellX0 || cell->x > cellX1 || cell->y < cellY0 || cell->y > cellY1) { continue; }
+		} else {
+			if(cellY > cellY1) { break; }
+			te_u32 cellIndex = _tinyengine_findSpatialCell(grid, cellX, cellY);
+			if(++cellX > cellX1) { cellX = cellX0; cellY++; }
+			if(cellIndex == 0) { continue; }
+			cell = &grid->cells[cellIndex - 1];
+		}
 
+		for(te_u32 i = 0; i < cell->count; i++) {
+			const _tinyengine_spatialEntry* entry = &cell->entries[i];
+			if(entry->x0 > x1 || entry->x1 < x || entry->y0 > y1 || entry->y1 < y) { continue; }
+			if(found < maxValues) { values[found] = entry->value; }
+			found++;
+		}
+	}
+	return found;
+}
 
+//// Entities
 
-#endif
+// Archetype storage: each combination of components is an archetype with its own chunks, and a chunk keeps
+// one packed array per component. Queries walk matching chunks front to back, systems get whole chunks and
+// are spread over worker threads. Removing an entity moves the last one of its archetype into the hole, so
+// chunks never have gaps. Creating, destroying and changing components must not happen while systems run.
 
-#include <string.h>
+#define _TE_ENTITY_SLOT(_e) (((_e) & 0xFFFFFF) - 1)
+#define _TE_ENTITY_GENERATION(_e) ((_e) >> 24)
 
-void _tinyengine_windowCallbackStub(tinyengine_windowContext* window, ...) { };
+#define _TE_ENTITY_ALIGN(_n) (((_n) + 15) & ~(te_u32) 15)
 
-tinyengine_windowContext* tinyengine_createWindow() {
+#define TE_MAX_ENTITY_THREADS 64
 
-	tinyengine_windowContext* window = malloc(sizeof(tinyengine_windowContext));
-	memset(window, 0, sizeof(tinyengine_windowContext));
+#if defined(TE_PTHREADS)
+	#include <unistd.h> // sysconf();
+
+	typedef struct _tinyengine_entityWorkers_t {
+		pthread_t threads[TE_MAX_ENTITY_THREADS];
+		te_u32 threadCount;
+		pthread_mutex_t lock;
+		pthread_cond_t wake;
+		pthread_cond_t done;
+		te_bool_u8 exit;
+		te_u32 generation; // bumped for every run
+
+		// The current run, written under the lock and read under it before claiming. nextClaim is the run
+		// generation in the high 32 bits and the next index in the low ones, so a worker still looping over
+		// an older run can never claim an index of the newer one.
+		tinyengine_world* world;
+		const tinyengine_system* systems;
+		te_u32 workCount;
+		te_u64 nextClaim;
+		te_u32 finished;
+		te_u32 busy; // workers that joined the run and have not left it
+	} _tinyengine_entityWorkers;
+#endif
 
-	te_bool_u8 valid = TE_FALSE;
+// Transform and sprite, 0 picks one thread per core. Threads are only started once systems run in parallel.
+te_bool_u8 tinyengine_createWorld(tinyengine_world* world, te_u32 threadCount) {
+	memset(world, 0, sizeof(tinyengine_world));
 
-	#if defined(TE_LINUX)
-		valid = _tinyengine_x11_createWindow(window);
-	#elif defined(TE_WIN32)
-		valid = _tinyengine_win32_createWindow(window);
+	#if defined(TE_PTHREADS)
+		if(threadCount == 0) {
+			long cores = sysconf(_SC_NPROCESSORS_ONLN);
+			threadCount = cores > 0 ? (te_u32) cores : 1;
+		}
+		if(threadCount > TE_MAX_ENTITY_THREADS) { threadCount = TE_MAX_ENTITY_THREADS; }
+	#else
+		threadCount = 1;
 	#endif
+	world->threadCount = threadCount;
 
-	if(!valid) { free(window); return NULL; }
-
-	window->keyCallback = &_tinyengine_windowCallbackStub;
-	window->closeCallback = &_tinyengine_windowCallbackStub;
-	window->characterCallback = &_tinyengine_windowCallbackStub;
-	window->frameCallback = &_tinyengine_windowCallbackStub;
+	te_u32 component;
+	return tinyengine_registerComponent(world, sizeof(tinyengine_transform), &component) && tinyengine_registerComponent(world, sizeof(tinyengine_sprite), &component);
+}
 
-	_tinyengine_pushWindowContext(window);
+void tinyengine_destroyWorld(tinyengine_world* world) {
+	#if defined(TE_PTHREADS)
+		_tinyengine_entityWorkers* workers = world->workers;
+		if(workers) {
+			pthread_mutex_lock(&workers->lock);
+			workers->exit = TE_TRUE;
+			pthread_cond_broadcast(&workers->wake);
+			pthread_mutex_unlock(&workers->lock);
+			for(te_u32 i = 0; i < workers->threadCount; i++) { pthread_join(workers->threads[i], NULL); }
+			pthread_mutex_destroy(&workers->lock);
+			pthread_cond_destroy(&workers->wake);
+			pthread_cond_destroy(&workers->done);
+			free(workers);
+		}
+	#endif
 
-	return window;
+	for(te_u32 i = 0; i < world->archetypeCount; i++) {
+		for(te_u32 chunk = 0; chunk < world->archetypes[i].chunkCount; chunk++) { free(world->archetypes[i].chunks[chunk].data); }
+		free(world->archetypes[i].chunks);
+	}
+	free(world->archetypes);
+	free(world->slots);
+	free(world->work);
+	memset(world, 0, sizeof(tinyengine_world));
 }
 
-void tinyengine_destroyWindow(tinyengine_windowContext* window) {
-	if(window == NULL) { return; }
-	#if defined(TE_LINUX)
-		_tinyengine_x11_destroyWindow(window);
-	#elif defined(TE_WIN32)
-		_tinyengine_win32_destroyWindow(window);
-	#endif
-	_tinyengine_removeWindowContext(window);
-	free(window);
+// Component ids are handed out in order, TE_COMPONENT(id) makes the mask bit
+te_bool_u8 tinyengine_registerComponent(tinyengine_world* world, te_u32 size, te_u32* component) {
+	if(size == 0 || world->componentCount == TE_MAX_COMPONENTS) { return TE_FALSE; }
+	world->componentSizes[world->componentCount] = size;
+	*component = world->componentCount++;
+	return TE_TRUE;
 }
 
-void tinyengine_destroyAllWindows() {
+// Archetype index + 1, 0 when a component is not registered or out of memory
+te_u32 _tinyengine_findArchetype(tinyengine_world* world, tinyengine_componentMask mask) {
+	for(te_u32 i = 0; i < world->archetypeCount; i++) {
+		if(world->archetypes[i].mask == mask) { return i + 1; }
+	}
 
-	tinyengine_windowContextList_node* node = tinyengine_state.windowContextList.head;
+	te_u32 entityBytes = sizeof(tinyengine_entity);
+	te_u32 arrays = 1;
+	for(te_u32 id = 0; id < TE_MAX_COMPONENTS; id++) {
+		if(!(mask & TE_COMPONENT(id))) { continue; }
+		if(world->componentSizes[id] == 0) { return 0; }
+		entityBytes += world->componentSizes[id];
+		arrays++;
+	}
 
-	while(node != NULL) {
-		tinyengine_windowContext* window = node->value;
-		if(window != NULL) {
-			#if defined(TE_LINUX)
-				_tinyengine_x11_destroyWindow(window);
-			#elif defined(TE_WIN32)
-				_tinyengine_win32_destroyWindow(window);
-			#endif
-			free(window);
+	if(world->archetypeCount == world->archetypeCapacity) {
+		te_u32 capacity = world->archetypeCapacity ? world->archetypeCapacity * 2 : 16;
+		_tinyengine_archetype* archetypes = realloc(world->archetypes, capacity * sizeof(_tinyengine_archetype));
+		if(archetypes == NULL) { return 0; }
+		world->archetypes = archetypes;
+		world->archetypeCapacity = capacity;
+	}
+
+	_tinyengine_archetype* archetype = &world->archetypes[world->archetypeCount];
+	memset(archetype, 0, sizeof(_tinyengine_archetype));
+	archetype->mask = mask;
+
+	// Every array starts 16 byte aligned, which costs at most 16 bytes each
+	te_u32 usable = TE_ENTITY_CHUNK_BYTES > arrays * 16 ? TE_ENTITY_CHUNK_BYTES - arrays * 16 : 0;
+	archetype->chunkCapacity = usable / entityBytes ? usable / entityBytes : 1;
+	te_u32 offset = _TE_ENTITY_ALIGN(archetype->chunkCapacity * (te_u32) sizeof(tinyengine_entity));
+	for(te_u32 id = 0; id < TE_MAX_COMPONENTS; id++) {
+		if(!(mask & TE_COMPONENT(id))) { continue; }
+		archetype->offsets[id] = offset;
+		offset = _TE_ENTITY_ALIGN(offset + archetype->chunkCapacity * world->componentSizes[id]);
+	}
+	archetype->chunkBytes = offset;
+
+	return ++world->archetypeCount;
+}
+
+static inline te_u8* _tinyengine_entityComponent(const tinyengine_world* world, const _tinyengine_archetype* archetype, te_u32 chunk, te_u32 row, te_u32 id) {
+	return archetype->chunks[chunk].data + archetype->offsets[id] + (size_t) row * world->componentSizes[id];
+}
+
+// Zero, apart from a scale of 1 and a white tint so a new sprite shows up
+void _tinyengine_initComponent(const tinyengine_world* world, te_u32 id, te_u8* data) {
+	memset(data, 0, world->componentSizes[id]);
+	if(id == TE_COMPONENT_TRANSFORM) { ((tinyengine_transform*) data)->scale = 1.0f; }
+	if(id == TE_COMPONENT_SPRITE) { memset(((tinyengine_sprite*) data)->color, 255, 4); }
+}
+
+// Room for one more entity at the end of the archetype, the row is left uninitialized
+te_bool_u8 _tinyengine_appendEntityRow(tinyengine_world* world, te_u32 archetypeIndex, te_u32* chunkIndex, te_u32* row) {
+	_tinyengine_archetype* archetype = &world->archetypes[archetypeIndex];
+
+	if(archetype->chunkCount == 0 || archetype->chunks[archetype->chunkCount - 1].count == archetype->chunkCapacity) {
+		if(archetype->chunkCount == archetype->chunksAllocated) {
+			te_u32 capacity = archetype->chunksAllocated ? archetype->chunksAllocated * 2 : 8;
+			_tinyengine_entityChunk* chunks = realloc(archetype->chunks, capacity * sizeof(_tinyengine_entityChunk));
+			if(chunks == NULL) { return TE_FALSE; }
+			archetype->chunks = chunks;
+			archetype->chunksAllocated = capacity;
 		}
-		free(node);
-		node = node->next;
+		te_u8* data = malloc(archetype->chunkBytes);
+		if(data == NULL) { return TE_FALSE; }
+		archetype->chunks[archetype->chunkCount].data = data;
+		archetype->chunks[archetype->chunkCount].count = 0;
+		archetype->chunkCount++;
 	}
 
-	tinyengine_state.windowContextList.head = NULL;
-	tinyengine_state.windowContextList.tail = NULL;
-	tinyengine_state.windowContextList.length = 0;
+	*chunkIndex = archetype->chunkCount - 1;
+	*row = archetype->chunks[*chunkIndex].count++;
+	archetype->length++;
+	return TE_TRUE;
 }
 
-void tinyengine_setWindowMaxSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
-	#if defined(TE_LINUX)
-		_tinyengine_x11_setWindowMaxSize(window,width,height);
-	#elif defined(TE_WIN32)
-		_tinyengine_win32_setWindowMaxSize(window,width,height);
-	#endif
+// Fills the hole with the last entity of the archetype
+void _tinyengine_removeEntityRow(tinyengine_world* world, te_u32 archetypeIndex, te_u32 chunkIndex, te_u32 row) {
+	_tinyengine_archetype* archetype = &world->archetypes[archetypeIndex];
+	te_u32 lastChunk = archetype->chunkCount - 1;
+	te_u32 lastRow = archetype->chunks[lastChunk].count - 1;
+
+	if(chunkIndex != lastChunk || row != lastRow) {
+		tinyengine_entity moved = ((tinyengine_entity*) archetype->chunks[lastChunk].data)[lastRow];
+		((tinyengine_entity*) archetype->chunks[chunkIndex].data)[row] = moved;
+		for(te_u32 id = 0; id < TE_MAX_COMPONENTS; id++) {
+			if(!(archetype->mask & TE_COMPONENT(id))) { continue; }
+			memcpy(_tinyengine_entityComponent(world, archetype, chunkIndex, row, id), _tinyengine_entityComponent(world, archetype, lastChunk, lastRow, id), world->componentSizes[id]);
+		}
+		_tinyengine_entitySlot* slot = &world->slots[_TE_ENTITY_SLOT(moved)];
+		slot->chunk = chunkIndex;
+		slot->row = row;
+	}
+
+	archetype->length--;
+	if(--archetype->chunks[lastChunk].count == 0) {
+		free(archetype->chunks[lastChunk].data);
+		archetype->chunkCount--;
+	}
 }
 
-void tinyengine_setWindowMinSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
-	#if defined(TE_LINUX)
-		_tinyengine_x11_setWindowMinSize(window,width,height);
-	#elif defined(TE_WIN32)
-		_tinyengine_win32_setWindowMinSize(window,width,height);
-	#endif
+// Components start zeroed, see _tinyengine_initComponent(). 0 when a component is not registered.
+tinyengine_entity tinyengine_createEntity(tinyengine_world* world, tinyengine_componentMask components) {
+	te_u32 archetypeIndex = _tinyengine_findArchetype(world, components);
+	if(archetypeIndex == 0) { return 0; }
+	archetypeIndex--;
+
+	te_u32 slotIndex;
+	if(world->freeSlot) {
+		slotIndex = world->freeSlot - 1;
+	} else {
+		if(world->slotCount == TE_MAX_ENTITIES) { TE_ERROR("Too many entities!\n"); return 0; }
+		if(world->slotCount == world->slotCapacity) {
+			te_u32 capacity = world->slotCapacity ? world->slotCapacity * 2 : 1024;
+			_tinyengine_entitySlot* slots = realloc(world->slots, capacity * sizeof(_tinyengine_entitySlot));
+			if(slots == NULL) { return 0; }
+			world->slots = slots;
+			world->slotCapacity = capacity;
+		}
+		slotIndex = world->slotCount;
+		world->slots[slotIndex].generation = 0;
+	}
+
+	te_u32 chunk, row;
+	if(!_tinyengine_appendEntityRow(world, archetypeIndex, &chunk, &row)) { return 0; }
+	if(slotIndex == world->slotCount) { world->slotCount++; } else { world->freeSlot = world->slots[slotIndex].chunk; }
+
+	_tinyengine_entitySlot* slot = &world->slots[slotIndex];
+	tinyengine_entity entity = ((te_u32) slot->generation << 24) | (slotIndex + 1);
+	slot->archetype = archetypeIndex + 1;
+	slot->chunk = chunk;
+	slot->row = row;
+
+	_tinyengine_archetype* archetype = &world->archetypes[archetypeIndex];
+	((tinyengine_entity*) archetype->chunks[chunk].data)[row] = entity;
+	for(te_u32 id = 0; id < TE_MAX_COMPONENTS; id++) {
+		if(archetype->mask & TE_COMPONENT(id)) { _tinyengine_initComponent(world, id, _tinyengine_entityComponent(world, archetype, chunk, row, id)); }
+	}
+
+	world->length++;
+	return entity;
 }
 
-void tinyengine_setWindowAspectRatio(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
-	#if defined(TE_LINUX)
-		_tinyengine_x11_setWindowAspectRatio(window,width,height);
-	#elif defined(TE_WIN32)
-		_tinyengine_win32_setWindowAspectRatio(window,width,height);
-	#endif
+te_bool_u8 tinyengine_isEntityAlive(const tinyengine_world* world, tinyengine_entity entity) {
+	te_u32 slot = _TE_ENTITY_SLOT(entity);
+	return slot < world->slotCount && world->slots[slot].archetype != 0 && world->slots[slot].generation == _TE_ENTITY_GENERATION(entity);
 }
 
-void tinyengine_showWindow(tinyengine_windowContext* window) {
-	#if defined(TE_LINUX)
-		_tinyengine_x11_showWindow(window);
-	#elif defined(TE_WIN32)
-		_tinyengine_win32_showWindow(window);
-	#endif
+void tinyengine_destroyEntity(tinyengine_world* world, tinyengine_entity entity) {
+	if(!tinyengine_isEntityAlive(world, entity)) { return; }
+	te_u32 slotIndex = _TE_ENTITY_SLOT(entity);
+	_tinyengine_entitySlot* slot = &world->slots[slotIndex];
+
+	_tinyengine_removeEntityRow(world, slot->archetype - 1, slot->chunk, slot->row);
+
+	slot->archetype = 0;
+	slot->generation++;
+	slot->chunk = world->freeSlot;
+	world->freeSlot = slotIndex + 1;
+	world->length--;
 }
 
-void tinyengine_setWindowTitle(tinyengine_windowContext* window, const char* title){
-	#if defined(TE_LINUX)
-		_tinyengine_x11_setWindowTitle(window,title);
-	#elif defined(TE_WIN32)
-		_tinyengine_win32_setWindowTitle(window,title);
-	#endif
+// Moves the entity to the archetype of the new mask, keeping the components both have
+te_bool_u8 _tinyengine_setEntityComponents(tinyengine_world* world, tinyengine_entity entity, tinyengine_componentMask components) {
+	if(!tinyengine_isEntityAlive(world, entity)) { return TE_FALSE; }
+	te_u32 slotIndex = _TE_ENTITY_SLOT(entity);
+	te_u32 sourceIndex = world->slots[slotIndex].archetype - 1;
+	if(world->archetypes[sourceIndex].mask == components) { return TE_TRUE; }
+
+	te_u32 targetIndex = _tinyengine_findArchetype(world, components);
+	if(targetIndex == 0) { return TE_FALSE; }
+	targetIndex--;
+
+	te_u32 chunk, row;
+	if(!_tinyengine_appendEntityRow(world, targetIndex, &chunk, &row)) { return TE_FALSE; }
+
+	_tinyengine_entitySlot* slot = &world->slots[slotIndex];
+	const _tinyengine_archetype* source = &world->archetypes[sourceIndex];
+	_tinyengine_archetype* target = &world->archetypes[targetIndex];
+	((tinyengine_entity*) target->chunks[chunk].data)[row] = entity;
+	for(te_u32 id = 0; id < TE_MAX_COMPONENTS; id++) {
+		if(!(components & TE_COMPONENT(id))) { continue; }
+		te_u8* data = _tinyengine_entityComponent(world, target, chunk, row, id);
+		if(source->mask & TE_COMPONENT(id)) {
+			memcpy(data, _tinyengine_entityComponent(world, source, slot->chunk, slot->row, id), world->componentSizes[id]);
+		} else {
+			_tinyengine_initComponent(world, id, data);
+		}
+	}
+
+	_tinyengine_removeEntityRow(world, sourceIndex, slot->chunk, slot->row);
+	slot->archetype = targetIndex + 1;
+	slot->chunk = chunk;
+	slot->row = row;
+	return TE_TRUE;
 }
 
-void tinyengine_setWindowSize(tinyengine_windowContext* window, te_u32 width, te_u32 height){
-	#if defined(TE_LINUX)
-		_tinyengine_x11_setWindowSize(window,width,height);
-	#elif defined(TE_WIN32)
-		_tinyengine_win32_setWindowSize(window,width,height);
-	#endif
+te_bool_u8 tinyengine_addComponents(tinyengine_world* world, tinyengine_entity entity, tinyengine_componentMask components) {
+	if(!tinyengine_isEntityAlive(world, entity)) { return TE_FALSE; }
+	return _tinyengine_setEntityComponents(world, entity, world->archetypes[world->slots[_TE_ENTITY_SLOT(entity)].archetype - 1].mask | components);
 }
 
-// TODO: this name isnt very descriptive to the window system, but also cant be generalized for the input?
-void tinyengine_pollEvents() {
-	#if defined(TE_LINUX)
-		_tinyengine_x11_pollDisplayEvents();
-	#elif defined(TE_WIN32)
-		_tinyengine_win32_pollEvents();
-	#endif
+te_bool_u8 tinyengine_removeComponents(tinyengine_world* world, tinyengine_entity entity, tinyengine_componentMask components) {
+	if(!tinyengine_isEntityAlive(world, entity)) { return TE_FALSE; }
+	return _tinyengine_setEntityComponents(world, entity, world->archetypes[world->slots[_TE_ENTITY_SLOT(entity)].archetype - 1].mask & ~components);
 }
 
-void tinyengine_swapBuffers(tinyengine_windowContext* window) {
-	#if defined(TE_LINUX)
-		_tinyengine_glx_swapBuffers(window);
-	#elif defined(TE_WIN32)
-		_tinyengine_wgl_swapBuffers(window);
-	#endif
+// NULL when the entity is gone or lacks the component, valid until the next structural change
+void* tinyengine_getComponent(const tinyengine_world* world, tinyengine_entity entity, te_u32 component) {
+	if(component >= TE_MAX_COMPONENTS || !tinyengine_isEntityAlive(world, entity)) { return NULL; }
+	const _tinyengine_entitySlot* slot = &world->slots[_TE_ENTITY_SLOT(entity)];
+	const _tinyengine_archetype* archetype = &world->archetypes[slot->archetype - 1];
+	if(!(archetype->mask & TE_COMPONENT(component))) { return NULL; }
+	return _tinyengine_entityComponent(world, archetype, slot->chunk, slot->row, component);
 }
 
-void tinyengine_makeCurrent(tinyengine_windowContext* window) {
-	#if defined(TE_LINUX)
-		_tinyengine_glx_makeCurrent(window);
-	#elif defined(TE_WIN32)
-		_tinyengine_wgl_makeCurrent(window);
-	#endif
+void tinyengine_beginEntityQuery(tinyengine_entityQuery* query, tinyengine_componentMask include, tinyengine_componentMask exclude) {
+	query->include = include;
+	query->exclude = exclude;
+	query->archetype = 0;
+	query->chunk = 0;
 }
 
-//// Renderer
+te_bool_u8 tinyengine_nextEntityChunk(const tinyengine_world* world, tinyengine_entityQuery* query, tinyengine_entityChunk* chunk) {
+	for(; query->archetype < world->archetypeCount; query->archetype++, query->chunk = 0) {
+		const _tinyengine_archetype* archetype = &world->archetypes[query->archetype];
+		if((archetype->mask & query->include) != query->include || (archetype->mask & query->exclude) || query->chunk >= archetype->chunkCount) { continue; }
+
+		const _tinyengine_entityChunk* source = &archetype->chunks[query->chunk++];
+		chunk->archetype = archetype;
+		chunk->data = source->data;
+		chunk->entities = (const tinyengine_entity*) source->data;
+		chunk->count = source->count;
+		return TE_TRUE;
+	}
+	return TE_FALSE;
+}
 
-// TODO: Support multiple renderers and allow selection of them with flags outside of platform
-#if defined(TE_LINUX) || defined(TE_WIN32)
-// opengl renderer
-// TODO: Create fallback opengl 1.0 renderer
+// The chunk's array of one component, NULL when its archetype does not have it
+void* tinyengine_getChunkComponents(const tinyengine_entityChunk* chunk, te_u32 component) {
+	if(component >= TE_MAX_COMPONENTS || !(chunk->archetype->mask & TE_COMPONENT(component))) { return NULL; }
+	return chunk->data + chunk->archetype->offsets[component];
+}
 
-static const char* TE_GL3_SPRITE_VERTEX_SRC =
-		"#version 130                                                            \n"
-		"in vec4 vertex;                                                         \n"
-		"out vec2 tex_cords;                                                     \n"
-		"                                                                        \n"
-		"uniform mat4 projection;                                                \n"
-		"                                                                        \n"
-		"void main()                                                             \n"
-		"{                                                                       \n"
-		"    tex_cords = vertex.zw;                                              \n"
-		"    gl_Position = vec4(vertex.x, vertex.y, 1.0, 1.0) * projection;      \n"
-		"}                                                                       \n"
-;
+// Source rectangle in pixels from the top left of the texture, drawn at its own size
+void tinyengine_setSprite(tinyengine_sprite* sprite, te_u32 texture, te_f32 textureWidth, te_f32 textureHeight, te_f32 x, te_f32 y, te_f32 width, te_f32 height) {
+	te_f32 u0 = x / textureWidth, v0 = 1.0f - y / textureHeight;
+	te_f32 u1 = u0 + width / textureWidth, v1 = v0 - height / textureHeight;
+	sprite->texture = texture;
+	sprite->width = width;
+	sprite->height = height;
+	sprite->u0 = (te_u16) ((u0 < 0.0f ? 0.0f : (u0 > 1.0f ? 1.0f : u0)) * 65535.0f + 0.5f);
+	sprite->v0 = (te_u16) ((v0 < 0.0f ? 0.0f : (v0 > 1.0f ? 1.0f : v0)) * 65535.0f + 0.5f);
+	sprite->u1 = (te_u16) ((u1 < 0.0f ? 0.0f : (u1 > 1.0f ? 1.0f : u1)) * 65535.0f + 0.5f);
+	sprite->v1 = (te_u16) ((v1 < 0.0f ? 0.0f : (v1 > 1.0f ? 1.0f : v1)) * 65535.0f + 0.5f);
+}
 
-static const char* TE_GL3_SPRITE_FRAGMENT_SRC =
-		"#version 130                                                            \n"
-		"in vec2 tex_cords;                                                      \n"
-		"out vec4 color;                                                         \n"
-		"                                                                        \n"
-		"uniform sampler2D texture_bank;                                         \n"
-//		"uniform vec3 sprite_color;                                              \n"
-		"                                                                        \n"
-		"void main()                                                             \n"
-		"{                                                                       \n"
-    "    color = texture(texture_bank, tex_cords);                           \n"
-		"}                                                                       \n"
-;
+static inline void _tinyengine_runEntityWork(tinyengine_world* world, const tinyengine_system* systems, const _tinyengine_entityWork* work) {
+	const _tinyengine_archetype* archetype = &world->archetypes[work->archetype];
+	const _tinyengine_entityChunk* source = &archetype->chunks[work->chunk];
+	tinyengine_entityChunk chunk = { archetype, source->data, (const tinyengine_entity*) source->data, source->count };
+	systems[work->system].function(world, &chunk, systems[work->system].user);
+}
 
-static const char* TE_GL3_TEXT_VERTEX_SRC =
-		"#version 130                                                            \n"
-		"in vec4 vertex;                                                         \n"
-		"out vec2 tex_cords;                                                     \n"
-		"                                                                        \n"
-		"uniform mat4 projection;                                                \n"
-		"                                                                        \n"
-		"void main()                                                             \n"
-		"{                                                                       \n"
-		"    tex_cords = vertex.xy;                                              \n"
-		"    gl_Position = vec4(vertex.z, vertex.w, 1.0, 1.0) * projection;      \n"
-		"}                                                                       \n"
-;
+#if defined(TE_PTHREADS)
+// Runs items of the given run until none are left, returns how many. The run is passed in as read under the lock.
+te_u32 _tinyengine_claimEntityWork(_tinyengine_entityWorkers* workers, te_u32 generation, tinyengine_world* world, const tinyengine_system* systems, te_u32 workCount) {
+	te_u32 done = 0;
+	te_u64 claim = __atomic_load_n(&workers->nextClaim, __ATOMIC_RELAXED);
+	while(TE_TRUE) {
+		te_u32 index = (te_u32) claim;
+		if((te_u32)(claim >> 32) != generation || index >= workCount) { break; }
+		if(!__atomic_compare_exchange_n(&workers->nextClaim, &claim, claim + 1, TE_TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) { continue; }
+		_tinyengine_runEntityWork(world, systems, &world->work[index]);
+		done++;
+		claim = __atomic_load_n(&workers->nextClaim, __ATOMIC_RELAXED);
+	}
+	return done;
+}
 
-static const char* TE_GL3_TEXT_FRAGMENT_SRC =
-		"#version 130                                                            \n"
-		"in vec2 tex_cords;                                                      \n"
-		"out vec4 color;                                                         \n"
-		"                                                                        \n"
-		"uniform sampler2D texture_bank;                                         \n"
-		"uniform vec3 text_color;                                                \n"
-		"                                                                        \n"
-		"void main()                                                             \n"
-		"{                                                                       \n"
-		"    float sample = texture(texture_bank, tex_cords).a;                  \n"
-    "    color = vec4(text_color,sample);                                    \n"
-		"}                                                                       \n"
-;
+void* _tinyengine_entityWorkerThread(void* argument) {
+	_tinyengine_entityWorkers* workers = (_tinyengine_entityWorkers*) argument;
+
+	pthread_mutex_lock(&workers->lock);
+	te_u32 seen = workers->generation;
+	while(TE_TRUE) {
+		while(!workers->exit && workers->generation == seen) { pthread_cond_wait(&workers->wake, &workers->lock); }
+		if(workers->exit) { break; }
+		seen = workers->generation;
+		workers->busy++;
+		tinyengine_world* world = workers->world;
+		const tinyengine_system* systems = workers->systems;
+		te_u32 workCount = workers->workCount;
+
+		pthread_mutex_unlock(&workers->lock);
+		te_u32 done = _tinyengine_claimEntityWork(workers, seen, world, systems, workCount);
+		pthread_mutex_lock(&workers->lock);
+
+		workers->finished += done;
+		workers->busy--;
+		if(workers->busy == 0 && workers->finished == workers->workCount) { pthread_cond_signal(&workers->done); }
+	}
+	pthread_mutex_unlock(&workers->lock);
 
-static const char* TE_GL3_FLAT_VERTEX_SRC =
-		"#version 130                                                            \n"
-		"in vec2 vertex;                                                         \n"
-		"                                                                        \n"
-		"uniform mat4 projection;                                                \n"
-		"                                                                        \n"
-		"void main()                                                             \n"
-		"{                                                                       \n"
-		"    gl_Position = vec4(vertex.x, vertex.y, 1.0, 1.0) * projection;      \n"
-		"}                                                                       \n"
-;
+	return NULL;
+}
 
-static const char* TE_GL3_FLAT_FRAGMENT_SRC =
-		"#version 130                                                            \n"
-		"out vec4 color;                                                         \n"
-		"                                                                        \n"
-		"uniform vec4 sprite_color;                                              \n"
-		"                                                                        \n"
-		"void main()                                                             \n"
-		"{                                                                       \n"
-    "    color = sprite_color;                                               \n"
-		"}                                                                       \n"
-;
+te_bool_u8 _tinyengine_startEntityWorkers(tinyengine_world* world) {
+	_tinyengine_entityWorkers* workers = calloc(1, sizeof(_tinyengine_entityWorkers));
+	if(workers == NULL) { return TE_FALSE; }
+	pthread_mutex_init(&workers->lock, NULL);
+	pthread_cond_init(&workers->wake, NULL);
+	pthread_cond_init(&workers->done, NULL);
 
-// TODO: Move these to the header
+	for(te_u32 i = 0; i + 1 < world->threadCount; i++) {
+		if(pthread_create(&workers->threads[i], NULL, &_tinyengine_entityWorkerThread, workers) != 0) { break; }
+		workers->threadCount++;
+	}
 
-#if defined(TE_WIN32)
-	#define _TE_GL_FUNCTION __stdcall
-#else
-	#define _TE_GL_FUNCTION
+	if(workers->threadCount == 0) {
+		TE_WARN("Could not start entity worker threads, systems run on the calling thread\n");
+		pthread_mutex_destroy(&workers->lock);
+		pthread_cond_destroy(&workers->wake);
+		pthread_cond_destroy(&workers->done);
+		free(workers);
+		world->threadCount = 1;
+		return TE_FALSE;
+	}
+
+	world->threadCount = workers->threadCount + 1;
+	world->workers = workers;
+	return TE_TRUE;
+}
 #endif
 
-typedef te_u32	te_GLenum;
+// Every chunk of every system in [first, end) as one pool of work, the calling thread helps
+void _tinyengine_runSystemPhase(tinyengine_world* world, const tinyengine_system* systems, te_u32 first, te_u32 end) {
+	te_u32 workCount = 0;
+	for(te_u32 system = first; system < end; system++) {
+		const tinyengine_system* current = &systems[system];
+		for(te_u32 archetypeIndex = 0; archetypeIndex < world->archetypeCount; archetypeIndex++) {
+			const _tinyengine_archetype* archetype = &world->archetypes[archetypeIndex];
+			if((archetype->mask & current->include) != current->include || (archetype->mask & current->exclude)) { continue; }
+
+			if(workCount + archetype->chunkCount > world->workCapacity) {
+				te_u32 capacity = world->workCapacity ? world->workCapacity : 256;
+				while(capacity < workCount + archetype->chunkCount) { capacity *= 2; }
+				_tinyengine_entityWork* work = realloc(world->work, capacity * sizeof(_tinyengine_entityWork));
+				if(work == NULL) { TE_ERROR("Out of memory scheduling systems!\n"); return; }
+				world->work = work;
+				world->workCapacity = capacity;
+			}
+			for(te_u32 chunk = 0; chunk < archetype->chunkCount; chunk++) {
+				world->work[workCount++] = (_tinyengine_entityWork){ system, archetypeIndex, chunk };
+			}
+		}
+	}
 
-typedef te_i8		te_GLbyte;
-typedef te_u8		te_GLubyte;
-typedef te_i16 	te_GLshort;
-typedef te_u16 	te_GLushort;
-typedef te_i32 	te_GLint;
-typedef te_u32 	te_GLuint;
+	#if defined(TE_PTHREADS)
+		if(workCount > 1 && world->threadCount > 1 && (world->workers || _tinyengine_startEntityWorkers(world))) {
+			_tinyengine_entityWorkers* workers = world->workers;
+			pthread_mutex_lock(&workers->lock);
+			workers->world = world;
+			workers->systems = systems;
+			workers->workCount = workCount;
+			workers->finished = 0;
+			workers->generation++;
+			te_u32 generation = workers->generation;
+			__atomic_store_n(&workers->nextClaim, (te_u64) generation << 32, __ATOMIC_RELAXED);
+			pthread_cond_broadcast(&workers->wake);
+			pthread_mutex_unlock(&workers->lock);
+
+			te_u32 done = _tinyengine_claimEntityWork(workers, generation, world, systems, workCount);
+
+			pthread_mutex_lock(&workers->lock);
+			workers->finished += done;
+			while(workers->finished < workers->workCount || workers->busy > 0) { pthread_cond_wait(&workers->done, &workers->lock); }
+			pthread_mutex_unlock(&workers->lock);
+			return;
+		}
+	#endif
 
-typedef te_i32 	te_GLsizei;
-typedef te_f32	te_GLfloat;
+	for(te_u32 i = 0; i < workCount; i++) { _tinyengine_runEntityWork(world, systems, &world->work[i]); }
+}
 
-typedef char		te_GLchar;
+// In order, except that consecutive systems run together while none of them writes what another one uses
+void tinyengine_runSystems(tinyengine_world* world, const tinyengine_system* systems, te_u32 systemCount) {
+	te_u32 first = 0;
+	while(first < systemCount) {
+		tinyengine_componentMask writes = systems[first].writes;
+		tinyengine_componentMask uses = systems[first].include | systems[first].writes;
+		te_u32 end = first + 1;
+		while(end < systemCount) {
+			tinyengine_componentMask nextUses = systems[end].include | systems[end].writes;
+			if((writes & nextUses) || (systems[end].writes & uses)) { break; }
+			writes |= systems[end].writes;
+			uses |= nextUses;
+			end++;
+		}
 
-typedef te_bool_u8 te_GLboolean;
+		_tinyengine_runSystemPhase(world, systems, first, end);
+		first = end;
+	}
+}
 
-typedef te_GLint* te_GLintptr;
-typedef te_GLsizei te_GLsizeiptr;
+//// Window System
 
-#define TE_GL_FALSE 0
-#define TE_GL_TRUE 1
+#include <stdlib.h> // malloc(); free();
+#include <string.h> // memcpy();
 
-typedef struct _tinyengine_gl3_bitmapBakedCharcter_t {
-  te_u16 x0,y0,x1,y1;
-  te_f32 xoff,yoff,xadvance;
-} _tinyengine_gl3_bitmapBakedCharcter;
+#define _TE_WINDOW_HANDLE_SLOT(_h) ((_h) & 0xFFFF)
+#define _TE_WINDOW_HANDLE_GENERATION(_h) ((_h) >> 16)
 
-typedef struct _tinyengine_gl3_bitmapGlyphCache_t {
-	_tinyengine_gl3_bitmapBakedCharcter characterData[96]; // ASCII 32..126 is 95 glyphs
-	te_u32 resolution;
-	te_GLuint textureID;
-} _tinyengine_gl3_bitmapGlyphCache;
+te_bool_u8 _tinyengine_registerWindowContext(tinyengine_windowContext* window) {
+	tinyengine_windowRegistry* registry = &tinyengine_state.windowRegistry;
 
-#define TE_GL_VENDOR 0x1F00
-#define TE_GL_RENDERER 0x1F01
-#define TE_GL_VERSION 0x1F02
-// Use this only in the GL 3.0 version not 1.0
-#define TE_GL_SHADING_LANGUAGE_VERSION 0x8B8C
+	te_u32 slot;
+	if(registry->freeLength > 0) {
+		slot = registry->freeSlots[--registry->freeLength];
+	} else {
+		if(registry->capacity >= TE_MAX_WINDOWS) { TE_ERROR("Window registry full!\n"); return TE_FALSE; }
 
-#define TE_GL_FRAGMENT_SHADER 0x8B30
-#define TE_GL_VERTEX_SHADER 0x8B31
-#define TE_GL_COMPILE_STATUS 0x8B81
-#define TE_GL_LINK_STATUS 0x8B82
+		if(registry->capacity == registry->allocated) {
+			te_u32 allocated = registry->allocated ? registry->allocated * 2 : 16;
+			if(allocated > TE_MAX_WINDOWS) { allocated = TE_MAX_WINDOWS; }
 
-#define TE_GL_TEXTURE_2D 0x0DE1
-#define TE_GL_ARRAY_BUFFER 0x8892
+			tinyengine_windowContext** windows = realloc(registry->windows, allocated * sizeof(tinyengine_windowContext*));
+			if(windows) { registry->windows = windows; }
+			te_u16* generations = realloc(registry->generations, allocated * sizeof(te_u16));
+			if(generations) { registry->generations = generations; }
+			te_u16* freeSlots = realloc(registry->freeSlots, allocated * sizeof(te_u16));
+			if(freeSlots) { registry->freeSlots = freeSlots; }
 
-#define TE_GL_TRIANGLES 0x0004
-#define TE_GL_TRIANGLE_STRIP 0x0005
-#define TE_GL_TRIANGLE_FAN 0x0006
+			if(!windows || !generations || !freeSlots) { TE_ERROR("Could not grow window registry!\n"); return TE_FALSE; }
+			registry->allocated = allocated;
+		}
 
-#define TE_GL_DYNAMIC_DRAW 0x88E8
+		slot = registry->capacity++;
+		registry->generations[slot] = 1;
+	}
 
-#define TE_GL_FLOAT 0x1406
+	registry->windows[slot] = window;
+	registry->length++;
+	window->handle = ((te_u32)registry->generations[slot] << 16) | slot;
 
-#define TE_GL_RGB 0x1907
-#define TE_GL_RGBA 0x1908
+	return TE_TRUE;
+}
 
-#define TE_GL_TEXTURE0 0x84C0
+void _tinyengine_unregisterWindowContext(tinyengine_windowContext* window) {
+	tinyengine_windowRegistry* registry = &tinyengine_state.windowRegistry;
 
-void _TE_GL_FUNCTION _tinyengine_gl3_stub() {
-	TE_FATAL("!!! Using unloaded GL3 function!\n");
-	TE_TRACE();
-	exit(-1);
+	te_u32 slot = _TE_WINDOW_HANDLE_SLOT(window->handle);
+	if(window->handle == 0 || slot >= registry->capacity || registry->windows[slot] != window) { return; }
+
+	registry->windows[slot] = NULL;
+	// Generation 0 is reserved so a zeroed handle never resolves
+	registry->generations[slot] = registry->generations[slot] == 0xFFFF ? 1 : registry->generations[slot] + 1;
+	registry->freeSlots[registry->freeLength++] = (te_u16) slot;
+	registry->length--;
+	window->handle = 0;
 }
 
-// TODO: Should this be moved into the state? or remain out for use by gamedevs and null otherwise?
-typedef struct tinyengine_gl3_functionTable {
-	te_GLenum ( _TE_GL_FUNCTION *glGetError)();
-	te_GLuint ( _TE_GL_FUNCTION *glCreateShader)(te_GLenum);
-	void ( _TE_GL_FUNCTION *glCompileShader)(te_GLuint);
-	void ( _TE_GL_FUNCTION *glGetShaderiv)(te_GLuint, te_GLenum, te_GLint*);
-	void ( _TE_GL_FUNCTION *glGetShaderInfoLog)(te_GLuint, te_GLsizei, te_GLsizei*, te_GLchar*);
-	void ( _TE_GL_FUNCTION *glBindAttribLocation)(te_GLuint, te_GLuint, const te_GLchar*);
-	te_GLuint ( _TE_GL_FUNCTION *glCreateProgram)();
-	void (_TE_GL_FUNCTION *glAttachShader)(te_GLuint, te_GLuint);
-	void (_TE_GL_FUNCTION *glLinkProgram)(te_GLuint);
-	void (_TE_GL_FUNCTION *glGetProgramiv)(te_GLuint, te_GLenum, te_GLint*);
-	void (_TE_GL_FUNCTION *glGetProgramInfoLog)(te_GLuint, te_GLsizei, te_GLsizei*, te_GLchar*);
-	void (_TE_GL_FUNCTION *glDeleteShader)(te_GLuint);
-	void (_TE_GL_FUNCTION *glDeleteProgram)(te_GLuint);
-	void (_TE_GL_FUNCTION *glShaderSource)(te_GLuint, te_GLsizei, const te_GLchar *const*, const te_GLint*);
+tinyengine_windowContext* tinyengine_getWindow(tinyengine_windowHandle handle) {
+	tinyengine_windowRegistry* registry = &tinyengine_state.windowRegistry;
 
-	void (_TE_GL_FUNCTION *glUseProgram)(te_GLuint);
-	void (_TE_GL_FUNCTION *glBindTexture)(te_GLenum,te_GLuint);
-	void (_TE_GL_FUNCTION *glBindVertexArray)(te_GLuint);
-	void (_TE_GL_FUNCTION *glUniform4f)(te_GLint,te_GLfloat,te_GLfloat,te_GLfloat,te_GLfloat);
-	void (_TE_GL_FUNCTION *glBindBuffer)(te_GLenum,te_GLuint);
-	void (_TE_GL_FUNCTION *glBufferSubData)(te_GLenum,te_GLintptr,te_GLsizeiptr, const void*);
-	void (_TE_GL_FUNCTION *glDrawArrays)(te_GLenum, te_GLint, te_GLsizei);
-	te_GLuint (_TE_GL_FUNCTION *glGetUniformLocation)(te_GLuint, const te_GLchar*);
+	te_u32 slot = _TE_WINDOW_HANDLE_SLOT(handle);
+	if(slot >= registry->capacity || registry->generations[slot] != _TE_WINDOW_HANDLE_GENERATION(handle)) { return NULL; }
+	return registry->windows[slot];
+}
 
-	void (_TE_GL_FUNCTION *glGenVertexArrays)(te_GLsizei, te_GLuint*);
-	void (_TE_GL_FUNCTION *glGenBuffers)(te_GLsizei, te_GLuint*);
-	void (_TE_GL_FUNCTION *glBufferData)(te_GLenum, te_GLsizeiptr, const void *, te_GLenum);
-	void (_TE_GL_FUNCTION *glVertexAttribPointer)(te_GLuint, te_GLint, te_GLenum, te_GLboolean, te_GLsizei, const void *);
-	void (_TE_GL_FUNCTION *glEnableVertexAttribArray)(te_GLuint);
+//// Event Queue
 
-	void (_TE_GL_FUNCTION *glUniformMatrix4fv)(te_GLint, te_GLsizei, te_GLboolean, const te_GLfloat*);
+#define _TE_EVENT_QUEUE_MASK (TE_EVENT_QUEUE_CAPACITY - 1)
 
-	void (_TE_GL_FUNCTION *glUniform1i)(te_GLint, te_GLint);
+void _tinyengine_recordEvent(const tinyengine_event* event);
 
-	void (_TE_GL_FUNCTION *glGenTextures)(te_GLsizei, te_GLuint *);
-	void (_TE_GL_FUNCTION *glTexImage2D)(te_GLenum, GLint level, te_GLint, te_GLsizei, te_GLsizei, te_GLint, te_GLenum, te_GLenum, const void *);
-	void (_TE_GL_FUNCTION *glGenerateMipmap)(te_GLenum);
+void _tinyengine_pushEvent(const tinyengine_event* source) {
+	tinyengine_eventQueue* queue = &tinyengine_state.eventQueue;
+	_tinyengine_inputLog* log = &tinyengine_state.inputLog;
 
-	void (_TE_GL_FUNCTION *glActiveTexture)(te_GLenum);
+	// During replay the recording is the only input, closing the window still works
+	if(log->replaying && !log->injecting && source->type != TE_EVENT_CLOSE) { return; }
 
-	void (_TE_GL_FUNCTION *glUniform3f)(te_GLint,te_GLfloat,te_GLfloat,te_GLfloat);
-}	te_gl3_functions;
+	tinyengine_event stamped = *source;
+	if(stamped.time <= 0.0) { stamped.time = tinyengine_getTime(); }
+	const tinyengine_event* event = &stamped;
+	if(log->recording) { _tinyengine_recordEvent(event); }
 
-// TODO: Compiler check and switch on this
-#pragma warning(push)
-#pragma warning( disable : 4113 4133 4068 )
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wincompatible-pointer-types"
-te_gl3_functions te_gl3 = {
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub,
-	&_tinyengine_gl3_stub
-};
-#pragma GCC diagnostic pop
-#pragma warning(pop)
+	// The next present of the window is the first that can show a response
+	te_bool_u8 input = event->type == TE_EVENT_KEY || event->type == TE_EVENT_MOUSE_MOVE || event->type == TE_EVENT_MOUSE_BUTTON;
+	if(input && event->window && event->window->latency.oldestInput == 0.0) { event->window->latency.oldestInput = event->time; }
 
-void* _tinyengine_gl_loadProc(const char* function) {
-	#if defined(TE_WIN32)
-		void* address = wglGetProcAddress(function);
-		if(address == NULL || address <= (void*)3){
-			HMODULE module = LoadLibraryA("opengl32.dll");
-			address = (void *)GetProcAddress(module, function);
+	// High rate motion and resize events are collapsed into the last queued one for the same window
+	if(queue->tail != queue->head && (event->type == TE_EVENT_MOUSE_MOVE || event->type == TE_EVENT_RESIZE)) {
+		tinyengine_event* last = &queue->events[(queue->tail - 1) & _TE_EVENT_QUEUE_MASK];
+		if(last->type == event->type && last->window == event->window) {
+			*last = *event;
+			return;
 		}
-		return address;
-	#elif defined(TE_LINUX)
-		return glXGetProcAddress(function);
+	}
+
+	if(queue->tail - queue->head >= TE_EVENT_QUEUE_CAPACITY) {
+		queue->dropped++;
+		return;
+	}
+
+	queue->events[queue->tail & _TE_EVENT_QUEUE_MASK] = *event;
+	queue->tail++;
+}
+
+void tinyengine_dispatchEvents() {
+	tinyengine_eventQueue* queue = &tinyengine_state.eventQueue;
+
+	while(queue->head != queue->tail) {
+		tinyengine_event* event = &queue->events[queue->head & _TE_EVENT_QUEUE_MASK];
+		queue->head++;
+
+		tinyengine_windowContext* window = event->window;
+		if(window == NULL) { continue; }
+
+		switch(event->type) {
+			case TE_EVENT_KEY: window->keyCallback(window, event->key.key, event->key.scancode, event->key.action); break;
+			case TE_EVENT_CHARACTER: window->characterCallback(window, event->character.codepoint); break;
+			case TE_EVENT_CLOSE: window->closeCallback(window); break;
+			default: break;
+		}
+	}
+}
+
+te_u32 tinyengine_drainEvents(tinyengine_event* events, te_u32 maxEvents) {
+	tinyengine_eventQueue* queue = &tinyengine_state.eventQueue;
+
+	te_u32 count = queue->tail - queue->head;
+	if(count > maxEvents) { count = maxEvents; }
+	if(count == 0) { return 0; }
+
+	// At most two copies, one up to the end of the ring and one from the start
+	te_u32 start = queue->head & _TE_EVENT_QUEUE_MASK;
+	te_u32 firstSpan = TE_EVENT_QUEUE_CAPACITY - start;
+	if(firstSpan > count) { firstSpan = count; }
+
+	memcpy(events, &queue->events[start], firstSpan * sizeof(tinyengine_event));
+	memcpy(events + firstSpan, &queue->events[0], (count - firstSpan) * sizeof(tinyengine_event));
+
+	queue->head += count;
+	return count;
+}
+
+// Queued events must not outlive their window
+void _tinyengine_discardWindowEvents(tinyengine_windowContext* window) {
+	tinyengine_eventQueue* queue = &tinyengine_state.eventQueue;
+	for(te_u32 i = queue->head; i != queue->tail; i++) {
+		tinyengine_event* event = &queue->events[i & _TE_EVENT_QUEUE_MASK];
+		if(event->window == window) { event->window = NULL; }
+	}
+}
+
+void tinyengine_setManualEventDrain(te_bool_u8 enabled) {
+	tinyengine_state.eventQueue.manualDrain = enabled;
+}
+
+//// Input Recording
+
+// Translated events are logged with the index of the tinyengine_pollEvents() call that queued them and
+// the time since recording started. Replay queues them on the same poll instead of live input, so an
+// application with a fixed timestep sees exactly the same session again. Windows are matched by their
+// registry slot, which holds when windows are created in the same order.
+
+#define TE_INPUT_LOG_VERSION 1
+
+typedef struct _tinyengine_inputLogHeader_t {
+	char magic[4]; // TEIN
+	te_u32 version;
+} _tinyengine_inputLogHeader;
+
+typedef struct _tinyengine_inputRecord_t {
+	te_u32 frame;
+	te_u8 type;
+	te_u8 reserved;
+	te_u16 window; // registry slot
+	te_f64 time;
+	te_i32 data[4]; // the event union as is
+} _tinyengine_inputRecord;
+
+te_bool_u8 tinyengine_recordInput(const char* path) {
+	_tinyengine_inputLog* log = &tinyengine_state.inputLog;
+	tinyengine_stopInputLog();
+
+	log->recording = fopen(path, "wb");
+	if(!log->recording) { TE_ERROR("Could not open input log %s\n", path); return TE_FALSE; }
+
+	_tinyengine_inputLogHeader header = { { 'T', 'E', 'I', 'N' }, TE_INPUT_LOG_VERSION };
+	fwrite(&header, sizeof(header), 1, log->recording);
+	log->frame = 0;
+	log->start = tinyengine_getTime();
+	return TE_TRUE;
+}
+
+te_bool_u8 tinyengine_replayInput(const char* path) {
+	_tinyengine_inputLog* log = &tinyengine_state.inputLog;
+	tinyengine_stopInputLog();
+
+	if(!tinyengine_mapFile(path, &log->replay)) { return TE_FALSE; }
+	const _tinyengine_inputLogHeader* header = (const _tinyengine_inputLogHeader*) log->replay.data;
+	if(log->replay.size < sizeof(*header) || memcmp(header->magic, "TEIN", 4) != 0 || header->version != TE_INPUT_LOG_VERSION) {
+		TE_ERROR("%s is not an input log\n", path);
+		tinyengine_unmapFile(&log->replay);
+		return TE_FALSE;
+	}
+
+	log->replayOffset = sizeof(*header);
+	log->replaying = TE_TRUE;
+	log->frame = 0;
+	log->start = tinyengine_getTime();
+	return TE_TRUE;
+}
+
+void tinyengine_stopInputLog() {
+	_tinyengine_inputLog* log = &tinyengine_state.inputLog;
+	if(log->recording && fclose(log->recording) != 0) { TE_WARN("Input log may be truncated\n"); }
+	if(log->replaying) { tinyengine_unmapFile(&log->replay); }
+	memset(log, 0, sizeof(*log));
+}
+
+// False once every recorded event has been queued, a soak run can stop there
+te_bool_u8 tinyengine_isReplayingInput() {
+	return tinyengine_state.inputLog.replaying;
+}
+
+te_u32 tinyengine_getInputFrame() {
+	return tinyengine_state.inputLog.frame;
+}
+
+void _tinyengine_recordEvent(const tinyengine_event* event) {
+	_tinyengine_inputLog* log = &tinyengine_state.inputLog;
+	if(event->window == NULL) { return; }
+
+	_tinyengine_inputRecord record = {0};
+	record.frame = log->frame;
+	record.type = event->type;
+	record.window = (te_u16) _TE_WINDOW_HANDLE_SLOT(event->window->handle);
+	record.time = event->time - log->start;
+	memcpy(record.data, &event->key, sizeof(record.data));
+	fwrite(&record, sizeof(record), 1, log->recording);
+}
+
+// Queues the recorded events of the current frame
+void _tinyengine_injectRecordedInput() {
+	_tinyengine_inputLog* log = &tinyengine_state.inputLog;
+	tinyengine_windowRegistry* registry = &tinyengine_state.windowRegistry;
+
+	log->injecting = TE_TRUE;
+	while(log->replay.size - log->replayOffset >= sizeof(_tinyengine_inputRecord)) {
+		_tinyengine_inputRecord record;
+		memcpy(&record, log->replay.data + log->replayOffset, sizeof(record));
+		if(record.frame > log->frame) { break; }
+		log->replayOffset += sizeof(record);
+
+		tinyengine_windowContext* window = record.window < registry->capacity ? registry->windows[record.window] : NULL;
+		if(window == NULL) { continue; }
+
+		tinyengine_event event = {0};
+		event.type = record.type;
+		event.window = window;
+		memcpy(&event.key, record.data, sizeof(record.data));
+		if(event.type == TE_EVENT_CLOSE) { window->closeRequested = TE_TRUE; }
+		_tinyengine_pushEvent(&event);
+	}
+	log->injecting = TE_FALSE;
+
+	if(log->replay.size - log->replayOffset < sizeof(_tinyengine_inputRecord)) {
+		TE_LOG("Input replay finished after %u frames\n", log->frame);
+		tinyengine_unmapFile(&log->replay);
+		log->replaying = TE_FALSE;
+	}
+}
+
+// TODO: decide on the windowing system in header, not by platform alone, allow override
+#if defined(TE_LINUX)
+
+// TODO: Load xlib,gtx,and other x11 extensions by dynamic loader instead of static link
+// TODO: Maybe be compatable with windows version of xserver?
+
+
+// TODO: should make these trap calls thread safe if I can
+void _tinyengine_x11_enableErrorTrap() {
+	tinyengine_state.x11state.errorCaught = TE_FALSE;
+	tinyengine_state.x11state.lastErrorCode = 0;
+	tinyengine_state.x11state.trapErrors = TE_TRUE;
+}
+
+void _tinyengine_x11_disableErrorTrap() {
+	XSync(tinyengine_state.x11state.display,TE_FALSE);
+	tinyengine_state.x11state.trapErrors = TE_FALSE;
+}
+
+int _tinyengine_x11_errorHandler(Display* display, XErrorEvent* event) {
+
+	#if defined(TE_DEBUG_OUTPUT_ENABLED)
+		char messageBuffer[100];
+		XGetErrorText(display, event->error_code, &messageBuffer[0], 100);
 	#endif
+
+	if(tinyengine_state.x11state.display != display) {
+		TE_WARN("Caught XError on unregistered display: %s",&messageBuffer[0]);
+		return 0;
+	}
+
+	if(tinyengine_state.x11state.trapErrors){
+		tinyengine_state.x11state.lastErrorCode = event->error_code;
+		tinyengine_state.x11state.errorCaught = TE_TRUE;
+		TE_ERROR("Caught X11 Error: %s\n",&messageBuffer[0]);
+	}else{
+		// TODO: handle potientially fatal xlib errors and pass information into render loop
+		TE_ERROR("X11 Error: %s\n",&messageBuffer[0]);
+		exit(-1);
+	}
+
+	return 0; // TODO: Find out what this return means
+}
+
+te_u32 _tinyengine_x11_windowTableBucket(Window windowID) {
+	// Fibonacci hashing, XIDs are sequential so the low bits alone cluster badly
+	return (te_u32)(((te_u64)windowID * 0x9E3779B97F4A7C15ull) >> 32) & (tinyengine_state.x11state.windowTableCapacity - 1);
+}
+
+te_bool_u8 _tinyengine_x11_insertWindowID(Window windowID, te_u16 slot) {
+	tinyengine_x11_state* x11 = &tinyengine_state.x11state;
+
+	// Keep the load factor under one half so probe chains stay short
+	if((x11->windowTableLength + 1) * 2 > x11->windowTableCapacity) {
+		Window* oldKeys = x11->windowTableKeys;
+		te_u16* oldSlots = x11->windowTableSlots;
+		te_u32 oldCapacity = x11->windowTableCapacity;
+
+		te_u32 capacity = oldCapacity ? oldCapacity * 2 : 32;
+		Window* keys = calloc(capacity, sizeof(Window));
+		te_u16* slots = malloc(capacity * sizeof(te_u16));
+		if(!keys || !slots) { free(keys); free(slots); TE_ERROR("Could not grow X11 window table!\n"); return TE_FALSE; }
+
+		x11->windowTableKeys = keys;
+		x11->windowTableSlots = slots;
+		x11->windowTableCapacity = capacity;
+
+		for(te_u32 i = 0; i < oldCapacity; i++) {
+			if(oldKeys[i] == 0) { continue; }
+			te_u32 bucket = _tinyengine_x11_windowTableBucket(oldKeys[i]);
+			while(keys[bucket] != 0) { bucket = (bucket + 1) & (capacity - 1); }
+			keys[bucket] = oldKeys[i];
+			slots[bucket] = oldSlots[i];
+		}
+
+		free(oldKeys);
+		free(oldSlots);
+	}
+
+	te_u32 mask = x11->windowTableCapacity - 1;
+	te_u32 bucket = _tinyengine_x11_windowTableBucket(windowID);
+	while(x11->windowTableKeys[bucket] != 0 && x11->windowTableKeys[bucket] != windowID) { bucket = (bucket + 1) & mask; }
+
+	if(x11->windowTableKeys[bucket] == 0) { x11->windowTableLength++; }
+	x11->windowTableKeys[bucket] = windowID;
+	x11->windowTableSlots[bucket] = slot;
+
+	return TE_TRUE;
+}
+
+void _tinyengine_x11_removeWindowID(Window windowID) {
+	tinyengine_x11_state* x11 = &tinyengine_state.x11state;
+	if(x11->windowTableCapacity == 0) { return; }
+
+	te_u32 mask = x11->windowTableCapacity - 1;
+	te_u32 bucket = _tinyengine_x11_windowTableBucket(windowID);
+	while(x11->windowTableKeys[bucket] != windowID) {
+		if(x11->windowTableKeys[bucket] == 0) { return; }
+		bucket = (bucket + 1) & mask;
+	}
+
+	// Backward shift deletion, no tombstones to accumulate with window churn
+	te_u32 hole = bucket;
+	te_u32 next = (hole + 1) & mask;
+	while(x11->windowTableKeys[next] != 0) {
+		te_u32 home = _tinyengine_x11_windowTableBucket(x11->windowTableKeys[next]);
+		if(((next - home) & mask) >= ((next - hole) & mask)) {
+			x11->windowTableKeys[hole] = x11->windowTableKeys[next];
+			x11->windowTableSlots[hole] = x11->windowTableSlots[next];
+			hole = next;
+		}
+		next = (next + 1) & mask;
+	}
+
+	x11->windowTableKeys[hole] = 0;
+	x11->windowTableLength--;
+}
+
+// Table lookup only, NULL for ids that are not ours or were destroyed
+tinyengine_windowContext* _tinyengine_x11_findWindowID(Window windowID) {
+	tinyengine_x11_state* x11 = &tinyengine_state.x11state;
+	if(x11->windowTableCapacity == 0) { return NULL; }
+
+	te_u32 mask = x11->windowTableCapacity - 1;
+	te_u32 bucket = _tinyengine_x11_windowTableBucket(windowID);
+	while(x11->windowTableKeys[bucket] != 0) {
+		if(x11->windowTableKeys[bucket] == windowID) { return tinyengine_state.windowRegistry.windows[x11->windowTableSlots[bucket]]; }
+		bucket = (bucket + 1) & mask;
+	}
 	return NULL;
 }
 
-#define _TE_GL_FUNCTION_LOAD(_f) te_gl3._f = _tinyengine_gl_loadProc(TE_D2STR(_f));
+tinyengine_windowContext* _tinyengine_x11_translateWindowIDToWindowContext(Window windowID) {
+	tinyengine_x11_state* x11 = &tinyengine_state.x11state;
 
-te_bool_u8 _tinyengine_gl3_init() {
-	const GLubyte* ( _TE_GL_FUNCTION *te_glGetString)(te_GLenum name) = _tinyengine_gl_loadProc("glGetString");
-	if(!te_glGetString) { TE_ERROR("Could not get address of glGetString!\n"); return TE_FALSE; }
-	if(te_glGetString(TE_GL_VERSION) == NULL) { TE_ERROR("glContext not valid!\n"); return TE_FALSE; }
-	if(atof(te_glGetString(TE_GL_VERSION)) < 3.0 ) { TE_ERROR("openGL version < 3.0!\n"); return TE_FALSE; }
+	if(windowID == x11->lastWindowID && x11->lastWindowContext != NULL) {
+		return x11->lastWindowContext;
+	}
+
+	tinyengine_windowContext* window = _tinyengine_x11_findWindowID(windowID);
+	if(window != NULL) {
+		x11->lastWindowID = windowID;
+		x11->lastWindowContext = window;
+		return window;
+	}
+
+	TE_ERROR("Could not translate window id %lu to windowContext pointer!\n",windowID);
+	return NULL;
+}
+
+#define TE_GLX_BUFFER_SWAP_COMPLETE_INTEL_MASK 0x04000000
+
+te_bool_u8 _tinyengine_x11_createWindow(tinyengine_windowContext* window) {
+
+	Window root = DefaultRootWindow(tinyengine_state.x11state.display);
+
+	XSetWindowAttributes windowAttributes = {};
+	window->platform.colormap = XCreateColormap(tinyengine_state.x11state.display, root, tinyengine_state.x11state.visualFormat->visual, AllocNone);
+	windowAttributes.colormap = window->platform.colormap;
+	windowAttributes.event_mask = ExposureMask | KeyPressMask | KeyReleaseMask | StructureNotifyMask | FocusChangeMask | PointerMotionMask | ButtonPressMask | ButtonReleaseMask;
+
+	_tinyengine_x11_enableErrorTrap();
+
+	window->platform.x11WindowID = XCreateWindow(
+		tinyengine_state.x11state.display, root,
+		0,0,300,300,0, // posX, posY, width, height, border
+		tinyengine_state.x11state.visualFormat->depth,InputOutput,tinyengine_state.x11state.visualFormat->visual,
+		CWColormap | CWEventMask,&windowAttributes
+	);
+
+	_tinyengine_x11_disableErrorTrap();
+
+	if(tinyengine_state.x11state.errorCaught) {
+		TE_ERROR("Error while creating window.\n");
+		XFreeColormap(tinyengine_state.x11state.display, window->platform.colormap);
+		return TE_FALSE;
+	}
+
+	if(!_tinyengine_x11_insertWindowID(window->platform.x11WindowID, _TE_WINDOW_HANDLE_SLOT(window->handle))) {
+		XDestroyWindow(tinyengine_state.x11state.display, window->platform.x11WindowID);
+		XFreeColormap(tinyengine_state.x11state.display, window->platform.colormap);
+		return TE_FALSE;
+	}
+
+	XSetWMProtocols(tinyengine_state.x11state.display, window->platform.x11WindowID, &(tinyengine_state.x11state.wm_delete_window), 1);
+
+	if(tinyengine_state.x11state.swapCompleteEvent) { glXSelectEvent(tinyengine_state.x11state.display, window->platform.x11WindowID, TE_GLX_BUFFER_SWAP_COMPLETE_INTEL_MASK); }
+
+	// All windows share one context, so shaders, buffers, textures and glyph caches only exist once
+	if(tinyengine_state.x11state.sharedContext == NULL) {
+		tinyengine_state.x11state.sharedContext = glXCreateContext(tinyengine_state.x11state.display, tinyengine_state.x11state.visualFormat, NULL, GL_TRUE);
+		if(tinyengine_state.x11state.sharedContext == NULL) {
+			TE_ERROR("Could not create GLX context!\n");
+			_tinyengine_x11_removeWindowID(window->platform.x11WindowID);
+			XDestroyWindow(tinyengine_state.x11state.display, window->platform.x11WindowID);
+			XFreeColormap(tinyengine_state.x11state.display, window->platform.colormap);
+			return TE_FALSE;
+		}
+	}
+	window->platform.glxContext = tinyengine_state.x11state.sharedContext;
+
+	return TE_TRUE;
+}
+
+void _tinyengine_x11_destroyWindow(tinyengine_windowContext* window){
+	Display* display = tinyengine_state.x11state.display;
+
+	if(tinyengine_state.x11state.lastWindowContext == window) {
+		tinyengine_state.x11state.lastWindowID = 0;
+		tinyengine_state.x11state.lastWindowContext = NULL;
+	}
+
+	_tinyengine_x11_removeWindowID(window->platform.x11WindowID);
+
+	// The shared context outlives its windows, only release it if it is bound to this one
+	if(glXGetCurrentDrawable() == window->platform.x11WindowID) { glXMakeCurrent(display, None, NULL); }
+
+	XDestroyWindow(display, window->platform.x11WindowID);
+	XFreeColormap(display, window->platform.colormap);
+}
+
+void _tinyengine_x11_setWindowMaxSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
+	XSizeHints* hints = XAllocSizeHints();
+	long returnedHints;
+	XGetWMNormalHints(tinyengine_state.x11state.display, window->platform.x11WindowID, hints, &returnedHints);
+	hints->flags |= PMaxSize;
+	hints->max_width = width;
+	hints->max_height = height;
+	XSetWMNormalHints(tinyengine_state.x11state.display, window->platform.x11WindowID, hints);
+	XFree(hints);
+}
+
+void _tinyengine_x11_setWindowMinSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
+	XSizeHints* hints = XAllocSizeHints();
+	long returnedHints;
+	XGetWMNormalHints(tinyengine_state.x11state.display, window->platform.x11WindowID, hints, &returnedHints);
+	hints->flags |= PMinSize;
+	hints->min_width = width;
+	hints->min_height = height;
+	XSetWMNormalHints(tinyengine_state.x11state.display, window->platform.x11WindowID, hints);
+	XFree(hints);
+}
+
+void _tinyengine_x11_setWindowAspectRatio(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
+	XSizeHints* hints = XAllocSizeHints();
+	long returnedHints;
+	XGetWMNormalHints(tinyengine_state.x11state.display, window->platform.x11WindowID, hints, &returnedHints);
+	hints->flags |= PAspect;
+	hints->min_aspect.x = hints->max_aspect.x = width;
+	hints->min_aspect.y = hints->max_aspect.y = height;
+	XSetWMNormalHints(tinyengine_state.x11state.display, window->platform.x11WindowID, hints);
+	XFree(hints);
+}
+
+void _tinyengine_x11_setWindowSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
+	XResizeWindow(tinyengine_state.x11state.display, window->platform.x11WindowID, width, height);
+}
+
+void _tinyengine_x11_setWindowTitle(tinyengine_windowContext* window, const char* title) {
+	XStoreName(tinyengine_state.x11state.display, window->platform.x11WindowID, title);
+}
+
+void _tinyengine_x11_showWindow(tinyengine_windowContext* window){
+	XMapWindow(tinyengine_state.x11state.display, window->platform.x11WindowID);
+}
+
+// Linux X servers stamp events with CLOCK_MONOTONIC milliseconds, truncated to 32 bits. Anything not within
+// the last second is some other clock (a remote server), the event then gets the time it was translated.
+te_f64 _tinyengine_x11_eventTime(Time serverTime) {
+	te_f64 now = tinyengine_getTime();
+	te_u32 age = (te_u32)(te_u64)(now * 1000.0) - (te_u32) serverTime;
+	return age < 1000 ? now - age * 0.001 : now;
+}
+
+te_bool_u8 _tinyengine_glx_presentTime(int64_t ust, te_f64* time);
+void _tinyengine_latencyPresented(tinyengine_windowContext* window, te_u64 swap, te_f64 time, te_u8 source);
+
+void _tinyengine_x11_translateEvent(XEvent* xevent) {
+
+	tinyengine_event event = {0};
+
+	if(xevent->type == tinyengine_state.x11state.swapCompleteEvent && xevent->type != 0) {
+		GLXBufferSwapComplete* complete = (GLXBufferSwapComplete*) xevent;
+		tinyengine_windowContext* window = _tinyengine_x11_translateWindowIDToWindowContext(complete->drawable);
+		if(window == NULL) { return; }
+		te_f64 time;
+		if(!_tinyengine_glx_presentTime(complete->ust, &time)) { time = tinyengine_getTime(); }
+		_tinyengine_latencyPresented(window, (te_u64) complete->sbc, time, TE_PRESENT_TIME_SWAP_EVENT);
+		return;
+	}
+
+	switch(xevent->type) {
+
+		case ClientMessage:
+		{
+			event.window = _tinyengine_x11_translateWindowIDToWindowContext(xevent->xclient.window);
+			if(event.window == NULL) { TE_WARN("ClientMessage event for unregistered window!\n"); break; }
+			if (xevent->xclient.data.l[0] == tinyengine_state.x11state.wm_delete_window) {
+				event.window->closeRequested = TE_TRUE;
+				event.type = TE_EVENT_CLOSE;
+				_tinyengine_pushEvent(&event);
+			}
+		} break;
+
+		case KeyPress: case KeyRelease:
+		{
+			event.window = _tinyengine_x11_translateWindowIDToWindowContext(xevent->xkey.window);
+			if(event.window == NULL) { TE_WARN("KeyMessage event for unregistered window!\n"); break; }
+
+			char buf[2];
+			KeySym ks;
+			XComposeStatus comp;
+
+			te_i32 len = XLookupString(&xevent->xkey, buf, 1, &ks, &comp);
+
+			// TODO: translate x11 key codes to universal keycodes
+			event.type = TE_EVENT_KEY;
+			event.time = _tinyengine_x11_eventTime(xevent->xkey.time);
+			event.key.key = (te_i32) ks;
+			event.key.scancode = (te_i32) xevent->xkey.keycode;
+			event.key.action = xevent->type == KeyPress ? TE_PRESS : TE_RELEASE;
+			_tinyengine_pushEvent(&event);
+
+			if (xevent->type == KeyRelease && len > 0) {
+				event.type = TE_EVENT_CHARACTER;
+				event.character.codepoint = (te_u8) buf[0];
+				_tinyengine_pushEvent(&event);
+			}
+		}	break;
+
+		case ConfigureNotify:
+		{
+			event.window = _tinyengine_x11_translateWindowIDToWindowContext(xevent->xconfigure.window);
+			if(event.window == NULL) { break; }
+
+			// Moves also generate ConfigureNotify, only size changes are interesting
+			te_u32 width = (te_u32) xevent->xconfigure.width;
+			te_u32 height = (te_u32) xevent->xconfigure.height;
+			if(width == event.window->platform.width && height == event.window->platform.height) { break; }
+			event.window->platform.width = width;
+			event.window->platform.height = height;
+
+			event.type = TE_EVENT_RESIZE;
+			event.resize.width = width;
+			event.resize.height = height;
+			_tinyengine_pushEvent(&event);
+		} break;
+
+		case Expose:
+		{
+			tinyengine_windowContext* window = _tinyengine_x11_translateWindowIDToWindowContext(xevent->xexpose.window);
+			if(window == NULL) { break; }
+			tinyengine_addWindowDamage(window, xevent->xexpose.x, xevent->xexpose.y, xevent->xexpose.width, xevent->xexpose.height);
+		} break;
+
+		case MotionNotify:
+		{
+			event.window = _tinyengine_x11_translateWindowIDToWindowContext(xevent->xmotion.window);
+			if(event.window == NULL) { break; }
+			event.type = TE_EVENT_MOUSE_MOVE;
+			event.time = _tinyengine_x11_eventTime(xevent->xmotion.time);
+			event.mouseMove.x = xevent->xmotion.x;
+			event.mouseMove.y = xevent->xmotion.y;
+			_tinyengine_pushEvent(&event);
+		} break;
+
+		case ButtonPress: case ButtonRelease:
+		{
+			event.window = _tinyengine_x11_translateWindowIDToWindowContext(xevent->xbutton.window);
+			if(event.window == NULL) { break; }
+			event.type = TE_EVENT_MOUSE_BUTTON;
+			event.time = _tinyengine_x11_eventTime(xevent->xbutton.time);
+			event.mouseButton.button = (te_i32) xevent->xbutton.button;
+			event.mouseButton.action = xevent->type == ButtonPress ? TE_PRESS : TE_RELEASE;
+			event.mouseButton.x = xevent->xbutton.x;
+			event.mouseButton.y = xevent->xbutton.y;
+			_tinyengine_pushEvent(&event);
+		} break;
+
+		case FocusIn: case FocusOut:
+		{
+			event.window = _tinyengine_x11_translateWindowIDToWindowContext(xevent->xfocus.window);
+			if(event.window == NULL) { break; }
+			event.type = TE_EVENT_FOCUS;
+			event.focus.focused = xevent->type == FocusIn;
+			_tinyengine_pushEvent(&event);
+		} break;
+
+		default: break;
+
+	}
+}
+
+void _tinyengine_x11_pollDisplayEvents() {
+
+	Display* display = tinyengine_state.x11state.display;
+	te_u32 droppedBefore = tinyengine_state.eventQueue.dropped;
+
+	// XPending flushes and checks the connection on every call, ask once per batch instead
+	te_i32 pending = XEventsQueued(display, QueuedAfterFlush);
+
+	while(pending > 0) {
+
+		while(pending-- > 0) {
+			XEvent event;
+			XNextEvent(display,&event);
+			_tinyengine_x11_translateEvent(&event);
+		}
+
+		pending = XEventsQueued(display, QueuedAfterReading);
+	}
+
+	if(tinyengine_state.eventQueue.dropped != droppedBefore) {
+		TE_WARN("Event queue full, dropped %u events!\n", tinyengine_state.eventQueue.dropped - droppedBefore);
+	}
+}
+
+te_bool_u8 _tinyengine_x11_hasGLXExtension(const char* extensions, const char* name) {
+	size_t length = strlen(name);
+	for(const char* match = extensions; match && (match = strstr(match, name)) != NULL; match += length) {
+		if((match == extensions || match[-1] == ' ') && (match[length] == ' ' || match[length] == '\0')) { return TE_TRUE; }
+	}
+	return TE_FALSE;
+}
+
+te_bool_u8 _tinyengine_x11_init() {
+
+	// TODO: make everything a local variable then just assign them all to the x11state at the end? (is this worst?)
+
+	tinyengine_state.x11state.nativeErrorHandler = XSetErrorHandler(&_tinyengine_x11_errorHandler);
+	tinyengine_state.x11state.display = XOpenDisplay(NULL);
+
+	if(tinyengine_state.x11state.display == NULL) {
+		TE_ERROR("Could not connect to X11 server!\n");
+		return TE_FALSE;
+	}
+
+	TE_LOG("X11 window manager loaded.\n");
+	TE_LOG("X11 display connected on %s\n",XDisplayString(tinyengine_state.x11state.display));
+	TE_LOG("X11 Display Version: %i.%i\n",XProtocolVersion(tinyengine_state.x11state.display),XProtocolRevision(tinyengine_state.x11state.display));
+	TE_LOG("X11 Vendor: %s\n",XServerVendor(tinyengine_state.x11state.display));
+
+	te_i32 glxAttributes[] = { GLX_RGBA, GLX_DEPTH_SIZE, 24, GLX_DOUBLEBUFFER, None };
+	tinyengine_state.x11state.visualFormat = glXChooseVisual(tinyengine_state.x11state.display, 0, glxAttributes);
+
+	if(tinyengine_state.x11state.visualFormat == NULL) {
+		TE_ERROR("GLX could not find any compatable OpenGL visual format for display!\n");
+		return TE_FALSE;
+	}
+
+	tinyengine_state.x11state.wm_delete_window = XInternAtom(tinyengine_state.x11state.display, "WM_DELETE_WINDOW", False);
+
+	tinyengine_state.x11state.wm_size_hints = XInternAtom(tinyengine_state.x11state.display, "WM_SIZE_HINTS", False);
+
+	const char* glxExtensions = glXQueryExtensionsString(tinyengine_state.x11state.display, DefaultScreen(tinyengine_state.x11state.display));
+	tinyengine_state.x11state.hasBufferAge = _tinyengine_x11_hasGLXExtension(glxExtensions, "GLX_EXT_buffer_age");
+	if(_tinyengine_x11_hasGLXExtension(glxExtensions, "GLX_MESA_copy_sub_buffer")) {
+		tinyengine_state.x11state.glXCopySubBufferMESA = (void (*)(Display*, GLXDrawable, int, int, int, int)) glXGetProcAddress((const GLubyte*) "glXCopySubBufferMESA");
+	}
+
+	// Swap complete events carry the present time, sync control has to be asked for it
+	int glxErrorBase, glxEventBase;
+	if(_tinyengine_x11_hasGLXExtension(glxExtensions, "GLX_INTEL_swap_event") && glXQueryExtension(tinyengine_state.x11state.display, &glxErrorBase, &glxEventBase)) {
+		tinyengine_state.x11state.swapCompleteEvent = glxEventBase + GLX_BufferSwapComplete;
+	}
+	if(_tinyengine_x11_hasGLXExtension(glxExtensions, "GLX_OML_sync_control")) {
+		tinyengine_state.x11state.glXGetSyncValuesOML = (Bool (*)(Display*, GLXDrawable, int64_t*, int64_t*, int64_t*)) glXGetProcAddress((const GLubyte*) "glXGetSyncValuesOML");
+		tinyengine_state.x11state.glXWaitForSbcOML = (Bool (*)(Display*, GLXDrawable, int64_t, int64_t*, int64_t*, int64_t*)) glXGetProcAddress((const GLubyte*) "glXWaitForSbcOML");
+	}
+
+	return TE_TRUE;
+}
+
+void _tinyengine_x11_terminate() {
+	Display* display = tinyengine_state.x11state.display;
+	if(display == NULL) { return; }
+
+	if(tinyengine_state.x11state.sharedContext) {
+		glXMakeCurrent(display, None, NULL);
+		glXDestroyContext(display, tinyengine_state.x11state.sharedContext);
+		tinyengine_state.x11state.sharedContext = NULL;
+	}
+
+	free(tinyengine_state.x11state.windowTableKeys);
+	free(tinyengine_state.x11state.windowTableSlots);
+	tinyengine_state.x11state.windowTableKeys = NULL;
+	tinyengine_state.x11state.windowTableSlots = NULL;
+	tinyengine_state.x11state.windowTableCapacity = 0;
+	tinyengine_state.x11state.windowTableLength = 0;
+
+	XFree(tinyengine_state.x11state.visualFormat);
+	XCloseDisplay(display);
+	tinyengine_state.x11state.display = NULL;
+}
+
+void _tinyengine_glx_makeCurrent(tinyengine_windowContext* window){
+	glXMakeCurrent(tinyengine_state.x11state.display, window->platform.x11WindowID, window->platform.glxContext);
+}
+
+void _tinyengine_glx_swapBuffers(tinyengine_windowContext* window) {
+	glXSwapBuffers(tinyengine_state.x11state.display, window->platform.x11WindowID);
+}
+
+#define TE_GLX_BACK_BUFFER_AGE_EXT 0x20F4
+
+// 0 when the contents are undefined or the age is unknown
+te_u32 _tinyengine_glx_backBufferAge(tinyengine_windowContext* window) {
+	if(!tinyengine_state.x11state.hasBufferAge) { return 0; }
+	unsigned int age = 0;
+	glXQueryDrawable(tinyengine_state.x11state.display, window->platform.x11WindowID, TE_GLX_BACK_BUFFER_AGE_EXT, &age);
+	return age;
+}
+
+// Copies a back buffer region to the front, GL bottom left origin. The back buffer is left untouched.
+te_bool_u8 _tinyengine_glx_presentRegion(tinyengine_windowContext* window, te_i32 x, te_i32 y, te_i32 width, te_i32 height) {
+	if(tinyengine_state.x11state.glXCopySubBufferMESA == NULL) { return TE_FALSE; }
+	tinyengine_state.x11state.glXCopySubBufferMESA(tinyengine_state.x11state.display, window->platform.x11WindowID, x, y, width, height);
+	return TE_TRUE;
+}
+
+// Mesa reports UST as CLOCK_MONOTONIC microseconds, other values are not comparable with event times
+te_bool_u8 _tinyengine_glx_presentTime(int64_t ust, te_f64* time) {
+	te_f64 now = tinyengine_getTime();
+	*time = (te_f64) ust * 1e-6;
+	return *time <= now + 0.002 && now - *time < 1.0;
+}
+
+te_u8 _tinyengine_glx_presentSource() {
+	if(tinyengine_state.x11state.swapCompleteEvent) { return TE_PRESENT_TIME_SWAP_EVENT; }
+	if(tinyengine_state.x11state.glXGetSyncValuesOML) { return TE_PRESENT_TIME_SYNC_CONTROL; }
+	return TE_PRESENT_TIME_SWAP_CALL;
+}
+
+// Asks sync control how far presentation has got, without blocking
+void _tinyengine_glx_pollPresents(tinyengine_windowContext* window) {
+	_tinyengine_windowLatency* latency = &window->latency;
+	if(latency->pendingHead == latency->pendingTail) { return; }
+
+	Display* display = tinyengine_state.x11state.display;
+	int64_t ust, msc, sbc;
+	if(!tinyengine_state.x11state.glXGetSyncValuesOML(display, window->platform.x11WindowID, &ust, &msc, &sbc)) { return; }
+	if((te_u64) sbc < latency->pending[latency->pendingHead & (TE_LATENCY_PENDING - 1)].swap) { return; }
+
+	// That ust is of the latest vertical blank, waiting on a swap count already reached returns at once with the swap's own
+	if(tinyengine_state.x11state.glXWaitForSbcOML) { tinyengine_state.x11state.glXWaitForSbcOML(display, window->platform.x11WindowID, sbc, &ust, &msc, &sbc); }
+
+	te_f64 time;
+	if(!_tinyengine_glx_presentTime(ust, &time)) { time = tinyengine_getTime(); }
+	_tinyengine_latencyPresented(window, (te_u64) sbc, time, TE_PRESENT_TIME_SYNC_CONTROL);
+}
+
+#elif defined(TE_WIN32)
+// TODO: tinyengine_win32 descripes the platform, need a new name for the windowing system specificly
+
+#define _TE_WINSTYLE WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_THICKFRAME
+
+LRESULT CALLBACK _tinyengine_win32_eventCallback(HWND hWindow, UINT Message, WPARAM wParam, LPARAM lParam) {
+
+	tinyengine_windowContext* window = GetPropA(hWindow,"tinyengine");
+	if(!window && Message == WM_CREATE) { window = (tinyengine_windowContext*) ((LPCREATESTRUCTA)lParam)->lpCreateParams; }
+	if(!window) { return DefWindowProc(hWindow,Message,wParam,lParam); }
+
+	tinyengine_event event = {0};
+	event.window = window;
+
+	switch(Message) {
+		case WM_CREATE: window->platform.windowReady = TE_TRUE; return 0;
+		case WM_CLOSE: window->closeRequested = TE_TRUE; event.type = TE_EVENT_CLOSE; _tinyengine_pushEvent(&event); return 0;
+		case WM_DESTROY: window->closeRequested = TE_TRUE; event.type = TE_EVENT_CLOSE; _tinyengine_pushEvent(&event); return 0;
+
+		case WM_MOUSEACTIVATE: break;
+		case WM_CAPTURECHANGED: break;
+
+		case WM_SETFOCUS: case WM_KILLFOCUS:
+			event.type = TE_EVENT_FOCUS;
+			event.focus.focused = Message == WM_SETFOCUS;
+			_tinyengine_pushEvent(&event);
+			break;
+
+		case WM_SIZE:
+			event.type = TE_EVENT_RESIZE;
+			event.resize.width = LOWORD(lParam);
+			event.resize.height = HIWORD(lParam);
+			_tinyengine_pushEvent(&event);
+			break;
+
+		case WM_SYSCOMMAND: break;
+
+		case WM_INPUTLANGCHANGE: break;
+
+		// TODO: Use this for char input instead of keyrelease?
+		case WM_CHAR:
+			event.type = TE_EVENT_CHARACTER;
+			event.character.codepoint = (te_u32) wParam;
+			_tinyengine_pushEvent(&event);
+			break;
+		case WM_SYSCHAR: break;
+		case WM_UNICHAR: break;
+
+		case WM_KEYDOWN: case WM_SYSKEYDOWN: case WM_KEYUP: case WM_SYSKEYUP:
+			event.type = TE_EVENT_KEY;
+			event.key.key = (te_i32) wParam;
+			event.key.scancode = (te_i32) ((lParam >> 16) & 0x1FF);
+			event.key.action = (Message == WM_KEYDOWN || Message == WM_SYSKEYDOWN) ? TE_PRESS : TE_RELEASE;
+			_tinyengine_pushEvent(&event);
+			break;
+
+		case WM_LBUTTONDOWN: case WM_RBUTTONDOWN: case WM_MBUTTONDOWN:
+		case WM_LBUTTONUP: case WM_RBUTTONUP: case WM_MBUTTONUP:
+			event.type = TE_EVENT_MOUSE_BUTTON;
+			event.mouseButton.button = (Message == WM_LBUTTONDOWN || Message == WM_LBUTTONUP) ? 1 : (Message == WM_MBUTTONDOWN || Message == WM_MBUTTONUP) ? 2 : 3;
+			event.mouseButton.action = (Message == WM_LBUTTONDOWN || Message == WM_RBUTTONDOWN || Message == WM_MBUTTONDOWN) ? TE_PRESS : TE_RELEASE;
+			event.mouseButton.x = (short) LOWORD(lParam);
+			event.mouseButton.y = (short) HIWORD(lParam);
+			_tinyengine_pushEvent(&event);
+			break;
+		case WM_XBUTTONDOWN: break;
+		case WM_XBUTTONUP: break;
+
+		case WM_MOUSEMOVE:
+			event.type = TE_EVENT_MOUSE_MOVE;
+			event.mouseMove.x = (short) LOWORD(lParam);
+			event.mouseMove.y = (short) HIWORD(lParam);
+			_tinyengine_pushEvent(&event);
+			break;
+
+		case WM_INPUT: break;
+
+		case WM_ERASEBKGND: return TRUE;
+
+
+		case WM_SIZING: // TODO: Seems to be busted on wine?
+			{
+				if(window->platform.aspectRatioWidth == 0 || window->platform.aspectRatioHeight == 0) {break;}
+				int edge = wParam;
+				RECT* size = (RECT*) lParam;
+
+				RECT reportedSize;
+				RECT adjustedSize;
+
+				// TODO: Should probably just memcpy this
+				GetClientRect(window->platform.win32window, &reportedSize);
+				GetClientRect(window->platform.win32window, &adjustedSize);
+				AdjustWindowRect(&adjustedSize,_TE_WINSTYLE,0);
+
+				te_i32 widthOffset = (reportedSize.right - reportedSize.left) - (adjustedSize.right - adjustedSize.left);
+				te_i32 heightOffset = (reportedSize.bottom - reportedSize.top) - (reportedSize.bottom - reportedSize.top);
+
+				const float ratio = (float) window->platform.aspectRatioWidth / (float) window->platform.aspectRatioHeight;
+
+				if (edge == WMSZ_LEFT  || edge == WMSZ_BOTTOMLEFT || edge == WMSZ_RIGHT || edge == WMSZ_BOTTOMRIGHT) {
+		        size->bottom = size->top + heightOffset + (int) ((size->right - size->left - widthOffset) / ratio);
+		    } else if (edge == WMSZ_TOPLEFT || edge == WMSZ_TOPRIGHT) {
+		        size->top = size->bottom - heightOffset - (int) ((size->right - size->left - widthOffset) / ratio);
+		    } else if (edge == WMSZ_TOP || edge == WMSZ_BOTTOM) {
+		        size->right = size->left + widthOffset + (int) ((size->bottom - size->top - heightOffset) * ratio);
+		    }
+
+				return TRUE;
+			}
+			break;
+		case WM_GETMINMAXINFO: // TODO: Seems to be busted in wine?
+			{
+				MINMAXINFO* info = (MINMAXINFO*) lParam;
+
+				RECT reportedSize;
+				RECT adjustedSize;
+
+				// TODO: Should probably just memcpy this
+				GetClientRect(window->platform.win32window, &reportedSize);
+				GetClientRect(window->platform.win32window, &adjustedSize);
+				AdjustWindowRect(&adjustedSize,_TE_WINSTYLE,0);
+
+				te_i32 widthOffset = (reportedSize.right - reportedSize.left) - (adjustedSize.right - adjustedSize.left);
+				te_i32 heightOffset = (reportedSize.bottom - reportedSize.top) - (reportedSize.bottom - reportedSize.top);
+
+				if(window->platform.minWidth > 0 && window->platform.minHeight > 0 ){
+					info->ptMinTrackSize.x = window->platform.minWidth + widthOffset;
+          info->ptMinTrackSize.y = window->platform.minHeight + heightOffset;
+				}
+
+				if(window->platform.maxWidth > 0 && window->platform.maxHeight > 0 ){
+					info->ptMaxTrackSize.x = window->platform.maxWidth + widthOffset;
+          info->ptMaxTrackSize.y = window->platform.maxHeight + heightOffset;
+				}
+
+				break;
+				return 0;
+			}
+			TE_LOG("TE1\n");
+			break;
+	}
+
+	return DefWindowProc(hWindow,Message,wParam,lParam);
+}
+
+void _tinyengine_win32_pollEvents() {
+	MSG message;
+
+	while(PeekMessageA(&message,0,0,0,PM_REMOVE)){
+		//GetMessage(&message,0,0,0);
+		TranslateMessage(&message);
+		DispatchMessage(&message);
+	}
+}
+
+void _tinyengine_win32_setWindowSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
+
+
+	RECT adjustedSize = {0,0,width,height};
+	AdjustWindowRect(&adjustedSize,_TE_WINSTYLE,0);
+	width = adjustedSize.right - adjustedSize.left;
+	height = adjustedSize.bottom - adjustedSize.top;
+
+	SetWindowPos(
+		window->platform.win32window,
+		HWND_TOP,0,0,
+		width, height,
+		SWP_NOACTIVATE | SWP_NOOWNERZORDER | SWP_NOMOVE | SWP_NOZORDER
+	);
+}
+
+void _tinyengine_win32_forceSizeUpdate(tinyengine_windowContext* window) {
+	RECT size;
+	GetWindowRect(window->platform.win32window, &size);
+	MoveWindow(window->platform.win32window,size.left, size.top, size.right - size.left, size.bottom - size.top, TRUE);
+}
+
+void _tinyengine_win32_setWindowMaxSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
+	window->platform.maxWidth = width;
+	window->platform.maxHeight = height;
+	_tinyengine_win32_forceSizeUpdate(window);
+}
+
+void _tinyengine_win32_setWindowMinSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
+	window->platform.minWidth = width;
+	window->platform.minHeight = height;
+	_tinyengine_win32_forceSizeUpdate(window);
+}
+
+void _tinyengine_win32_setWindowAspectRatio(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
+	window->platform.aspectRatioWidth = width;
+	window->platform.aspectRatioHeight = height;
+	_tinyengine_win32_forceSizeUpdate(window);
+}
+
+void _tinyengine_win32_getWindowSize(tinyengine_windowContext* window, te_u32* width, te_u32* height) {
+	RECT adjustedSize;
+	GetClientRect(window->platform.win32window, &adjustedSize);
+	AdjustWindowRect(&adjustedSize,_TE_WINSTYLE,0);
+	*width = adjustedSize.right - adjustedSize.left;
+	*height = adjustedSize.bottom - adjustedSize.top;
+}
+
+void _tinyengine_win32_setWindowTitle(tinyengine_windowContext* window, const char* title) {
+	SetWindowTextA(window->platform.win32window, title);
+}
+
+void _tinyengine_win32_showWindow(tinyengine_windowContext* window) {
+	ShowWindow(window->platform.win32window, SW_SHOWNA);
+}
+
+te_bool_u8 _tinyengine_win32_createWindow(tinyengine_windowContext* window){
+
+	// TODO: Load modern GL pipelines
+
+	HINSTANCE Instance = GetModuleHandle(NULL);
+
+	RECT adjustedSize = {0,0,300,300};
+	AdjustWindowRect(&adjustedSize,_TE_WINSTYLE,0);
+
+	int winWidth = adjustedSize.right - adjustedSize.left;
+	int winHeight = adjustedSize.bottom - adjustedSize.top;
+
+	window->platform.win32window = CreateWindowExA(0,tinyengine_win32_className,"tinyengine",_TE_WINSTYLE,CW_USEDEFAULT,CW_USEDEFAULT,winWidth,winHeight,NULL,NULL,Instance,window);
+
+	if(!window->platform.win32window) {
+		#if defined(TE_DEBUG_OUTPUT_ENABLED)
+			DWORD errorCode = GetLastError();
+			LPSTR errorMessage = NULL;
+			FormatMessageA(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
+	                                 NULL, errorCode, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), (LPSTR)&errorMessage, 0, NULL);
+			TE_ERROR("Error while creating window: %s",errorMessage);
+		#endif
+		return TE_FALSE;
+	}
+
+	SetPropA(window->platform.win32window, "tinyengine", window);
+
+	// TODO: Is this even neccesary?
+	UINT_PTR timeout = SetTimer(NULL,0,1000,NULL);
+	while(!window->platform.windowReady){
+		MSG message;
+		GetMessageA(&message,0,0,0);
+		if(message.message == WM_TIMER && message.wParam == timeout) {
+			TE_ERROR("Timeout while waiting for windowCreate event!\n");
+			return TE_FALSE;
+		}
+		TranslateMessage(&message);
+		DispatchMessage(&message);
+	}
+	KillTimer(NULL,timeout);
+
+	window->platform.win32deviceContext = GetDC(window->platform.win32window);
+
+	PIXELFORMATDESCRIPTOR pfd = {
+		sizeof(PIXELFORMATDESCRIPTOR),
+		1,
+		PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER, //Flags
+		PFD_TYPE_RGBA,        // The kind of framebuffer. RGBA or palette.
+		32,                   // Colordepth of the framebuffer.
+		0, 0, 0, 0, 0, 0,
+		0,
+		0,
+		0,
+		0, 0, 0, 0,
+		24,                   // Number of bits for the depthbuffer
+		8,                    // Number of bits for the stencilbuffer
+		0,                    // Number of Aux buffers in the framebuffer.
+		PFD_MAIN_PLANE,
+		0,
+		0, 0, 0
+	};
+
+
+
+	int pixelFormat = ChoosePixelFormat(window->platform.win32deviceContext,&pfd);
+	SetPixelFormat(window->platform.win32deviceContext,pixelFormat,&pfd);
+
+	// All windows share one context, so shaders, buffers, textures and glyph caches only exist once
+	if(tinyengine_state.win32state.sharedContext == NULL) {
+		tinyengine_state.win32state.sharedContext = wglCreateContext(window->platform.win32deviceContext);
+		if(tinyengine_state.win32state.sharedContext == NULL) {
+			TE_ERROR("Could not create WGL context!\n");
+			ReleaseDC(window->platform.win32window, window->platform.win32deviceContext);
+			DestroyWindow(window->platform.win32window);
+			return TE_FALSE;
+		}
+	}
+	window->platform.win32openGLcontext = tinyengine_state.win32state.sharedContext;
+
+	return TE_TRUE;
+}
+
+void _tinyengine_win32_destroyWindow() {}
+
+te_bool_u8 _tinyengine_win32_init() {
+	HINSTANCE Instance = GetModuleHandle(NULL);
+	WNDCLASSEXA winClassParams = {0};
+	winClassParams.cbSize = sizeof(WNDCLASSEX);
+	winClassParams.style = CS_OWNDC;
+	winClassParams.lpfnWndProc = _tinyengine_win32_eventCallback;
+	winClassParams.hInstance = Instance;
+	//	winClass.hIcon = ; TODO: Implement Window Icon
+	winClassParams.hCursor = LoadCursor(NULL, IDC_ARROW);
+	winClassParams.lpszClassName = tinyengine_win32_className;
+	RegisterClassExA(&winClassParams);
+	TE_LOG("win32 windows manager loaded.\n");
+	return TE_TRUE;
+}
+
+void _tinyengine_win32_terminate() {
+	if(tinyengine_state.win32state.sharedContext) {
+		wglMakeCurrent(NULL, NULL);
+		wglDeleteContext(tinyengine_state.win32state.sharedContext);
+		tinyengine_state.win32state.sharedContext = NULL;
+	}
+}
+
+void _tinyengine_wgl_makeCurrent(tinyengine_windowContext* window) {
+	wglMakeCurrent (window->platform.win32deviceContext, window->platform.win32openGLcontext);
+}
+
+void _tinyengine_wgl_swapBuffers(tinyengine_windowContext* window) {
+	SwapBuffers(window->platform.win32deviceContext);
+}
+
+#else // empty window system
+
+
+
+#endif
+
+#include <string.h>
+
+void _tinyengine_windowCallbackStub(tinyengine_windowContext* window, ...) { };
+
+tinyengine_windowContext* tinyengine_createWindow() {
+
+	tinyengine_windowContext* window = malloc(sizeof(tinyengine_windowContext));
+	memset(window, 0, sizeof(tinyengine_windowContext));
+
+	// Registered first so the platform layer can index its lookup tables by slot
+	if(!_tinyengine_registerWindowContext(window)) { free(window); return NULL; }
+
+	te_bool_u8 valid = TE_FALSE;
+
+	#if defined(TE_LINUX)
+		valid = _tinyengine_x11_createWindow(window);
+	#elif defined(TE_WIN32)
+		valid = _tinyengine_win32_createWindow(window);
+	#endif
+
+	if(!valid) { _tinyengine_unregisterWindowContext(window); free(window); return NULL; }
+
+	window->keyCallback = &_tinyengine_windowCallbackStub;
+	window->closeCallback = &_tinyengine_windowCallbackStub;
+	window->characterCallback = &_tinyengine_windowCallbackStub;
+	window->frameCallback = &_tinyengine_windowCallbackStub;
+
+	return window;
+}
+
+void _tinyengine_gl3_destroyWindowRenderContext(tinyengine_windowContext* window);
+
+void tinyengine_destroyWindow(tinyengine_windowContext* window) {
+	if(window == NULL) { return; }
+
+	// Render objects live in the shared context, which only has to be current with some window to delete them
+	if(window->render2D.batchVAO) {
+		#if defined(TE_LINUX)
+			if(glXGetCurrentContext() == NULL) { _tinyengine_glx_makeCurrent(window); }
+		#elif defined(TE_WIN32)
+			if(wglGetCurrentContext() == NULL) { _tinyengine_wgl_makeCurrent(window); }
+		#endif
+		_tinyengine_gl3_destroyWindowRenderContext(window);
+	}
+
+	#if defined(TE_LINUX)
+		_tinyengine_x11_destroyWindow(window);
+	#elif defined(TE_WIN32)
+		_tinyengine_win32_destroyWindow(window);
+	#endif
+	_tinyengine_discardWindowEvents(window);
+	_tinyengine_unregisterWindowContext(window);
+	free(window);
+}
+
+void tinyengine_destroyAllWindows() {
+	tinyengine_windowRegistry* registry = &tinyengine_state.windowRegistry;
+
+	for(te_u32 slot = 0; slot < registry->capacity; slot++) {
+		if(registry->windows[slot] != NULL) { tinyengine_destroyWindow(registry->windows[slot]); }
+	}
+
+	tinyengine_state.eventQueue.head = tinyengine_state.eventQueue.tail;
+}
+
+void tinyengine_setWindowMaxSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
+	#if defined(TE_LINUX)
+		_tinyengine_x11_setWindowMaxSize(window,width,height);
+	#elif defined(TE_WIN32)
+		_tinyengine_win32_setWindowMaxSize(window,width,height);
+	#endif
+}
+
+void tinyengine_setWindowMinSize(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
+	#if defined(TE_LINUX)
+		_tinyengine_x11_setWindowMinSize(window,width,height);
+	#elif defined(TE_WIN32)
+		_tinyengine_win32_setWindowMinSize(window,width,height);
+	#endif
+}
+
+void tinyengine_setWindowAspectRatio(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
+	#if defined(TE_LINUX)
+		_tinyengine_x11_setWindowAspectRatio(window,width,height);
+	#elif defined(TE_WIN32)
+		_tinyengine_win32_setWindowAspectRatio(window,width,height);
+	#endif
+}
+
+void tinyengine_showWindow(tinyengine_windowContext* window) {
+	#if defined(TE_LINUX)
+		_tinyengine_x11_showWindow(window);
+	#elif defined(TE_WIN32)
+		_tinyengine_win32_showWindow(window);
+	#endif
+}
+
+void tinyengine_setWindowTitle(tinyengine_windowContext* window, const char* title){
+	#if defined(TE_LINUX)
+		_tinyengine_x11_setWindowTitle(window,title);
+	#elif defined(TE_WIN32)
+		_tinyengine_win32_setWindowTitle(window,title);
+	#endif
+}
+
+void tinyengine_setWindowSize(tinyengine_windowContext* window, te_u32 width, te_u32 height){
+	#if defined(TE_LINUX)
+		_tinyengine_x11_setWindowSize(window,width,height);
+	#elif defined(TE_WIN32)
+		_tinyengine_win32_setWindowSize(window,width,height);
+	#endif
+}
+
+// TODO: this name isnt very descriptive to the window system, but also cant be generalized for the input?
+void tinyengine_pollEvents() {
+	#if defined(TE_LINUX)
+		_tinyengine_x11_pollDisplayEvents();
+	#elif defined(TE_WIN32)
+		_tinyengine_win32_pollEvents();
+	#endif
+
+	_tinyengine_inputLog* log = &tinyengine_state.inputLog;
+	if(log->replaying) { _tinyengine_injectRecordedInput(); }
+	if(log->replaying || log->recording) { log->frame++; }
+
+	// With manual drain the app pulls the whole batch with tinyengine_drainEvents() instead of callbacks
+	if(!tinyengine_state.eventQueue.manualDrain) { tinyengine_dispatchEvents(); }
+}
+
+//// Damage Tracking
+
+// With tracking enabled only reported damage is repainted. The renderer scissors each frame to the damage
+// since the back buffer was last drawn, which the buffer age tells, and tinyengine_getRedrawRect() lets the
+// app skip work outside it. Without a known age the whole window is repainted, as before.
+
+void _tinyengine_unionDamageRect(_tinyengine_damageRect* rect, const _tinyengine_damageRect* other) {
+	if(other->x1 <= other->x0 || other->y1 <= other->y0) { return; }
+	if(rect->x1 <= rect->x0 || rect->y1 <= rect->y0) { *rect = *other; return; }
+	if(other->x0 < rect->x0) { rect->x0 = other->x0; }
+	if(other->y0 < rect->y0) { rect->y0 = other->y0; }
+	if(other->x1 > rect->x1) { rect->x1 = other->x1; }
+	if(other->y1 > rect->y1) { rect->y1 = other->y1; }
+}
+
+// Off by default, every frame is then a full repaint and a full swap
+void tinyengine_setDamageTracking(tinyengine_windowContext* window, te_bool_u8 enabled) {
+	if(window->damage.enabled == enabled) { return; }
+	window->damage.enabled = enabled;
+	window->damage.backBufferCurrent = TE_FALSE;
+	window->damage.framesTracked = 0;
+	tinyengine_damageWindow(window);
+}
+
+// Present only the repainted rectangle where the window system can (GLX_MESA_copy_sub_buffer).
+// The copy is not synchronized to vertical blank, so the app paces its own frames.
+void tinyengine_setPartialPresent(tinyengine_windowContext* window, te_bool_u8 enabled) {
+	window->damage.partialPresent = enabled;
+}
+
+void tinyengine_addWindowDamage(tinyengine_windowContext* window, te_i32 x, te_i32 y, te_i32 width, te_i32 height) {
+	_tinyengine_damageRect rect = { x, y, x + width, y + height };
+	_tinyengine_unionDamageRect(&window->damage.pending, &rect);
+}
+
+void tinyengine_damageWindow(tinyengine_windowContext* window) {
+	window->damage.pending = (_tinyengine_damageRect){ 0, 0, 0x3FFFFFFF, 0x3FFFFFFF };
+}
+
+// Area the current frame repaints, the whole view without damage tracking. False when nothing is repainted.
+te_bool_u8 tinyengine_getRedrawRect(tinyengine_windowContext* window, te_i32* x, te_i32* y, te_i32* width, te_i32* height) {
+	_tinyengine_damageRect rect = window->damage.redraw;
+	if(!window->damage.enabled) { rect = (_tinyengine_damageRect){ 0, 0, (te_i32) window->damage.width, (te_i32) window->damage.height }; }
+	*x = rect.x0;
+	*y = rect.y0;
+	*width = rect.x1 > rect.x0 ? rect.x1 - rect.x0 : 0;
+	*height = rect.y1 > rect.y0 ? rect.y1 - rect.y0 : 0;
+	return *width > 0 && *height > 0;
+}
+
+te_u32 _tinyengine_backBufferAge(tinyengine_windowContext* window) {
+	if(window->damage.backBufferCurrent) { return 1; }
+	#if defined(TE_LINUX)
+		return _tinyengine_glx_backBufferAge(window);
+	#else
+		return 0;
+	#endif
+}
+
+// Called by the renderer at the start of a frame, works out damage.redraw. False without damage tracking.
+te_bool_u8 _tinyengine_prepareRedraw(tinyengine_windowContext* window) {
+	_tinyengine_windowDamage* damage = &window->damage;
+	if(!damage->enabled || damage->width == 0 || damage->height == 0) { return TE_FALSE; }
+
+	// Damage reported from here on is drawn over the next frame, this one is already being built
+	_tinyengine_unionDamageRect(&damage->frame, &damage->pending);
+	damage->pending = (_tinyengine_damageRect){ 0, 0, 0, 0 };
+
+	// A back buffer of age n is missing this frame's damage and that of the n - 1 frames before
+	te_u32 age = _tinyengine_backBufferAge(window);
+	_tinyengine_damageRect redraw = damage->frame;
+	if(age == 0 || age - 1 > damage->framesTracked || age - 1 > TE_DAMAGE_HISTORY) {
+		redraw = (_tinyengine_damageRect){ 0, 0, (te_i32) damage->width, (te_i32) damage->height };
+	} else {
+		for(te_u32 i = 0; i + 1 < age; i++) { _tinyengine_unionDamageRect(&redraw, &damage->history[i]); }
+	}
+
+	if(redraw.x0 < 0) { redraw.x0 = 0; }
+	if(redraw.y0 < 0) { redraw.y0 = 0; }
+	if(redraw.x1 > (te_i32) damage->width) { redraw.x1 = (te_i32) damage->width; }
+	if(redraw.y1 > (te_i32) damage->height) { redraw.y1 = (te_i32) damage->height; }
+	if(redraw.x1 <= redraw.x0 || redraw.y1 <= redraw.y0) { redraw = (_tinyengine_damageRect){ 0, 0, 0, 0 }; }
+	damage->redraw = redraw;
+	return TE_TRUE;
+}
+
+//// Present Latency
+
+// Every window measures how long input takes to reach the screen: from the oldest input event since the last
+// present to the time the next present was shown. Present times come from the window system where it can tell
+// (GLX_INTEL_swap_event, GLX_OML_sync_control), otherwise from when the swap call returned.
+
+void _tinyengine_latencyAddSample(tinyengine_windowContext* window, te_f64 ms, te_u8 source) {
+	_tinyengine_windowLatency* latency = &window->latency;
+	if(ms < 0.0) { ms = 0.0; }
+	te_u32 bucket = ms < TE_LATENCY_BUCKETS - 1 ? (te_u32) ms : TE_LATENCY_BUCKETS - 1;
+	latency->histogram[bucket]++;
+	latency->frames++;
+	latency->totalMs += ms;
+	latency->lastMs = ms;
+	latency->source = source;
+	if(ms > latency->maxMs) { latency->maxMs = ms; }
+}
+
+// Every pending swap up to and including this swap count is on screen at time
+void _tinyengine_latencyPresented(tinyengine_windowContext* window, te_u64 swap, te_f64 time, te_u8 source) {
+	_tinyengine_windowLatency* latency = &window->latency;
+	while(latency->pendingHead != latency->pendingTail) {
+		_tinyengine_latencySwap* pending = &latency->pending[latency->pendingHead & (TE_LATENCY_PENDING - 1)];
+		if(pending->swap > swap) { break; }
+		_tinyengine_latencyAddSample(window, (time - pending->input) * 1000.0, source);
+		latency->pendingHead++;
+	}
+}
+
+// Called right before the swap, the frame being presented consumed any input so far
+void _tinyengine_latencyQueueSwap(tinyengine_windowContext* window) {
+	_tinyengine_windowLatency* latency = &window->latency;
+	latency->swaps++;
+	if(latency->oldestInput == 0.0) { return; }
+
+	// Present times stopped coming (a compositor eating swap events), settle for the swap time
+	if(latency->pendingTail - latency->pendingHead == TE_LATENCY_PENDING) {
+		_tinyengine_latencySwap* oldest = &latency->pending[latency->pendingHead & (TE_LATENCY_PENDING - 1)];
+		_tinyengine_latencyAddSample(window, (oldest->swapTime - oldest->input) * 1000.0, TE_PRESENT_TIME_SWAP_CALL);
+		latency->pendingHead++;
+	}
+
+	latency->pending[latency->pendingTail & (TE_LATENCY_PENDING - 1)] = (_tinyengine_latencySwap){ latency->swaps, latency->oldestInput, tinyengine_getTime() };
+	latency->pendingTail++;
+	latency->oldestInput = 0.0;
+}
+
+void tinyengine_getLatencyStats(tinyengine_windowContext* window, tinyengine_latencyStats* stats) {
+	_tinyengine_windowLatency* latency = &window->latency;
+	memset(stats, 0, sizeof(*stats));
+	memcpy(stats->histogram, latency->histogram, sizeof(stats->histogram));
+	stats->frames = latency->frames;
+	stats->lastMs = latency->lastMs;
+	stats->maxMs = latency->maxMs;
+	stats->source = latency->source;
+	if(latency->frames == 0) { return; }
+
+	stats->meanMs = latency->totalMs / latency->frames;
+	te_u32 seen = 0;
+	for(te_u32 bucket = 0; bucket < TE_LATENCY_BUCKETS; bucket++) {
+		seen += latency->histogram[bucket];
+		if(stats->p50Ms == 0.0 && (te_u64) seen * 2 >= latency->frames) { stats->p50Ms = bucket + 1; }
+		if(stats->p99Ms == 0.0 && (te_u64) seen * 100 >= (te_u64) latency->frames * 99) { stats->p99Ms = bucket + 1; }
+	}
+	if(stats->p99Ms > stats->maxMs) { stats->p99Ms = stats->maxMs; }
+	if(stats->p50Ms > stats->maxMs) { stats->p50Ms = stats->maxMs; }
+}
+
+// Swaps still waiting for a present time are kept, they count once it arrives
+void tinyengine_resetLatencyStats(tinyengine_windowContext* window) {
+	_tinyengine_windowLatency* latency = &window->latency;
+	memset(latency->histogram, 0, sizeof(latency->histogram));
+	latency->frames = 0;
+	latency->totalMs = 0.0;
+	latency->maxMs = 0.0;
+	latency->lastMs = 0.0;
+}
+
+void tinyengine_swapBuffers(tinyengine_windowContext* window) {
+	_tinyengine_windowDamage* damage = &window->damage;
+	_tinyengine_windowLatency* latency = &window->latency;
+
+	#if defined(TE_LINUX)
+		te_u8 source = _tinyengine_glx_presentSource();
+		if(source == TE_PRESENT_TIME_SYNC_CONTROL) { _tinyengine_glx_pollPresents(window); }
+	#else
+		te_u8 source = TE_PRESENT_TIME_SWAP_CALL;
+	#endif
+
+	if(damage->enabled) {
+		memmove(damage->history + 1, damage->history, (TE_DAMAGE_HISTORY - 1) * sizeof(_tinyengine_damageRect));
+		damage->history[0] = damage->frame;
+		damage->frame = (_tinyengine_damageRect){ 0, 0, 0, 0 };
+		if(damage->framesTracked < TE_DAMAGE_HISTORY) { damage->framesTracked++; }
+
+		// The back buffer already matches the front outside the redraw rect, so copying that rect presents the frame
+		_tinyengine_damageRect redraw = damage->redraw;
+		te_bool_u8 whole = redraw.x0 == 0 && redraw.y0 == 0 && redraw.x1 == (te_i32) damage->width && redraw.y1 == (te_i32) damage->height;
+		if(damage->partialPresent && !whole) {
+			if(redraw.x1 <= redraw.x0) { damage->backBufferCurrent = TE_TRUE; return; }
+			#if defined(TE_LINUX)
+				if(_tinyengine_glx_presentRegion(window, redraw.x0, (te_i32) damage->height - redraw.y1, redraw.x1 - redraw.x0, redraw.y1 - redraw.y0)) {
+					damage->backBufferCurrent = TE_TRUE;
+					// Copies are no swap, they show up straight away
+					if(latency->oldestInput != 0.0) { _tinyengine_latencyAddSample(window, (tinyengine_getTime() - latency->oldestInput) * 1000.0, TE_PRESENT_TIME_SWAP_CALL); }
+					latency->oldestInput = 0.0;
+					return;
+				}
+			#endif
+		}
+		damage->backBufferCurrent = TE_FALSE;
+	}
+
+	_tinyengine_latencyQueueSwap(window);
+	#if defined(TE_LINUX)
+		_tinyengine_glx_swapBuffers(window);
+	#elif defined(TE_WIN32)
+		_tinyengine_wgl_swapBuffers(window);
+	#endif
+	if(source == TE_PRESENT_TIME_SWAP_CALL) { _tinyengine_latencyPresented(window, latency->swaps, tinyengine_getTime(), TE_PRESENT_TIME_SWAP_CALL); }
+}
+
+void tinyengine_makeCurrent(tinyengine_windowContext* window) {
+	#if defined(TE_LINUX)
+		_tinyengine_glx_makeCurrent(window);
+	#elif defined(TE_WIN32)
+		_tinyengine_wgl_makeCurrent(window);
+	#endif
+}
+
+//// Renderer
+
+// TODO: Support multiple renderers and allow selection of them with flags outside of platform
+#if defined(TE_LINUX) || defined(TE_WIN32)
+// opengl renderer
+// TODO: Create fallback opengl 1.0 renderer
+
+// Every shader starts with one of these. With uniform buffers the view is a block shared by all programs,
+// one small buffer update per window instead of a uniform upload per program.
+static const char* TE_GL3_SHADER_PRELUDE = "#version 130\n";
+static const char* TE_GL3_SHADER_PRELUDE_VIEW_BLOCK = "#version 140\n#define TE_VIEW_BLOCK\n";
+static const char* TE_GL3_SHADER_PRELUDE_VIEW_BLOCK_ARB = "#version 130\n#extension GL_ARB_uniform_buffer_object : require\n#define TE_VIEW_BLOCK\n";
+
+#define TE_GL3_VIEW_UNIFORM \
+		"#ifdef TE_VIEW_BLOCK                                                    \n" \
+		"layout(std140) uniform view { mat4 projection; };                       \n" \
+		"#else                                                                   \n" \
+		"uniform mat4 projection;                                                \n" \
+		"#endif                                                                  \n"
+
+// Immediate mode vertices share one compact layout, see _tinyengine_gl3_vertex2D. Text uses the sprite vertex shader.
+// Positions carry a depth for the layered pass, 2D vertices leave it out and read 0.
+
+static const char* TE_GL3_SPRITE_VERTEX_SRC =
+		"in vec3 position;                                                       \n"
+		"in vec2 uv;                                                             \n"
+		"in vec4 tint;                                                           \n"
+		"out vec2 tex_cords;                                                     \n"
+		"out vec4 vertex_color;                                                  \n"
+		"                                                                        \n"
+		TE_GL3_VIEW_UNIFORM
+		"                                                                        \n"
+		"void main()                                                             \n"
+		"{                                                                       \n"
+		"    tex_cords = uv;                                                     \n"
+		"    vertex_color = vec4(tint.rgb * tint.a, tint.a);                     \n"
+		"    gl_Position = vec4(position, 1.0) * projection;                     \n"
+		"}                                                                       \n"
+;
+
+static const char* TE_GL3_SPRITE_FRAGMENT_SRC =
+		"in vec2 tex_cords;                                                      \n"
+		"in vec4 vertex_color;                                                   \n"
+		"out vec4 color;                                                         \n"
+		"                                                                        \n"
+		"uniform sampler2D texture_bank;                                         \n"
+		"                                                                        \n"
+		"void main()                                                             \n"
+		"{                                                                       \n"
+		"    color = texture(texture_bank, tex_cords) * vertex_color;            \n"
+		"}                                                                       \n"
+;
+
+static const char* TE_GL3_TEXT_FRAGMENT_SRC =
+		"in vec2 tex_cords;                                                      \n"
+		"in vec4 vertex_color;                                                   \n"
+		"out vec4 color;                                                         \n"
+		"                                                                        \n"
+		"uniform sampler2D texture_bank;                                         \n"
+		"                                                                        \n"
+		"void main()                                                             \n"
+		"{                                                                       \n"
+		"    color = vertex_color * texture(texture_bank, tex_cords).a;          \n"
+		"}                                                                       \n"
+;
+
+static const char* TE_GL3_FLAT_VERTEX_SRC =
+		"in vec3 position;                                                       \n"
+		"in vec4 tint;                                                           \n"
+		"out vec4 vertex_color;                                                  \n"
+		"                                                                        \n"
+		TE_GL3_VIEW_UNIFORM
+		"                                                                        \n"
+		"void main()                                                             \n"
+		"{                                                                       \n"
+		"    vertex_color = vec4(tint.rgb * tint.a, tint.a);                     \n"
+		"    gl_Position = vec4(position, 1.0) * projection;                     \n"
+		"}                                                                       \n"
+;
+
+static const char* TE_GL3_FLAT_FRAGMENT_SRC =
+		"in vec4 vertex_color;                                                   \n"
+		"out vec4 color;                                                         \n"
+		"                                                                        \n"
+		"void main()                                                             \n"
+		"{                                                                       \n"
+		"    color = vertex_color;                                               \n"
+		"}                                                                       \n"
+;
+
+// Bilinear upscale with an unsharp mask over the four neighbours. upscale is (texel width, texel height, strength),
+// limit the largest coordinate the offscreen frame covers, taps stay inside it.
+static const char* TE_GL3_UPSCALE_FRAGMENT_SRC =
+		"in vec2 tex_cords;                                                      \n"
+		"out vec4 color;                                                         \n"
+		"                                                                        \n"
+		"uniform sampler2D texture_bank;                                         \n"
+		"uniform vec3 upscale;                                                   \n"
+		"uniform vec3 limit;                                                     \n"
+		"                                                                        \n"
+		"vec4 tap(vec2 offset)                                                   \n"
+		"{                                                                       \n"
+		"    vec2 low = upscale.xy * 0.5;                                        \n"
+		"    return texture(texture_bank, clamp(tex_cords + offset * upscale.xy, low, limit.xy - low)); \n"
+		"}                                                                       \n"
+		"                                                                        \n"
+		"void main()                                                             \n"
+		"{                                                                       \n"
+		"    vec4 centre = tap(vec2(0.0, 0.0));                                  \n"
+		"    vec4 around = tap(vec2(1.0, 0.0)) + tap(vec2(-1.0, 0.0)) + tap(vec2(0.0, 1.0)) + tap(vec2(0.0, -1.0)); \n"
+		"    color = clamp(centre + (centre - around * 0.25) * upscale.z, 0.0, 1.0); \n"
+		"}                                                                       \n"
+;
+
+static const char* const TE_GL3_VERTEX2D_ATTRIBUTES[] = { "position", "uv", "tint", NULL };
+
+// TODO: Move these to the header
+
+#if defined(TE_WIN32)
+	#define _TE_GL_FUNCTION __stdcall
+#else
+	#define _TE_GL_FUNCTION
+#endif
+
+typedef te_u32	te_GLenum;
+
+typedef te_i8		te_GLbyte;
+typedef te_u8		te_GLubyte;
+typedef te_i16 	te_GLshort;
+typedef te_u16 	te_GLushort;
+typedef te_i32 	te_GLint;
+typedef te_u32 	te_GLuint;
+
+typedef te_i32 	te_GLsizei;
+typedef te_f32	te_GLfloat;
+
+typedef char		te_GLchar;
+
+typedef te_bool_u8 te_GLboolean;
+
+// Pointer sized, offsets and sizes above 2GB or in 64 bit registers depend on it
+typedef intptr_t te_GLintptr;
+typedef intptr_t te_GLsizeiptr;
+typedef te_u64 te_GLuint64;
+typedef struct _te_GLsync* te_GLsync;
+
+#define TE_GL_FALSE 0
+#define TE_GL_TRUE 1
+
+typedef struct _tinyengine_gl3_bitmapBakedCharcter_t {
+  te_u16 x0,y0,x1,y1;
+  te_f32 xoff,yoff,xadvance;
+} _tinyengine_gl3_bitmapBakedCharcter;
+
+// Compact vertex for all immediate mode drawing, 16 bytes. A float layout with the same tint would take 32.
+typedef struct _tinyengine_gl3_vertex2D_t {
+	te_f32 x, y;
+	te_u16 u, v; // normalized, 0..1
+	te_u8 color[4]; // straight alpha, premultiplied in the shader
+} _tinyengine_gl3_vertex2D;
+
+// Quads collected before a draw call, 4 vertices each
+#ifndef TE_GL3_BATCH_QUADS
+	#define TE_GL3_BATCH_QUADS 2048
+#endif
+
+// The stream buffer holds this many batches before it is orphaned
+#define TE_GL3_BATCH_BUFFER_BATCHES 8
+#define TE_GL3_BATCH_BUFFER_QUADS (TE_GL3_BATCH_QUADS * TE_GL3_BATCH_BUFFER_BATCHES)
+
+// One static index buffer covers the whole stream buffer, so it has to stay addressable with 16 bit indices
+#if TE_GL3_BATCH_BUFFER_QUADS * 4 > 65536
+	#error "TE_GL3_BATCH_QUADS too large for 16 bit quad indices"
+#endif
+
+typedef struct _tinyengine_gl3_bitmapGlyphCache_t {
+	_tinyengine_gl3_bitmapBakedCharcter characterData[96]; // ASCII 32..126 is 95 glyphs
+	te_u32 resolution;
+	te_GLuint textureID;
+} _tinyengine_gl3_bitmapGlyphCache;
+
+#define TE_GL_VENDOR 0x1F00
+#define TE_GL_RENDERER 0x1F01
+#define TE_GL_VERSION 0x1F02
+// Use this only in the GL 3.0 version not 1.0
+#define TE_GL_SHADING_LANGUAGE_VERSION 0x8B8C
+
+#define TE_GL_FRAGMENT_SHADER 0x8B30
+#define TE_GL_VERTEX_SHADER 0x8B31
+#define TE_GL_COMPILE_STATUS 0x8B81
+#define TE_GL_LINK_STATUS 0x8B82
+
+#define TE_GL_TEXTURE_2D 0x0DE1
+#define TE_GL_ARRAY_BUFFER 0x8892
+#define TE_GL_ELEMENT_ARRAY_BUFFER 0x8893
+
+#define TE_GL_TRIANGLES 0x0004
+#define TE_GL_TRIANGLE_STRIP 0x0005
+#define TE_GL_TRIANGLE_FAN 0x0006
+
+#define TE_GL_STATIC_DRAW 0x88E4
+#define TE_GL_DYNAMIC_DRAW 0x88E8
+#define TE_GL_STREAM_DRAW 0x88E0
+#define TE_GL_STREAM_READ 0x88E1
+
+#define TE_GL_PIXEL_PACK_BUFFER 0x88EB
+#define TE_GL_PIXEL_UNPACK_BUFFER 0x88EC
+#define TE_GL_MAP_READ_BIT 0x0001
+#define TE_GL_MAP_WRITE_BIT 0x0002
+#define TE_GL_MAP_INVALIDATE_RANGE_BIT 0x0004
+#define TE_GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
+#define TE_GL_MAP_UNSYNCHRONIZED_BIT 0x0020
+
+#define TE_GL_UNSIGNED_BYTE 0x1401
+#define TE_GL_UNSIGNED_SHORT 0x1403
+
+#define TE_GL_FLOAT 0x1406
+
+#define TE_GL_RGB 0x1907
+#define TE_GL_RGBA 0x1908
+
+#define TE_GL_TEXTURE0 0x84C0
+
+#define TE_GL_EXTENSIONS 0x1F03
+#define TE_GL_NUM_EXTENSIONS 0x821D
+
+#define TE_GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define TE_GL_PROGRAM_BINARY_LENGTH 0x8741
+#define TE_GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+
+#define TE_GL_COMPLETION_STATUS_KHR 0x91B1
+
+#define TE_GL_TEXTURE_MAG_FILTER 0x2800
+#define TE_GL_TEXTURE_MIN_FILTER 0x2801
+#define TE_GL_LINEAR 0x2601
+#define TE_GL_LINEAR_MIPMAP_LINEAR 0x2703
+#define TE_GL_TEXTURE_BASE_LEVEL 0x813C
+#define TE_GL_TEXTURE_MAX_LEVEL 0x813D
+#define TE_GL_UNPACK_ALIGNMENT 0x0CF5
+#define TE_GL_MAJOR_VERSION 0x821B
+#define TE_GL_MINOR_VERSION 0x821C
+
+#define TE_GL_UNIFORM_BUFFER 0x8A11
+#define TE_GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT 0x8A34
+
+#define TE_GL_FRAMEBUFFER 0x8D40
+#define TE_GL_RENDERBUFFER 0x8D41
+#define TE_GL_COLOR_ATTACHMENT0 0x8CE0
+#define TE_GL_DEPTH_ATTACHMENT 0x8D00
+#define TE_GL_DEPTH_COMPONENT24 0x81A6
+#define TE_GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define TE_GL_TEXTURE_WRAP_S 0x2802
+#define TE_GL_TEXTURE_WRAP_T 0x2803
+#define TE_GL_CLAMP_TO_EDGE 0x812F
+
+#define TE_GL_TIME_ELAPSED 0x88BF
+#define TE_GL_SAMPLES_PASSED 0x8914
+#define TE_GL_QUERY_RESULT 0x8866
+#define TE_GL_QUERY_RESULT_AVAILABLE 0x8867
+
+#define TE_GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define TE_GL_ALREADY_SIGNALED 0x911A
+#define TE_GL_CONDITION_SATISFIED 0x911C
+#define TE_GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define TE_GL_INVALID_INDEX 0xFFFFFFFFu
+
+#define TE_GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define TE_GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#define TE_GL_COMPRESSED_RGB8_ETC2 0x9274
+#define TE_GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+
+void _TE_GL_FUNCTION _tinyengine_gl3_stub() {
+	TE_FATAL("!!! Using unloaded GL3 function!\n");
+	TE_TRACE();
+	exit(-1);
+}
+
+// TODO: Should this be moved into the state? or remain out for use by gamedevs and null otherwise?
+typedef struct tinyengine_gl3_functionTable {
+	te_GLenum ( _TE_GL_FUNCTION *glGetError)();
+	te_GLuint ( _TE_GL_FUNCTION *glCreateShader)(te_GLenum);
+	void ( _TE_GL_FUNCTION *glCompileShader)(te_GLuint);
+	void ( _TE_GL_FUNCTION *glGetShaderiv)(te_GLuint, te_GLenum, te_GLint*);
+	void ( _TE_GL_FUNCTION *glGetShaderInfoLog)(te_GLuint, te_GLsizei, te_GLsizei*, te_GLchar*);
+	void ( _TE_GL_FUNCTION *glBindAttribLocation)(te_GLuint, te_GLuint, const te_GLchar*);
+	te_GLuint ( _TE_GL_FUNCTION *glCreateProgram)();
+	void (_TE_GL_FUNCTION *glAttachShader)(te_GLuint, te_GLuint);
+	void (_TE_GL_FUNCTION *glLinkProgram)(te_GLuint);
+	void (_TE_GL_FUNCTION *glGetProgramiv)(te_GLuint, te_GLenum, te_GLint*);
+	void (_TE_GL_FUNCTION *glGetProgramInfoLog)(te_GLuint, te_GLsizei, te_GLsizei*, te_GLchar*);
+	void (_TE_GL_FUNCTION *glDeleteShader)(te_GLuint);
+	void (_TE_GL_FUNCTION *glDeleteProgram)(te_GLuint);
+	void (_TE_GL_FUNCTION *glShaderSource)(te_GLuint, te_GLsizei, const te_GLchar *const*, const te_GLint*);
+
+	void (_TE_GL_FUNCTION *glUseProgram)(te_GLuint);
+	void (_TE_GL_FUNCTION *glBindTexture)(te_GLenum,te_GLuint);
+	void (_TE_GL_FUNCTION *glBindVertexArray)(te_GLuint);
+	void (_TE_GL_FUNCTION *glUniform4f)(te_GLint,te_GLfloat,te_GLfloat,te_GLfloat,te_GLfloat);
+	void (_TE_GL_FUNCTION *glBindBuffer)(te_GLenum,te_GLuint);
+	void (_TE_GL_FUNCTION *glBufferSubData)(te_GLenum,te_GLintptr,te_GLsizeiptr, const void*);
+	void (_TE_GL_FUNCTION *glDrawArrays)(te_GLenum, te_GLint, te_GLsizei);
+	te_GLuint (_TE_GL_FUNCTION *glGetUniformLocation)(te_GLuint, const te_GLchar*);
+
+	void (_TE_GL_FUNCTION *glGenVertexArrays)(te_GLsizei, te_GLuint*);
+	void (_TE_GL_FUNCTION *glGenBuffers)(te_GLsizei, te_GLuint*);
+	void (_TE_GL_FUNCTION *glBufferData)(te_GLenum, te_GLsizeiptr, const void *, te_GLenum);
+	void (_TE_GL_FUNCTION *glVertexAttribPointer)(te_GLuint, te_GLint, te_GLenum, te_GLboolean, te_GLsizei, const void *);
+	void (_TE_GL_FUNCTION *glEnableVertexAttribArray)(te_GLuint);
+
+	void (_TE_GL_FUNCTION *glUniformMatrix4fv)(te_GLint, te_GLsizei, te_GLboolean, const te_GLfloat*);
+
+	void (_TE_GL_FUNCTION *glUniform1i)(te_GLint, te_GLint);
+
+	void (_TE_GL_FUNCTION *glGenTextures)(te_GLsizei, te_GLuint *);
+	void (_TE_GL_FUNCTION *glTexImage2D)(te_GLenum, GLint level, te_GLint, te_GLsizei, te_GLsizei, te_GLint, te_GLenum, te_GLenum, const void *);
+	void (_TE_GL_FUNCTION *glGenerateMipmap)(te_GLenum);
+
+	void (_TE_GL_FUNCTION *glActiveTexture)(te_GLenum);
+
+	void (_TE_GL_FUNCTION *glUniform3f)(te_GLint,te_GLfloat,te_GLfloat,te_GLfloat);
+
+	void (_TE_GL_FUNCTION *glDeleteVertexArrays)(te_GLsizei, const te_GLuint*);
+	void (_TE_GL_FUNCTION *glDeleteBuffers)(te_GLsizei, const te_GLuint*);
+
+	const te_GLubyte* (_TE_GL_FUNCTION *glGetStringi)(te_GLenum, te_GLuint);
+	void (_TE_GL_FUNCTION *glGetProgramBinary)(te_GLuint, te_GLsizei, te_GLsizei*, te_GLenum*, void*);
+	void (_TE_GL_FUNCTION *glProgramBinary)(te_GLuint, te_GLenum, const void*, te_GLsizei);
+	void (_TE_GL_FUNCTION *glProgramParameteri)(te_GLuint, te_GLenum, te_GLint);
+
+	void (_TE_GL_FUNCTION *glMaxShaderCompilerThreadsKHR)(te_GLuint);
+
+	void* (_TE_GL_FUNCTION *glMapBufferRange)(te_GLenum, te_GLintptr, te_GLsizeiptr, te_GLenum);
+	te_GLboolean (_TE_GL_FUNCTION *glUnmapBuffer)(te_GLenum);
+	void (_TE_GL_FUNCTION *glTexSubImage2D)(te_GLenum, te_GLint, te_GLint, te_GLint, te_GLsizei, te_GLsizei, te_GLenum, te_GLenum, const void*);
+	void (_TE_GL_FUNCTION *glDeleteTextures)(te_GLsizei, const te_GLuint*);
+	void (_TE_GL_FUNCTION *glMultiDrawArrays)(te_GLenum, const te_GLint*, const te_GLsizei*, te_GLsizei);
+	void (_TE_GL_FUNCTION *glCompressedTexImage2D)(te_GLenum, te_GLint, te_GLenum, te_GLsizei, te_GLsizei, te_GLint, te_GLsizei, const void*);
+	void (_TE_GL_FUNCTION *glBindBufferRange)(te_GLenum, te_GLuint, te_GLuint, te_GLintptr, te_GLsizeiptr);
+	te_GLuint (_TE_GL_FUNCTION *glGetUniformBlockIndex)(te_GLuint, const te_GLchar*);
+	void (_TE_GL_FUNCTION *glUniformBlockBinding)(te_GLuint, te_GLuint, te_GLuint);
+	te_GLsync (_TE_GL_FUNCTION *glFenceSync)(te_GLenum, te_GLuint);
+	te_GLenum (_TE_GL_FUNCTION *glClientWaitSync)(te_GLsync, te_GLuint, te_GLuint64);
+	void (_TE_GL_FUNCTION *glDeleteSync)(te_GLsync);
+	void (_TE_GL_FUNCTION *glGenQueries)(te_GLsizei, te_GLuint*);
+	void (_TE_GL_FUNCTION *glDeleteQueries)(te_GLsizei, const te_GLuint*);
+	void (_TE_GL_FUNCTION *glBeginQuery)(te_GLenum, te_GLuint);
+	void (_TE_GL_FUNCTION *glEndQuery)(te_GLenum);
+	void (_TE_GL_FUNCTION *glGetQueryObjectuiv)(te_GLuint, te_GLenum, te_GLuint*);
+	void (_TE_GL_FUNCTION *glGetQueryObjectui64v)(te_GLuint, te_GLenum, te_GLuint64*);
+	void (_TE_GL_FUNCTION *glGenFramebuffers)(te_GLsizei, te_GLuint*);
+	void (_TE_GL_FUNCTION *glDeleteFramebuffers)(te_GLsizei, const te_GLuint*);
+	void (_TE_GL_FUNCTION *glBindFramebuffer)(te_GLenum, te_GLuint);
+	void (_TE_GL_FUNCTION *glFramebufferTexture2D)(te_GLenum, te_GLenum, te_GLenum, te_GLuint, te_GLint);
+	te_GLenum (_TE_GL_FUNCTION *glCheckFramebufferStatus)(te_GLenum);
+	void (_TE_GL_FUNCTION *glGenRenderbuffers)(te_GLsizei, te_GLuint*);
+	void (_TE_GL_FUNCTION *glDeleteRenderbuffers)(te_GLsizei, const te_GLuint*);
+	void (_TE_GL_FUNCTION *glBindRenderbuffer)(te_GLenum, te_GLuint);
+	void (_TE_GL_FUNCTION *glRenderbufferStorage)(te_GLenum, te_GLenum, te_GLsizei, te_GLsizei);
+	void (_TE_GL_FUNCTION *glFramebufferRenderbuffer)(te_GLenum, te_GLenum, te_GLenum, te_GLuint);
+}	te_gl3_functions;
+
+// TODO: Compiler check and switch on this
+#pragma warning(push)
+#pragma warning( disable : 4113 4133 4068 )
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wincompatible-pointer-types"
+te_gl3_functions te_gl3 = {
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub,
+	&_tinyengine_gl3_stub
+};
+
+#define TE_GL3_PROGRAM_EMPTY 0
+#define TE_GL3_PROGRAM_PENDING 1
+#define TE_GL3_PROGRAM_READY 2
+#define TE_GL3_PROGRAM_FAILED 3
+
+// A program whose compile and link were submitted without waiting on the driver, see _tinyengine_gl3_submitProgram()
+typedef struct _tinyengine_gl3_program_t {
+	te_GLuint program;
+	te_GLuint vertex;
+	te_GLuint fragment;
+	te_u8 status;
+	te_u64 cacheKey;
+
+	te_f64 submitTime;
+	te_f64 compileLatency; // seconds from submit until the driver reported completion
+
+	// Run once the program is linked, before it is first used
+	void (*ready)(struct _tinyengine_gl3_program_t*);
+
+	// Null terminated names bound to attribute locations 0.., NULL binds just "vertex" to 0
+	const char* const* attributes;
+
+	// Without uniform buffers every program holds its own copy of the projection
+	te_GLint projectionLocation;
+	struct tinyengine_windowContext_t* projectionWindow; // whose projection the uniform currently holds
+
+} _tinyengine_gl3_program;
+
+// Texture streaming, see _tinyengine_gl3_streamTexture()
+
+// Must be below 0xFFFF, handles keep the slot in 16 bits
+#ifndef TE_GL3_MAX_STREAMED_TEXTURES
+	#define TE_GL3_MAX_STREAMED_TEXTURES 1024
+#endif
+
+// Bytes uploaded from staging per frame unless changed with _tinyengine_gl3_setTextureUploadBudget()
+#ifndef TE_GL3_TEXTURE_UPLOAD_BUDGET
+	#define TE_GL3_TEXTURE_UPLOAD_BUDGET (4 * 1024 * 1024)
+#endif
+
+// Upper bound on pixel buffer memory mapped for the decoder at once
+#ifndef TE_GL3_TEXTURE_STAGING_LIMIT
+	#define TE_GL3_TEXTURE_STAGING_LIMIT (64 * 1024 * 1024)
+#endif
+
+// Writes width * height premultiplied RGBA8 pixels to the front of the staging memory, runs on the loader thread.
+// The staging memory is at least the decode size given to _tinyengine_gl3_streamTexture(). It is mapped write
+// only and may be uncached, decoders must never read it back.
+typedef te_bool_u8 (*tinyengine_textureDecodeFunction)(void* user, te_u8* pixels, size_t size, te_u32 width, te_u32 height);
+
+#define TE_GL3_STREAM_FREE 0
+#define TE_GL3_STREAM_QUEUED 1 // waiting for staging memory
+#define TE_GL3_STREAM_STAGED 2 // mapped, waiting for or being decoded by the loader thread
+#define TE_GL3_STREAM_DECODED 3 // waiting for upload
+#define TE_GL3_STREAM_READY 4
+#define TE_GL3_STREAM_FAILED 5
+
+typedef struct _tinyengine_gl3_streamedTexture_t {
+	te_u8 status;
+	te_bool_u8 released;
+	te_u16 generation;
+
+	te_GLuint texture;
+	te_GLuint pixelBuffer;
+	te_u8* staging;
+	size_t stagingSize;
+	size_t decodeSize;
+	te_u32 width;
+	te_u32 height;
+
+	tinyengine_textureDecodeFunction decode;
+	void (*release)(void* user);
+	void* user;
+} _tinyengine_gl3_streamedTexture;
+
+typedef struct _tinyengine_gl3_textureStream_t {
+	_tinyengine_gl3_streamedTexture textures[TE_GL3_MAX_STREAMED_TEXTURES];
+	te_u32 textureCount; // slots ever handed out
+
+	// Slots waiting for the loader thread, in submission order
+	te_u16 decodeQueue[TE_GL3_MAX_STREAMED_TEXTURES];
+	te_u32 decodeHead;
+	te_u32 decodeTail;
+
+	te_u32 pending; // textures not yet ready or failed
+	size_t stagingInFlight;
+	size_t uploadBudget;
+	size_t bytesUploaded; // total, for stats
+
+	te_GLuint placeholder;
+
+	#if defined(TE_PTHREADS)
+		te_bool_u8 threadRunning;
+		te_bool_u8 threadExit;
+		pthread_t thread;
+		pthread_mutex_t lock;
+		pthread_cond_t wake;
+	#endif
+} _tinyengine_gl3_textureStream;
+
+// Engine level draw commands recorded to a file, see _tinyengine_gl3_startCapture()
+#include <stdio.h> // FILE
+#define TE_CAPTURE_MAX_WINDOWS 8
+#define TE_CAPTURE_MAX_FONTS 32
+
+// Draw paths commands cannot describe, each one warns once per capture, see _tinyengine_gl3_warnNotCaptured()
+#define TE_CAPTURE_SKIPPED_ENTITIES (1u << 0)
+#define TE_CAPTURE_SKIPPED_TILEMAPS (1u << 1)
+#define TE_CAPTURE_SKIPPED_LAYERS (1u << 2)
+#define TE_CAPTURE_SKIPPED_CACHED_LAYERS (1u << 3)
+
+typedef struct _tinyengine_gl3_capture_t {
+	FILE* file;
+	struct tinyengine_windowContext_t* windows[TE_CAPTURE_MAX_WINDOWS];
+	const _tinyengine_gl3_bitmapGlyphCache* fonts[TE_CAPTURE_MAX_FONTS];
+	te_u32 fontCount;
+	te_GLuint* textures; // already written, sorted
+	te_u32 textureCount;
+	te_u32 textureCapacity;
+	te_u32 frames;
+	size_t bytes;
+	te_u32 skipped; // TE_CAPTURE_SKIPPED_* paths already warned about
+} _tinyengine_gl3_capture;
+
+// Window contents read back without stalling and written out by an encoder thread, see _tinyengine_gl3_startRecording()
+#define TE_GL3_RECORD_BUFFERS 4
+
+#define TE_RECORD_Y4M 0 // one YUV4MPEG2 stream, 4:2:0
+#define TE_RECORD_PNG 1 // numbered uncompressed PNG files
+
+#define TE_GL3_RECORD_FREE 0
+#define TE_GL3_RECORD_READING 1 // readback issued, waiting on the fence
+#define TE_GL3_RECORD_ENCODING 2 // mapped, owned by the encoder
+#define TE_GL3_RECORD_ENCODED 3 // ready to unmap
+
+typedef struct _tinyengine_gl3_frameRecorder_t {
+	struct tinyengine_windowContext_t* window;
+	te_u32 format;
+	char path[512]; // the stream, or the prefix of the numbered files
+	FILE* file;
+	te_u32 width;
+	te_u32 height;
+	te_u32 fps;
+
+	te_GLuint buffers[TE_GL3_RECORD_BUFFERS];
+	te_GLsync fences[TE_GL3_RECORD_BUFFERS];
+	const te_u8* mapped[TE_GL3_RECORD_BUFFERS];
+	te_u32 frameNumbers[TE_GL3_RECORD_BUFFERS];
+	te_u32 issuedAt[TE_GL3_RECORD_BUFFERS];
+	volatile te_u8 status[TE_GL3_RECORD_BUFFERS];
+	te_u32 next; // slot the next readback goes to, slots are used in order
+
+	te_u32 encodeQueue[TE_GL3_RECORD_BUFFERS]; // slots in frame order
+	te_u32 encodeHead;
+	te_u32 encodeTail;
+	te_u8* scratch; // encoder's conversion buffer
+
+	te_u32 framesSeen;
+	te_u32 framesWritten;
+	te_u32 framesDropped;
+	te_f64 gpuThreadSeconds; // spent in _tinyengine_gl3_recordFrame(), for benchmarks
+
+	#if defined(TE_PTHREADS)
+		te_bool_u8 threadRunning;
+		te_bool_u8 threadExit;
+		pthread_t thread;
+		pthread_mutex_t lock;
+		pthread_cond_t wake;
+	#endif
+} _tinyengine_gl3_frameRecorder;
+
+#define TE_LAYER_AUTO 0 // opaque when the tint and the texture are, see _tinyengine_gl3_setTextureOpaque()
+#define TE_LAYER_OPAQUE 1 // every covered pixel is replaced, alpha is ignored
+#define TE_LAYER_TRANSLUCENT 2 // always blended
+
+typedef struct _tinyengine_gl3_layerSprite_t {
+	te_f32 x0, y0, x1, y1;
+	te_u16 u0, v0, u1, v1;
+	te_u8 color[4];
+	te_GLuint texture; // 0 draws a flat rectangle
+	te_i32 layer;
+	te_u32 sequence; // submission order, the painter's rank once sorted
+	te_bool_u8 opaque;
+} _tinyengine_gl3_layerSprite;
+
+// The batch vertex with a depth in front
+typedef struct _tinyengine_gl3_layerVertex_t {
+	te_f32 x, y, z;
+	te_u16 u, v;
+	te_u8 color[4];
+} _tinyengine_gl3_layerVertex;
+
+typedef struct _tinyengine_gl3_layers_t {
+	struct tinyengine_windowContext_t* window; // collecting between beginLayers and endLayers
+	_tinyengine_gl3_layerSprite* sprites;
+	te_u32 count;
+	te_u32 capacity;
+	te_u32* order; // opaque front to back, then translucent back to front
+	_tinyengine_gl3_layerVertex* vertices;
+	te_GLuint vbo;
+
+	// Last pass, for benchmarks
+	te_u32 opaqueCount;
+	te_u32 translucentCount;
+	te_u32 drawCalls;
+	size_t bytesUploaded;
+} _tinyengine_gl3_layers;
+
+#define TE_GL3_OVERDRAW_QUERIES 4
+
+// Samples passed per frame over the view area. Fragments rejected by the depth test are not counted.
+typedef struct _tinyengine_gl3_overdrawCounter_t {
+	struct tinyengine_windowContext_t* window; // counting while set
+	te_GLuint queries[TE_GL3_OVERDRAW_QUERIES];
+	te_u32 pixels[TE_GL3_OVERDRAW_QUERIES]; // view area when the query was issued
+	te_u32 issued; // running counts, issued - collected queries are in flight
+	te_u32 collected;
+	te_bool_u8 active; // a query is open between startFrame and endFrame
+
+	te_f32 lastFrame;
+	te_u64 samples; // totals since counting started
+	te_u64 area;
+} _tinyengine_gl3_overdrawCounter;
+
+// Text and cached layers drawn while a window renders offscreen, drawn over the upscaled frame at native resolution
+typedef struct _tinyengine_gl3_overlayRun_t {
+	_tinyengine_gl3_program* program;
+	te_GLuint texture;
+	te_bool_u8 worldSpace;
+	te_u32 firstQuad;
+	te_u32 quadCount;
+} _tinyengine_gl3_overlayRun;
+
+typedef struct _tinyengine_gl3_overlay_t {
+	_tinyengine_gl3_vertex2D* vertices;
+	te_u32 quadCount;
+	te_u32 quadCapacity;
+	_tinyengine_gl3_overlayRun* runs;
+	te_u32 runCount;
+	te_u32 runCapacity;
+} _tinyengine_gl3_overlay;
+
+#define TE_GL3_MAX_RENDER_TARGETS 64
+#define TE_GL3_RENDER_TARGET_IDLE_FRAMES 300 // released targets are deleted after this many frames unused
+
+#define TE_RENDER_TARGET_COLOR 0 // RGBA8
+#define TE_RENDER_TARGET_COLOR_DEPTH 1 // RGBA8 and a 24 bit depth buffer
+
+// Framebuffer with its attachments, pooled by size and format, see _tinyengine_gl3_acquireRenderTarget()
+typedef struct _tinyengine_gl3_renderTarget_t {
+	te_GLuint framebuffer; // 0 for a free slot
+	te_GLuint texture;
+	te_GLuint depthBuffer;
+	te_u32 width;
+	te_u32 height;
+	te_u32 format;
+	te_bool_u8 inUse;
+	te_u32 releasedFrame;
+} _tinyengine_gl3_renderTarget;
+
+// Draws recorded once into a texture and composited as a single sprite, see _tinyengine_gl3_beginCachedLayer()
+typedef struct _tinyengine_gl3_cachedLayer_t {
+	te_u32 target; // pooled render target, 0 until first recorded
+	te_u32 width;
+	te_u32 height;
+	te_u64 contentHash; // of the last recording, 0 when only invalidated explicitly
+	te_bool_u8 valid;
+	te_u32 redraws; // for benchmarks
+} _tinyengine_gl3_cachedLayer;
+
+// Window state put aside while a cached layer records
+typedef struct _tinyengine_gl3_layerRecording_t {
+	_tinyengine_gl3_cachedLayer* layer; // recording when set
+	te_u32 viewWidth;
+	te_u32 viewHeight;
+	te_bool_u8 worldSpace;
+	te_bool_u8 scissor;
+} _tinyengine_gl3_layerRecording;
+
+// Resources shared by every window, they all render through the one shared context
+typedef struct tinyengine_gl3_state_t {
+	te_bool_u8 initialized;
+	te_bool_u8 sharedResourcesReady;
+
+	const char* rendererString;
+	const char* versionString;
+
+	te_bool_u8 hasProgramBinary;
+	char shaderCacheDirectory[512]; // empty disables the program binary cache
+	te_u32 shaderCacheHits;
+	te_u32 shaderCacheMisses;
+
+	te_bool_u8 hasParallelShaderCompile;
+
+	// Block compressed formats the cooked texture loader can upload as is
+	te_bool_u8 hasS3TC;
+	te_bool_u8 hasETC2;
+
+	// Fences, frame recording knows when a readback landed without waiting for it
+	te_bool_u8 hasSync;
+
+	// GPU timing for dynamic resolution
+	te_bool_u8 hasTimerQuery;
+
+	// Shared view block, see _tinyengine_gl3_applyProjection()
+	te_bool_u8 hasUniformBuffer;
+	const char* shaderPrelude;
+	te_u32 viewBlockStride; // screen block at 0, world block at this offset
+	struct tinyengine_windowContext_t* boundViewWindow; // whose block is bound to binding 0
+	te_bool_u8 boundViewWorld;
+
+	_tinyengine_gl3_program textProgram;
+
+	// Retained scenes, created with the first scene
+	_tinyengine_gl3_program sceneProgram;
+	te_GLuint whiteTexture;
+
+	_tinyengine_gl3_program spriteProgram;
+	_tinyengine_gl3_program flatProgram;
+
+	// Dynamic resolution, created with the first sharpening upscale
+	_tinyengine_gl3_program upscaleProgram;
+	te_GLint upscaleLocation;
+	te_GLint upscaleLimitLocation;
+	_tinyengine_gl3_overlay overlay;
+
+	// Offscreen targets for dynamic resolution and cached layers
+	_tinyengine_gl3_renderTarget renderTargets[TE_GL3_MAX_RENDER_TARGETS];
+	te_u32 frameIndex; // counts endFrame calls, for idle targets
+	te_u32 renderTargetsCreated; // totals, for benchmarks
+	_tinyengine_gl3_layerRecording cachedLayerRecording;
+
+	// Immediate mode draws collect here until the program, texture or window changes, see _tinyengine_gl3_flushBatch()
+	_tinyengine_gl3_vertex2D batchVertices[TE_GL3_BATCH_QUADS * 4];
+	te_u32 batchLength; // in vertices
+	_tinyengine_gl3_program* batchProgram;
+	te_GLuint batchTexture;
+	struct tinyengine_windowContext_t* batchWindow;
+	te_GLuint batchVBO;
+	te_GLuint quadIndexBuffer; // static 0,1,2,2,3,0 pattern over the whole stream buffer
+	te_u32 batchBufferOffset; // vertices written since the buffer was last orphaned
+	te_u32 batchDrawCalls; // totals, for benchmarks
+	te_u64 batchBytes;
+
+	_tinyengine_gl3_textureStream textureStream;
+	_tinyengine_gl3_capture capture;
+	_tinyengine_gl3_frameRecorder recorder;
+
+	_tinyengine_gl3_layers layers;
+	_tinyengine_gl3_overdrawCounter overdraw;
+	te_u8* opaqueTextures; // bit per texture name
+	te_u32 opaqueTextureCapacity; // in names
+} tinyengine_gl3_state;
+
+tinyengine_gl3_state te_gl3_state = {0};
+#pragma GCC diagnostic pop
+#pragma warning(pop)
+
+void* _tinyengine_gl_loadProc(const char* function) {
+	#if defined(TE_WIN32)
+		void* address = wglGetProcAddress(function);
+		if(address == NULL || address <= (void*)3){
+			HMODULE module = LoadLibraryA("opengl32.dll");
+			address = (void *)GetProcAddress(module, function);
+		}
+		return address;
+	#elif defined(TE_LINUX)
+		return glXGetProcAddress(function);
+	#endif
+	return NULL;
+}
+
+#define _TE_GL_FUNCTION_LOAD(_f) te_gl3._f = _tinyengine_gl_loadProc(TE_D2STR(_f));
+
+te_bool_u8 _tinyengine_gl3_hasExtension(const char* name) {
+	te_GLint count = 0;
+	glGetIntegerv(TE_GL_NUM_EXTENSIONS, &count);
+	for(te_GLint i = 0; i < count; i++) {
+		const char* extension = (const char*) te_gl3.glGetStringi(TE_GL_EXTENSIONS, i);
+		if(extension && strcmp(extension, name) == 0) { return TE_TRUE; }
+	}
+	return TE_FALSE;
+}
+
+//// Program binary cache
+
+// Linked programs are stored on disk keyed by a hash of their sources and the driver, so a warm start
+// skips GLSL compilation entirely. Any mismatch or load failure falls back to compiling from source.
+
+#include <stdio.h> // fopen(); fread(); fwrite(); snprintf();
+#if defined(TE_WIN32)
+	#include <direct.h> // _mkdir();
+	#define _TE_MKDIR(_p) _mkdir(_p)
+#else
+	#include <sys/stat.h> // mkdir();
+	#define _TE_MKDIR(_p) mkdir((_p), 0755)
+#endif
+
+#define TE_GL3_SHADER_CACHE_VERSION 1
+
+typedef struct _tinyengine_gl3_programBinaryHeader_t {
+	char magic[4]; // TEPB
+	te_u32 version;
+	te_u64 key;
+	te_u32 binaryFormat;
+	te_u32 length;
+} _tinyengine_gl3_programBinaryHeader;
+
+void _tinyengine_gl3_setShaderCacheDirectory(const char* path) {
+	te_gl3_state.shaderCacheDirectory[0] = '\0';
+	if(path == NULL) { return; }
+	int written = snprintf(te_gl3_state.shaderCacheDirectory, sizeof(te_gl3_state.shaderCacheDirectory), "%s", path);
+	// A path cut short could name some other directory, no cache is safer
+	if(written < 0 || (size_t) written >= sizeof(te_gl3_state.shaderCacheDirectory)) {
+		TE_WARN("Shader cache path is too long, the cache is off\n");
+		te_gl3_state.shaderCacheDirectory[0] = '\0';
+		return;
+	}
+	_TE_MKDIR(te_gl3_state.shaderCacheDirectory);
+}
+
+void _tinyengine_gl3_defaultShaderCacheDirectory() {
+	te_gl3_state.shaderCacheDirectory[0] = '\0';
+	#if defined(TE_GL3_SHADER_CACHE_DIR)
+		_tinyengine_gl3_setShaderCacheDirectory(TE_GL3_SHADER_CACHE_DIR);
+	#elif defined(TE_WIN32)
+		const char* base = getenv("LOCALAPPDATA");
+		if(base == NULL) { return; }
+		char path[sizeof(te_gl3_state.shaderCacheDirectory)];
+		int written = snprintf(path, sizeof(path), "%s\\tinyengine", base);
+		if(written < 0 || (size_t) written >= sizeof(path)) { TE_WARN("Shader cache path is too long, the cache is off\n"); return; }
+		_tinyengine_gl3_setShaderCacheDirectory(path);
+	#else
+		char path[sizeof(te_gl3_state.shaderCacheDirectory)];
+		int written;
+		const char* base = getenv("XDG_CACHE_HOME");
+		if(base != NULL && base[0] != '\0') {
+			written = snprintf(path, sizeof(path), "%s/tinyengine", base);
+		} else {
+			base = getenv("HOME");
+			if(base == NULL) { return; }
+			written = snprintf(path, sizeof(path), "%s/.cache", base);
+			if(written >= 0 && (size_t) written < sizeof(path)) { _TE_MKDIR(path); }
+			written = snprintf(path, sizeof(path), "%s/.cache/tinyengine", base);
+		}
+		if(written < 0 || (size_t) written >= sizeof(path)) { TE_WARN("Shader cache path is too long, the cache is off\n"); return; }
+		_tinyengine_gl3_setShaderCacheDirectory(path);
+	#endif
+}
+
+te_u64 _tinyengine_gl3_programCacheKey(const char* vertexSrc, const char* fragmentSrc) {
+	te_u32 version = TE_GL3_SHADER_CACHE_VERSION;
+	te_u64 key = TE_FNV1A64_SEED;
+	key = _tinyengine_fnv1a64(key, &version, sizeof(version));
+	key = _tinyengine_fnv1a64(key, te_gl3_state.shaderPrelude, strlen(te_gl3_state.shaderPrelude) + 1);
+	key = _tinyengine_fnv1a64(key, vertexSrc, strlen(vertexSrc) + 1);
+	key = _tinyengine_fnv1a64(key, fragmentSrc, strlen(fragmentSrc) + 1);
+	if(te_gl3_state.rendererString) { key = _tinyengine_fnv1a64(key, te_gl3_state.rendererString, strlen(te_gl3_state.rendererString) + 1); }
+	if(te_gl3_state.versionString) { key = _tinyengine_fnv1a64(key, te_gl3_state.versionString, strlen(te_gl3_state.versionString) + 1); }
+	return key;
+}
+
+te_bool_u8 _tinyengine_gl3_programCachePath(te_u64 key, char* path, size_t length) {
+	if(!te_gl3_state.hasProgramBinary || te_gl3_state.shaderCacheDirectory[0] == '\0') { return TE_FALSE; }
+	snprintf(path, length, "%s/%016llx.teprog", te_gl3_state.shaderCacheDirectory, (unsigned long long) key);
+	return TE_TRUE;
+}
+
+te_bool_u8 _tinyengine_gl3_loadProgramBinary(te_GLuint* program, te_u64 key) {
+	char path[600];
+	if(!_tinyengine_gl3_programCachePath(key, path, sizeof(path))) { return TE_FALSE; }
+
+	FILE* file = fopen(path, "rb");
+	if(file == NULL) { return TE_FALSE; }
+
+	_tinyengine_gl3_programBinaryHeader header;
+	te_bool_u8 valid = fread(&header, sizeof(header), 1, file) == 1
+		&& memcmp(header.magic, "TEPB", 4) == 0
+		&& header.version == TE_GL3_SHADER_CACHE_VERSION
+		&& header.key == key
+		&& header.length > 0;
+
+	void* binary = valid ? malloc(header.length) : NULL;
+	valid = binary != NULL && fread(binary, 1, header.length, file) == header.length;
+	fclose(file);
+
+	if(!valid) { free(binary); TE_WARN("Discarding invalid program binary %s\n", path); return TE_FALSE; }
+
+	*program = te_gl3.glCreateProgram();
+	te_gl3.glProgramBinary(*program, header.binaryFormat, binary, (te_GLsizei) header.length);
+	free(binary);
+
+	// The driver rejects binaries from other versions or hardware with a failed link status
+	te_GLint success = TE_GL_FALSE;
+	te_gl3.glGetProgramiv(*program, TE_GL_LINK_STATUS, &success);
+	if(success == TE_GL_FALSE) {
+		TE_WARN("Driver rejected cached program binary %s\n", path);
+		te_gl3.glDeleteProgram(*program);
+		*program = 0;
+		return TE_FALSE;
+	}
+
+	return TE_TRUE;
+}
+
+void _tinyengine_gl3_storeProgramBinary(te_GLuint program, te_u64 key) {
+	char path[600];
+	if(!_tinyengine_gl3_programCachePath(key, path, sizeof(path))) { return; }
+
+	te_GLint length = 0;
+	te_gl3.glGetProgramiv(program, TE_GL_PROGRAM_BINARY_LENGTH, &length);
+	if(length <= 0) { return; }
+
+	void* binary = malloc(length);
+	if(binary == NULL) { return; }
+
+	_tinyengine_gl3_programBinaryHeader header = { {'T','E','P','B'}, TE_GL3_SHADER_CACHE_VERSION, key, 0, 0 };
+	te_GLsizei written = 0;
+	te_gl3.glGetProgramBinary(program, length, &written, &header.binaryFormat, binary);
+	header.length = (te_u32) written;
+
+	// Write to a temporary name first so a crash never leaves a truncated binary behind
+	char temporaryPath[610];
+	snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", path);
+
+	FILE* file = fopen(temporaryPath, "wb");
+	if(file != NULL) {
+		te_bool_u8 ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(binary, 1, written, file) == (size_t) written;
+		ok = fclose(file) == 0 && ok;
+		remove(path);
+		if(!ok || rename(temporaryPath, path) != 0) { remove(temporaryPath); TE_WARN("Could not write program binary %s\n", path); }
+	}
+
+	free(binary);
+}
+
+te_bool_u8 _tinyengine_gl3_init() {
+	if(te_gl3_state.initialized) { return TE_TRUE; }
+
+	const GLubyte* ( _TE_GL_FUNCTION *te_glGetString)(te_GLenum name) = _tinyengine_gl_loadProc("glGetString");
+	if(!te_glGetString) { TE_ERROR("Could not get address of glGetString!\n"); return TE_FALSE; }
+	if(te_glGetString(TE_GL_VERSION) == NULL) { TE_ERROR("glContext not valid!\n"); return TE_FALSE; }
+	if(atof(te_glGetString(TE_GL_VERSION)) < 3.0 ) { TE_ERROR("openGL version < 3.0!\n"); return TE_FALSE; }
+
+	TE_LOG("loaded openGL 3.0 render backend.\n");
+
+	TE_LOG("OpenGL Version: %s\n",te_glGetString(TE_GL_VERSION));
+	TE_LOG("OpenGL Shader Language Version: %s\n",te_glGetString(TE_GL_SHADING_LANGUAGE_VERSION));
+	TE_LOG("OpenGL Vendor: %s\n",te_glGetString(TE_GL_VENDOR));
+	TE_LOG("OpenGL Renderer: %s\n",te_glGetString(TE_GL_RENDERER));
+
+	te_gl3_state.rendererString = (const char*) te_glGetString(TE_GL_RENDERER);
+	te_gl3_state.versionString = (const char*) te_glGetString(TE_GL_VERSION);
+
+	// TODO: Load opengl functions
+	_TE_GL_FUNCTION_LOAD(glGetError);
+	_TE_GL_FUNCTION_LOAD(glCreateShader);
+	_TE_GL_FUNCTION_LOAD(glCompileShader);
+	_TE_GL_FUNCTION_LOAD(glGetShaderiv);
+	_TE_GL_FUNCTION_LOAD(glGetShaderInfoLog);
+	_TE_GL_FUNCTION_LOAD(glBindAttribLocation);
+	_TE_GL_FUNCTION_LOAD(glCreateProgram);
+	_TE_GL_FUNCTION_LOAD(glAttachShader);
+	_TE_GL_FUNCTION_LOAD(glLinkProgram);
+	_TE_GL_FUNCTION_LOAD(glGetProgramiv);
+	_TE_GL_FUNCTION_LOAD(glGetProgramInfoLog);
+	_TE_GL_FUNCTION_LOAD(glDeleteShader);
+	_TE_GL_FUNCTION_LOAD(glDeleteProgram);
+	_TE_GL_FUNCTION_LOAD(glShaderSource);
+
+	_TE_GL_FUNCTION_LOAD(glUseProgram);
+	_TE_GL_FUNCTION_LOAD(glBindTexture);
+	_TE_GL_FUNCTION_LOAD(glBindVertexArray);
+	_TE_GL_FUNCTION_LOAD(glUniform4f);
+	_TE_GL_FUNCTION_LOAD(glBindBuffer);
+	_TE_GL_FUNCTION_LOAD(glBufferSubData);
+	_TE_GL_FUNCTION_LOAD(glDrawArrays);
+	_TE_GL_FUNCTION_LOAD(glGetUniformLocation);
+
+	_TE_GL_FUNCTION_LOAD(glGenVertexArrays);
+	_TE_GL_FUNCTION_LOAD(glGenBuffers);
+	_TE_GL_FUNCTION_LOAD(glBufferData);
+	_TE_GL_FUNCTION_LOAD(glVertexAttribPointer);
+	_TE_GL_FUNCTION_LOAD(glEnableVertexAttribArray);
+
+	_TE_GL_FUNCTION_LOAD(glUniformMatrix4fv);
+
+	_TE_GL_FUNCTION_LOAD(glUniform1i);
+
+	_TE_GL_FUNCTION_LOAD(glGenTextures);
+	_TE_GL_FUNCTION_LOAD(glTexImage2D);
+	_TE_GL_FUNCTION_LOAD(glGenerateMipmap);
+
+	_TE_GL_FUNCTION_LOAD(glActiveTexture);
+
+	_TE_GL_FUNCTION_LOAD(glUniform3f);
+
+	_TE_GL_FUNCTION_LOAD(glDeleteVertexArrays);
+	_TE_GL_FUNCTION_LOAD(glDeleteBuffers);
+
+	_TE_GL_FUNCTION_LOAD(glGetStringi);
+
+	_TE_GL_FUNCTION_LOAD(glMapBufferRange);
+	_TE_GL_FUNCTION_LOAD(glUnmapBuffer);
+	_TE_GL_FUNCTION_LOAD(glTexSubImage2D);
+	_TE_GL_FUNCTION_LOAD(glDeleteTextures);
+	_TE_GL_FUNCTION_LOAD(glCompressedTexImage2D);
+	_TE_GL_FUNCTION_LOAD(glMultiDrawArrays);
+
+	_TE_GL_FUNCTION_LOAD(glGenQueries);
+	_TE_GL_FUNCTION_LOAD(glDeleteQueries);
+	_TE_GL_FUNCTION_LOAD(glBeginQuery);
+	_TE_GL_FUNCTION_LOAD(glEndQuery);
+	_TE_GL_FUNCTION_LOAD(glGetQueryObjectuiv);
+
+	_TE_GL_FUNCTION_LOAD(glGenFramebuffers);
+	_TE_GL_FUNCTION_LOAD(glDeleteFramebuffers);
+	_TE_GL_FUNCTION_LOAD(glBindFramebuffer);
+	_TE_GL_FUNCTION_LOAD(glFramebufferTexture2D);
+	_TE_GL_FUNCTION_LOAD(glCheckFramebufferStatus);
+	_TE_GL_FUNCTION_LOAD(glGenRenderbuffers);
+	_TE_GL_FUNCTION_LOAD(glDeleteRenderbuffers);
+	_TE_GL_FUNCTION_LOAD(glBindRenderbuffer);
+	_TE_GL_FUNCTION_LOAD(glRenderbufferStorage);
+	_TE_GL_FUNCTION_LOAD(glFramebufferRenderbuffer);
+
+	te_GLint major = 0;
+	te_GLint minor = 0;
+	glGetIntegerv(TE_GL_MAJOR_VERSION, &major);
+	glGetIntegerv(TE_GL_MINOR_VERSION, &minor);
+	te_gl3_state.hasS3TC = _tinyengine_gl3_hasExtension("GL_EXT_texture_compression_s3tc");
+	te_gl3_state.hasETC2 = major > 4 || (major == 4 && minor >= 3) || _tinyengine_gl3_hasExtension("GL_ARB_ES3_compatibility");
+
+	te_gl3_state.shaderPrelude = TE_GL3_SHADER_PRELUDE;
+	#if !defined(TE_GL3_NO_UNIFORM_BUFFER)
+		if(major > 3 || (major == 3 && minor >= 1)) {
+			te_gl3_state.hasUniformBuffer = TE_TRUE;
+			te_gl3_state.shaderPrelude = TE_GL3_SHADER_PRELUDE_VIEW_BLOCK;
+		} else if(_tinyengine_gl3_hasExtension("GL_ARB_uniform_buffer_object")) {
+			te_gl3_state.hasUniformBuffer = TE_TRUE;
+			te_gl3_state.shaderPrelude = TE_GL3_SHADER_PRELUDE_VIEW_BLOCK_ARB;
+		}
+	#endif
+	if(te_gl3_state.hasUniformBuffer) {
+		_TE_GL_FUNCTION_LOAD(glBindBufferRange);
+		_TE_GL_FUNCTION_LOAD(glGetUniformBlockIndex);
+		_TE_GL_FUNCTION_LOAD(glUniformBlockBinding);
+
+		te_GLint alignment = 256;
+		glGetIntegerv(TE_GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		if(alignment < 64) { alignment = 64; }
+		te_gl3_state.viewBlockStride = (te_u32)((64 + alignment - 1) / alignment * alignment);
+	}
+
+	if(major > 3 || (major == 3 && minor >= 2) || _tinyengine_gl3_hasExtension("GL_ARB_sync")) {
+		_TE_GL_FUNCTION_LOAD(glFenceSync);
+		_TE_GL_FUNCTION_LOAD(glClientWaitSync);
+		_TE_GL_FUNCTION_LOAD(glDeleteSync);
+		te_gl3_state.hasSync = te_gl3.glFenceSync != NULL;
+	}
+
+	if(major > 3 || (major == 3 && minor >= 3) || _tinyengine_gl3_hasExtension("GL_ARB_timer_query")) {
+		_TE_GL_FUNCTION_LOAD(glGetQueryObjectui64v);
+		te_gl3_state.hasTimerQuery = te_gl3.glGetQueryObjectui64v != NULL;
+	}
+
+	if(_tinyengine_gl3_hasExtension("GL_KHR_parallel_shader_compile")) {
+		_TE_GL_FUNCTION_LOAD(glMaxShaderCompilerThreadsKHR);
+		te_gl3_state.hasParallelShaderCompile = TE_TRUE;
+	} else if(_tinyengine_gl3_hasExtension("GL_ARB_parallel_shader_compile")) {
+		te_gl3.glMaxShaderCompilerThreadsKHR = _tinyengine_gl_loadProc("glMaxShaderCompilerThreadsARB");
+		te_gl3_state.hasParallelShaderCompile = te_gl3.glMaxShaderCompilerThreadsKHR != NULL;
+	}
+
+	// Let the driver pick how many compiler threads to use
+	if(te_gl3_state.hasParallelShaderCompile) { te_gl3.glMaxShaderCompilerThreadsKHR(0xFFFFFFFF); }
+
+	if(_tinyengine_gl3_hasExtension("GL_ARB_get_program_binary")) {
+		_TE_GL_FUNCTION_LOAD(glGetProgramBinary);
+		_TE_GL_FUNCTION_LOAD(glProgramBinary);
+		_TE_GL_FUNCTION_LOAD(glProgramParameteri);
+
+		te_GLint formats = 0;
+		glGetIntegerv(TE_GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		// Some drivers expose the extension but no formats to store
+		te_gl3_state.hasProgramBinary = formats > 0;
+	}
+
+	#if !defined(TE_GL3_NO_SHADER_CACHE)
+		if(te_gl3_state.hasProgramBinary && te_gl3_state.shaderCacheDirectory[0] == '\0') { _tinyengine_gl3_defaultShaderCacheDirectory(); }
+	#endif
+
+	te_gl3_state.initialized = TE_TRUE;
+
+	return TE_TRUE;
+}
+
+
+// Compile and link are only submitted here, status is not queried so the driver can work on every
+// program at once. A cached binary makes the program ready immediately.
+void _tinyengine_gl3_submitProgram(_tinyengine_gl3_program* program, const char* vertexSrc, const char* fragmentSrc) {
+
+	program->submitTime = tinyengine_getTime();
+	program->cacheKey = _tinyengine_gl3_programCacheKey(vertexSrc, fragmentSrc);
+	program->projectionWindow = NULL;
+
+	if(_tinyengine_gl3_loadProgramBinary(&program->program, program->cacheKey)) {
+		te_gl3_state.shaderCacheHits++;
+		program->vertex = 0;
+		program->fragment = 0;
+		program->status = TE_GL3_PROGRAM_READY;
+		program->compileLatency = tinyengine_getTime() - program->submitTime;
+		TE_LOG("Loaded cached shader program %016llx in %.3fms\n", (unsigned long long) program->cacheKey, program->compileLatency * 1000.0);
+		if(program->ready) { program->ready(program); }
+		return;
+	}
+	te_gl3_state.shaderCacheMisses++;
+	program->compileLatency = 0.0;
+
+	const char* sources[2] = { te_gl3_state.shaderPrelude, vertexSrc };
+	program->vertex = te_gl3.glCreateShader(TE_GL_VERTEX_SHADER);
+	te_gl3.glShaderSource(program->vertex, 2, sources, NULL);
+	te_gl3.glCompileShader(program->vertex);
+
+	sources[1] = fragmentSrc;
+	program->fragment = te_gl3.glCreateShader(TE_GL_FRAGMENT_SHADER);
+	te_gl3.glShaderSource(program->fragment, 2, sources, NULL);
+	te_gl3.glCompileShader(program->fragment);
+
+	// Linking a program with failed shaders just fails the link, the logs are collected at finish
+	program->program = te_gl3.glCreateProgram();
+	if(program->attributes) {
+		for(te_u32 i = 0; program->attributes[i]; i++) { te_gl3.glBindAttribLocation(program->program,i,program->attributes[i]); }
+	} else {
+		te_gl3.glBindAttribLocation(program->program,0,"vertex");
+	}
+	te_gl3.glAttachShader(program->program, program->vertex);
+	te_gl3.glAttachShader(program->program, program->fragment);
+	if(te_gl3_state.hasProgramBinary) { te_gl3.glProgramParameteri(program->program, TE_GL_PROGRAM_BINARY_RETRIEVABLE_HINT, TE_GL_TRUE); }
+	te_gl3.glLinkProgram(program->program);
+
+	program->status = TE_GL3_PROGRAM_PENDING;
+}
+
+// Blocks until the program is linked, returns false if compilation or linking failed
+te_bool_u8 _tinyengine_gl3_finishProgram(_tinyengine_gl3_program* program) {
+	if(program->status != TE_GL3_PROGRAM_PENDING) { return program->status == TE_GL3_PROGRAM_READY; }
+
+	te_GLint success;
+	char infoLog[512];
+
+	te_gl3.glGetProgramiv(program->program, TE_GL_LINK_STATUS, &success);
+
+	// Without the parallel compile extension this is the first moment completion is known
+	if(program->compileLatency == 0.0) { program->compileLatency = tinyengine_getTime() - program->submitTime; }
+
+	if(success == TE_GL_FALSE) {
+		te_gl3.glGetShaderiv(program->vertex, TE_GL_COMPILE_STATUS, &success);
+		if(success == TE_GL_FALSE) {
+			te_gl3.glGetShaderInfoLog(program->vertex, 512, NULL, infoLog);
+			TE_ERROR("Vertex shader compilation failed: %s\n",infoLog);
+		}
+
+		te_gl3.glGetShaderiv(program->fragment, TE_GL_COMPILE_STATUS, &success);
+		if(success == TE_GL_FALSE) {
+			te_gl3.glGetShaderInfoLog(program->fragment, 512, NULL, infoLog);
+			TE_ERROR("Fragment shader compilation failed: %s\n",infoLog);
+		}
+
+		te_gl3.glGetProgramInfoLog(program->program, 512, NULL, infoLog);
+		TE_ERROR("shader program link failed: %s\n",infoLog);
+
+		te_gl3.glDeleteShader(program->vertex);
+		te_gl3.glDeleteShader(program->fragment);
+		te_gl3.glDeleteProgram(program->program);
+
+		program->program = 0;
+		program->status = TE_GL3_PROGRAM_FAILED;
+
+		return TE_FALSE;
+	}
+
+	// delete the shaders as they're linked into our program now and no longer necessery
+	te_gl3.glDeleteShader(program->vertex);
+	te_gl3.glDeleteShader(program->fragment);
+	program->vertex = 0;
+	program->fragment = 0;
+
+	_tinyengine_gl3_storeProgramBinary(program->program, program->cacheKey);
+	TE_LOG("Compiled shader program %016llx in %.3fms\n", (unsigned long long) program->cacheKey, program->compileLatency * 1000.0);
+
+	program->status = TE_GL3_PROGRAM_READY;
+	if(program->ready) { program->ready(program); }
+
+	return TE_TRUE;
+}
+
+// Never blocks, returns true once the program is no longer pending
+te_bool_u8 _tinyengine_gl3_pollProgram(_tinyengine_gl3_program* program) {
+	if(program->status != TE_GL3_PROGRAM_PENDING) { return TE_TRUE; }
+	if(!te_gl3_state.hasParallelShaderCompile) { return TE_FALSE; }
+
+	te_GLint complete = TE_GL_FALSE;
+	te_gl3.glGetProgramiv(program->program, TE_GL_COMPLETION_STATUS_KHR, &complete);
+	if(complete == TE_GL_FALSE) { return TE_FALSE; }
+
+	program->compileLatency = tinyengine_getTime() - program->submitTime;
+	_tinyengine_gl3_finishProgram(program);
+	return TE_TRUE;
+}
+
+// Synchronous compile kept for callers that need a program right away
+te_bool_u8 _tinyengine_gl3_compileShader(te_GLuint* program, const char* vertexSrc, const char* fragmentSrc) {
+	_tinyengine_gl3_program pipeline = {0};
+	_tinyengine_gl3_submitProgram(&pipeline, vertexSrc, fragmentSrc);
+	te_bool_u8 success = _tinyengine_gl3_finishProgram(&pipeline);
+	*program = pipeline.program;
+	return success;
+}
+
+// Called wherever texture contents change or a name is deleted, see _tinyengine_gl3_captureTexture()
+void _tinyengine_gl3_forgetCapturedTexture(te_GLuint texture);
+
+// Opaque textures can go through the depth tested pass of _tinyengine_gl3_endLayers(). The loaders mark what
+// they upload, anything else is translucent until marked.
+void _tinyengine_gl3_setTextureOpaque(te_GLuint texture, te_bool_u8 opaque) {
+	if(texture >= te_gl3_state.opaqueTextureCapacity) {
+		if(!opaque) { return; }
+		te_u32 capacity = te_gl3_state.opaqueTextureCapacity ? te_gl3_state.opaqueTextureCapacity : 256;
+		while(capacity <= texture) { capacity *= 2; }
+		te_u8* bits = realloc(te_gl3_state.opaqueTextures, capacity / 8);
+		if(bits == NULL) { return; }
+		memset(bits + te_gl3_state.opaqueTextureCapacity / 8, 0, (capacity - te_gl3_state.opaqueTextureCapacity) / 8);
+		te_gl3_state.opaqueTextures = bits;
+		te_gl3_state.opaqueTextureCapacity = capacity;
+	}
+	if(opaque) {
+		te_gl3_state.opaqueTextures[texture / 8] |= (te_u8)(1 << (texture % 8));
+	} else {
+		te_gl3_state.opaqueTextures[texture / 8] &= (te_u8)~(1 << (texture % 8));
+	}
+}
+
+te_bool_u8 _tinyengine_gl3_isTextureOpaque(te_GLuint texture) {
+	if(texture >= te_gl3_state.opaqueTextureCapacity) { return TE_FALSE; }
+	return (te_gl3_state.opaqueTextures[texture / 8] >> (texture % 8)) & 1;
+}
+
+static te_bool_u8 _tinyengine_gl3_pixelsOpaque(const te_u8* pixels, size_t count) {
+	for(size_t i = 0; i < count; i++) {
+		if(pixels[i * 4 + 3] != 255) { return TE_FALSE; }
+	}
+	return TE_TRUE;
+}
+
+te_GLuint _tinyengine_gl3_loadTextureRGB(tinyengine_windowContext* window, te_u32 width, te_u32 height, te_u32 channels, te_u8* data) {
+
+	if(!data) { return 0; }
+	if(channels > 4 || channels < 3) { return 0; }
+	if(width == 0 || height == 0) { return 0; }
+
+	// The caller's pixels are left alone, alpha is premultiplied in a copy
+	te_u8* premultiplied = NULL;
+	if(channels == 4) {
+		premultiplied = malloc((size_t) width * height * 4);
+		if(premultiplied == NULL) { return 0; }
+		memcpy(premultiplied, data, (size_t) width * height * 4);
+		tinyengine_premultiplyAlpha(premultiplied, (size_t) width * height);
+		data = premultiplied;
+	}
+
+	te_GLuint texture;
+	te_gl3.glGenTextures(1, &texture);
+	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, texture);
+	te_gl3.glTexImage2D(TE_GL_TEXTURE_2D, 0, TE_GL_RGBA, width, height, 0, channels == 4 ? TE_GL_RGBA :  TE_GL_RGB, GL_UNSIGNED_BYTE, data);
+	te_gl3.glGenerateMipmap(TE_GL_TEXTURE_2D);
+	_tinyengine_gl3_forgetCapturedTexture(texture);
+	_tinyengine_gl3_setTextureOpaque(texture, channels == 3 || _tinyengine_gl3_pixelsOpaque(data, (size_t) width * height));
+
+	free(premultiplied);
+	return texture;
+}
+
+te_GLenum _tinyengine_gl3_compressedFormat(te_u32 format) {
+	switch(format) {
+		case TE_TEXTURE_FORMAT_BC1: return te_gl3_state.hasS3TC ? TE_GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : 0;
+		case TE_TEXTURE_FORMAT_BC3: return te_gl3_state.hasS3TC ? TE_GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0;
+		case TE_TEXTURE_FORMAT_ETC2_RGB8: return te_gl3_state.hasETC2 ? TE_GL_COMPRESSED_RGB8_ETC2 : 0;
+		case TE_TEXTURE_FORMAT_ETC2_RGBA8: return te_gl3_state.hasETC2 ? TE_GL_COMPRESSED_RGBA8_ETC2_EAC : 0;
+	}
+	return 0;
+}
+
+// Uploads every level of a cooked texture as stored, data only needs to live for the call
+te_GLuint _tinyengine_gl3_loadCookedTexture(const te_u8* data, size_t size) {
+	tinyengine_cookedTexture cooked;
+	if(!tinyengine_parseCookedTexture(data, size, &cooked)) { TE_ERROR("Invalid cooked texture!\n"); return 0; }
+
+	te_GLenum compressedFormat = 0;
+	if(cooked.format != TE_TEXTURE_FORMAT_RGBA8) {
+		compressedFormat = _tinyengine_gl3_compressedFormat(cooked.format);
+		if(compressedFormat == 0) { TE_ERROR("Driver does not support cooked texture format %u, cook it as rgba8!\n", cooked.format); return 0; }
+	}
+	if(!cooked.premultiplied) { TE_WARN("Cooked texture is not premultiplied, edges will blend dark\n"); }
+
+	te_GLuint texture;
+	te_gl3.glGenTextures(1, &texture);
+	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, texture);
+
+	// Level rows are tightly packed, a 1 or 2 pixel wide mip would otherwise be read with padding
+	glPixelStorei(TE_GL_UNPACK_ALIGNMENT, 1);
+	for(te_u32 level = 0; level < cooked.levelCount; level++) {
+		te_u32 width = cooked.width >> level ? cooked.width >> level : 1;
+		te_u32 height = cooked.height >> level ? cooked.height >> level : 1;
+		if(compressedFormat) {
+			te_gl3.glCompressedTexImage2D(TE_GL_TEXTURE_2D, level, compressedFormat, width, height, 0, (te_GLsizei) cooked.levelSizes[level], cooked.levels[level]);
+		} else {
+			te_gl3.glTexImage2D(TE_GL_TEXTURE_2D, level, TE_GL_RGBA, width, height, 0, TE_GL_RGBA, TE_GL_UNSIGNED_BYTE, cooked.levels[level]);
+		}
+	}
+	glPixelStorei(TE_GL_UNPACK_ALIGNMENT, 4);
+
+	// A partial chain is still complete when sampling stops at the last stored level
+	glTexParameteri(TE_GL_TEXTURE_2D, TE_GL_TEXTURE_MAX_LEVEL, cooked.levelCount - 1);
+	glTexParameteri(TE_GL_TEXTURE_2D, TE_GL_TEXTURE_MIN_FILTER, cooked.levelCount > 1 ? TE_GL_LINEAR_MIPMAP_LINEAR : TE_GL_LINEAR);
+	glTexParameteri(TE_GL_TEXTURE_2D, TE_GL_TEXTURE_MAG_FILTER, TE_GL_LINEAR);
+	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, 0);
+	_tinyengine_gl3_forgetCapturedTexture(texture);
+
+	// Compressed formats with alpha are not inspected, mark them by hand when they are known to be opaque
+	te_bool_u8 opaque = cooked.format == TE_TEXTURE_FORMAT_ETC2_RGB8;
+	if(cooked.format == TE_TEXTURE_FORMAT_RGBA8) { opaque = _tinyengine_gl3_pixelsOpaque(cooked.levels[0], (size_t) cooked.width * cooked.height); }
+	_tinyengine_gl3_setTextureOpaque(texture, opaque);
+
+	return texture;
+}
+
+te_GLuint _tinyengine_gl3_loadCookedTextureFile(const char* path) {
+	tinyengine_mappedFile file;
+	if(!tinyengine_mapFile(path, &file)) { return 0; }
+	te_GLuint texture = _tinyengine_gl3_loadCookedTexture(file.data, file.size);
+	tinyengine_unmapFile(&file);
+	return texture;
+}
+
+//// Texture streaming
+
+// Textures are decoded on a loader thread straight into mapped pixel buffer objects, the GL thread
+// then uploads them from the PBO with glTexSubImage2D within a per frame byte budget. Until a texture
+// is uploaded its handle resolves to a placeholder.
+
+#define _TE_STREAM_SLOT(_h) (((_h) & 0xFFFF) - 1)
+#define _TE_STREAM_GENERATION(_h) ((_h) >> 16)
+
+#if defined(TE_PTHREADS)
+	#define _TE_STREAM_LOCK() pthread_mutex_lock(&te_gl3_state.textureStream.lock)
+	#define _TE_STREAM_UNLOCK() pthread_mutex_unlock(&te_gl3_state.textureStream.lock)
+#else
+	#define _TE_STREAM_LOCK()
+	#define _TE_STREAM_UNLOCK()
+#endif
+
+te_bool_u8 _tinyengine_gl3_decodeStreamedTexture(_tinyengine_gl3_streamedTexture* entry) {
+	return entry->decode(entry->user, entry->staging, entry->stagingSize, entry->width, entry->height);
+}
+
+#if defined(TE_PTHREADS)
+void* _tinyengine_gl3_textureLoaderThread(void* argument) {
+	_tinyengine_gl3_textureStream* stream = &te_gl3_state.textureStream;
+
+	pthread_mutex_lock(&stream->lock);
+	while(!stream->threadExit) {
+		if(stream->decodeHead == stream->decodeTail) {
+			pthread_cond_wait(&stream->wake, &stream->lock);
+			continue;
+		}
+
+		_tinyengine_gl3_streamedTexture* entry = &stream->textures[stream->decodeQueue[stream->decodeHead % TE_GL3_MAX_STREAMED_TEXTURES]];
+		stream->decodeHead++;
+
+		// The staging pointer stays valid while mapped, the GL thread leaves STAGED entries alone
+		pthread_mutex_unlock(&stream->lock);
+		te_bool_u8 decoded = _tinyengine_gl3_decodeStreamedTexture(entry);
+		pthread_mutex_lock(&stream->lock);
+
+		entry->status = decoded ? TE_GL3_STREAM_DECODED : TE_GL3_STREAM_FAILED;
+	}
+	pthread_mutex_unlock(&stream->lock);
+
+	return NULL;
+}
+#endif
+
+void _tinyengine_gl3_createPlaceholderTexture() {
+	const te_u8 pixel[4] = { 128, 128, 128, 255 };
+	te_gl3.glGenTextures(1, &te_gl3_state.textureStream.placeholder);
+	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, te_gl3_state.textureStream.placeholder);
+	te_gl3.glTexImage2D(TE_GL_TEXTURE_2D, 0, TE_GL_RGBA, 1, 1, 0, TE_GL_RGBA, TE_GL_UNSIGNED_BYTE, pixel);
+	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, 0);
+}
+
+// decodeSize is the staging memory the decoder needs, 0 for exactly width * height * 4
+te_u32 _tinyengine_gl3_streamTexture(te_u32 width, te_u32 height, size_t decodeSize, tinyengine_textureDecodeFunction decode, void (*release)(void*), void* user) {
+	_tinyengine_gl3_textureStream* stream = &te_gl3_state.textureStream;
+
+	if(width == 0 || height == 0 || decode == NULL) { return 0; }
+
+	if(stream->placeholder == 0) {
+		_tinyengine_gl3_createPlaceholderTexture();
+		if(stream->uploadBudget == 0) { stream->uploadBudget = TE_GL3_TEXTURE_UPLOAD_BUDGET; }
+	}
+
+	#if defined(TE_PTHREADS)
+		if(!stream->threadRunning) {
+			pthread_mutex_init(&stream->lock, NULL);
+			pthread_cond_init(&stream->wake, NULL);
+			stream->threadExit = TE_FALSE;
+			if(pthread_create(&stream->thread, NULL, &_tinyengine_gl3_textureLoaderThread, NULL) != 0) {
+				TE_ERROR("Could not start texture loader thread!\n");
+				pthread_mutex_destroy(&stream->lock);
+				pthread_cond_destroy(&stream->wake);
+				return 0;
+			}
+			stream->threadRunning = TE_TRUE;
+		}
+	#endif
+
+	_TE_STREAM_LOCK();
+
+	te_u32 slot = 0;
+	while(slot < stream->textureCount && stream->textures[slot].status != TE_GL3_STREAM_FREE) { slot++; }
+	if(slot == TE_GL3_MAX_STREAMED_TEXTURES) {
+		_TE_STREAM_UNLOCK();
+		TE_ERROR("Too many streamed textures!\n");
+		return 0;
+	}
+	if(slot == stream->textureCount) { stream->textureCount++; }
+
+	_tinyengine_gl3_streamedTexture* entry = &stream->textures[slot];
+	te_u16 generation = entry->generation == 0 || entry->generation == 0xFFFF ? 1 : entry->generation + 1;
+	memset(entry, 0, sizeof(_tinyengine_gl3_streamedTexture));
+	entry->generation = generation;
+	entry->width = width;
+	entry->height = height;
+	entry->decodeSize = decodeSize > (size_t) width * height * 4 ? decodeSize : (size_t) width * height * 4;
+	entry->decode = decode;
+	entry->release = release;
+	entry->user = user;
+	entry->status = TE_GL3_STREAM_QUEUED;
+	stream->pending++;
+
+	_TE_STREAM_UNLOCK();
+
+	// Storage is allocated now so the upload is a plain sub image copy
+	te_gl3.glGenTextures(1, &entry->texture);
+	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, entry->texture);
+	te_gl3.glTexImage2D(TE_GL_TEXTURE_2D, 0, TE_GL_RGBA, width, height, 0, TE_GL_RGBA, TE_GL_UNSIGNED_BYTE, NULL);
+	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, 0);
+	_tinyengine_gl3_forgetCapturedTexture(entry->texture);
+	_tinyengine_gl3_setTextureOpaque(entry->texture, TE_FALSE); // the name may be reused
+
+	return ((te_u32)generation << 16) | (slot + 1);
+}
+
+typedef struct _tinyengine_gl3_rawPixels_t {
+	const te_u8* data;
+	te_u32 channels;
+} _tinyengine_gl3_rawPixels;
+
+te_bool_u8 _tinyengine_gl3_decodeRawPixels(void* user, te_u8* pixels, size_t size, te_u32 width, te_u32 height) {
+	_tinyengine_gl3_rawPixels* raw = (_tinyengine_gl3_rawPixels*) user;
+	size_t count = (size_t) width * height;
+
+	if(raw->channels == 4) {
+		// Premultiplied in a register sized copy, the staging memory is never read
+		for(size_t i = 0; i < count; i++) {
+			te_u8 pixel[4];
+			memcpy(pixel, raw->data + i * 4, 4);
+			tinyengine_premultiplyAlpha(pixel, 1);
+			memcpy(pixels + i * 4, pixel, 4);
+		}
+		return TE_TRUE;
+	}
+
+	for(size_t i = 0; i < count; i++) {
+		pixels[i * 4 + 0] = raw->data[i * 3 + 0];
+		pixels[i * 4 + 1] = raw->data[i * 3 + 1];
+		pixels[i * 4 + 2] = raw->data[i * 3 + 2];
+		pixels[i * 4 + 3] = 255;
+	}
+	return TE_TRUE;
+}
+
+// The pixels are read on the loader thread, they must stay valid until the texture is ready
+te_u32 _tinyengine_gl3_streamTextureRGB(te_u32 width, te_u32 height, te_u32 channels, const te_u8* data) {
+	if(!data) { return 0; }
+	if(channels > 4 || channels < 3) { return 0; }
+
+	_tinyengine_gl3_rawPixels* raw = malloc(sizeof(_tinyengine_gl3_rawPixels));
+	if(raw == NULL) { return 0; }
+	raw->data = data;
+	raw->channels = channels;
+
+	te_u32 handle = _tinyengine_gl3_streamTexture(width, height, 0, &_tinyengine_gl3_decodeRawPixels, &free, raw);
+	if(handle == 0) { free(raw); }
+	return handle;
+}
+
+typedef struct _tinyengine_gl3_encodedImage_t {
+	const te_u8* data;
+	size_t size;
+	tinyengine_mappedFile file; // empty for images in caller memory
+	te_u8* decompressed; // owned copy of a compressed archive asset
+} _tinyengine_gl3_encodedImage;
+
+te_bool_u8 _tinyengine_gl3_decodeEncodedImage(void* user, te_u8* pixels, size_t size, te_u32 width, te_u32 height) {
+	_tinyengine_gl3_encodedImage* image = (_tinyengine_gl3_encodedImage*) user;
+	return _tinyengine_decodeImage(image->data, image->size, pixels, size, TE_TRUE);
+}
+
+void _tinyengine_gl3_releaseEncodedImage(void* user) {
+	_tinyengine_gl3_encodedImage* image = (_tinyengine_gl3_encodedImage*) user;
+	if(image->file.data) { tinyengine_unmapFile(&image->file); }
+	free(image->decompressed);
+	free(image);
+}
+
+te_u32 _tinyengine_gl3_streamEncodedImage(_tinyengine_gl3_encodedImage* image) {
+	te_u32 width, height;
+	if(!tinyengine_imageInfo(image->data, image->size, &width, &height)) {
+		TE_ERROR("Unknown or unsupported image format!\n");
+		_tinyengine_gl3_releaseEncodedImage(image);
+		return 0;
+	}
+
+	size_t decodeSize = tinyengine_imageDecodeSize(image->data, image->size);
+	te_u32 handle = _tinyengine_gl3_streamTexture(width, height, decodeSize, &_tinyengine_gl3_decodeEncodedImage, &_tinyengine_gl3_releaseEncodedImage, image);
+	if(handle == 0) { _tinyengine_gl3_releaseEncodedImage(image); }
+	return handle;
+}
+
+// PNG or QOI, the file is mapped and decoded straight into staging memory on the loader thread
+te_u32 _tinyengine_gl3_streamTextureFile(const char* path) {
+	_tinyengine_gl3_encodedImage* image = malloc(sizeof(_tinyengine_gl3_encodedImage));
+	if(image == NULL) { return 0; }
+	memset(image, 0, sizeof(_tinyengine_gl3_encodedImage));
+
+	if(!tinyengine_mapFile(path, &image->file)) { free(image); return 0; }
+	image->data = image->file.data;
+	image->size = image->file.size;
+
+	return _tinyengine_gl3_streamEncodedImage(image);
+}
+
+// The encoded data is read on the loader thread, it must stay valid until the texture is ready
+te_u32 _tinyengine_gl3_streamTextureMemory(const te_u8* data, size_t size) {
+	if(!data) { return 0; }
+
+	_tinyengine_gl3_encodedImage* image = malloc(sizeof(_tinyengine_gl3_encodedImage));
+	if(image == NULL) { return 0; }
+	memset(image, 0, sizeof(_tinyengine_gl3_encodedImage));
+	image->data = data;
+	image->size = size;
+
+	return _tinyengine_gl3_streamEncodedImage(image);
+}
+
+// Raw assets are decoded straight from the archive mapping, which must stay open until the texture is ready
+te_u32 _tinyengine_gl3_streamTextureAsset(const tinyengine_asset* asset) {
+	if(asset->compression == TE_ARCHIVE_RAW) { return _tinyengine_gl3_streamTextureMemory(asset->data, asset->size); }
+
+	// Images are already compressed so the packer stores them raw, this is the uncommon path
+	_tinyengine_gl3_encodedImage* image = malloc(sizeof(_tinyengine_gl3_encodedImage));
+	if(image == NULL) { return 0; }
+	memset(image, 0, sizeof(_tinyengine_gl3_encodedImage));
+
+	image->decompressed = malloc(asset->size);
+	if(image->decompressed == NULL || !tinyengine_readAsset(asset, image->decompressed, asset->size)) {
+		TE_ERROR("Could not decompress %s\n", asset->name);
+		_tinyengine_gl3_releaseEncodedImage(image);
+		return 0;
+	}
+	image->data = image->decompressed;
+	image->size = asset->size;
+
+	return _tinyengine_gl3_streamEncodedImage(image);
+}
+
+_tinyengine_gl3_streamedTexture* _tinyengine_gl3_lookupStreamedTexture(te_u32 handle) {
+	te_u32 slot = _TE_STREAM_SLOT(handle);
+	if(handle == 0 || slot >= te_gl3_state.textureStream.textureCount) { return NULL; }
+	_tinyengine_gl3_streamedTexture* entry = &te_gl3_state.textureStream.textures[slot];
+	if(entry->generation != _TE_STREAM_GENERATION(handle) || entry->status == TE_GL3_STREAM_FREE) { return NULL; }
+	return entry;
+}
+
+te_bool_u8 _tinyengine_gl3_isTextureReady(te_u32 handle) {
+	_tinyengine_gl3_streamedTexture* entry = _tinyengine_gl3_lookupStreamedTexture(handle);
+	return entry != NULL && entry->status == TE_GL3_STREAM_READY;
+}
+
+// Safe to draw with at any time, resolves to the placeholder until the upload happened
+te_GLuint _tinyengine_gl3_getStreamedTexture(te_u32 handle) {
+	_tinyengine_gl3_streamedTexture* entry = _tinyengine_gl3_lookupStreamedTexture(handle);
+	if(entry == NULL || entry->status != TE_GL3_STREAM_READY) { return te_gl3_state.textureStream.placeholder; }
+	return entry->texture;
+}
+
+void _tinyengine_gl3_setTextureUploadBudget(size_t bytesPerFrame) {
+	te_gl3_state.textureStream.uploadBudget = bytesPerFrame;
+}
+
+void _tinyengine_gl3_freeStreamedTexture(_tinyengine_gl3_streamedTexture* entry) {
+	if(entry->release) { entry->release(entry->user); entry->release = NULL; }
+	if(entry->texture) {
+		_tinyengine_gl3_forgetCapturedTexture(entry->texture);
+		_tinyengine_gl3_setTextureOpaque(entry->texture, TE_FALSE);
+		te_gl3.glDeleteTextures(1, &entry->texture);
+		entry->texture = 0;
+	}
+	entry->status = TE_GL3_STREAM_FREE;
+}
+
+void _tinyengine_gl3_releaseStreamedTexture(te_u32 handle) {
+	_tinyengine_gl3_streamedTexture* entry = _tinyengine_gl3_lookupStreamedTexture(handle);
+	if(entry == NULL) { return; }
+
+	_TE_STREAM_LOCK();
+	// In flight textures, failed ones still holding their staging included, are freed by _tinyengine_gl3_updateTextureStreaming()
+	if(entry->status == TE_GL3_STREAM_READY || (entry->status == TE_GL3_STREAM_FAILED && entry->pixelBuffer == 0)) {
+		_tinyengine_gl3_freeStreamedTexture(entry);
+	} else {
+		entry->released = TE_TRUE;
+	}
+	_TE_STREAM_UNLOCK();
+}
+
+void _tinyengine_gl3_retireStaging(_tinyengine_gl3_streamedTexture* entry) {
+	_tinyengine_gl3_textureStream* stream = &te_gl3_state.textureStream;
+
+	te_gl3.glBindBuffer(TE_GL_PIXEL_UNPACK_BUFFER, entry->pixelBuffer);
+	te_bool_u8 intact = te_gl3.glUnmapBuffer(TE_GL_PIXEL_UNPACK_BUFFER);
+	te_gl3.glBindBuffer(TE_GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if(!intact && entry->status == TE_GL3_STREAM_DECODED) {
+		// The mapping was lost (mode switch etc.), decode again into fresh staging
+		TE_WARN("Texture staging memory was corrupted, decoding again.\n");
+		entry->status = TE_GL3_STREAM_QUEUED;
+	}
+
+	entry->staging = NULL;
+	stream->stagingInFlight -= entry->stagingSize;
+}
+
+// Called once per frame from _tinyengine_gl3_startFrame(), uploads decoded textures within the budget and stages queued ones.
+// The lock is only held to pick up finished decodes and to queue new ones, so the loader thread keeps decoding during uploads.
+void _tinyengine_gl3_updateTextureStreaming() {
+	_tinyengine_gl3_textureStream* stream = &te_gl3_state.textureStream;
+	if(stream->pending == 0) { return; }
+
+	// The loader thread leaves an entry alone once it is decoded or failed
+	te_u16 finished[TE_GL3_MAX_STREAMED_TEXTURES];
+	te_u32 finishedCount = 0;
+	_TE_STREAM_LOCK();
+	for(te_u32 slot = 0; slot < stream->textureCount; slot++) {
+		const _tinyengine_gl3_streamedTexture* entry = &stream->textures[slot];
+		if(entry->status == TE_GL3_STREAM_DECODED || (entry->status == TE_GL3_STREAM_FAILED && entry->pixelBuffer)) { finished[finishedCount++] = (te_u16) slot; }
+	}
+	_TE_STREAM_UNLOCK();
+
+	size_t uploaded = 0;
+
+	for(te_u32 i = 0; i < finishedCount; i++) {
+		te_u32 slot = finished[i];
+		_tinyengine_gl3_streamedTexture* entry = &stream->textures[slot];
+
+		if(entry->status == TE_GL3_STREAM_FAILED) {
+			_tinyengine_gl3_retireStaging(entry);
+			te_gl3.glDeleteBuffers(1, &entry->pixelBuffer);
+			entry->pixelBuffer = 0;
+			if(entry->release) { entry->release(entry->user); entry->release = NULL; }
+			stream->pending--;
+			TE_ERROR("Could not decode streamed texture %u!\n", slot);
+			if(entry->released) { _tinyengine_gl3_freeStreamedTexture(entry); }
+			continue;
+		}
+
+		// Always let one texture through so a texture larger than the budget still loads
+		size_t bytes = (size_t) entry->width * entry->height * 4;
+		if(uploaded > 0 && uploaded + bytes > stream->uploadBudget) { continue; }
+
+		_tinyengine_gl3_retireStaging(entry);
+		if(entry->status != TE_GL3_STREAM_DECODED) { continue; }
+
+		if(!entry->released) {
+			te_gl3.glBindBuffer(TE_GL_PIXEL_UNPACK_BUFFER, entry->pixelBuffer);
+			te_gl3.glBindTexture(TE_GL_TEXTURE_2D, entry->texture);
+			te_gl3.glTexSubImage2D(TE_GL_TEXTURE_2D, 0, 0, 0, entry->width, entry->height, TE_GL_RGBA, TE_GL_UNSIGNED_BYTE, (const void*) 0);
+			te_gl3.glBindBuffer(TE_GL_PIXEL_UNPACK_BUFFER, 0);
+			te_gl3.glGenerateMipmap(TE_GL_TEXTURE_2D);
+			te_gl3.glBindTexture(TE_GL_TEXTURE_2D, 0);
+			_tinyengine_gl3_forgetCapturedTexture(entry->texture);
+			uploaded += bytes;
+		}
+
+		te_gl3.glDeleteBuffers(1, &entry->pixelBuffer);
+		entry->pixelBuffer = 0;
+		if(entry->release) { entry->release(entry->user); entry->release = NULL; }
+
+		entry->status = TE_GL3_STREAM_READY;
+		stream->pending--;
+		if(entry->released) { _tinyengine_gl3_freeStreamedTexture(entry); }
+	}
+
+	stream->bytesUploaded += uploaded;
+
+	// Stage queued textures in submission order while staging memory is available
+	te_u16 staged[TE_GL3_MAX_STREAMED_TEXTURES];
+	te_u32 stagedCount = 0;
+	for(te_u32 slot = 0; slot < stream->textureCount; slot++) {
+		_tinyengine_gl3_streamedTexture* entry = &stream->textures[slot];
+		if(entry->status != TE_GL3_STREAM_QUEUED) { continue; }
+
+		if(entry->released) {
+			stream->pending--;
+			_tinyengine_gl3_freeStreamedTexture(entry);
+			continue;
+		}
+
+		size_t size = entry->decodeSize;
+		if(stream->stagingInFlight > 0 && stream->stagingInFlight + size > TE_GL3_TEXTURE_STAGING_LIMIT) { break; }
+
+		if(entry->pixelBuffer == 0) { te_gl3.glGenBuffers(1, &entry->pixelBuffer); }
+		te_gl3.glBindBuffer(TE_GL_PIXEL_UNPACK_BUFFER, entry->pixelBuffer);
+		te_gl3.glBufferData(TE_GL_PIXEL_UNPACK_BUFFER, (te_GLsizeiptr) size, NULL, TE_GL_STREAM_DRAW);
+		entry->staging = te_gl3.glMapBufferRange(TE_GL_PIXEL_UNPACK_BUFFER, 0, (te_GLsizeiptr) size, TE_GL_MAP_WRITE_BIT | TE_GL_MAP_INVALIDATE_BUFFER_BIT);
+		te_gl3.glBindBuffer(TE_GL_PIXEL_UNPACK_BUFFER, 0);
+
+		if(entry->staging == NULL) { TE_WARN("Could not map texture staging memory!\n"); break; }
+
+		entry->stagingSize = size;
+		stream->stagingInFlight += size;
+		entry->status = TE_GL3_STREAM_STAGED;
+
+		#if defined(TE_PTHREADS)
+			staged[stagedCount++] = (te_u16) slot;
+		#else
+			// No loader thread, decode inline and upload next frame
+			entry->status = _tinyengine_gl3_decodeStreamedTexture(entry) ? TE_GL3_STREAM_DECODED : TE_GL3_STREAM_FAILED;
+		#endif
+	}
+
+	#if defined(TE_PTHREADS)
+		if(stagedCount > 0) {
+			pthread_mutex_lock(&stream->lock);
+			for(te_u32 i = 0; i < stagedCount; i++) {
+				stream->decodeQueue[stream->decodeTail % TE_GL3_MAX_STREAMED_TEXTURES] = staged[i];
+				stream->decodeTail++;
+			}
+			pthread_cond_signal(&stream->wake);
+			pthread_mutex_unlock(&stream->lock);
+		}
+	#endif
+}
+
+void _tinyengine_gl3_terminateTextureStreaming() {
+	_tinyengine_gl3_textureStream* stream = &te_gl3_state.textureStream;
+
+	#if defined(TE_PTHREADS)
+		if(stream->threadRunning) {
+			pthread_mutex_lock(&stream->lock);
+			stream->threadExit = TE_TRUE;
+			pthread_cond_signal(&stream->wake);
+			pthread_mutex_unlock(&stream->lock);
+
+			pthread_join(stream->thread, NULL);
+			pthread_mutex_destroy(&stream->lock);
+			pthread_cond_destroy(&stream->wake);
+			stream->threadRunning = TE_FALSE;
+		}
+	#endif
+
+	// Sources of textures that never finished or were never released, GL objects go with the context
+	for(te_u32 slot = 0; slot < stream->textureCount; slot++) {
+		_tinyengine_gl3_streamedTexture* entry = &stream->textures[slot];
+		if(entry->release) { entry->release(entry->user); entry->release = NULL; }
+	}
+}
+
+void _tinyengine_gl3_projectionOrtho(te_GLfloat matrix[16], te_f32 left, te_f32 right, te_f32 bottom, te_f32 top, te_f32 _near, te_f32 _far){
+
+	matrix[0] = 2/(right-left);
+	matrix[1] = 0;
+	matrix[2] = 0;
+	matrix[3] = -(right+left)/(right-left);
+
+	matrix[4] = 0;
+	matrix[5] = 2/(top-bottom);
+	matrix[6] = 0;
+	matrix[7] = -(top+bottom)/(top-bottom);
+
+	matrix[8] = 0;
+	matrix[9] = 0;
+	matrix[10] = -2/(_far-_near);
+	matrix[11] = -(_far+_near)/(_far-_near);
+
+	matrix[12] = 0;
+	matrix[13] = 0;
+	matrix[14] = 0;
+	matrix[15] = 1;
+}
+
+//// Command capture
+
+// Records what the application asks the renderer to do, so a slow scene can be replayed and profiled
+// without the game (src/replay.c). A record is an opcode byte, a window index byte and a fixed number
+// of 32 bit words, text, textures and fonts add a tail. Fields are in host byte order. Textures are read
+// back the first time a draw uses them, which covers every way of loading one.
+
+#define TE_CAPTURE_VERSION 1
+
+enum {
+	TE_CAPTURE_FRAME_START = 1, // -
+	TE_CAPTURE_FRAME_END,       // -
+	TE_CAPTURE_VIEW,            // width, height
+	TE_CAPTURE_CAMERA,          // x, y, zoom, rotation
+	TE_CAPTURE_WORLD_SPACE,     // enabled
+	TE_CAPTURE_RECTANGLE,       // x, y, width, height, r, g, b, a
+	TE_CAPTURE_SPRITE,          // texture, x, y, width, height, scale, tex_width, tex_height, tex_x, tex_y, r, g, b, a
+	TE_CAPTURE_TEXT,            // font, x, y, scale, r, g, b, length + length characters
+	TE_CAPTURE_TEXTURE,         // texture, width, height + width * height premultiplied RGBA8 pixels
+	TE_CAPTURE_FONT,            // font, resolution, texture + 96 baked characters
+	TE_CAPTURE_OPCODE_COUNT
+};
+
+// Words per opcode
+static const te_u8 TE_CAPTURE_WORDS[TE_CAPTURE_OPCODE_COUNT] = { 0, 0, 0, 2, 4, 1, 8, 14, 8, 3, 3 };
+
+typedef union _tinyengine_captureWord_t {
+	te_f32 f;
+	te_u32 u;
+} _tinyengine_captureWord;
+
+typedef struct _tinyengine_gl3_captureHeader_t {
+	char magic[4]; // TECP
+	te_u32 version;
+} _tinyengine_gl3_captureHeader;
+
+te_bool_u8 _tinyengine_gl3_startCapture(const char* path) {
+	_tinyengine_gl3_capture* capture = &te_gl3_state.capture;
+	if(capture->file) { TE_WARN("Capture already running\n"); return TE_FALSE; }
+
+	capture->file = fopen(path, "wb");
+	if(!capture->file) { TE_ERROR("Could not open capture file %s\n", path); return TE_FALSE; }
+
+	_tinyengine_gl3_captureHeader header = { { 'T', 'E', 'C', 'P' }, TE_CAPTURE_VERSION };
+	fwrite(&header, sizeof(header), 1, capture->file);
+	capture->bytes = sizeof(header);
+	capture->frames = 0;
+	return TE_TRUE;
+}
+
+void _tinyengine_gl3_stopCapture() {
+	_tinyengine_gl3_capture* capture = &te_gl3_state.capture;
+	if(!capture->file) { return; }
+
+	if(fclose(capture->file) != 0) { TE_WARN("Capture file may be truncated\n"); }
+	TE_LOG("Captured %u frames, %zu bytes\n", capture->frames, capture->bytes);
+	free(capture->textures);
+	memset(capture, 0, sizeof(*capture));
+}
+
+void _tinyengine_gl3_captureCommand(te_u8 opcode, tinyengine_windowContext* window, const _tinyengine_captureWord* words, const void* tail, size_t tailSize) {
+	_tinyengine_gl3_capture* capture = &te_gl3_state.capture;
+	if(te_gl3_state.cachedLayerRecording.layer) { return; } // drawn into the layer, not the window
+
+	te_u8 record[2] = { opcode, 0 };
+	if(window) {
+		// Destroyed windows leave their index empty, the next new window takes it over
+		te_u32 index = TE_CAPTURE_MAX_WINDOWS;
+		for(te_u32 i = 0; i < TE_CAPTURE_MAX_WINDOWS; i++) {
+			if(capture->windows[i] == window) { index = i; break; }
+			if(capture->windows[i] == NULL && index == TE_CAPTURE_MAX_WINDOWS) { index = i; }
+		}
+		if(index == TE_CAPTURE_MAX_WINDOWS) { return; }
+		capture->windows[index] = window;
+		record[1] = (te_u8) index;
+	}
+
+	fwrite(record, sizeof(record), 1, capture->file);
+	if(TE_CAPTURE_WORDS[opcode]) { fwrite(words, sizeof(_tinyengine_captureWord), TE_CAPTURE_WORDS[opcode], capture->file); }
+	if(tailSize) { fwrite(tail, 1, tailSize, capture->file); }
+	capture->bytes += sizeof(record) + sizeof(_tinyengine_captureWord) * TE_CAPTURE_WORDS[opcode] + tailSize;
+}
+
+// Writes a texture's pixels the first time it is drawn with. Names are forgotten when their contents change or
+// they are deleted, so the next draw writes the texture again and replay replaces what it uploaded before.
+void _tinyengine_gl3_captureTexture(te_GLuint texture) {
+	_tinyengine_gl3_capture* capture = &te_gl3_state.capture;
+	if(te_gl3_state.cachedLayerRecording.layer) { return; }
+
+	te_u32 low = 0, high = capture->textureCount;
+	while(low < high) {
+		te_u32 middle = (low + high) / 2;
+		if(capture->textures[middle] < texture) { low = middle + 1; } else { high = middle; }
+	}
+	if(low < capture->textureCount && capture->textures[low] == texture) { return; }
+
+	if(capture->textureCount == capture->textureCapacity) {
+		te_u32 capacity = capture->textureCapacity ? capture->textureCapacity * 2 : 64;
+		te_GLuint* textures = realloc(capture->textures, capacity * sizeof(te_GLuint));
+		if(!textures) { return; }
+		capture->textures = textures;
+		capture->textureCapacity = capacity;
+	}
+	memmove(capture->textures + low + 1, capture->textures + low, (capture->textureCount - low) * sizeof(te_GLuint));
+	capture->textures[low] = texture;
+	capture->textureCount++;
+
+	te_GLint width = 0, height = 0;
+	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, texture);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+
+	size_t size = (size_t) width * height * 4;
+	te_u8* pixels = size ? malloc(size) : NULL;
+	if(pixels) { glGetTexImage(GL_TEXTURE_2D, 0, TE_GL_RGBA, TE_GL_UNSIGNED_BYTE, pixels); }
+	else { width = height = 0; size = 0; }
+
+	_tinyengine_captureWord words[3];
+	words[0].u = texture;
+	words[1].u = (te_u32) width;
+	words[2].u = (te_u32) height;
+	_tinyengine_gl3_captureCommand(TE_CAPTURE_TEXTURE, NULL, words, pixels, size);
+	free(pixels);
+}
+
+void _tinyengine_gl3_forgetCapturedTexture(te_GLuint texture) {
+	_tinyengine_gl3_capture* capture = &te_gl3_state.capture;
+	if(!capture->file) { return; }
+
+	te_u32 low = 0, high = capture->textureCount;
+	while(low < high) {
+		te_u32 middle = (low + high) / 2;
+		if(capture->textures[middle] < texture) { low = middle + 1; } else { high = middle; }
+	}
+	if(low == capture->textureCount || capture->textures[low] != texture) { return; }
+
+	memmove(capture->textures + low, capture->textures + low + 1, (capture->textureCount - low - 1) * sizeof(te_GLuint));
+	capture->textureCount--;
+}
+
+// Fonts are recorded once, text commands refer to them by index
+te_u32 _tinyengine_gl3_captureFont(const _tinyengine_gl3_bitmapGlyphCache* font) {
+	_tinyengine_gl3_capture* capture = &te_gl3_state.capture;
+	if(te_gl3_state.cachedLayerRecording.layer) { return TE_CAPTURE_MAX_FONTS; }
+	for(te_u32 i = 0; i < capture->fontCount; i++) {
+		if(capture->fonts[i] == font) { return i; }
+	}
+	if(capture->fontCount == TE_CAPTURE_MAX_FONTS) { return TE_CAPTURE_MAX_FONTS; }
+
+	_tinyengine_gl3_captureTexture(font->textureID);
+
+	_tinyengine_captureWord words[3];
+	words[0].u = capture->fontCount;
+	words[1].u = font->resolution;
+	words[2].u = font->textureID;
+	_tinyengine_gl3_captureCommand(TE_CAPTURE_FONT, NULL, words, font->characterData, sizeof(font->characterData));
+
+	capture->fonts[capture->fontCount] = font;
+	return capture->fontCount++;
+}
+
+// Replays miss whatever these paths draw, so the first time each one runs during a capture says so
+void _tinyengine_gl3_warnNotCaptured(te_u32 path, const char* what) {
+	_tinyengine_gl3_capture* capture = &te_gl3_state.capture;
+	if(!capture->file || (capture->skipped & path)) { return; }
+	capture->skipped |= path;
+	TE_WARN("%s are not recorded by the running capture\n", what);
+}
+
+//// Frame recording
+
+// endFrame reads the back buffer into the next of a few pixel pack buffers and fences it. A later frame
+// maps the buffer once its fence has signalled and passes the mapping to an encoder thread, which
+// converts and writes it while the GL thread carries on. When every buffer is still busy the frame is
+// dropped rather than waited for. Without fences a buffer is mapped after the ring has gone round.
+
+#if defined(TE_PTHREADS)
+	#define _TE_RECORD_LOCK() pthread_mutex_lock(&te_gl3_state.recorder.lock)
+	#define _TE_RECORD_UNLOCK() pthread_mutex_unlock(&te_gl3_state.recorder.lock)
+#else
+	#define _TE_RECORD_LOCK()
+	#define _TE_RECORD_UNLOCK()
+#endif
+
+static te_u32 _tinyengine_crc32(te_u32 crc, const te_u8* data, size_t size) {
+	static te_u32 table[256];
+	if(table[1] == 0) {
+		for(te_u32 i = 0; i < 256; i++) {
+			te_u32 value = i;
+			for(te_u32 bit = 0; bit < 8; bit++) { value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1; }
+			table[i] = value;
+		}
+	}
+	crc = ~crc;
+	for(size_t i = 0; i < size; i++) { crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8); }
+	return ~crc;
+}
+
+static void _tinyengine_writeBigEndian32(te_u8* out, te_u32 value) {
+	out[0] = (te_u8)(value >> 24); out[1] = (te_u8)(value >> 16); out[2] = (te_u8)(value >> 8); out[3] = (te_u8) value;
+}
+
+static void _tinyengine_writePNGChunk(FILE* file, const char* type, const te_u8* data, te_u32 size) {
+	te_u8 header[8];
+	_tinyengine_writeBigEndian32(header, size);
+	memcpy(header + 4, type, 4);
+	te_u32 crc = _tinyengine_crc32(_tinyengine_crc32(0, header + 4, 4), data, size);
+	te_u8 footer[4];
+	_tinyengine_writeBigEndian32(footer, crc);
+	fwrite(header, 1, 8, file);
+	if(size) { fwrite(data, 1, size, file); }
+	fwrite(footer, 1, 4, file);
+}
+
+// RGB PNG in stored deflate blocks, fast to write and readable by everything. rows are bottom up.
+static te_bool_u8 _tinyengine_writeStoredPNG(const char* path, const te_u8* pixels, te_u32 width, te_u32 height, te_u8* scratch) {
+	FILE* file = fopen(path, "wb");
+	if(!file) { return TE_FALSE; }
+
+	static const te_u8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	fwrite(signature, 1, 8, file);
+
+	te_u8 ihdr[13] = {0};
+	_tinyengine_writeBigEndian32(ihdr, width);
+	_tinyengine_writeBigEndian32(ihdr + 4, height);
+	ihdr[8] = 8; // bit depth
+	ihdr[9] = 2; // RGB
+	_tinyengine_writePNGChunk(file, "IHDR", ihdr, sizeof(ihdr));
+
+	// Filter byte 0 and RGB for each row, flipped to top down
+	size_t rowSize = 1 + (size_t) width * 3;
+	size_t rawSize = rowSize * height;
+	te_u8* raw = scratch;
+	for(te_u32 y = 0; y < height; y++) {
+		const te_u8* source = pixels + (size_t)(height - 1 - y) * width * 4;
+		te_u8* row = raw + rowSize * y;
+		row[0] = 0;
+		for(te_u32 x = 0; x < width; x++) { memcpy(row + 1 + x * 3, source + x * 4, 3); }
+	}
+
+	// zlib stream of stored blocks, at most 65535 bytes each
+	te_u8* idat = raw + rawSize;
+	te_u8* out = idat;
+	*out++ = 0x78; *out++ = 0x01;
+	te_u32 a = 1, b = 0;
+	for(size_t offset = 0; offset < rawSize; ) {
+		size_t length = rawSize - offset > 65535 ? 65535 : rawSize - offset;
+		*out++ = offset + length == rawSize ? 1 : 0;
+		*out++ = (te_u8) length; *out++ = (te_u8)(length >> 8);
+		*out++ = (te_u8) ~length; *out++ = (te_u8)(~length >> 8);
+		memcpy(out, raw + offset, length);
+		for(size_t i = 0; i < length; i++) { a = (a + out[i]) % 65521; b = (b + a) % 65521; }
+		out += length;
+		offset += length;
+	}
+	_tinyengine_writeBigEndian32(out, (b << 16) | a);
+	out += 4;
+	_tinyengine_writePNGChunk(file, "IDAT", idat, (te_u32)(out - idat));
+	_tinyengine_writePNGChunk(file, "IEND", NULL, 0);
+
+	return fclose(file) == 0;
+}
+
+// Full range BT.601 with 2x2 chroma averaging, rows are bottom up
+static void _tinyengine_writeY4MFrame(FILE* file, const te_u8* pixels, te_u32 width, te_u32 height, te_u8* scratch) {
+	te_u32 chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+	te_u8* luma = scratch;
+	te_u8* cb = luma + (size_t) width * height;
+	te_u8* cr = cb + (size_t) chromaWidth * chromaHeight;
+
+	for(te_u32 y = 0; y < height; y++) {
+		const te_u8* row = pixels + (size_t)(height - 1 - y) * width * 4;
+		te_u8* out = luma + (size_t) y * width;
+		for(te_u32 x = 0; x < width; x++) {
+			const te_u8* p = row + x * 4;
+			out[x] = (te_u8)((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+		}
+	}
+	for(te_u32 y = 0; y < chromaHeight; y++) {
+		const te_u8* row0 = pixels + (size_t)(height - 1 - y * 2) * width * 4;
+		const te_u8* row1 = y * 2 + 1 < height ? row0 - (size_t) width * 4 : row0;
+		for(te_u32 x = 0; x < chromaWidth; x++) {
+			te_u32 x1 = x * 2 + 1 < width ? x * 2 + 1 : x * 2;
+			te_i32 r = row0[x * 8] + row0[x1 * 4] + row1[x * 8] + row1[x1 * 4];
+			te_i32 g = row0[x * 8 + 1] + row0[x1 * 4 + 1] + row1[x * 8 + 1] + row1[x1 * 4 + 1];
+			te_i32 bl = row0[x * 8 + 2] + row0[x1 * 4 + 2] + row1[x * 8 + 2] + row1[x1 * 4 + 2];
+			cb[(size_t) y * chromaWidth + x] = (te_u8)((-43 * r - 85 * g + 128 * bl + 512 * 256 + 512) >> 10);
+			cr[(size_t) y * chromaWidth + x] = (te_u8)((128 * r - 107 * g - 21 * bl + 512 * 256 + 512) >> 10);
+		}
+	}
+
+	fwrite("FRAME\n", 1, 6, file);
+	fwrite(scratch, 1, (size_t) width * height + (size_t) chromaWidth * chromaHeight * 2, file);
+}
+
+void _tinyengine_gl3_encodeRecordedFrame(_tinyengine_gl3_frameRecorder* recorder, te_u32 slot) {
+	if(recorder->format == TE_RECORD_Y4M) {
+		_tinyengine_writeY4MFrame(recorder->file, recorder->mapped[slot], recorder->width, recorder->height, recorder->scratch);
+	} else {
+		char path[600];
+		snprintf(path, sizeof(path), "%s%06u.png", recorder->path, recorder->frameNumbers[slot]);
+		if(!_tinyengine_writeStoredPNG(path, recorder->mapped[slot], recorder->width, recorder->height, recorder->scratch)) { TE_WARN("Could not write %s\n", path); }
+	}
+	recorder->framesWritten++;
+}
+
+#if defined(TE_PTHREADS)
+void* _tinyengine_gl3_recordEncoderThread(void* argument) {
+	_tinyengine_gl3_frameRecorder* recorder = &te_gl3_state.recorder;
+
+	pthread_mutex_lock(&recorder->lock);
+	while(TE_TRUE) {
+		if(recorder->encodeHead == recorder->encodeTail) {
+			if(recorder->threadExit) { break; }
+			pthread_cond_wait(&recorder->wake, &recorder->lock);
+			continue;
+		}
+		te_u32 slot = recorder->encodeQueue[recorder->encodeHead % TE_GL3_RECORD_BUFFERS];
+
+		// The mapping stays put while the slot is ENCODING, the GL thread only unmaps ENCODED slots
+		pthread_mutex_unlock(&recorder->lock);
+		_tinyengine_gl3_encodeRecordedFrame(recorder, slot);
+		pthread_mutex_lock(&recorder->lock);
+
+		recorder->encodeHead++;
+		recorder->status[slot] = TE_GL3_RECORD_ENCODED;
+	}
+	pthread_mutex_unlock(&recorder->lock);
+
+	return NULL;
+}
+#endif
+
+// Records every frame of one window until _tinyengine_gl3_stopRecording(), fps only goes into the Y4M header.
+// For PNG the path is a prefix, frames are written as <path>000000.png and up.
+te_bool_u8 _tinyengine_gl3_startRecording(tinyengine_windowContext* window, const char* path, te_u32 format, te_u32 fps) {
+	_tinyengine_gl3_frameRecorder* recorder = &te_gl3_state.recorder;
+	if(recorder->window) { TE_WARN("Already recording\n"); return TE_FALSE; }
+
+	memset(recorder, 0, sizeof(*recorder));
+	recorder->format = format;
+	recorder->width = window->render2D.viewWidth;
+	recorder->height = window->render2D.viewHeight;
+	recorder->fps = fps ? fps : 60;
+	snprintf(recorder->path, sizeof(recorder->path), "%s", path);
+	if(recorder->width == 0 || recorder->height == 0) { return TE_FALSE; }
+
+	// Room for the stored PNG rows and their zlib framing, which is more than a Y4M frame needs
+	size_t rawSize = ((size_t) recorder->width * 3 + 1) * recorder->height;
+	recorder->scratch = malloc(rawSize * 2 + (rawSize / 65535 + 1) * 5 + 16);
+	if(!recorder->scratch) { return TE_FALSE; }
+
+	if(format == TE_RECORD_Y4M) {
+		recorder->file = fopen(path, "wb");
+		if(!recorder->file) { TE_ERROR("Could not open %s\n", path); free(recorder->scratch); return TE_FALSE; }
+		fprintf(recorder->file, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n", recorder->width, recorder->height, recorder->fps);
+	}
+
+	size_t frameSize = (size_t) recorder->width * recorder->height * 4;
+	te_gl3.glGenBuffers(TE_GL3_RECORD_BUFFERS, recorder->buffers);
+	for(te_u32 i = 0; i < TE_GL3_RECORD_BUFFERS; i++) {
+		te_gl3.glBindBuffer(TE_GL_PIXEL_PACK_BUFFER, recorder->buffers[i]);
+		te_gl3.glBufferData(TE_GL_PIXEL_PACK_BUFFER, (te_GLsizeiptr) frameSize, NULL, TE_GL_STREAM_READ);
+	}
+	te_gl3.glBindBuffer(TE_GL_PIXEL_PACK_BUFFER, 0);
+
+	#if defined(TE_PTHREADS)
+		pthread_mutex_init(&recorder->lock, NULL);
+		pthread_cond_init(&recorder->wake, NULL);
+		if(pthread_create(&recorder->thread, NULL, &_tinyengine_gl3_recordEncoderThread, NULL) != 0) {
+			TE_WARN("Could not start the encoder thread, encoding on the GL thread\n");
+			pthread_mutex_destroy(&recorder->lock);
+			pthread_cond_destroy(&recorder->wake);
+		} else {
+			recorder->threadRunning = TE_TRUE;
+		}
+	#endif
+
+	recorder->window = window;
+	return TE_TRUE;
+}
+
+// Maps a finished readback and queues it for encoding. Returns false while the GPU is still on it.
+te_bool_u8 _tinyengine_gl3_collectRecordedFrame(_tinyengine_gl3_frameRecorder* recorder, te_u32 slot, te_bool_u8 wait) {
+	if(te_gl3_state.hasSync) {
+		te_GLenum result = te_gl3.glClientWaitSync(recorder->fences[slot], TE_GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000000000ull : 0);
+		if(result != TE_GL_ALREADY_SIGNALED && result != TE_GL_CONDITION_SATISFIED && !wait) { return TE_FALSE; }
+		te_gl3.glDeleteSync(recorder->fences[slot]);
+		recorder->fences[slot] = NULL;
+	} else if(!wait && recorder->framesSeen - recorder->issuedAt[slot] < TE_GL3_RECORD_BUFFERS - 1) {
+		return TE_FALSE;
+	}
+
+	size_t frameSize = (size_t) recorder->width * recorder->height * 4;
+	te_gl3.glBindBuffer(TE_GL_PIXEL_PACK_BUFFER, recorder->buffers[slot]);
+	recorder->mapped[slot] = te_gl3.glMapBufferRange(TE_GL_PIXEL_PACK_BUFFER, 0, (te_GLsizeiptr) frameSize, TE_GL_MAP_READ_BIT);
+	te_gl3.glBindBuffer(TE_GL_PIXEL_PACK_BUFFER, 0);
+	if(!recorder->mapped[slot]) { recorder->status[slot] = TE_GL3_RECORD_FREE; recorder->framesDropped++; return TE_TRUE; }
+
+	#if defined(TE_PTHREADS)
+		if(recorder->threadRunning) {
+			_TE_RECORD_LOCK();
+			recorder->status[slot] = TE_GL3_RECORD_ENCODING;
+			recorder->encodeQueue[recorder->encodeTail % TE_GL3_RECORD_BUFFERS] = slot;
+			recorder->encodeTail++;
+			pthread_cond_signal(&recorder->wake);
+			_TE_RECORD_UNLOCK();
+			return TE_TRUE;
+		}
+	#endif
+
+	_tinyengine_gl3_encodeRecordedFrame(recorder, slot);
+	recorder->status[slot] = TE_GL3_RECORD_ENCODED;
+	return TE_TRUE;
+}
+
+void _tinyengine_gl3_releaseRecordedFrames(_tinyengine_gl3_frameRecorder* recorder) {
+	_TE_RECORD_LOCK();
+	for(te_u32 slot = 0; slot < TE_GL3_RECORD_BUFFERS; slot++) {
+		if(recorder->status[slot] != TE_GL3_RECORD_ENCODED) { continue; }
+		te_gl3.glBindBuffer(TE_GL_PIXEL_PACK_BUFFER, recorder->buffers[slot]);
+		te_gl3.glUnmapBuffer(TE_GL_PIXEL_PACK_BUFFER);
+		recorder->mapped[slot] = NULL;
+		recorder->status[slot] = TE_GL3_RECORD_FREE;
+	}
+	_TE_RECORD_UNLOCK();
+	te_gl3.glBindBuffer(TE_GL_PIXEL_PACK_BUFFER, 0);
+}
+
+// Called from endFrame before the swap, while the back buffer still holds the frame
+void _tinyengine_gl3_recordFrame(tinyengine_windowContext* window) {
+	_tinyengine_gl3_frameRecorder* recorder = &te_gl3_state.recorder;
+	te_f64 start = tinyengine_getTime();
+
+	_tinyengine_gl3_releaseRecordedFrames(recorder);
+
+	// Oldest first, so frames reach the encoder in order. The slot written next is the oldest one.
+	for(te_u32 i = 0; i < TE_GL3_RECORD_BUFFERS; i++) {
+		te_u32 slot = (recorder->next + i) % TE_GL3_RECORD_BUFFERS;
+		if(recorder->status[slot] != TE_GL3_RECORD_READING) { continue; }
+		if(!_tinyengine_gl3_collectRecordedFrame(recorder, slot, TE_FALSE)) { break; }
+	}
+
+	te_u32 slot = recorder->next;
+	if(recorder->status[slot] != TE_GL3_RECORD_FREE) {
+		recorder->framesDropped++;
+	} else {
+		te_gl3.glBindBuffer(TE_GL_PIXEL_PACK_BUFFER, recorder->buffers[slot]);
+		glReadPixels(0, 0, (te_GLsizei) recorder->width, (te_GLsizei) recorder->height, TE_GL_RGBA, TE_GL_UNSIGNED_BYTE, (void*) 0);
+		te_gl3.glBindBuffer(TE_GL_PIXEL_PACK_BUFFER, 0);
+		if(te_gl3_state.hasSync) { recorder->fences[slot] = te_gl3.glFenceSync(TE_GL_SYNC_GPU_COMMANDS_COMPLETE, 0); }
+		recorder->status[slot] = TE_GL3_RECORD_READING;
+		recorder->frameNumbers[slot] = recorder->framesSeen;
+		recorder->issuedAt[slot] = recorder->framesSeen;
+		recorder->next = (slot + 1) % TE_GL3_RECORD_BUFFERS;
+	}
+	recorder->framesSeen++;
+
+	recorder->gpuThreadSeconds += tinyengine_getTime() - start;
+}
+
+// Waits for outstanding readbacks and the encoder, then closes the output
+void _tinyengine_gl3_stopRecording() {
+	_tinyengine_gl3_frameRecorder* recorder = &te_gl3_state.recorder;
+	if(!recorder->window) { return; }
+
+	for(te_u32 i = 0; i < TE_GL3_RECORD_BUFFERS; i++) {
+		te_u32 slot = (recorder->next + i) % TE_GL3_RECORD_BUFFERS;
+		if(recorder->status[slot] == TE_GL3_RECORD_READING) { _tinyengine_gl3_collectRecordedFrame(recorder, slot, TE_TRUE); }
+	}
+
+	#if defined(TE_PTHREADS)
+		if(recorder->threadRunning) {
+			pthread_mutex_lock(&recorder->lock);
+			recorder->threadExit = TE_TRUE;
+			pthread_cond_signal(&recorder->wake);
+			pthread_mutex_unlock(&recorder->lock);
+			pthread_join(recorder->thread, NULL);
+			pthread_mutex_destroy(&recorder->lock);
+			pthread_cond_destroy(&recorder->wake);
+			recorder->threadRunning = TE_FALSE;
+		}
+	#endif
+
+	_tinyengine_gl3_releaseRecordedFrames(recorder);
+	te_gl3.glDeleteBuffers(TE_GL3_RECORD_BUFFERS, recorder->buffers);
+	if(recorder->file && fclose(recorder->file) != 0) { TE_WARN("Recording may be truncated\n"); }
+	TE_LOG("Recorded %u frames, dropped %u\n", recorder->framesWritten, recorder->framesDropped);
+	free(recorder->scratch);
+	recorder->file = NULL;
+	recorder->scratch = NULL;
+	recorder->window = NULL;
+}
+
+// First use of a program is where a pending compile finally blocks
+te_bool_u8 _tinyengine_gl3_bindProgram(tinyengine_windowContext* window, _tinyengine_gl3_program* program) {
+	if(program->status != TE_GL3_PROGRAM_READY && !_tinyengine_gl3_finishProgram(program)) { return TE_FALSE; }
+
+	te_gl3.glUseProgram(program->program);
+
+	// Every program reads the view block at binding 0, only switching window or space rebinds it
+	if(te_gl3_state.hasUniformBuffer) {
+		if(te_gl3_state.boundViewWindow != window || te_gl3_state.boundViewWorld != window->render2D.worldSpace) {
+			te_gl3.glBindBufferRange(TE_GL_UNIFORM_BUFFER, 0, window->render2D.viewBuffer, window->render2D.worldSpace ? te_gl3_state.viewBlockStride : 0, 16 * sizeof(te_f32));
+			te_gl3_state.boundViewWindow = window;
+			te_gl3_state.boundViewWorld = window->render2D.worldSpace;
+		}
+		return TE_TRUE;
+	}
+
+	// Programs are shared, so the projection uniform belongs to whichever window used them last
+	if(program->projectionWindow != window) {
+		te_gl3.glUniformMatrix4fv(program->projectionLocation,1,TE_GL_FALSE,&window->render2D.projectionMatrix[0]);
+		program->projectionWindow = window;
+	}
+
+	return TE_TRUE;
+}
+
+void _tinyengine_gl3_flushBatch();
+void _tinyengine_gl3_setOverdrawCounter(tinyengine_windowContext* window);
+void _tinyengine_gl3_setDynamicResolution(tinyengine_windowContext* window, te_f32 targetMs, te_f32 minScale, te_f32 maxScale, te_u32 filter);
+te_bool_u8 _tinyengine_gl3_beginDynamicResolution(tinyengine_windowContext* window);
+void _tinyengine_gl3_resolveDynamicResolution(tinyengine_windowContext* window);
+void _tinyengine_gl3_trimRenderTargets(te_u32 idleFrames);
+
+// Camera as an affine map from world to window pixels: screen = (a * x + b * y + tx, -b * x + a * y + ty)
+static inline void _tinyengine_gl3_cameraTransform(const _tinyengine_render2DWindowContext* render2D, te_f32* a, te_f32* b, te_f32* tx, te_f32* ty) {
+	te_f32 zoom = render2D->cameraZoom > 0.0f ? render2D->cameraZoom : 1.0f;
+	te_f32 cameraX = render2D->cameraZoom > 0.0f ? render2D->cameraX : render2D->viewWidth * 0.5f;
+	te_f32 cameraY = render2D->cameraZoom > 0.0f ? render2D->cameraY : render2D->viewHeight * 0.5f;
+	*a = zoom * cosf(render2D->cameraRotation);
+	*b = zoom * sinf(render2D->cameraRotation);
+	*tx = render2D->viewWidth * 0.5f - (*a * cameraX + *b * cameraY);
+	*ty = render2D->viewHeight * 0.5f - (-*b * cameraX + *a * cameraY);
+}
+
+void _tinyengine_gl3_worldToScreen(tinyengine_windowContext* window, te_f32 x, te_f32 y, te_f32* screenX, te_f32* screenY) {
+	if(!window->render2D.worldSpace) { *screenX = x; *screenY = y; return; }
+	te_f32 a, b, tx, ty;
+	_tinyengine_gl3_cameraTransform(&window->render2D, &a, &b, &tx, &ty);
+	*screenX = a * x + b * y + tx;
+	*screenY = -b * x + a * y + ty;
+}
+
+// Projection of one space, the camera composed with the window ortho for world space
+void _tinyengine_gl3_viewMatrix(const _tinyengine_render2DWindowContext* render2D, te_bool_u8 world, te_f32 matrix[16]) {
+	te_f32 width = render2D->viewWidth > 0 ? (te_f32) render2D->viewWidth : 1.0f;
+	te_f32 height = render2D->viewHeight > 0 ? (te_f32) render2D->viewHeight : 1.0f;
+	_tinyengine_gl3_projectionOrtho(matrix,0.0f,width,height,0.0f,-1.0f,1.0f);
+	if(!world) { return; }
+
+	te_f32 a, b, tx, ty;
+	_tinyengine_gl3_cameraTransform(render2D, &a, &b, &tx, &ty);
+	matrix[0] = 2.0f * a / width;
+	matrix[1] = 2.0f * b / width;
+	matrix[3] = 2.0f * tx / width - 1.0f;
+	matrix[4] = 2.0f * b / height;
+	matrix[5] = -2.0f * a / height;
+	matrix[7] = 1.0f - 2.0f * ty / height;
+}
+
+// Rebuilds the projection of one space. With uniform buffers that is a single 64 byte update of the
+// window's view block, otherwise every program reloads it on its next bind.
+void _tinyengine_gl3_applyProjection(tinyengine_windowContext* window, te_bool_u8 world) {
+	if(te_gl3_state.batchWindow == window) { _tinyengine_gl3_flushBatch(); }
+	_tinyengine_render2DWindowContext* render2D = &window->render2D;
+	te_f32 matrix[16];
+	_tinyengine_gl3_viewMatrix(render2D, world, matrix);
+
+	if(te_gl3_state.hasUniformBuffer && render2D->viewBuffer) {
+		te_gl3.glBindBuffer(TE_GL_UNIFORM_BUFFER, render2D->viewBuffer);
+		te_gl3.glBufferSubData(TE_GL_UNIFORM_BUFFER, world ? te_gl3_state.viewBlockStride : 0, sizeof(matrix), matrix);
+		te_gl3.glBindBuffer(TE_GL_UNIFORM_BUFFER, 0);
+	}
+	if(world != render2D->worldSpace) { return; }
+
+	memcpy(render2D->projectionMatrix, matrix, sizeof(matrix));
+
+	// The visible area is the bounding box of the view rectangle mapped back into this space
+	te_f32 width = (te_f32) render2D->viewWidth;
+	te_f32 height = (te_f32) render2D->viewHeight;
+	if(world) {
+		te_f32 a, b, tx, ty;
+		_tinyengine_gl3_cameraTransform(render2D, &a, &b, &tx, &ty);
+		te_f32 scale = 1.0f / (a * a + b * b);
+		te_f32 centreX = ((width * 0.5f - tx) * a - (height * 0.5f - ty) * b) * scale;
+		te_f32 centreY = ((width * 0.5f - tx) * b + (height * 0.5f - ty) * a) * scale;
+		te_f32 halfWidth = (fabsf(a) * width + fabsf(b) * height) * 0.5f * scale;
+		te_f32 halfHeight = (fabsf(b) * width + fabsf(a) * height) * 0.5f * scale;
+		render2D->visibleX0 = centreX - halfWidth;
+		render2D->visibleY0 = centreY - halfHeight;
+		render2D->visibleX1 = centreX + halfWidth;
+		render2D->visibleY1 = centreY + halfHeight;
+	} else {
+		render2D->visibleX0 = 0.0f;
+		render2D->visibleY0 = 0.0f;
+		render2D->visibleX1 = width;
+		render2D->visibleY1 = height;
+	}
+
+	if(!te_gl3_state.hasUniformBuffer) {
+		if(te_gl3_state.flatProgram.projectionWindow == window) { te_gl3_state.flatProgram.projectionWindow = NULL; }
+		if(te_gl3_state.spriteProgram.projectionWindow == window) { te_gl3_state.spriteProgram.projectionWindow = NULL; }
+		if(te_gl3_state.textProgram.projectionWindow == window) { te_gl3_state.textProgram.projectionWindow = NULL; }
+		if(te_gl3_state.sceneProgram.projectionWindow == window) { te_gl3_state.sceneProgram.projectionWindow = NULL; }
+		if(te_gl3_state.upscaleProgram.projectionWindow == window) { te_gl3_state.upscaleProgram.projectionWindow = NULL; }
+	}
+}
+
+void _tinyengine_gl3_updateView(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
+	if(te_gl3_state.capture.file) {
+		_tinyengine_captureWord words[2] = { { .u = width }, { .u = height } };
+		_tinyengine_gl3_captureCommand(TE_CAPTURE_VIEW, window, words, NULL, 0);
+	}
+
+	window->render2D.viewWidth = width;
+	window->render2D.viewHeight = height;
+	_tinyengine_gl3_applyProjection(window, TE_FALSE);
+	_tinyengine_gl3_applyProjection(window, TE_TRUE);
+
+	// Resized back buffers start out undefined
+	window->damage.width = width;
+	window->damage.height = height;
+	window->damage.backBufferCurrent = TE_FALSE;
+	tinyengine_damageWindow(window);
+}
+
+// World space camera: (x, y) is shown at the centre of the view, zoom > 1 magnifies, rotation in radians
+void _tinyengine_gl3_setCamera(tinyengine_windowContext* window, te_f32 x, te_f32 y, te_f32 zoom, te_f32 rotation) {
+	if(te_gl3_state.capture.file) {
+		_tinyengine_captureWord words[4] = { { .f = x }, { .f = y }, { .f = zoom }, { .f = rotation } };
+		_tinyengine_gl3_captureCommand(TE_CAPTURE_CAMERA, window, words, NULL, 0);
+	}
+
+	window->render2D.cameraX = x;
+	window->render2D.cameraY = y;
+	window->render2D.cameraZoom = zoom > 0.0f ? zoom : 1.0f;
+	window->render2D.cameraRotation = rotation;
+	_tinyengine_gl3_applyProjection(window, TE_TRUE);
+}
+
+// Draws after this go through the camera, switch back for screen space UI and text
+void _tinyengine_gl3_setWorldSpace(tinyengine_windowContext* window, te_bool_u8 enabled) {
+	if(window->render2D.worldSpace == enabled) { return; }
+	if(te_gl3_state.capture.file) {
+		_tinyengine_captureWord words[1] = { { .u = enabled } };
+		_tinyengine_gl3_captureCommand(TE_CAPTURE_WORLD_SPACE, window, words, NULL, 0);
+	}
+	if(te_gl3_state.batchWindow == window) { _tinyengine_gl3_flushBatch(); }
+	window->render2D.worldSpace = enabled;
+	_tinyengine_gl3_applyProjection(window, enabled);
+}
+
+// Visible rectangle of the current space, the query for a spatial grid
+void _tinyengine_gl3_getVisibleRect(tinyengine_windowContext* window, te_f32* x, te_f32* y, te_f32* width, te_f32* height) {
+	*x = window->render2D.visibleX0;
+	*y = window->render2D.visibleY0;
+	*width = window->render2D.visibleX1 - window->render2D.visibleX0;
+	*height = window->render2D.visibleY1 - window->render2D.visibleY0;
+}
+
+// False when the rectangle is entirely outside the view, always true before the view is known
+static inline te_bool_u8 _tinyengine_gl3_isVisible(tinyengine_windowContext* window, te_f32 x0, te_f32 y0, te_f32 x1, te_f32 y1) {
+	const _tinyengine_render2DWindowContext* render2D = &window->render2D;
+	if(render2D->viewWidth == 0) { return TE_TRUE; }
+	return x1 >= render2D->visibleX0 && x0 <= render2D->visibleX1 && y1 >= render2D->visibleY0 && y0 <= render2D->visibleY1;
+}
+
+// Programs read the view from binding 0 of the uniform buffer
+void _tinyengine_gl3_bindViewBlock(_tinyengine_gl3_program* program) {
+	if(!te_gl3_state.hasUniformBuffer) { return; }
+	te_GLuint block = te_gl3.glGetUniformBlockIndex(program->program, "view");
+	if(block != TE_GL_INVALID_INDEX) { te_gl3.glUniformBlockBinding(program->program, block, 0); }
+}
+
+void _tinyengine_gl3_flatProgramReady(_tinyengine_gl3_program* program) {
+	_tinyengine_gl3_bindViewBlock(program);
+	program->projectionLocation = te_gl3.glGetUniformLocation(program->program, "projection");
+}
+
+void _tinyengine_gl3_texturedProgramReady(_tinyengine_gl3_program* program) {
+	_tinyengine_gl3_bindViewBlock(program);
+	te_gl3.glUseProgram(program->program);
+	te_gl3.glUniform1i(te_gl3.glGetUniformLocation(program->program, "texture_bank"), 0);
+	program->projectionLocation = te_gl3.glGetUniformLocation(program->program, "projection");
+}
+
+void _tinyengine_gl3_upscaleProgramReady(_tinyengine_gl3_program* program) {
+	_tinyengine_gl3_texturedProgramReady(program);
+	te_gl3_state.upscaleLocation = te_gl3.glGetUniformLocation(program->program, "upscale");
+	te_gl3_state.upscaleLimitLocation = te_gl3.glGetUniformLocation(program->program, "limit");
+}
+
+te_bool_u8 _tinyengine_gl3_createSharedResources() {
+
+	// All three programs are submitted before anything waits on them
+
+	te_gl3_state.flatProgram.ready = &_tinyengine_gl3_flatProgramReady;
+	te_gl3_state.flatProgram.attributes = TE_GL3_VERTEX2D_ATTRIBUTES;
+	_tinyengine_gl3_submitProgram(&te_gl3_state.flatProgram,TE_GL3_FLAT_VERTEX_SRC,TE_GL3_FLAT_FRAGMENT_SRC);
+
+	te_gl3_state.spriteProgram.ready = &_tinyengine_gl3_texturedProgramReady;
+	te_gl3_state.spriteProgram.attributes = TE_GL3_VERTEX2D_ATTRIBUTES;
+	_tinyengine_gl3_submitProgram(&te_gl3_state.spriteProgram,TE_GL3_SPRITE_VERTEX_SRC,TE_GL3_SPRITE_FRAGMENT_SRC);
+
+	te_gl3_state.textProgram.ready = &_tinyengine_gl3_texturedProgramReady;
+	te_gl3_state.textProgram.attributes = TE_GL3_VERTEX2D_ATTRIBUTES;
+	_tinyengine_gl3_submitProgram(&te_gl3_state.textProgram,TE_GL3_SPRITE_VERTEX_SRC,TE_GL3_TEXT_FRAGMENT_SRC);
+
+	// One stream buffer for all immediate mode drawing
+
+	te_gl3.glGenBuffers(1, &te_gl3_state.batchVBO);
+	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, te_gl3_state.batchVBO);
+	te_gl3.glBufferData(TE_GL_ARRAY_BUFFER, sizeof(_tinyengine_gl3_vertex2D) * 4 * TE_GL3_BATCH_BUFFER_QUADS, NULL, TE_GL_STREAM_DRAW);
+	te_gl3_state.batchBufferOffset = 0;
+
+	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, 0);
+
+	// Quads are 4 vertices, this never changes. A batch draws the slice of it that matches its place in the stream buffer.
+	te_u16* indices = malloc(sizeof(te_u16) * 6 * TE_GL3_BATCH_BUFFER_QUADS);
+	if(!indices) { TE_ERROR("Could not allocate quad indices\n"); return TE_FALSE; }
+	for(te_u32 quad = 0; quad < TE_GL3_BATCH_BUFFER_QUADS; quad++) {
+		te_u16 first = (te_u16) (quad * 4);
+		te_u16* index = indices + quad * 6;
+		index[0] = first; index[1] = first + 1; index[2] = first + 2;
+		index[3] = first + 2; index[4] = first + 3; index[5] = first;
+	}
+	te_gl3.glGenBuffers(1, &te_gl3_state.quadIndexBuffer);
+	te_gl3.glBindBuffer(TE_GL_ELEMENT_ARRAY_BUFFER, te_gl3_state.quadIndexBuffer);
+	te_gl3.glBufferData(TE_GL_ELEMENT_ARRAY_BUFFER, sizeof(te_u16) * 6 * TE_GL3_BATCH_BUFFER_QUADS, indices, TE_GL_STATIC_DRAW);
+	te_gl3.glBindBuffer(TE_GL_ELEMENT_ARRAY_BUFFER, 0);
+	free(indices);
+
+	te_gl3_state.sharedResourcesReady = TE_TRUE;
+	return TE_TRUE;
+}
+
+// Picks up programs the driver finished in the background, so their latency is measured when they complete
+void _tinyengine_gl3_pollPrograms() {
+	_tinyengine_gl3_pollProgram(&te_gl3_state.flatProgram);
+	_tinyengine_gl3_pollProgram(&te_gl3_state.spriteProgram);
+	_tinyengine_gl3_pollProgram(&te_gl3_state.textProgram);
+	_tinyengine_gl3_pollProgram(&te_gl3_state.sceneProgram);
+	_tinyengine_gl3_pollProgram(&te_gl3_state.upscaleProgram);
+}
+
+te_bool_u8 _tinyengine_gl3_createWindowRenderContext(tinyengine_windowContext* window) {
+	// TODO: check if opengl3 has been initilized and init it if not first
+
+	te_gl3.glActiveTexture(TE_GL_TEXTURE0);
+	glEnable(GL_BLEND);
+	// Every texture and shader output is premultiplied, which keeps filtering and mipmaps free of dark fringes
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+	glClearColor(0.0f,0.0f,0.0f,1.0f);
+
+	// Only the first window pays for shader compilation and buffer allocation
+	if(!te_gl3_state.sharedResourcesReady && !_tinyengine_gl3_createSharedResources()) { return TE_FALSE; }
+
+	te_gl3.glGenVertexArrays(1, &window->render2D.batchVAO);
+	te_gl3.glBindVertexArray(window->render2D.batchVAO);
+	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, te_gl3_state.batchVBO);
+	te_gl3.glEnableVertexAttribArray(0);
+	te_gl3.glVertexAttribPointer(0, 2, TE_GL_FLOAT, TE_GL_FALSE, sizeof(_tinyengine_gl3_vertex2D), (void*) offsetof(_tinyengine_gl3_vertex2D, x));
+	te_gl3.glEnableVertexAttribArray(1);
+	te_gl3.glVertexAttribPointer(1, 2, TE_GL_UNSIGNED_SHORT, TE_GL_TRUE, sizeof(_tinyengine_gl3_vertex2D), (void*) offsetof(_tinyengine_gl3_vertex2D, u));
+	te_gl3.glEnableVertexAttribArray(2);
+	te_gl3.glVertexAttribPointer(2, 4, TE_GL_UNSIGNED_BYTE, TE_GL_TRUE, sizeof(_tinyengine_gl3_vertex2D), (void*) offsetof(_tinyengine_gl3_vertex2D, color));
+	te_gl3.glBindBuffer(TE_GL_ELEMENT_ARRAY_BUFFER, te_gl3_state.quadIndexBuffer); // recorded in the VAO
+
+	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, 0);
+	te_gl3.glBindVertexArray(0);
+
+	if(te_gl3_state.hasUniformBuffer) {
+		te_gl3.glGenBuffers(1, &window->render2D.viewBuffer);
+		te_gl3.glBindBuffer(TE_GL_UNIFORM_BUFFER, window->render2D.viewBuffer);
+		te_gl3.glBufferData(TE_GL_UNIFORM_BUFFER, te_gl3_state.viewBlockStride + 16 * sizeof(te_f32), NULL, TE_GL_DYNAMIC_DRAW);
+		te_gl3.glBindBuffer(TE_GL_UNIFORM_BUFFER, 0);
+		_tinyengine_gl3_applyProjection(window, TE_FALSE);
+		_tinyengine_gl3_applyProjection(window, TE_TRUE);
+	}
+
+	return TE_TRUE;
+}
+
+// Called by tinyengine_destroyWindow(), nothing in the shared state may point at the window afterwards
+void _tinyengine_gl3_destroyWindowRenderContext(tinyengine_windowContext* window) {
+	// Quads still batched for the window are dropped, flushing would draw them into whichever surface is current
+	if(te_gl3_state.batchWindow == window) { te_gl3_state.batchLength = 0; te_gl3_state.batchWindow = NULL; }
+	te_gl3.glDeleteVertexArrays(1, &window->render2D.batchVAO);
+	if(window->render2D.layerVAO) { te_gl3.glDeleteVertexArrays(1, &window->render2D.layerVAO); }
+	window->render2D.layerVAO = 0;
+	if(te_gl3_state.layers.window == window) { te_gl3_state.layers.window = NULL; }
+	if(te_gl3_state.overdraw.window == window) { _tinyengine_gl3_setOverdrawCounter(NULL); }
+	_tinyengine_gl3_setDynamicResolution(window, 0.0f, 1.0f, 1.0f, TE_UPSCALE_BILINEAR);
+	if(window->render2D.viewBuffer) { te_gl3.glDeleteBuffers(1, &window->render2D.viewBuffer); }
+	window->render2D.viewBuffer = 0;
+	if(te_gl3_state.boundViewWindow == window) { te_gl3_state.boundViewWindow = NULL; }
+	if(te_gl3_state.flatProgram.projectionWindow == window) { te_gl3_state.flatProgram.projectionWindow = NULL; }
+	if(te_gl3_state.spriteProgram.projectionWindow == window) { te_gl3_state.spriteProgram.projectionWindow = NULL; }
+	if(te_gl3_state.textProgram.projectionWindow == window) { te_gl3_state.textProgram.projectionWindow = NULL; }
+	if(te_gl3_state.sceneProgram.projectionWindow == window) { te_gl3_state.sceneProgram.projectionWindow = NULL; }
+	if(te_gl3_state.upscaleProgram.projectionWindow == window) { te_gl3_state.upscaleProgram.projectionWindow = NULL; }
+	for(te_u32 i = 0; i < TE_CAPTURE_MAX_WINDOWS; i++) {
+		if(te_gl3_state.capture.windows[i] == window) { te_gl3_state.capture.windows[i] = NULL; }
+	}
+	// Frames already read back are still written out
+	if(te_gl3_state.recorder.window == window) { _tinyengine_gl3_stopRecording(); }
+}
+
+// GL objects die with the shared context, this only forgets them so the renderer can be initialized again
+void _tinyengine_gl3_terminate() {
+	_tinyengine_gl3_stopCapture();
+	_tinyengine_gl3_stopRecording();
+	_tinyengine_gl3_terminateTextureStreaming();
+	free(te_gl3_state.layers.sprites);
+	free(te_gl3_state.layers.order);
+	free(te_gl3_state.layers.vertices);
+	free(te_gl3_state.opaqueTextures);
+	free(te_gl3_state.overlay.vertices);
+	free(te_gl3_state.overlay.runs);
+
+	char shaderCacheDirectory[sizeof(te_gl3_state.shaderCacheDirectory)];
+	memcpy(shaderCacheDirectory, te_gl3_state.shaderCacheDirectory, sizeof(shaderCacheDirectory));
+	memset(&te_gl3_state, 0, sizeof(te_gl3_state));
+	memcpy(te_gl3_state.shaderCacheDirectory, shaderCacheDirectory, sizeof(shaderCacheDirectory));
+}
+
+//// Overdraw counter
+
+// Counts the samples each frame of one window writes with an occlusion query, read back a few frames later so
+// nothing stalls. Samples per rendered pixel is the overdraw: 1 when every pixel is written once, less where the
+// clear shows through. Disabled with NULL.
+void _tinyengine_gl3_setOverdrawCounter(tinyengine_windowContext* window) {
+	_tinyengine_gl3_overdrawCounter* counter = &te_gl3_state.overdraw;
+	if(counter->window) {
+		if(counter->active) { te_gl3.glEndQuery(TE_GL_SAMPLES_PASSED); }
+		te_gl3.glDeleteQueries(TE_GL3_OVERDRAW_QUERIES, counter->queries);
+	}
+	memset(counter, 0, sizeof(_tinyengine_gl3_overdrawCounter));
+	if(window == NULL) { return; }
+
+	counter->window = window;
+	te_gl3.glGenQueries(TE_GL3_OVERDRAW_QUERIES, counter->queries);
+}
+
+// Last collected frame and the average since the counter was set, 0 until a result came back
+void _tinyengine_gl3_getOverdraw(te_f32* lastFrame, te_f32* average) {
+	const _tinyengine_gl3_overdrawCounter* counter = &te_gl3_state.overdraw;
+	if(lastFrame) { *lastFrame = counter->lastFrame; }
+	if(average) { *average = counter->area ? (te_f32)((te_f64) counter->samples / (te_f64) counter->area) : 0.0f; }
+}
+
+static void _tinyengine_gl3_beginOverdrawQuery(tinyengine_windowContext* window) {
+	_tinyengine_gl3_overdrawCounter* counter = &te_gl3_state.overdraw;
+	if(counter->window != window || counter->active) { return; }
+	// Every query still in flight means the GPU is that far behind, this frame goes uncounted
+	if(counter->issued - counter->collected == TE_GL3_OVERDRAW_QUERIES) { return; }
+
+	// An offscreen frame renders fewer pixels than the view, the scene is measured against those
+	te_u32 slot = counter->issued % TE_GL3_OVERDRAW_QUERIES;
+	const _tinyengine_dynamicResolution* resolution = &window->render2D.resolution;
+	counter->pixels[slot] = resolution->active ? resolution->renderWidth * resolution->renderHeight : window->render2D.viewWidth * window->render2D.viewHeight;
+	te_gl3.glBeginQuery(TE_GL_SAMPLES_PASSED, counter->queries[slot]);
+	counter->active = TE_TRUE;
+}
+
+static void _tinyengine_gl3_endOverdrawQuery(tinyengine_windowContext* window) {
+	_tinyengine_gl3_overdrawCounter* counter = &te_gl3_state.overdraw;
+	if(counter->window != window) { return; }
+	if(counter->active) {
+		te_gl3.glEndQuery(TE_GL_SAMPLES_PASSED);
+		counter->active = TE_FALSE;
+		counter->issued++;
+	}
+
+	while(counter->collected != counter->issued) {
+		te_u32 slot = counter->collected % TE_GL3_OVERDRAW_QUERIES;
+		te_GLuint available = 0;
+		te_gl3.glGetQueryObjectuiv(counter->queries[slot], TE_GL_QUERY_RESULT_AVAILABLE, &available);
+		if(!available) { break; }
+
+		te_GLuint samples = 0;
+		te_gl3.glGetQueryObjectuiv(counter->queries[slot], TE_GL_QUERY_RESULT, &samples);
+		te_u32 pixels = counter->pixels[slot] ? counter->pixels[slot] : 1;
+		counter->lastFrame = (te_f32) samples / (te_f32) pixels;
+		counter->samples += samples;
+		counter->area += pixels;
+		counter->collected++;
+	}
+}
+
+void _tinyengine_gl3_startFrame(tinyengine_windowContext* window) {
+	if(te_gl3_state.capture.file) { _tinyengine_gl3_captureCommand(TE_CAPTURE_FRAME_START, window, NULL, NULL, 0); }
+	_tinyengine_gl3_pollPrograms();
+	_tinyengine_gl3_updateTextureStreaming();
+
+	// Everything up to endFrame is clipped to the damaged area, offscreen frames are redrawn whole
+	if(_tinyengine_gl3_beginDynamicResolution(window)) {
+		tinyengine_damageWindow(window);
+		_tinyengine_prepareRedraw(window);
+	} else if(_tinyengine_prepareRedraw(window)) {
+		_tinyengine_damageRect redraw = window->damage.redraw;
+		glEnable(GL_SCISSOR_TEST);
+		glScissor(redraw.x0, (te_i32) window->damage.height - redraw.y1, redraw.x1 - redraw.x0, redraw.y1 - redraw.y0);
+	}
+	_tinyengine_gl3_beginOverdrawQuery(window);
+	glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void _tinyengine_gl3_endFrame(tinyengine_windowContext* window) {
+	if(te_gl3_state.capture.file) {
+		_tinyengine_gl3_captureCommand(TE_CAPTURE_FRAME_END, window, NULL, NULL, 0);
+		te_gl3_state.capture.frames++;
+	}
+	_tinyengine_gl3_flushBatch();
+	// The upscale and the overlay drawn over it are not part of the scene the overdraw is counted for
+	_tinyengine_gl3_endOverdrawQuery(window);
+	if(window->render2D.resolution.active) { _tinyengine_gl3_resolveDynamicResolution(window); }
+	if(window->damage.enabled) { glDisable(GL_SCISSOR_TEST); }
+	if(te_gl3_state.recorder.window == window) { _tinyengine_gl3_recordFrame(window); }
+
+	te_gl3_state.frameIndex++;
+	_tinyengine_gl3_trimRenderTargets(TE_GL3_RENDER_TARGET_IDLE_FRAMES);
+}
+
+//// Immediate mode batching
+
+// Draws everything collected so far with a single call. The stream buffer is written front to back without
+// synchronization and orphaned when full, so the driver never waits on batches still in flight.
+void _tinyengine_gl3_flushBatch() {
+	te_u32 length = te_gl3_state.batchLength;
+	if(!length) { return; }
+	te_gl3_state.batchLength = 0;
+
+	tinyengine_windowContext* window = te_gl3_state.batchWindow;
+	if(!_tinyengine_gl3_bindProgram(window, te_gl3_state.batchProgram)) { return; }
+	if(te_gl3_state.batchProgram != &te_gl3_state.flatProgram) { te_gl3.glBindTexture(TE_GL_TEXTURE_2D, te_gl3_state.batchTexture); }
+
+	te_GLsizeiptr size = (te_GLsizeiptr) (length * sizeof(_tinyengine_gl3_vertex2D));
+	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, te_gl3_state.batchVBO);
+	if(te_gl3_state.batchBufferOffset + length > 4 * TE_GL3_BATCH_BUFFER_QUADS) {
+		te_gl3.glBufferData(TE_GL_ARRAY_BUFFER, sizeof(_tinyengine_gl3_vertex2D) * 4 * TE_GL3_BATCH_BUFFER_QUADS, NULL, TE_GL_STREAM_DRAW);
+		te_gl3_state.batchBufferOffset = 0;
+	}
+
+	te_GLintptr offset = (te_GLintptr) (te_gl3_state.batchBufferOffset * sizeof(_tinyengine_gl3_vertex2D));
+	void* destination = te_gl3.glMapBufferRange(TE_GL_ARRAY_BUFFER, offset, size, TE_GL_MAP_WRITE_BIT | TE_GL_MAP_INVALIDATE_RANGE_BIT | TE_GL_MAP_UNSYNCHRONIZED_BIT);
+	if(destination) {
+		memcpy(destination, te_gl3_state.batchVertices, (size_t) size);
+		te_gl3.glUnmapBuffer(TE_GL_ARRAY_BUFFER);
+	} else {
+		te_gl3.glBufferSubData(TE_GL_ARRAY_BUFFER, offset, size, te_gl3_state.batchVertices);
+	}
+	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, 0);
+
+	te_gl3.glBindVertexArray(window->render2D.batchVAO);
+	te_u32 firstQuad = te_gl3_state.batchBufferOffset / 4;
+	glDrawElements(TE_GL_TRIANGLES, (te_GLsizei) (length / 4 * 6), TE_GL_UNSIGNED_SHORT, (const void*) (firstQuad * 6 * sizeof(te_u16)));
+	te_gl3.glBindVertexArray(0);
+
+	te_gl3_state.batchBufferOffset += length;
+	te_gl3_state.batchDrawCalls++;
+	te_gl3_state.batchBytes += (te_u64) size;
+}
+
+static inline te_u16 _tinyengine_gl3_unorm16(te_f32 value) {
+	value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+	return (te_u16) (value * 65535.0f + 0.5f);
+}
+
+static inline te_u8 _tinyengine_gl3_unorm8(te_f32 value) {
+	value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+	return (te_u8) (value * 255.0f + 0.5f);
+}
+
+// Space for one more quad, starting a new batch when the program, texture or window changes
+static _tinyengine_gl3_vertex2D* _tinyengine_gl3_batchQuad(tinyengine_windowContext* window, _tinyengine_gl3_program* program, te_GLuint texture) {
+	if(te_gl3_state.batchWindow != window || te_gl3_state.batchProgram != program || te_gl3_state.batchTexture != texture || te_gl3_state.batchLength + 4 > 4 * TE_GL3_BATCH_QUADS) {
+		_tinyengine_gl3_flushBatch();
+		te_gl3_state.batchWindow = window;
+		te_gl3_state.batchProgram = program;
+		te_gl3_state.batchTexture = texture;
+	}
+
+	_tinyengine_gl3_vertex2D* quad = te_gl3_state.batchVertices + te_gl3_state.batchLength;
+	te_gl3_state.batchLength += 4;
+	return quad;
+}
+
+// Corners in index buffer order, (x0, y0) gets (u0, v0) and (x1, y1) gets (u1, v1)
+static inline void _tinyengine_gl3_writeQuad(_tinyengine_gl3_vertex2D* quad, te_f32 x0, te_f32 y0, te_f32 x1, te_f32 y1, te_u16 u0, te_u16 v0, te_u16 u1, te_u16 v1, const te_u8 color[4]) {
+	const te_f32 xs[4] = { x0, x1, x1, x0 };
+	const te_f32 ys[4] = { y0, y0, y1, y1 };
+	const te_u16 us[4] = { u0, u1, u1, u0 };
+	const te_u16 vs[4] = { v0, v0, v1, v1 };
+	for(te_u32 i = 0; i < 4; i++) {
+		quad[i].x = xs[i];
+		quad[i].y = ys[i];
+		quad[i].u = us[i];
+		quad[i].v = vs[i];
+		memcpy(quad[i].color, color, 4);
+	}
+}
+
+void _tinyengine_gl3_drawRectangle2D(tinyengine_windowContext* window, te_f32 x, te_f32 y, te_f32 width, te_f32 height, te_v4_f32 color) {
+	if(te_gl3_state.capture.file) {
+		_tinyengine_captureWord words[8] = { { .f = x }, { .f = y }, { .f = width }, { .f = height }, { .f = color.x }, { .f = color.y }, { .f = color.z }, { .f = color.w } };
+		_tinyengine_gl3_captureCommand(TE_CAPTURE_RECTANGLE, window, words, NULL, 0);
+	}
+	if(!_tinyengine_gl3_isVisible(window, x, y, x + width, y + height)) { return; }
+
+	te_u8 tint[4] = { _tinyengine_gl3_unorm8(color.x), _tinyengine_gl3_unorm8(color.y), _tinyengine_gl3_unorm8(color.z), _tinyengine_gl3_unorm8(color.w) };
+	_tinyengine_gl3_vertex2D* quad = _tinyengine_gl3_batchQuad(window, &te_gl3_state.flatProgram, 0);
+	_tinyengine_gl3_writeQuad(quad, x, y, x + width, y + height, 0, 0, 0, 0, tint);
+}
+
+// Texture repeats a tiled sprite is cut into per axis, beyond this it is clamped to a single stretched copy
+#ifndef TE_GL3_SPRITE_MAX_TILES
+	#define TE_GL3_SPRITE_MAX_TILES 64
+#endif
+
+typedef struct _tinyengine_gl3_spriteSpan_t {
+	te_f32 p0, p1;
+	te_u16 t0, t1;
+} _tinyengine_gl3_spriteSpan;
+
+// One axis of a sprite, position p0..p1 mapped to texture coordinate t0..t1. Coordinates past 0..1 repeat
+// the texture, which unorm16 UVs can not express, so the axis is cut at every whole repeat into spans whose
+// coordinates fit in 0..1. Returns the span count.
+static te_u32 _tinyengine_gl3_spriteSpans(te_f32 p0, te_f32 p1, te_f32 t0, te_f32 t1, _tinyengine_gl3_spriteSpan* spans) {
+	te_f32 lo = t0 < t1 ? t0 : t1;
+	te_f32 hi = t0 < t1 ? t1 : t0;
+	te_f32 first = floorf(lo);
+	te_f32 count = ceilf(hi) - first;
+	if((lo >= 0.0f && hi <= 1.0f) || count > TE_GL3_SPRITE_MAX_TILES) {
+		spans[0] = (_tinyengine_gl3_spriteSpan){ p0, p1, _tinyengine_gl3_unorm16(t0), _tinyengine_gl3_unorm16(t1) };
+		return 1;
+	}
+	if(hi == lo) {
+		spans[0] = (_tinyengine_gl3_spriteSpan){ p0, p1, _tinyengine_gl3_unorm16(t0 - first), _tinyengine_gl3_unorm16(t1 - first) };
+		return 1;
+	}
+
+	te_u32 length = 0;
+	te_f32 scale = (p1 - p0) / (t1 - t0);
+	for(te_u32 i = 0; i < (te_u32) count; i++) {
+		te_f32 base = first + (te_f32) i;
+		te_f32 a = lo > base ? lo : base;
+		te_f32 b = hi < base + 1.0f ? hi : base + 1.0f;
+		if(b <= a) { continue; }
+		spans[length++] = (_tinyengine_gl3_spriteSpan){ p0 + (a - t0) * scale, p0 + (b - t0) * scale, _tinyengine_gl3_unorm16(a - base), _tinyengine_gl3_unorm16(b - base) };
+	}
+	return length;
+}
+
+// The sprite is multiplied by the tint, white leaves it unchanged. A source rectangle reaching past the
+// texture tiles it, drawn as one quad per repeat.
+void _tinyengine_gl3_drawSpriteTinted(tinyengine_windowContext* window, te_GLuint texture, te_f32 x, te_f32 y, te_f32 width, te_f32 height, te_f32 scale, te_f32 tex_width, te_f32 tex_height, te_f32 tex_x, te_f32 tex_y, te_v4_f32 color) {
+	if(te_gl3_state.capture.file) {
+		_tinyengine_gl3_captureTexture(texture);
+		_tinyengine_captureWord words[14] = { { .u = texture }, { .f = x }, { .f = y }, { .f = width }, { .f = height }, { .f = scale }, { .f = tex_width },
+			{ .f = tex_height }, { .f = tex_x }, { .f = tex_y }, { .f = color.x }, { .f = color.y }, { .f = color.z }, { .f = color.w } };
+		_tinyengine_gl3_captureCommand(TE_CAPTURE_SPRITE, window, words, NULL, 0);
+	}
+
+	if(!_tinyengine_gl3_isVisible(window, x, y, x + width * scale, y + height * scale)) { return; }
+
+	// Rows count down from the top of the texture
+	te_f32 ux0 = tex_x / tex_width;
+	te_f32 uy0 = 1.0f - tex_y / tex_height;
+	te_f32 ux1 = ux0 + (width / tex_width);
+	te_f32 uy1 = uy0 - (height / tex_height);
+
+	_tinyengine_gl3_spriteSpan columns[TE_GL3_SPRITE_MAX_TILES];
+	_tinyengine_gl3_spriteSpan rows[TE_GL3_SPRITE_MAX_TILES];
+	te_u32 columnCount = _tinyengine_gl3_spriteSpans(x, (width * scale) + x, ux0, ux1, columns);
+	te_u32 rowCount = _tinyengine_gl3_spriteSpans(y, (height * scale) + y, uy0, uy1, rows);
+
+	te_u8 tint[4] = { _tinyengine_gl3_unorm8(color.x), _tinyengine_gl3_unorm8(color.y), _tinyengine_gl3_unorm8(color.z), _tinyengine_gl3_unorm8(color.w) };
+	for(te_u32 row = 0; row < rowCount; row++) {
+		for(te_u32 column = 0; column < columnCount; column++) {
+			const _tinyengine_gl3_spriteSpan* cx = &columns[column];
+			const _tinyengine_gl3_spriteSpan* cy = &rows[row];
+			_tinyengine_gl3_vertex2D* quad = _tinyengine_gl3_batchQuad(window, &te_gl3_state.spriteProgram, texture);
+			_tinyengine_gl3_writeQuad(quad, cx->p0, cy->p0, cx->p1, cy->p1, cx->t0, cy->t0, cx->t1, cy->t1, tint);
+		}
+	}
+}
+
+void _tinyengine_gl3_drawSprite(tinyengine_windowContext* window, te_GLuint texture, te_f32 x, te_f32 y, te_f32 width, te_f32 height, te_f32 scale, te_f32 tex_width, te_f32 tex_height, te_f32 tex_x, te_f32 tex_y) {
+	_tinyengine_gl3_drawSpriteTinted(window, texture, x, y, width, height, scale, tex_width, tex_height, tex_x, tex_y, (te_v4_f32){1.0f,1.0f,1.0f,1.0f});
+}
+
+// Every entity with a transform and a sprite, streamed from the chunks into the sprite batch. A texture change
+// starts a new batch, so entities sharing a texture are best created together.
+void _tinyengine_gl3_drawEntities(tinyengine_windowContext* window, const tinyengine_world* world) {
+	_tinyengine_gl3_warnNotCaptured(TE_CAPTURE_SKIPPED_ENTITIES, "Entities");
+	tinyengine_entityQuery query;
+	tinyengine_entityChunk chunk;
+	tinyengine_beginEntityQuery(&query, TE_COMPONENT(TE_COMPONENT_TRANSFORM) | TE_COMPONENT(TE_COMPONENT_SPRITE), 0);
+	while(tinyengine_nextEntityChunk(world, &query, &chunk)) {
+		const tinyengine_transform* transforms = (const tinyengine_transform*) tinyengine_getChunkComponents(&chunk, TE_COMPONENT_TRANSFORM);
+		const tinyengine_sprite* sprites = (const tinyengine_sprite*) tinyengine_getChunkComponents(&chunk, TE_COMPONENT_SPRITE);
+		for(te_u32 i = 0; i < chunk.count; i++) {
+			const tinyengine_sprite* sprite = &sprites[i];
+			te_f32 x0 = transforms[i].x, y0 = transforms[i].y;
+			te_f32 x1 = x0 + sprite->width * transforms[i].scale, y1 = y0 + sprite->height * transforms[i].scale;
+			if(!_tinyengine_gl3_isVisible(window, x0, y0, x1, y1)) { continue; }
+
+			_tinyengine_gl3_vertex2D* quad = _tinyengine_gl3_batchQuad(window, &te_gl3_state.spriteProgram, sprite->texture);
+			_tinyengine_gl3_writeQuad(quad, x0, y0, x1, y1, sprite->u0, sprite->v0, sprite->u1, sprite->v1, sprite->color);
+		}
+	}
+}
+
+//// Render targets
+
+// Offscreen framebuffers are pooled by size and format: a released target stays allocated and is handed to
+// the next request that matches, so a layer that redraws or a view that toggles between two sizes never
+// reallocates. Targets unused for TE_GL3_RENDER_TARGET_IDLE_FRAMES are deleted at the end of a frame.
+// Handles are slot + 1, 0 means none.
+
+static _tinyengine_gl3_renderTarget* _tinyengine_gl3_getRenderTarget(te_u32 handle) {
+	if(handle == 0 || handle > TE_GL3_MAX_RENDER_TARGETS) { return NULL; }
+	_tinyengine_gl3_renderTarget* target = &te_gl3_state.renderTargets[handle - 1];
+	return target->framebuffer ? target : NULL;
+}
+
+static void _tinyengine_gl3_deleteRenderTarget(_tinyengine_gl3_renderTarget* target) {
+	_tinyengine_gl3_forgetCapturedTexture(target->texture);
+	_tinyengine_gl3_setTextureOpaque(target->texture, TE_FALSE);
+	te_gl3.glDeleteFramebuffers(1, &target->framebuffer);
+	te_gl3.glDeleteTextures(1, &target->texture);
+	if(target->depthBuffer) { te_gl3.glDeleteRenderbuffers(1, &target->depthBuffer); }
+	memset(target, 0, sizeof(_tinyengine_gl3_renderTarget));
+}
+
+static te_bool_u8 _tinyengine_gl3_createRenderTarget(_tinyengine_gl3_renderTarget* target, te_u32 width, te_u32 height, te_u32 format) {
+	te_gl3.glGenFramebuffers(1, &target->framebuffer);
+	te_gl3.glGenTextures(1, &target->texture);
+	target->width = width;
+	target->height = height;
+	target->format = format;
+
+	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, target->texture);
+	te_gl3.glTexImage2D(TE_GL_TEXTURE_2D, 0, TE_GL_RGBA, width, height, 0, TE_GL_RGBA, TE_GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(TE_GL_TEXTURE_2D, TE_GL_TEXTURE_MIN_FILTER, TE_GL_LINEAR);
+	glTexParameteri(TE_GL_TEXTURE_2D, TE_GL_TEXTURE_MAG_FILTER, TE_GL_LINEAR);
+	glTexParameteri(TE_GL_TEXTURE_2D, TE_GL_TEXTURE_WRAP_S, TE_GL_CLAMP_TO_EDGE);
+	glTexParameteri(TE_GL_TEXTURE_2D, TE_GL_TEXTURE_WRAP_T, TE_GL_CLAMP_TO_EDGE);
+	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, 0);
+
+	te_gl3.glBindFramebuffer(TE_GL_FRAMEBUFFER, target->framebuffer);
+	te_gl3.glFramebufferTexture2D(TE_GL_FRAMEBUFFER, TE_GL_COLOR_ATTACHMENT0, TE_GL_TEXTURE_2D, target->texture, 0);
+	if(format == TE_RENDER_TARGET_COLOR_DEPTH) {
+		te_gl3.glGenRenderbuffers(1, &target->depthBuffer);
+		te_gl3.glBindRenderbuffer(TE_GL_RENDERBUFFER, target->depthBuffer);
+		te_gl3.glRenderbufferStorage(TE_GL_RENDERBUFFER, TE_GL_DEPTH_COMPONENT24, width, height);
+		te_gl3.glBindRenderbuffer(TE_GL_RENDERBUFFER, 0);
+		te_gl3.glFramebufferRenderbuffer(TE_GL_FRAMEBUFFER, TE_GL_DEPTH_ATTACHMENT, TE_GL_RENDERBUFFER, target->depthBuffer);
+	}
+	te_bool_u8 complete = te_gl3.glCheckFramebufferStatus(TE_GL_FRAMEBUFFER) == TE_GL_FRAMEBUFFER_COMPLETE;
+	te_gl3.glBindFramebuffer(TE_GL_FRAMEBUFFER, 0);
+	if(!complete) {
+		TE_ERROR("Render target %ux%u is incomplete!\n", width, height);
+		_tinyengine_gl3_deleteRenderTarget(target);
+		return TE_FALSE;
+	}
+
+	te_gl3_state.renderTargetsCreated++;
+	return TE_TRUE;
+}
+
+// A free target of this size and format, created when the pool has none. Leaves framebuffer 0 bound when it creates one.
+te_u32 _tinyengine_gl3_acquireRenderTarget(te_u32 width, te_u32 height, te_u32 format) {
+	if(width == 0 || height == 0) { return 0; }
+
+	_tinyengine_gl3_renderTarget* empty = NULL;
+	_tinyengine_gl3_renderTarget* oldest = NULL;
+	for(te_u32 i = 0; i < TE_GL3_MAX_RENDER_TARGETS; i++) {
+		_tinyengine_gl3_renderTarget* target = &te_gl3_state.renderTargets[i];
+		if(target->framebuffer == 0) {
+			if(empty == NULL) { empty = target; }
+			continue;
+		}
+		if(target->inUse) { continue; }
+		if(target->width == width && target->height == height && target->format == format) {
+			target->inUse = TE_TRUE;
+			return i + 1;
+		}
+		if(oldest == NULL || te_gl3_state.frameIndex - target->releasedFrame > te_gl3_state.frameIndex - oldest->releasedFrame) { oldest = target; }
+	}
+
+	// A full pool gives up the target that has been free the longest
+	if(empty == NULL && oldest != NULL) {
+		_tinyengine_gl3_deleteRenderTarget(oldest);
+		empty = oldest;
+	}
+	if(empty == NULL) { TE_ERROR("Too many render targets in use!\n"); return 0; }
+	if(!_tinyengine_gl3_createRenderTarget(empty, width, height, format)) { return 0; }
+
+	empty->inUse = TE_TRUE;
+	return (te_u32)(empty - te_gl3_state.renderTargets) + 1;
+}
+
+// Returns a target to the pool, its contents are undefined from here on
+void _tinyengine_gl3_releaseRenderTarget(te_u32 handle) {
+	_tinyengine_gl3_renderTarget* target = _tinyengine_gl3_getRenderTarget(handle);
+	if(target == NULL) { return; }
+	target->inUse = TE_FALSE;
+	target->releasedFrame = te_gl3_state.frameIndex;
+}
+
+// Deletes free targets released at least idleFrames ago, 0 deletes every free target
+void _tinyengine_gl3_trimRenderTargets(te_u32 idleFrames) {
+	for(te_u32 i = 0; i < TE_GL3_MAX_RENDER_TARGETS; i++) {
+		_tinyengine_gl3_renderTarget* target = &te_gl3_state.renderTargets[i];
+		if(target->framebuffer == 0 || target->inUse) { continue; }
+		if(te_gl3_state.frameIndex - target->releasedFrame >= idleFrames) { _tinyengine_gl3_deleteRenderTarget(target); }
+	}
+}
+
+//// Dynamic resolution
+
+// A window can render its frames into an offscreen target scaled between minScale and maxScale of the view,
+// which endFrame upscales to the back buffer. The scale follows the GPU time of the scene towards targetMs:
+// fill cost grows with the pixel count, so the scale moves by the square root of the time ratio, dropping
+// faster than it recovers and holding still within a dead band around the target. Without timer queries the
+// interval between frames is measured instead, which includes waiting on the swap. Projection and culling
+// keep working in view units. Text and cached layers are held back and drawn after the upscale, at native
+// resolution and on top of the frame. targetMs 0 turns it off.
+
+void _tinyengine_gl3_setDynamicResolution(tinyengine_windowContext* window, te_f32 targetMs, te_f32 minScale, te_f32 maxScale, te_u32 filter) {
+	_tinyengine_dynamicResolution* resolution = &window->render2D.resolution;
+	if(targetMs <= 0.0f) {
+		_tinyengine_gl3_releaseRenderTarget(resolution->target);
+		if(resolution->queries[0]) { te_gl3.glDeleteQueries(TE_RESOLUTION_QUERIES, resolution->queries); }
+		memset(resolution, 0, sizeof(_tinyengine_dynamicResolution));
+		return;
+	}
+
+	if(minScale <= 0.0f) { minScale = 0.25f; }
+	if(maxScale < minScale) { maxScale = minScale; }
+	if(resolution->targetMs <= 0.0f) {
+		resolution->scale = maxScale < 1.0f ? maxScale : 1.0f;
+		if(te_gl3_state.hasTimerQuery) { te_gl3.glGenQueries(TE_RESOLUTION_QUERIES, resolution->queries); }
+	}
+	resolution->targetMs = targetMs;
+	resolution->minScale = minScale;
+	resolution->maxScale = maxScale;
+	resolution->filter = filter;
+	if(resolution->sharpness == 0.0f) { resolution->sharpness = 0.5f; }
+	if(resolution->scale < minScale) { resolution->scale = minScale; }
+	if(resolution->scale > maxScale) { resolution->scale = maxScale; }
+
+	if(filter == TE_UPSCALE_SHARPEN && te_gl3_state.upscaleProgram.status == TE_GL3_PROGRAM_EMPTY) {
+		te_gl3_state.upscaleProgram.ready = &_tinyengine_gl3_upscaleProgramReady;
+		te_gl3_state.upscaleProgram.attributes = TE_GL3_VERTEX2D_ATTRIBUTES;
+		_tinyengine_gl3_submitProgram(&te_gl3_state.upscaleProgram,TE_GL3_SPRITE_VERTEX_SRC,TE_GL3_UPSCALE_FRAGMENT_SRC);
+	}
+}
+
+// Scale the current frame renders at, 1 when dynamic resolution is off
+te_f32 _tinyengine_gl3_getResolutionScale(tinyengine_windowContext* window) {
+	const _tinyengine_dynamicResolution* resolution = &window->render2D.resolution;
+	return resolution->targetMs > 0.0f ? resolution->scale : 1.0f;
+}
+
+static void _tinyengine_gl3_adjustResolution(_tinyengine_dynamicResolution* resolution, te_f32 ms) {
+	if(ms <= 0.0f) { return; }
+	resolution->frameMs = resolution->frameMs > 0.0f ? resolution->frameMs * 0.8f + ms * 0.2f : ms;
+
+	te_f32 ratio = resolution->targetMs / resolution->frameMs;
+	if(ratio > 0.9f && ratio < 1.2f) { return; }
+	te_f32 step = sqrtf(ratio);
+	if(step < 0.85f) { step = 0.85f; }
+	if(step > 1.05f) { step = 1.05f; }
+
+	te_f32 scale = resolution->scale * step;
+	resolution->scale = scale < resolution->minScale ? resolution->minScale : (scale > resolution->maxScale ? resolution->maxScale : scale);
+}
+
+// Called by startFrame, binds the offscreen target and starts timing. False when the frame draws to the window.
+te_bool_u8 _tinyengine_gl3_beginDynamicResolution(tinyengine_windowContext* window) {
+	_tinyengine_dynamicResolution* resolution = &window->render2D.resolution;
+	resolution->active = TE_FALSE;
+	if(resolution->targetMs <= 0.0f) { return TE_FALSE; }
+
+	te_u32 viewWidth = window->render2D.viewWidth, viewHeight = window->render2D.viewHeight;
+	if(viewWidth == 0 || viewHeight == 0) { return TE_FALSE; }
+
+	// Sized for the largest scale, so scale changes never reallocate. Depth is for the layered sprite pass.
+	te_u32 width = (te_u32) ceilf(viewWidth * resolution->maxScale);
+	te_u32 height = (te_u32) ceilf(viewHeight * resolution->maxScale);
+	const _tinyengine_gl3_renderTarget* target = _tinyengine_gl3_getRenderTarget(resolution->target);
+	if(target == NULL || target->width != width || target->height != height) {
+		_tinyengine_gl3_releaseRenderTarget(resolution->target);
+		resolution->target = _tinyengine_gl3_acquireRenderTarget(width, height, TE_RENDER_TARGET_COLOR_DEPTH);
+		target = _tinyengine_gl3_getRenderTarget(resolution->target);
+		if(target == NULL) {
+			_tinyengine_gl3_setDynamicResolution(window, 0.0f, 1.0f, 1.0f, TE_UPSCALE_BILINEAR);
+			return TE_FALSE;
+		}
+	}
+
+	if(!te_gl3_state.hasTimerQuery) {
+		te_f64 now = tinyengine_getTime();
+		if(resolution->lastFrameStart > 0.0) { _tinyengine_gl3_adjustResolution(resolution, (te_f32)((now - resolution->lastFrameStart) * 1000.0)); }
+		resolution->lastFrameStart = now;
+	}
+
+	resolution->renderWidth = (te_u32)(viewWidth * resolution->scale + 0.5f);
+	resolution->renderHeight = (te_u32)(viewHeight * resolution->scale + 0.5f);
+	if(resolution->renderWidth == 0) { resolution->renderWidth = 1; }
+	if(resolution->renderHeight == 0) { resolution->renderHeight = 1; }
+	if(resolution->renderWidth > width) { resolution->renderWidth = width; }
+	if(resolution->renderHeight > height) { resolution->renderHeight = height; }
+
+	te_gl3.glBindFramebuffer(TE_GL_FRAMEBUFFER, target->framebuffer);
+	glViewport(0, 0, resolution->renderWidth, resolution->renderHeight);
+
+	// A frame is skipped when every query is still in flight, the GPU is that far behind
+	if(te_gl3_state.hasTimerQuery && resolution->issued - resolution->collected < TE_RESOLUTION_QUERIES) {
+		te_gl3.glBeginQuery(TE_GL_TIME_ELAPSED, resolution->queries[resolution->issued % TE_RESOLUTION_QUERIES]);
+	}
+
+	te_gl3_state.overlay.quadCount = 0;
+	te_gl3_state.overlay.runCount = 0;
+	resolution->active = TE_TRUE;
+	return TE_TRUE;
+}
+
+// Where text and cached layers put a quad, the batch or the overlay of an offscreen frame. A cached layer
+// records at its own resolution, so draws into it always go to the batch.
+static _tinyengine_gl3_vertex2D* _tinyengine_gl3_overlayQuad(tinyengine_windowContext* window, _tinyengine_gl3_program* program, te_GLuint texture) {
+	if(!window->render2D.resolution.active || te_gl3_state.cachedLayerRecording.layer) { return _tinyengine_gl3_batchQuad(window, program, texture); }
+
+	_tinyengine_gl3_overlay* overlay = &te_gl3_state.overlay;
+	if(overlay->quadCount == overlay->quadCapacity) {
+		te_u32 capacity = overlay->quadCapacity ? overlay->quadCapacity * 2 : 256;
+		_tinyengine_gl3_vertex2D* vertices = realloc(overlay->vertices, (size_t) capacity * 4 * sizeof(_tinyengine_gl3_vertex2D));
+		if(vertices == NULL) { return NULL; }
+		overlay->vertices = vertices;
+		overlay->quadCapacity = capacity;
+	}
+
+	_tinyengine_gl3_overlayRun* run = overlay->runCount ? &overlay->runs[overlay->runCount - 1] : NULL;
+	if(run == NULL || run->program != program || run->texture != texture || run->worldSpace != window->render2D.worldSpace) {
+		if(overlay->runCount == overlay->runCapacity) {
+			te_u32 capacity = overlay->runCapacity ? overlay->runCapacity * 2 : 16;
+			_tinyengine_gl3_overlayRun* runs = realloc(overlay->runs, capacity * sizeof(_tinyengine_gl3_overlayRun));
+			if(runs == NULL) { return NULL; }
+			overlay->runs = runs;
+			overlay->runCapacity = capacity;
+		}
+		run = &overlay->runs[overlay->runCount++];
+		run->program = program;
+		run->texture = texture;
+		run->worldSpace = window->render2D.worldSpace;
+		run->firstQuad = overlay->quadCount;
+		run->quadCount = 0;
+	}
+
+	run->quadCount++;
+	return overlay->vertices + (size_t)(overlay->quadCount++) * 4;
+}
+
+// Switches space without recording it, the draws made here are not the application's
+static void _tinyengine_gl3_useSpace(tinyengine_windowContext* window, te_bool_u8 worldSpace) {
+	if(window->render2D.worldSpace == worldSpace) { return; }
+	_tinyengine_gl3_flushBatch();
+	window->render2D.worldSpace = worldSpace;
+	_tinyengine_gl3_applyProjection(window, worldSpace);
+}
+
+// Called by endFrame after the scene is flushed: upscale to the window, then the held back overlay
+void _tinyengine_gl3_resolveDynamicResolution(tinyengine_windowContext* window) {
+	_tinyengine_dynamicResolution* resolution = &window->render2D.resolution;
+	resolution->active = TE_FALSE;
+
+	if(te_gl3_state.hasTimerQuery) {
+		if(resolution->issued - resolution->collected < TE_RESOLUTION_QUERIES) {
+			te_gl3.glEndQuery(TE_GL_TIME_ELAPSED);
+			resolution->issued++;
+		}
+		while(resolution->collected != resolution->issued) {
+			te_GLuint query = resolution->queries[resolution->collected % TE_RESOLUTION_QUERIES];
+			te_GLuint available = 0;
+			te_gl3.glGetQueryObjectuiv(query, TE_GL_QUERY_RESULT_AVAILABLE, &available);
+			if(!available) { break; }
+			te_GLuint64 nanoseconds = 0;
+			te_gl3.glGetQueryObjectui64v(query, TE_GL_QUERY_RESULT, &nanoseconds);
+			_tinyengine_gl3_adjustResolution(resolution, (te_f32)(nanoseconds / 1e6));
+			resolution->collected++;
+		}
+	}
+
+	te_gl3.glBindFramebuffer(TE_GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, window->render2D.viewWidth, window->render2D.viewHeight);
+
+	te_bool_u8 worldSpace = window->render2D.worldSpace;
+	_tinyengine_gl3_useSpace(window, TE_FALSE);
+
+	// Rows count up from the bottom of the target, the top of the view is the last rendered row
+	const _tinyengine_gl3_renderTarget* target = _tinyengine_gl3_getRenderTarget(resolution->target);
+	te_f32 u1 = (te_f32) resolution->renderWidth / target->width;
+	te_f32 v0 = (te_f32) resolution->renderHeight / target->height;
+	_tinyengine_gl3_program* program = &te_gl3_state.spriteProgram;
+	if(resolution->filter == TE_UPSCALE_SHARPEN && _tinyengine_gl3_bindProgram(window, &te_gl3_state.upscaleProgram)) {
+		program = &te_gl3_state.upscaleProgram;
+		te_gl3.glUniform3f(te_gl3_state.upscaleLocation, 1.0f / target->width, 1.0f / target->height, resolution->sharpness);
+		te_gl3.glUniform3f(te_gl3_state.upscaleLimitLocation, u1, v0, 0.0f);
+	}
+
+	static const te_u8 white[4] = { 255, 255, 255, 255 };
+	glDisable(GL_BLEND);
+	_tinyengine_gl3_vertex2D* quad = _tinyengine_gl3_batchQuad(window, program, target->texture);
+	_tinyengine_gl3_writeQuad(quad, 0.0f, 0.0f, (te_f32) window->render2D.viewWidth, (te_f32) window->render2D.viewHeight,
+		0, _tinyengine_gl3_unorm16(v0), _tinyengine_gl3_unorm16(u1), 0, white);
+	_tinyengine_gl3_flushBatch();
+	glEnable(GL_BLEND);
+
+	_tinyengine_gl3_overlay* overlay = &te_gl3_state.overlay;
+	for(te_u32 i = 0; i < overlay->runCount; i++) {
+		const _tinyengine_gl3_overlayRun* run = &overlay->runs[i];
+		_tinyengine_gl3_useSpace(window, run->worldSpace);
+		for(te_u32 index = 0; index < run->quadCount; index++) {
+			quad = _tinyengine_gl3_batchQuad(window, run->program, run->texture);
+			memcpy(quad, overlay->vertices + (size_t)(run->firstQuad + index) * 4, 4 * sizeof(_tinyengine_gl3_vertex2D));
+		}
+	}
+	_tinyengine_gl3_flushBatch();
+	overlay->quadCount = 0;
+	overlay->runCount = 0;
+
+	_tinyengine_gl3_useSpace(window, worldSpace);
+}
+
+//// Cached layers
+
+// UI that rarely changes is drawn into a pooled texture once and composited as a single sprite each frame.
+//
+//   if(_tinyengine_gl3_beginCachedLayer(window, &hud, 320, 200, hash)) {
+//       ... the usual draw calls, in layer pixels from its top left ...
+//       _tinyengine_gl3_endCachedLayer(window, &hud);
+//   }
+//   _tinyengine_gl3_drawCachedLayer(window, &hud, x, y);
+//
+// begin only returns true when the layer has to be recorded again: on first use, after a resize or
+// _tinyengine_gl3_invalidateCachedLayer(), or when a non zero contentHash differs from the last recording
+// (_tinyengine_fnv1a64() over the state the panel shows is enough). The texture holds premultiplied
+// colors over transparent black, so the composite blends like the draws would have. Targets carry a depth
+// buffer so _tinyengine_gl3_endLayers() orders opaque sprites the same as on the window. Layers do not nest.
+// Command capture leaves out both the recording and the composite, so a running capture warns about them.
+
+// The frame's own target, the dynamic resolution one or the window
+static void _tinyengine_gl3_bindFrameTarget(tinyengine_windowContext* window) {
+	const _tinyengine_dynamicResolution* resolution = &window->render2D.resolution;
+	if(resolution->active) {
+		te_gl3.glBindFramebuffer(TE_GL_FRAMEBUFFER, _tinyengine_gl3_getRenderTarget(resolution->target)->framebuffer);
+		glViewport(0, 0, resolution->renderWidth, resolution->renderHeight);
+	} else {
+		te_gl3.glBindFramebuffer(TE_GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, window->render2D.viewWidth, window->render2D.viewHeight);
+	}
+}
+
+// True when the layer is recording, end it with _tinyengine_gl3_endCachedLayer()
+te_bool_u8 _tinyengine_gl3_beginCachedLayer(tinyengine_windowContext* window, _tinyengine_gl3_cachedLayer* layer, te_u32 width, te_u32 height, te_u64 contentHash) {
+	_tinyengine_gl3_layerRecording* recording = &te_gl3_state.cachedLayerRecording;
+	if(recording->layer) { TE_WARN("Cached layers do not nest\n"); return TE_FALSE; }
+	if(width == 0 || height == 0) { return TE_FALSE; }
+
+	te_bool_u8 resized = layer->width != width || layer->height != height || _tinyengine_gl3_getRenderTarget(layer->target) == NULL;
+	if(layer->valid && !resized && (contentHash == 0 || contentHash == layer->contentHash)) { return TE_FALSE; }
+
+	_tinyengine_gl3_flushBatch();
+	if(resized) {
+		_tinyengine_gl3_releaseRenderTarget(layer->target);
+		layer->target = _tinyengine_gl3_acquireRenderTarget(width, height, TE_RENDER_TARGET_COLOR_DEPTH);
+		if(layer->target == 0) {
+			layer->valid = TE_FALSE;
+			_tinyengine_gl3_bindFrameTarget(window); // creating a target unbinds the frame's
+			return TE_FALSE;
+		}
+	}
+	layer->width = width;
+	layer->height = height;
+	layer->contentHash = contentHash;
+	layer->valid = TE_TRUE;
+	layer->redraws++;
+
+	recording->layer = layer;
+	recording->viewWidth = window->render2D.viewWidth;
+	recording->viewHeight = window->render2D.viewHeight;
+	recording->worldSpace = window->render2D.worldSpace;
+	recording->scissor = glIsEnabled(GL_SCISSOR_TEST);
+	_tinyengine_gl3_warnNotCaptured(TE_CAPTURE_SKIPPED_CACHED_LAYERS, "Cached layers");
+
+	te_gl3.glBindFramebuffer(TE_GL_FRAMEBUFFER, _tinyengine_gl3_getRenderTarget(layer->target)->framebuffer);
+	glViewport(0, 0, width, height);
+	glDisable(GL_SCISSOR_TEST);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+	// Screen space over the layer, rows still count down from the top. World space puts the camera over it.
+	window->render2D.viewWidth = width;
+	window->render2D.viewHeight = height;
+	window->render2D.worldSpace = TE_FALSE;
+	_tinyengine_gl3_applyProjection(window, TE_FALSE);
+	_tinyengine_gl3_applyProjection(window, TE_TRUE);
+	return TE_TRUE;
+}
+
+// Ends the recording and puts the window back the way begin found it
+void _tinyengine_gl3_endCachedLayer(tinyengine_windowContext* window, _tinyengine_gl3_cachedLayer* layer) {
+	_tinyengine_gl3_layerRecording* recording = &te_gl3_state.cachedLayerRecording;
+	if(layer == NULL || recording->layer != layer) { return; }
+
+	_tinyengine_gl3_flushBatch();
+	window->render2D.viewWidth = recording->viewWidth;
+	window->render2D.viewHeight = recording->viewHeight;
+	window->render2D.worldSpace = recording->worldSpace;
+	_tinyengine_gl3_applyProjection(window, TE_FALSE);
+	_tinyengine_gl3_applyProjection(window, TE_TRUE);
+	_tinyengine_gl3_bindFrameTarget(window);
+	if(recording->scissor) { glEnable(GL_SCISSOR_TEST); }
+	recording->layer = NULL;
+}
+
+void _tinyengine_gl3_invalidateCachedLayer(_tinyengine_gl3_cachedLayer* layer) {
+	layer->valid = TE_FALSE;
+}
+
+// One sprite at x, y in the current space, nothing until the layer has been recorded
+void _tinyengine_gl3_drawCachedLayer(tinyengine_windowContext* window, const _tinyengine_gl3_cachedLayer* layer, te_f32 x, te_f32 y) {
+	const _tinyengine_gl3_renderTarget* target = _tinyengine_gl3_getRenderTarget(layer->target);
+	if(!layer->valid || target == NULL) { return; }
+	_tinyengine_gl3_warnNotCaptured(TE_CAPTURE_SKIPPED_CACHED_LAYERS, "Cached layers");
+	if(!_tinyengine_gl3_isVisible(window, x, y, x + layer->width, y + layer->height)) { return; }
+
+	// Rows count up from the bottom of the target, like the dynamic resolution target
+	static const te_u8 white[4] = { 255, 255, 255, 255 };
+	_tinyengine_gl3_vertex2D* quad = _tinyengine_gl3_overlayQuad(window, &te_gl3_state.spriteProgram, target->texture);
+	if(quad == NULL) { return; }
+	_tinyengine_gl3_writeQuad(quad, x, y, x + layer->width, y + layer->height, 0, 65535, 65535, 0, white);
+}
+
+// Gives the texture back to the pool, the layer records again on its next begin
+void _tinyengine_gl3_destroyCachedLayer(_tinyengine_gl3_cachedLayer* layer) {
+	_tinyengine_gl3_releaseRenderTarget(layer->target);
+	memset(layer, 0, sizeof(_tinyengine_gl3_cachedLayer));
+}
+
+// A whole string is one batch, the glyphs all come from the font texture
+void _tinyengine_gl3_drawText(tinyengine_windowContext* window, _tinyengine_gl3_bitmapGlyphCache* font, const char* text, te_f32 x, te_f32 y, te_f32 scale, te_v3_f32 color) {
+	if(te_gl3_state.capture.file) {
+		te_u32 length = (te_u32) strlen(text);
+		_tinyengine_captureWord words[8] = { { .u = _tinyengine_gl3_captureFont(font) }, { .f = x }, { .f = y }, { .f = scale }, { .f = color.x }, { .f = color.y }, { .f = color.z }, { .u = length } };
+		_tinyengine_gl3_captureCommand(TE_CAPTURE_TEXT, window, words, text, length);
+	}
+
+	te_u8 tint[4] = { _tinyengine_gl3_unorm8(color.x), _tinyengine_gl3_unorm8(color.y), _tinyengine_gl3_unorm8(color.z), 255 };
+	te_f32 ipw = 1.0f / font->resolution;
+	te_f32 iph = 1.0f / font->resolution;
+
+	for(const char* c = text; *c != '\0'; c++) {
+		const _tinyengine_gl3_bitmapBakedCharcter *b = font->characterData + (*c >= 32 && *c <= 126 ? *c-32 : ' '-32);
+
+		int round_x = (int) floor((x + (b->xoff * scale)) + 0.5f);
+		int round_y = (int) floor((y + (b->yoff * scale)) + 0.5f);
+
+		te_f32 x0 = round_x;
+		te_f32 y0 = round_y;
+		te_f32 x1 = round_x + ((b->x1 - b->x0) * scale);
+		te_f32 y1 = round_y + ((b->y1 - b->y0) * scale);
+
+		x += b->xadvance * scale;
+
+		_tinyengine_gl3_vertex2D* quad = _tinyengine_gl3_overlayQuad(window, &te_gl3_state.textProgram, font->textureID);
+		if(quad == NULL) { return; }
+		_tinyengine_gl3_writeQuad(quad, x0, y0, x1, y1,
+			_tinyengine_gl3_unorm16(b->x0 * ipw), _tinyengine_gl3_unorm16(b->y0 * iph), _tinyengine_gl3_unorm16(b->x1 * ipw), _tinyengine_gl3_unorm16(b->y1 * iph), tint);
+	}
+}
+
+//// Retained scene
+
+// Optional retained layer for mostly static 2D content. Nodes keep their vertices resident in one buffer
+// per scene. A change bumps the node's version and queues it, the next draw rebuilds only queued nodes and
+// uploads their merged vertex ranges. When nothing changed, a frame is a few multi draw calls.
+// Node handles are (generation << 16) | (slot + 1), 0 is never a valid node.
+
+#include <math.h> // cosf(); sinf(); floorf();
+
+static const char* TE_GL3_SCENE_VERTEX_SRC =
+		"in vec2 position;                                                       \n"
+		"in vec2 uv;                                                             \n"
+		"in vec4 tint;                                                           \n"
+		"in float mode;                                                          \n"
+		"out vec2 tex_cords;                                                     \n"
+		"out vec4 vertex_color;                                                  \n"
+		"out float alpha_only;                                                   \n"
+		"                                                                        \n"
+		TE_GL3_VIEW_UNIFORM
+		"                                                                        \n"
+		"void main()                                                             \n"
+		"{                                                                       \n"
+		"    tex_cords = uv;                                                     \n"
+		"    vertex_color = vec4(tint.rgb * tint.a, tint.a);                     \n"
+		"    alpha_only = mode;                                                  \n"
+		"    gl_Position = vec4(position.x, position.y, 1.0, 1.0) * projection;  \n"
+		"}                                                                       \n"
+;
+
+static const char* TE_GL3_SCENE_FRAGMENT_SRC =
+		"in vec2 tex_cords;                                                      \n"
+		"in vec4 vertex_color;                                                   \n"
+		"in float alpha_only;                                                    \n"
+		"out vec4 color;                                                         \n"
+		"                                                                        \n"
+		"uniform sampler2D texture_bank;                                         \n"
+		"                                                                        \n"
+		"void main()                                                             \n"
+		"{                                                                       \n"
+		"    vec4 sample = texture(texture_bank, tex_cords);                     \n"
+		"    color = mix(sample, vec4(sample.a), alpha_only) * vertex_color;     \n"
+		"}                                                                       \n"
+;
+
+static const char* const TE_GL3_SCENE_ATTRIBUTES[] = { "position", "uv", "tint", "mode", NULL };
+
+#define TE_GL3_SCENE_GROUP 1
+#define TE_GL3_SCENE_RECT 2
+#define TE_GL3_SCENE_SPRITE 3
+#define TE_GL3_SCENE_TEXT 4
+
+#define TE_GL3_MAX_SCENE_NODES 0xFFFF
+
+// Dirty ranges closer than this many vertices are uploaded as one
+#ifndef TE_GL3_SCENE_MERGE_GAP
+	#define TE_GL3_SCENE_MERGE_GAP 256
+#endif
 
-	TE_LOG("loaded openGL 3.0 render backend.\n");
+typedef struct _tinyengine_gl3_sceneVertex_t {
+	te_f32 x, y;
+	te_f32 u, v;
+	te_u8 color[4];
+	te_f32 mode; // 1 samples alpha only, for glyphs
+} _tinyengine_gl3_sceneVertex;
 
-	TE_LOG("OpenGL Version: %s\n",te_glGetString(TE_GL_VERSION));
-	TE_LOG("OpenGL Shader Language Version: %s\n",te_glGetString(TE_GL_SHADING_LANGUAGE_VERSION));
-	TE_LOG("OpenGL Vendor: %s\n",te_glGetString(TE_GL_VENDOR));
-	TE_LOG("OpenGL Renderer: %s\n",te_glGetString(TE_GL_RENDERER));
+typedef struct _tinyengine_gl3_sceneNode_t {
+	te_u8 type; // 0 for a free slot
+	te_bool_u8 visible;
+	te_bool_u8 queued;
+	te_u16 generation;
 
-	// TODO: Load opengl functions
-	_TE_GL_FUNCTION_LOAD(glGetError);
-	_TE_GL_FUNCTION_LOAD(glCreateShader);
-	_TE_GL_FUNCTION_LOAD(glCompileShader);
-	_TE_GL_FUNCTION_LOAD(glGetShaderiv);
-	_TE_GL_FUNCTION_LOAD(glGetShaderInfoLog);
-	_TE_GL_FUNCTION_LOAD(glBindAttribLocation);
-	_TE_GL_FUNCTION_LOAD(glCreateProgram);
-	_TE_GL_FUNCTION_LOAD(glAttachShader);
-	_TE_GL_FUNCTION_LOAD(glLinkProgram);
-	_TE_GL_FUNCTION_LOAD(glGetProgramiv);
-	_TE_GL_FUNCTION_LOAD(glGetProgramInfoLog);
-	_TE_GL_FUNCTION_LOAD(glDeleteShader);
-	_TE_GL_FUNCTION_LOAD(glDeleteProgram);
-	_TE_GL_FUNCTION_LOAD(glShaderSource);
+	// Slots + 1, 0 for none
+	te_u32 parent;
+	te_u32 firstChild;
+	te_u32 nextSibling;
 
-	_TE_GL_FUNCTION_LOAD(glUseProgram);
-	_TE_GL_FUNCTION_LOAD(glBindTexture);
-	_TE_GL_FUNCTION_LOAD(glBindVertexArray);
-	_TE_GL_FUNCTION_LOAD(glUniform4f);
-	_TE_GL_FUNCTION_LOAD(glBindBuffer);
-	_TE_GL_FUNCTION_LOAD(glBufferSubData);
-	_TE_GL_FUNCTION_LOAD(glDrawArrays);
-	_TE_GL_FUNCTION_LOAD(glGetUniformLocation);
+	te_i32 layer;
+	te_u32 sequence; // creation order, draw order within a layer
 
-	_TE_GL_FUNCTION_LOAD(glGenVertexArrays);
-	_TE_GL_FUNCTION_LOAD(glGenBuffers);
-	_TE_GL_FUNCTION_LOAD(glBufferData);
-	_TE_GL_FUNCTION_LOAD(glVertexAttribPointer);
-	_TE_GL_FUNCTION_LOAD(glEnableVertexAttribArray);
+	te_f32 x, y;
+	te_f32 scaleX, scaleY;
+	te_f32 rotation; // radians
 
-	_TE_GL_FUNCTION_LOAD(glUniformMatrix4fv);
+	te_u32 version; // bumped on every change
+	te_u32 builtVersion; // version the resident vertices were built from
 
-	_TE_GL_FUNCTION_LOAD(glUniform1i);
+	te_f32 width, height;
+	te_v4_f32 color;
+	te_GLuint texture;
+	te_f32 u0, v0, u1, v1;
+	_tinyengine_gl3_bitmapGlyphCache* font;
+	char* text;
 
-	_TE_GL_FUNCTION_LOAD(glGenTextures);
-	_TE_GL_FUNCTION_LOAD(glTexImage2D);
-	_TE_GL_FUNCTION_LOAD(glGenerateMipmap);
+	te_u32 firstVertex;
+	te_u32 vertexCount;
+	te_u32 vertexCapacity;
+} _tinyengine_gl3_sceneNode;
 
-	_TE_GL_FUNCTION_LOAD(glActiveTexture);
+typedef struct _tinyengine_gl3_sceneBatch_t {
+	te_GLuint texture;
+	te_u32 firstRange;
+	te_u32 rangeCount;
+} _tinyengine_gl3_sceneBatch;
+
+typedef struct _tinyengine_gl3_sceneOrder_t {
+	te_i32 layer;
+	te_u32 sequence;
+	te_u32 slot;
+} _tinyengine_gl3_sceneOrder;
+
+typedef struct _tinyengine_gl3_sceneRange_t {
+	te_u32 first;
+	te_u32 count;
+} _tinyengine_gl3_sceneRange;
+
+typedef struct _tinyengine_gl3_scene_t {
+	_tinyengine_gl3_sceneNode* nodes;
+	te_u32 nodeCapacity;
+	te_u32 nodeCount; // slots ever handed out
+	te_u32* freeSlots;
+	te_u32 freeLength;
+	te_u32 liveNodes;
+	te_u32 nextSequence;
+
+	te_u32* queue; // slots with changes not yet built
+	te_u32 queueLength;
+
+	// CPU copy of the vertex buffer, ranges of removed or moved nodes are garbage until compaction
+	_tinyengine_gl3_sceneVertex* vertices;
+	te_u32 vertexCount;
+	te_u32 vertexCapacity;
+	te_u32 garbageVertices;
+	te_bool_u8 fullUpload;
+
+	// Draw list, rebuilt only when nodes are added, removed, reordered or relocated
+	te_bool_u8 structureDirty;
+	_tinyengine_gl3_sceneBatch* batches;
+	te_u32 batchCount;
+	te_GLint* rangeFirsts;
+	te_GLsizei* rangeCounts;
+	te_u32 rangeCount;
+
+	te_GLuint vao;
+	te_GLuint vbo;
+	te_u32 gpuVertexCapacity;
+
+	// Screen area covered by changed nodes before and after the change, reported as window damage
+	_tinyengine_damageRect damage;
+
+	// Last draw, for benchmarks
+	te_u32 nodesRebuilt;
+	te_u32 uploadRanges;
+	size_t bytesUploaded;
+	te_u32 drawCalls;
+} _tinyengine_gl3_scene;
+
+_tinyengine_gl3_sceneNode* _tinyengine_gl3_lookupSceneNode(_tinyengine_gl3_scene* scene, te_u32 node) {
+	te_u32 slot = (node & 0xFFFF) - 1;
+	if(node == 0 || slot >= scene->nodeCount) { return NULL; }
+	_tinyengine_gl3_sceneNode* entry = &scene->nodes[slot];
+	if(entry->type == 0 || entry->generation != (node >> 16)) { return NULL; }
+	return entry;
+}
 
-	_TE_GL_FUNCTION_LOAD(glUniform3f);
+// Bounds of the node's resident vertices, where it was last drawn
+void _tinyengine_gl3_damageSceneNode(_tinyengine_gl3_scene* scene, const _tinyengine_gl3_sceneNode* entry) {
+	if(entry->builtVersion == 0 || entry->vertexCount == 0) { return; }
+	const _tinyengine_gl3_sceneVertex* vertex = scene->vertices + entry->firstVertex;
+	te_f32 x0 = vertex->x, y0 = vertex->y, x1 = vertex->x, y1 = vertex->y;
+	for(te_u32 i = 1; i < entry->vertexCount; i++) {
+		vertex++;
+		if(vertex->x < x0) { x0 = vertex->x; }
+		if(vertex->y < y0) { y0 = vertex->y; }
+		if(vertex->x > x1) { x1 = vertex->x; }
+		if(vertex->y > y1) { y1 = vertex->y; }
+	}
+	_tinyengine_damageRect rect = { (te_i32) floorf(x0), (te_i32) floorf(y0), (te_i32) ceilf(x1), (te_i32) ceilf(y1) };
+	_tinyengine_unionDamageRect(&scene->damage, &rect);
+}
 
-	return TE_TRUE;
+void _tinyengine_gl3_queueSceneNode(_tinyengine_gl3_scene* scene, te_u32 slot) {
+	_tinyengine_gl3_sceneNode* entry = &scene->nodes[slot];
+	entry->version++;
+	if(entry->queued) { return; }
+	entry->queued = TE_TRUE;
+	scene->queue[scene->queueLength++] = slot;
 }
 
+// Transform and visibility are inherited, so those changes rebuild the whole subtree
+void _tinyengine_gl3_queueSceneSubtree(_tinyengine_gl3_scene* scene, te_u32 slot) {
+	_tinyengine_gl3_queueSceneNode(scene, slot);
+	for(te_u32 child = scene->nodes[slot].firstChild; child; child = scene->nodes[child - 1].nextSibling) {
+		_tinyengine_gl3_queueSceneSubtree(scene, child - 1);
+	}
+}
 
-te_bool_u8 _tinyengine_gl3_compileShader(te_GLuint* program, const char* vertexSrc, const char* fragmentSrc) {
+_tinyengine_gl3_scene* _tinyengine_gl3_createScene() {
+	_tinyengine_gl3_scene* scene = malloc(sizeof(_tinyengine_gl3_scene));
+	if(scene == NULL) { return NULL; }
+	memset(scene, 0, sizeof(_tinyengine_gl3_scene));
 
-	te_GLuint vertex, fragment;
-	te_GLint success ;
-	char infoLog[512];
+	if(te_gl3_state.sceneProgram.status == TE_GL3_PROGRAM_EMPTY) {
+		te_gl3_state.sceneProgram.ready = &_tinyengine_gl3_texturedProgramReady;
+		te_gl3_state.sceneProgram.attributes = TE_GL3_SCENE_ATTRIBUTES;
+		_tinyengine_gl3_submitProgram(&te_gl3_state.sceneProgram,TE_GL3_SCENE_VERTEX_SRC,TE_GL3_SCENE_FRAGMENT_SRC);
+	}
 
-	// vertex Shader
-	vertex = te_gl3.glCreateShader(TE_GL_VERTEX_SHADER);
-	te_gl3.glShaderSource(vertex, 1, &vertexSrc, NULL);
-	te_gl3.glCompileShader(vertex);
-	// print compile errors if any
-	te_gl3.glGetShaderiv(vertex, TE_GL_COMPILE_STATUS, &success);
-	if(success == TE_GL_FALSE) {
-		te_gl3.glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-		TE_ERROR("Vertex shader compilation failed: %s\n",infoLog);
-		return TE_FALSE;
-	};
+	// Rects sample a white texel so every node type shares one program
+	if(te_gl3_state.whiteTexture == 0) {
+		const te_u8 pixel[4] = { 255, 255, 255, 255 };
+		te_gl3.glGenTextures(1, &te_gl3_state.whiteTexture);
+		te_gl3.glBindTexture(TE_GL_TEXTURE_2D, te_gl3_state.whiteTexture);
+		te_gl3.glTexImage2D(TE_GL_TEXTURE_2D, 0, TE_GL_RGBA, 1, 1, 0, TE_GL_RGBA, TE_GL_UNSIGNED_BYTE, pixel);
+		glTexParameteri(TE_GL_TEXTURE_2D, TE_GL_TEXTURE_MIN_FILTER, TE_GL_LINEAR);
+		te_gl3.glBindTexture(TE_GL_TEXTURE_2D, 0);
+	}
 
-	// fragment Shader
-	fragment = te_gl3.glCreateShader(TE_GL_FRAGMENT_SHADER);
-	te_gl3.glShaderSource(fragment, 1, &fragmentSrc, NULL);
-	te_gl3.glCompileShader(fragment);
-	// print compile errors if any
-	te_gl3.glGetShaderiv(fragment, TE_GL_COMPILE_STATUS, &success);
-	if(success == TE_GL_FALSE) {
-		te_gl3.glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-		TE_ERROR("Fragment shader compilation failed: %s\n",infoLog);
-		return TE_FALSE;
-	};
+	te_gl3.glGenVertexArrays(1, &scene->vao);
+	te_gl3.glGenBuffers(1, &scene->vbo);
+	te_gl3.glBindVertexArray(scene->vao);
+	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, scene->vbo);
+	te_gl3.glEnableVertexAttribArray(0);
+	te_gl3.glVertexAttribPointer(0, 2, TE_GL_FLOAT, TE_GL_FALSE, sizeof(_tinyengine_gl3_sceneVertex), (const void*) 0);
+	te_gl3.glEnableVertexAttribArray(1);
+	te_gl3.glVertexAttribPointer(1, 2, TE_GL_FLOAT, TE_GL_FALSE, sizeof(_tinyengine_gl3_sceneVertex), (const void*) (2 * sizeof(te_f32)));
+	te_gl3.glEnableVertexAttribArray(2);
+	te_gl3.glVertexAttribPointer(2, 4, TE_GL_UNSIGNED_BYTE, TE_GL_TRUE, sizeof(_tinyengine_gl3_sceneVertex), (const void*) (4 * sizeof(te_f32)));
+	te_gl3.glEnableVertexAttribArray(3);
+	te_gl3.glVertexAttribPointer(3, 1, TE_GL_FLOAT, TE_GL_FALSE, sizeof(_tinyengine_gl3_sceneVertex), (const void*) (4 * sizeof(te_f32) + 4));
+	te_gl3.glBindVertexArray(0);
+	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, 0);
 
-	// shader Program
-	*program = te_gl3.glCreateProgram();
-	te_gl3.glBindAttribLocation(*program,0,"vertex");
-	te_gl3.glAttachShader(*program, vertex);
-	te_gl3.glAttachShader(*program, fragment);
-	te_gl3.glLinkProgram(*program);
-	// print linking errors if any
-	te_gl3.glGetProgramiv(*program, TE_GL_LINK_STATUS, &success);
-	if(success == TE_GL_FALSE) {
-		te_gl3.glGetProgramInfoLog(*program, 512, NULL, infoLog);
-		TE_ERROR("shader program link failed: %s\n",infoLog);
+	return scene;
+}
 
-		// TODO: Do I need to delete this if shader failure is a critical error?
-		te_gl3.glDeleteShader(vertex);
-		te_gl3.glDeleteShader(fragment);
-		te_gl3.glDeleteProgram(*program);
+void _tinyengine_gl3_destroyScene(_tinyengine_gl3_scene* scene) {
+	if(scene == NULL) { return; }
+	for(te_u32 slot = 0; slot < scene->nodeCount; slot++) { free(scene->nodes[slot].text); }
+	te_gl3.glDeleteVertexArrays(1, &scene->vao);
+	te_gl3.glDeleteBuffers(1, &scene->vbo);
+	free(scene->nodes);
+	free(scene->freeSlots);
+	free(scene->queue);
+	free(scene->vertices);
+	free(scene->batches);
+	free(scene->rangeFirsts);
+	free(scene->rangeCounts);
+	free(scene);
+}
 
-		*program = 0;
+te_u32 _tinyengine_gl3_addSceneNode(_tinyengine_gl3_scene* scene, te_u32 parent, te_u8 type, te_f32 x, te_f32 y) {
+	_tinyengine_gl3_sceneNode* parentEntry = NULL;
+	if(parent != 0 && (parentEntry = _tinyengine_gl3_lookupSceneNode(scene, parent)) == NULL) { return 0; }
 
-		return TE_FALSE;
+	te_u32 slot;
+	if(scene->freeLength > 0) {
+		slot = scene->freeSlots[--scene->freeLength];
+	} else {
+		if(scene->nodeCount == TE_GL3_MAX_SCENE_NODES) { TE_ERROR("Too many scene nodes!\n"); return 0; }
+		if(scene->nodeCount == scene->nodeCapacity) {
+			te_u32 capacity = scene->nodeCapacity ? scene->nodeCapacity * 2 : 256;
+			_tinyengine_gl3_sceneNode* nodes = realloc(scene->nodes, capacity * sizeof(_tinyengine_gl3_sceneNode));
+			te_u32* freeSlots = realloc(scene->freeSlots, capacity * sizeof(te_u32));
+			te_u32* queue = realloc(scene->queue, capacity * sizeof(te_u32));
+			if(nodes) { scene->nodes = nodes; }
+			if(freeSlots) { scene->freeSlots = freeSlots; }
+			if(queue) { scene->queue = queue; }
+			if(!nodes || !freeSlots || !queue) { return 0; }
+			memset(scene->nodes + scene->nodeCapacity, 0, (capacity - scene->nodeCapacity) * sizeof(_tinyengine_gl3_sceneNode));
+			scene->nodeCapacity = capacity;
+		}
+		slot = scene->nodeCount++;
 	}
 
-	// delete the shaders as they're linked into our program now and no longer necessery
-	te_gl3.glDeleteShader(vertex);
-	te_gl3.glDeleteShader(fragment);
+	_tinyengine_gl3_sceneNode* entry = &scene->nodes[slot];
+	te_u16 generation = entry->generation == 0 || entry->generation == 0xFFFF ? 1 : entry->generation + 1;
+	te_bool_u8 queued = entry->queued; // a removed node can still sit in the queue, it must not be queued twice
+	memset(entry, 0, sizeof(_tinyengine_gl3_sceneNode));
+	entry->generation = generation;
+	entry->queued = queued;
+	entry->type = type;
+	entry->visible = TE_TRUE;
+	entry->sequence = scene->nextSequence++;
+	entry->x = x;
+	entry->y = y;
+	entry->scaleX = 1.0f;
+	entry->scaleY = 1.0f;
+	entry->color = (te_v4_f32){1.0f, 1.0f, 1.0f, 1.0f};
+
+	if(parentEntry) {
+		entry->parent = (parentEntry - scene->nodes) + 1;
+		entry->nextSibling = parentEntry->firstChild;
+		parentEntry->firstChild = slot + 1;
+	}
 
-	return TE_TRUE;
+	scene->liveNodes++;
+	scene->structureDirty = TE_TRUE;
+	_tinyengine_gl3_queueSceneNode(scene, slot);
+
+	return ((te_u32) generation << 16) | (slot + 1);
 }
 
-te_GLuint _tinyengine_gl3_loadTextureRGB(tinyengine_windowContext* window, te_u32 width, te_u32 height, te_u32 channels, te_u8* data) {
+// Pure transform node to move, scale or hide children together
+te_u32 _tinyengine_gl3_addSceneGroup(_tinyengine_gl3_scene* scene, te_u32 parent, te_f32 x, te_f32 y) {
+	return _tinyengine_gl3_addSceneNode(scene, parent, TE_GL3_SCENE_GROUP, x, y);
+}
 
-	if(!data) { return 0; }
-	if(channels > 4 || channels < 3) { return 0; }
-	if(width == 0 || height == 0) { return 0; }
+te_u32 _tinyengine_gl3_addSceneRectangle(_tinyengine_gl3_scene* scene, te_u32 parent, te_f32 x, te_f32 y, te_f32 width, te_f32 height, te_v4_f32 color) {
+	te_u32 node = _tinyengine_gl3_addSceneNode(scene, parent, TE_GL3_SCENE_RECT, x, y);
+	if(node == 0) { return 0; }
+	_tinyengine_gl3_sceneNode* entry = _tinyengine_gl3_lookupSceneNode(scene, node);
+	entry->width = width;
+	entry->height = height;
+	entry->color = color;
+	entry->texture = te_gl3_state.whiteTexture;
+	return node;
+}
 
-	te_GLuint texture;
-	te_gl3.glGenTextures(1, &texture);
-	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, texture);
-	te_gl3.glTexImage2D(TE_GL_TEXTURE_2D, 0, TE_GL_RGBA, width, height, 0, channels == 4 ? TE_GL_RGBA :  TE_GL_RGB, GL_UNSIGNED_BYTE, data);
-	te_gl3.glGenerateMipmap(TE_GL_TEXTURE_2D);
-	return texture;
+// Same texture coordinates as _tinyengine_gl3_drawSprite(), scale with _tinyengine_gl3_setSceneNodeScale()
+te_u32 _tinyengine_gl3_addSceneSprite(_tinyengine_gl3_scene* scene, te_u32 parent, te_GLuint texture, te_f32 x, te_f32 y, te_f32 width, te_f32 height, te_f32 tex_width, te_f32 tex_height, te_f32 tex_x, te_f32 tex_y) {
+	te_u32 node = _tinyengine_gl3_addSceneNode(scene, parent, TE_GL3_SCENE_SPRITE, x, y);
+	if(node == 0) { return 0; }
+	_tinyengine_gl3_sceneNode* entry = _tinyengine_gl3_lookupSceneNode(scene, node);
+	entry->width = width;
+	entry->height = height;
+	entry->texture = texture;
+	entry->u0 = tex_x / tex_width;
+	entry->v0 = -tex_y / tex_height;
+	entry->u1 = entry->u0 + (width / tex_width);
+	entry->v1 = entry->v0 - (height / tex_height);
+	return node;
 }
 
-void _tinyengine_gl3_projectionOrtho(te_GLfloat matrix[16], te_f32 left, te_f32 right, te_f32 bottom, te_f32 top, te_f32 _near, te_f32 _far){
+void _tinyengine_gl3_setSceneText(_tinyengine_gl3_scene* scene, te_u32 node, const char* text);
+
+te_u32 _tinyengine_gl3_addSceneText(_tinyengine_gl3_scene* scene, te_u32 parent, _tinyengine_gl3_bitmapGlyphCache* font, const char* text, te_f32 x, te_f32 y, te_f32 scale, te_v3_f32 color) {
+	te_u32 node = _tinyengine_gl3_addSceneNode(scene, parent, TE_GL3_SCENE_TEXT, x, y);
+	if(node == 0) { return 0; }
+	_tinyengine_gl3_sceneNode* entry = _tinyengine_gl3_lookupSceneNode(scene, node);
+	entry->font = font;
+	entry->texture = font->textureID;
+	entry->scaleX = scale;
+	entry->scaleY = scale;
+	entry->color = (te_v4_f32){color.x, color.y, color.z, 1.0f};
+	_tinyengine_gl3_setSceneText(scene, node, text);
+	return node;
+}
 
-	matrix[0] = 2/(right-left);
-	matrix[1] = 0;
-	matrix[2] = 0;
-	matrix[3] = -(right+left)/(right-left);
+void _tinyengine_gl3_freeSceneSubtree(_tinyengine_gl3_scene* scene, te_u32 slot) {
+	_tinyengine_gl3_sceneNode* entry = &scene->nodes[slot];
+	for(te_u32 child = entry->firstChild; child;) {
+		te_u32 next = scene->nodes[child - 1].nextSibling;
+		_tinyengine_gl3_freeSceneSubtree(scene, child - 1);
+		child = next;
+	}
 
-	matrix[4] = 0;
-	matrix[5] = 2/(top-bottom);
-	matrix[6] = 0;
-	matrix[7] = -(top+bottom)/(top-bottom);
+	// A queued slot is skipped when the queue is built, its type is 0 by then
+	_tinyengine_gl3_damageSceneNode(scene, entry);
+	scene->garbageVertices += entry->vertexCapacity;
+	free(entry->text);
+	te_u16 generation = entry->generation;
+	te_bool_u8 queued = entry->queued;
+	memset(entry, 0, sizeof(_tinyengine_gl3_sceneNode));
+	entry->generation = generation;
+	entry->queued = queued;
+	scene->freeSlots[scene->freeLength++] = slot;
+	scene->liveNodes--;
+}
 
-	matrix[8] = 0;
-	matrix[9] = 0;
-	matrix[10] = -2/(_far-_near);
-	matrix[11] = -(_far+_near)/(_far-_near);
+// Removes the node and all of its children
+void _tinyengine_gl3_removeSceneNode(_tinyengine_gl3_scene* scene, te_u32 node) {
+	_tinyengine_gl3_sceneNode* entry = _tinyengine_gl3_lookupSceneNode(scene, node);
+	if(entry == NULL) { return; }
+	te_u32 slot = entry - scene->nodes;
 
-	matrix[12] = 0;
-	matrix[13] = 0;
-	matrix[14] = 0;
-	matrix[15] = 1;
+	if(entry->parent) {
+		te_u32* link = &scene->nodes[entry->parent - 1].firstChild;
+		while(*link != slot + 1) { link = &scene->nodes[*link - 1].nextSibling; }
+		*link = entry->nextSibling;
+	}
+
+	_tinyengine_gl3_freeSceneSubtree(scene, slot);
+	scene->structureDirty = TE_TRUE;
 }
 
-void _tinyengine_gl3_updateView(tinyengine_windowContext* window, te_u32 width, te_u32 height) {
-	_tinyengine_gl3_projectionOrtho(window->render2D.projectionMatrix,0.0f,(te_f32)width,(te_f32)height,0.0f,-1.0f,1.0f);
-	te_gl3.glUseProgram(window->render2D.flatShader);
-	te_gl3.glUniformMatrix4fv(te_gl3.glGetUniformLocation(window->render2D.flatShader,"projection"),1,TE_GL_FALSE,&window->render2D.projectionMatrix[0]);
-	te_gl3.glUseProgram(window->render2D.spriteShader);
-	te_gl3.glUniformMatrix4fv(te_gl3.glGetUniformLocation(window->render2D.spriteShader,"projection"),1,TE_GL_FALSE,&window->render2D.projectionMatrix[0]);
-	te_gl3.glUseProgram(window->render2D.textShader);
-	te_gl3.glUniformMatrix4fv(te_gl3.glGetUniformLocation(window->render2D.textShader,"projection"),1,TE_GL_FALSE,&window->render2D.projectionMatrix[0]);
+void _tinyengine_gl3_setSceneNodePosition(_tinyengine_gl3_scene* scene, te_u32 node, te_f32 x, te_f32 y) {
+	_tinyengine_gl3_sceneNode* entry = _tinyengine_gl3_lookupSceneNode(scene, node);
+	if(entry == NULL || (entry->x == x && entry->y == y)) { return; }
+	entry->x = x;
+	entry->y = y;
+	_tinyengine_gl3_queueSceneSubtree(scene, entry - scene->nodes);
+}
 
+void _tinyengine_gl3_setSceneNodeScale(_tinyengine_gl3_scene* scene, te_u32 node, te_f32 scaleX, te_f32 scaleY) {
+	_tinyengine_gl3_sceneNode* entry = _tinyengine_gl3_lookupSceneNode(scene, node);
+	if(entry == NULL || (entry->scaleX == scaleX && entry->scaleY == scaleY)) { return; }
+	entry->scaleX = scaleX;
+	entry->scaleY = scaleY;
+	_tinyengine_gl3_queueSceneSubtree(scene, entry - scene->nodes);
 }
 
-te_bool_u8 _tinyengine_gl3_createWindowRenderContext(tinyengine_windowContext* window) {
-	// TODO: check if opengl3 has been initilized and init it if not first
-	
-	te_gl3.glActiveTexture(TE_GL_TEXTURE0);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+void _tinyengine_gl3_setSceneNodeRotation(_tinyengine_gl3_scene* scene, te_u32 node, te_f32 radians) {
+	_tinyengine_gl3_sceneNode* entry = _tinyengine_gl3_lookupSceneNode(scene, node);
+	if(entry == NULL || entry->rotation == radians) { return; }
+	entry->rotation = radians;
+	_tinyengine_gl3_queueSceneSubtree(scene, entry - scene->nodes);
+}
 
-	glClearColor(0.0f,0.0f,0.0f,1.0f);
+void _tinyengine_gl3_setSceneNodeColor(_tinyengine_gl3_scene* scene, te_u32 node, te_v4_f32 color) {
+	_tinyengine_gl3_sceneNode* entry = _tinyengine_gl3_lookupSceneNode(scene, node);
+	if(entry == NULL || memcmp(&entry->color, &color, sizeof(te_v4_f32)) == 0) { return; }
+	entry->color = color;
+	_tinyengine_gl3_queueSceneNode(scene, entry - scene->nodes);
+}
 
-	// Flat shape render pipeline
+void _tinyengine_gl3_setSceneNodeVisible(_tinyengine_gl3_scene* scene, te_u32 node, te_bool_u8 visible) {
+	_tinyengine_gl3_sceneNode* entry = _tinyengine_gl3_lookupSceneNode(scene, node);
+	if(entry == NULL || entry->visible == visible) { return; }
+	entry->visible = visible;
+	_tinyengine_gl3_queueSceneSubtree(scene, entry - scene->nodes);
+}
 
-	te_gl3.glGenVertexArrays(1, &window->render2D.flatVAO);
-	te_gl3.glGenBuffers(1, &window->render2D.flatVBO);
-	te_gl3.glBindVertexArray(window->render2D.flatVAO);
-	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, window->render2D.flatVBO);
-	te_gl3.glBufferData(TE_GL_ARRAY_BUFFER, sizeof(float) * 6 * 2, NULL, TE_GL_DYNAMIC_DRAW);
-	te_gl3.glEnableVertexAttribArray(0);
-	te_gl3.glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), 0);
-	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, 0);
-	te_gl3.glBindVertexArray(0);
+// Higher layers draw on top, nodes within a layer draw in creation order
+void _tinyengine_gl3_setSceneNodeLayer(_tinyengine_gl3_scene* scene, te_u32 node, te_i32 layer) {
+	_tinyengine_gl3_sceneNode* entry = _tinyengine_gl3_lookupSceneNode(scene, node);
+	if(entry == NULL || entry->layer == layer) { return; }
+	entry->layer = layer;
+	_tinyengine_gl3_damageSceneNode(scene, entry);
+	scene->structureDirty = TE_TRUE;
+}
 
-	if(_tinyengine_gl3_compileShader(&window->render2D.flatShader,TE_GL3_FLAT_VERTEX_SRC,TE_GL3_FLAT_FRAGMENT_SRC)){
-		// Uniform init
-	} else { return TE_FALSE; }
+void _tinyengine_gl3_setSceneText(_tinyengine_gl3_scene* scene, te_u32 node, const char* text) {
+	_tinyengine_gl3_sceneNode* entry = _tinyengine_gl3_lookupSceneNode(scene, node);
+	if(entry == NULL || entry->type != TE_GL3_SCENE_TEXT) { return; }
+	if(entry->text && strcmp(entry->text, text) == 0) { return; }
+
+	size_t length = strlen(text);
+	char* copy = malloc(length + 1);
+	if(copy == NULL) { return; }
+	memcpy(copy, text, length + 1);
+	free(entry->text);
+	entry->text = copy;
+	_tinyengine_gl3_queueSceneNode(scene, entry - scene->nodes);
+}
 
-	// Sprite render pipeline
+te_u32 _tinyengine_gl3_getSceneNodeVersion(_tinyengine_gl3_scene* scene, te_u32 node) {
+	_tinyengine_gl3_sceneNode* entry = _tinyengine_gl3_lookupSceneNode(scene, node);
+	return entry ? entry->version : 0;
+}
 
-	te_gl3.glGenVertexArrays(1, &window->render2D.spriteVAO);
-	te_gl3.glGenBuffers(1, &window->render2D.spriteVBO);
-	te_gl3.glBindVertexArray(window->render2D.spriteVAO);
-	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, window->render2D.spriteVBO);
-	te_gl3.glBufferData(TE_GL_ARRAY_BUFFER, sizeof(te_f32) * 6 * 4, NULL, TE_GL_DYNAMIC_DRAW);
-	te_gl3.glEnableVertexAttribArray(0);
-	te_gl3.glVertexAttribPointer(0, 4, TE_GL_FLOAT, TE_GL_FALSE, 4 * sizeof(te_GLfloat), 0);
-	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, 0);
-	te_gl3.glBindVertexArray(0);
+// Affine 2x3 as { a, b, c, d, tx, ty }, a point maps to (a x + c y + tx, b x + d y + ty)
+void _tinyengine_gl3_sceneWorldTransform(_tinyengine_gl3_scene* scene, const _tinyengine_gl3_sceneNode* entry, te_f32 world[6], te_bool_u8* visible) {
+	te_f32 cosine = entry->rotation != 0.0f ? cosf(entry->rotation) : 1.0f;
+	te_f32 sine = entry->rotation != 0.0f ? sinf(entry->rotation) : 0.0f;
+	te_f32 local[6] = { cosine * entry->scaleX, sine * entry->scaleX, -sine * entry->scaleY, cosine * entry->scaleY, entry->x, entry->y };
 
-	if(_tinyengine_gl3_compileShader(&window->render2D.spriteShader,TE_GL3_SPRITE_VERTEX_SRC,TE_GL3_SPRITE_FRAGMENT_SRC)){
-		te_gl3.glUseProgram(window->render2D.spriteShader);
-		te_gl3.glUniform1i(te_gl3.glGetUniformLocation(window->render2D.spriteShader, "texture_bank"), 0);
-	} else { return TE_FALSE; }
+	if(entry->parent == 0) {
+		memcpy(world, local, sizeof(local));
+		*visible = entry->visible;
+		return;
+	}
 
-	// Bitmap Glyph Cache Render Pipeline
+	te_f32 parent[6];
+	_tinyengine_gl3_sceneWorldTransform(scene, &scene->nodes[entry->parent - 1], parent, visible);
+	*visible = *visible && entry->visible;
+	world[0] = parent[0] * local[0] + parent[2] * local[1];
+	world[1] = parent[1] * local[0] + parent[3] * local[1];
+	world[2] = parent[0] * local[2] + parent[2] * local[3];
+	world[3] = parent[1] * local[2] + parent[3] * local[3];
+	world[4] = parent[0] * local[4] + parent[2] * local[5] + parent[4];
+	world[5] = parent[1] * local[4] + parent[3] * local[5] + parent[5];
+}
 
-	te_gl3.glGenVertexArrays(1, &window->render2D.textVAO);
-	te_gl3.glGenBuffers(1, &window->render2D.textVBO);
-	te_gl3.glBindVertexArray(window->render2D.textVAO);
-	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, window->render2D.textVBO);
-	te_gl3.glBufferData(TE_GL_ARRAY_BUFFER, sizeof(te_GLfloat) * 6 * 4, NULL, TE_GL_DYNAMIC_DRAW);
-	te_gl3.glEnableVertexAttribArray(0);
-	te_gl3.glVertexAttribPointer(0, 4, TE_GL_FLOAT, TE_GL_FALSE, 4 * sizeof(GLfloat), 0);
-	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, 0);
-	te_gl3.glBindVertexArray(0);
+te_u32 _tinyengine_gl3_sceneNodeVertexCount(const _tinyengine_gl3_sceneNode* entry) {
+	switch(entry->type) {
+		case TE_GL3_SCENE_RECT:
+		case TE_GL3_SCENE_SPRITE: return 6;
+		case TE_GL3_SCENE_TEXT: return entry->text ? (te_u32) strlen(entry->text) * 6 : 0;
+	}
+	return 0;
+}
+
+void _tinyengine_gl3_sceneQuad(_tinyengine_gl3_sceneVertex* out, const te_f32 world[6], te_f32 x0, te_f32 y0, te_f32 x1, te_f32 y1, te_f32 u0, te_f32 v0, te_f32 u1, te_f32 v1, const te_u8 color[4], te_f32 mode) {
+	const te_f32 corners[6][4] = {
+		{ x1, y0, u1, v0 }, { x1, y1, u1, v1 }, { x0, y0, u0, v0 },
+		{ x1, y1, u1, v1 }, { x0, y1, u0, v1 }, { x0, y0, u0, v0 }
+	};
+	for(te_u32 i = 0; i < 6; i++) {
+		out[i].x = world[0] * corners[i][0] + world[2] * corners[i][1] + world[4];
+		out[i].y = world[1] * corners[i][0] + world[3] * corners[i][1] + world[5];
+		out[i].u = corners[i][2];
+		out[i].v = corners[i][3];
+		memcpy(out[i].color, color, 4);
+		out[i].mode = mode;
+	}
+}
 
-	if(_tinyengine_gl3_compileShader(&window->render2D.textShader,TE_GL3_TEXT_VERTEX_SRC,TE_GL3_TEXT_FRAGMENT_SRC)) {
-		te_gl3.glUseProgram(window->render2D.textShader);
-		te_gl3.glUniform1i(te_gl3.glGetUniformLocation(window->render2D.textShader, "texture_bank"), 0);
-	} else { return TE_FALSE;	}
+void _tinyengine_gl3_buildSceneNode(_tinyengine_gl3_scene* scene, _tinyengine_gl3_sceneNode* entry) {
+	te_f32 world[6];
+	te_bool_u8 visible;
+	_tinyengine_gl3_sceneWorldTransform(scene, entry, world, &visible);
 
-	return TE_TRUE;
+	_tinyengine_gl3_sceneVertex* out = scene->vertices + entry->firstVertex;
+	te_u8 color[4] = {
+		(te_u8)(entry->color.x * 255.0f + 0.5f), (te_u8)(entry->color.y * 255.0f + 0.5f),
+		(te_u8)(entry->color.z * 255.0f + 0.5f), (te_u8)(entry->color.w * 255.0f + 0.5f)
+	};
+	// Hidden nodes keep their range, zero alpha is cheaper than another draw list rebuild
+	if(!visible) { color[3] = 0; }
+
+	if(entry->type == TE_GL3_SCENE_RECT) {
+		_tinyengine_gl3_sceneQuad(out, world, 0.0f, 0.0f, entry->width, entry->height, 0.0f, 0.0f, 1.0f, 1.0f, color, 0.0f);
+	} else if(entry->type == TE_GL3_SCENE_SPRITE) {
+		_tinyengine_gl3_sceneQuad(out, world, 0.0f, 0.0f, entry->width, entry->height, entry->u0, entry->v0, entry->u1, entry->v1, color, 0.0f);
+	} else if(entry->type == TE_GL3_SCENE_TEXT) {
+		// Same layout as _tinyengine_gl3_drawText() at scale 1, the node scale does the rest
+		const _tinyengine_gl3_bitmapGlyphCache* font = entry->font;
+		te_f32 pen = 0.0f;
+		te_f32 texel = 1.0f / font->resolution;
+		for(const char* c = entry->text; *c != '\0'; c++) {
+			const _tinyengine_gl3_bitmapBakedCharcter* b = font->characterData + (*c >= 32 && *c <= 126 ? *c - 32 : 0);
+			te_f32 x0 = floorf(pen + b->xoff + 0.5f);
+			te_f32 y0 = floorf(b->yoff + 0.5f);
+			_tinyengine_gl3_sceneQuad(out, world, x0, y0, x0 + (b->x1 - b->x0), y0 + (b->y1 - b->y0), b->x0 * texel, b->y0 * texel, b->x1 * texel, b->y1 * texel, color, 1.0f);
+			out += 6;
+			pen += b->xadvance;
+		}
+	}
 }
 
-void _tinyengine_gl3_startFrame(tinyengine_windowContext* window) {
-	glClear(GL_COLOR_BUFFER_BIT);
+te_bool_u8 _tinyengine_gl3_reserveSceneVertices(_tinyengine_gl3_scene* scene, te_u32 count) {
+	if(scene->vertexCount + count <= scene->vertexCapacity) { return TE_TRUE; }
+
+	// Mostly garbage, pack the live ranges into a new array instead of just growing
+	te_bool_u8 compact = scene->garbageVertices > scene->vertexCount / 2;
+	te_u32 needed = (compact ? scene->vertexCount - scene->garbageVertices : scene->vertexCount) + count;
+	te_u32 capacity = scene->vertexCapacity ? scene->vertexCapacity : 1024;
+	while(capacity < needed) { capacity *= 2; }
+
+	if(!compact) {
+		_tinyengine_gl3_sceneVertex* vertices = realloc(scene->vertices, (size_t) capacity * sizeof(_tinyengine_gl3_sceneVertex));
+		if(vertices == NULL) { return TE_FALSE; }
+		scene->vertices = vertices;
+		scene->vertexCapacity = capacity;
+		return TE_TRUE;
+	}
+
+	_tinyengine_gl3_sceneVertex* vertices = malloc((size_t) capacity * sizeof(_tinyengine_gl3_sceneVertex));
+	if(vertices == NULL) { return TE_FALSE; }
+	te_u32 cursor = 0;
+	for(te_u32 slot = 0; slot < scene->nodeCount; slot++) {
+		_tinyengine_gl3_sceneNode* entry = &scene->nodes[slot];
+		if(entry->type == 0 || entry->vertexCapacity == 0) { continue; }
+		memcpy(vertices + cursor, scene->vertices + entry->firstVertex, entry->vertexCount * sizeof(_tinyengine_gl3_sceneVertex));
+		entry->firstVertex = cursor;
+		entry->vertexCapacity = entry->vertexCount;
+		cursor += entry->vertexCount;
+	}
+	free(scene->vertices);
+	scene->vertices = vertices;
+	scene->vertexCapacity = capacity;
+	scene->vertexCount = cursor;
+	scene->garbageVertices = 0;
+	scene->fullUpload = TE_TRUE;
+	scene->structureDirty = TE_TRUE;
+	return TE_TRUE;
 }
 
-void _tinyengine_gl3_endFrame(tinyengine_windowContext* window) {
+int _tinyengine_gl3_compareSceneOrder(const void* a, const void* b) {
+	const _tinyengine_gl3_sceneOrder* left = (const _tinyengine_gl3_sceneOrder*) a;
+	const _tinyengine_gl3_sceneOrder* right = (const _tinyengine_gl3_sceneOrder*) b;
+	if(left->layer != right->layer) { return left->layer < right->layer ? -1 : 1; }
+	return left->sequence < right->sequence ? -1 : (left->sequence > right->sequence ? 1 : 0);
+}
 
+int _tinyengine_gl3_compareSceneRange(const void* a, const void* b) {
+	const _tinyengine_gl3_sceneRange* left = (const _tinyengine_gl3_sceneRange*) a;
+	const _tinyengine_gl3_sceneRange* right = (const _tinyengine_gl3_sceneRange*) b;
+	return left->first < right->first ? -1 : (left->first > right->first ? 1 : 0);
 }
 
-// TODO: Replace all the vertex logic with a transformation uniform to stretch a square around instead
-void _tinyengine_gl3_drawRectangle2D(tinyengine_windowContext* window, te_f32 x, te_f32 y, te_f32 width, te_f32 height, te_v4_f32 color) {
+// Consecutive nodes with the same texture become one batch, adjacent ranges within it one draw range
+void _tinyengine_gl3_buildSceneBatches(_tinyengine_gl3_scene* scene) {
+	_tinyengine_gl3_sceneOrder* order = malloc((scene->liveNodes ? scene->liveNodes : 1) * sizeof(_tinyengine_gl3_sceneOrder));
+	scene->batches = realloc(scene->batches, (scene->liveNodes ? scene->liveNodes : 1) * sizeof(_tinyengine_gl3_sceneBatch));
+	scene->rangeFirsts = realloc(scene->rangeFirsts, (scene->liveNodes ? scene->liveNodes : 1) * sizeof(te_GLint));
+	scene->rangeCounts = realloc(scene->rangeCounts, (scene->liveNodes ? scene->liveNodes : 1) * sizeof(te_GLsizei));
+	scene->batchCount = 0;
+	scene->rangeCount = 0;
+	if(!order || !scene->batches || !scene->rangeFirsts || !scene->rangeCounts) { free(order); return; }
+
+	te_u32 count = 0;
+	for(te_u32 slot = 0; slot < scene->nodeCount; slot++) {
+		_tinyengine_gl3_sceneNode* entry = &scene->nodes[slot];
+		if(entry->type == 0 || entry->vertexCount == 0) { continue; }
+		order[count].layer = entry->layer;
+		order[count].sequence = entry->sequence;
+		order[count].slot = slot;
+		count++;
+	}
+	qsort(order, count, sizeof(_tinyengine_gl3_sceneOrder), &_tinyengine_gl3_compareSceneOrder);
 
-	te_gl3.glUseProgram(window->render2D.flatShader);
-	te_gl3.glBindTexture(TE_GL_TEXTURE_2D,0);
-	te_gl3.glBindVertexArray(window->render2D.flatVAO);
-
-	te_gl3.glUniform4f(te_gl3.glGetUniformLocation(window->render2D.flatShader, "sprite_color"), color.x,color.y,color.z,color.w);
-
-	float vx0 = x;
-	float vy0 = y;
-	float vx1 = (width + x);
-	float vy1 = (height + y);
-
-	float vertices[] = {
-		// first triangle
-		 vx1,  vy0,  // top right
-		 vx1,  vy1,  // bottom right
-		 vx0,  vy0,  // top left
-		// second triangle
-		 vx1,  vy1,  // bottom right
-		 vx0,  vy1,  // bottom left
-		 vx0,  vy0   // top left
-	};
+	_tinyengine_gl3_sceneBatch* batch = NULL;
+	for(te_u32 i = 0; i < count; i++) {
+		_tinyengine_gl3_sceneNode* entry = &scene->nodes[order[i].slot];
 
-	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, window->render2D.flatVBO);
-	te_gl3.glBufferSubData(TE_GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, 0);
+		if(batch == NULL || batch->texture != entry->texture) {
+			batch = &scene->batches[scene->batchCount++];
+			batch->texture = entry->texture;
+			batch->firstRange = scene->rangeCount;
+			batch->rangeCount = 0;
+		}
 
-	te_gl3.glDrawArrays(TE_GL_TRIANGLES, 0, 6);
-	te_gl3.glBindVertexArray(0);
+		te_u32 last = batch->firstRange + batch->rangeCount - 1;
+		if(batch->rangeCount > 0 && (te_u32)(scene->rangeFirsts[last] + scene->rangeCounts[last]) == entry->firstVertex) {
+			scene->rangeCounts[last] += entry->vertexCount;
+			continue;
+		}
+		scene->rangeFirsts[scene->rangeCount] = entry->firstVertex;
+		scene->rangeCounts[scene->rangeCount] = entry->vertexCount;
+		scene->rangeCount++;
+		batch->rangeCount++;
+	}
+
+	free(order);
+	scene->structureDirty = TE_FALSE;
 }
 
-void _tinyengine_gl3_drawSprite(tinyengine_windowContext* window, te_GLuint texture, te_f32 x, te_f32 y, te_f32 width, te_f32 height, te_f32 scale, te_f32 tex_width, te_f32 tex_height, te_f32 tex_x, te_f32 tex_y) {
-	te_gl3.glUseProgram(window->render2D.spriteShader);
-	te_gl3.glBindTexture(GL_TEXTURE_2D,texture);
-	te_gl3.glBindVertexArray(window->render2D.spriteVAO);
+void _tinyengine_gl3_updateScene(_tinyengine_gl3_scene* scene) {
+	scene->nodesRebuilt = 0;
+	scene->uploadRanges = 0;
+	scene->bytesUploaded = 0;
+
+	if(scene->queueLength == 0 && !scene->structureDirty && !scene->fullUpload) { return; }
+
+	_tinyengine_gl3_sceneRange* ranges = malloc((scene->queueLength ? scene->queueLength : 1) * sizeof(_tinyengine_gl3_sceneRange));
+	te_u32 rangeCount = 0;
+
+	for(te_u32 i = 0; i < scene->queueLength; i++) {
+		_tinyengine_gl3_sceneNode* entry = &scene->nodes[scene->queue[i]];
+		entry->queued = TE_FALSE;
+		if(entry->type == 0 || entry->builtVersion == entry->version) { continue; }
+		_tinyengine_gl3_damageSceneNode(scene, entry);
+
+		// Grown text moves to a fresh range at the end, its old range becomes garbage
+		te_u32 count = _tinyengine_gl3_sceneNodeVertexCount(entry);
+		if(count > entry->vertexCapacity) {
+			if(!_tinyengine_gl3_reserveSceneVertices(scene, count)) { continue; }
+			scene->garbageVertices += entry->vertexCapacity;
+			entry->firstVertex = scene->vertexCount;
+			entry->vertexCapacity = count;
+			scene->vertexCount += count;
+			scene->structureDirty = TE_TRUE;
+		}
+		if(count != entry->vertexCount) { scene->structureDirty = TE_TRUE; }
+		entry->vertexCount = count;
+
+		_tinyengine_gl3_buildSceneNode(scene, entry);
+		entry->builtVersion = entry->version;
+		_tinyengine_gl3_damageSceneNode(scene, entry);
+		scene->nodesRebuilt++;
+
+		if(ranges && count > 0) {
+			ranges[rangeCount].first = entry->firstVertex;
+			ranges[rangeCount].count = count;
+			rangeCount++;
+		}
+	}
+	scene->queueLength = 0;
+
+	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, scene->vbo);
+	if(scene->fullUpload || scene->gpuVertexCapacity < scene->vertexCapacity) {
+		te_gl3.glBufferData(TE_GL_ARRAY_BUFFER, (te_GLsizeiptr) scene->vertexCapacity * sizeof(_tinyengine_gl3_sceneVertex), NULL, TE_GL_DYNAMIC_DRAW);
+		te_gl3.glBufferSubData(TE_GL_ARRAY_BUFFER, 0, (te_GLsizeiptr) scene->vertexCount * sizeof(_tinyengine_gl3_sceneVertex), scene->vertices);
+		scene->gpuVertexCapacity = scene->vertexCapacity;
+		scene->bytesUploaded = (size_t) scene->vertexCount * sizeof(_tinyengine_gl3_sceneVertex);
+		scene->uploadRanges = 1;
+		scene->fullUpload = TE_FALSE;
+	} else if(rangeCount > 0) {
+		qsort(ranges, rangeCount, sizeof(_tinyengine_gl3_sceneRange), &_tinyengine_gl3_compareSceneRange);
+
+		te_u32 first = ranges[0].first;
+		te_u32 end = ranges[0].first + ranges[0].count;
+		for(te_u32 i = 1; i <= rangeCount; i++) {
+			if(i < rangeCount && ranges[i].first <= end + TE_GL3_SCENE_MERGE_GAP) {
+				if(ranges[i].first + ranges[i].count > end) { end = ranges[i].first + ranges[i].count; }
+				continue;
+			}
+			te_gl3.glBufferSubData(TE_GL_ARRAY_BUFFER, (te_GLintptr) first * sizeof(_tinyengine_gl3_sceneVertex), (te_GLsizeiptr)(end - first) * sizeof(_tinyengine_gl3_sceneVertex), scene->vertices + first);
+			scene->bytesUploaded += (size_t)(end - first) * sizeof(_tinyengine_gl3_sceneVertex);
+			scene->uploadRanges++;
+			if(i < rangeCount) {
+				first = ranges[i].first;
+				end = ranges[i].first + ranges[i].count;
+			}
+		}
+	}
+	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, 0);
+	free(ranges);
 
-	// this is still a mainly cpu heavy operation
+	if(scene->structureDirty) { _tinyengine_gl3_buildSceneBatches(scene); }
+}
 
-	te_f32 ux0 = tex_x / tex_width;
-	te_f32 uy0 = -tex_y / tex_height;
-	te_f32 ux1 = ux0 + (width / tex_width);
-	te_f32 uy1 = uy0 - (height / tex_height);
+// With damage tracking, call before startFrame so this frame's redraw covers the scene's changes.
+// Changes first seen by drawScene stay pending in the window and are repainted the frame after. The scene
+// is assumed to be drawn in the space current at this call.
+void _tinyengine_gl3_damageScene(tinyengine_windowContext* window, _tinyengine_gl3_scene* scene) {
+	_tinyengine_gl3_updateScene(scene);
+	_tinyengine_damageRect damage = scene->damage;
+	if(window->render2D.worldSpace && damage.x1 > damage.x0) {
+		te_f32 x0 = 0.0f, y0 = 0.0f, x1 = 0.0f, y1 = 0.0f;
+		for(te_u32 corner = 0; corner < 4; corner++) {
+			te_f32 x, y;
+			_tinyengine_gl3_worldToScreen(window, (te_f32)(corner & 1 ? damage.x1 : damage.x0), (te_f32)(corner & 2 ? damage.y1 : damage.y0), &x, &y);
+			if(corner == 0 || x < x0) { x0 = x; }
+			if(corner == 0 || y < y0) { y0 = y; }
+			if(corner == 0 || x > x1) { x1 = x; }
+			if(corner == 0 || y > y1) { y1 = y; }
+		}
+		damage = (_tinyengine_damageRect){ (te_i32) floorf(x0), (te_i32) floorf(y0), (te_i32) ceilf(x1), (te_i32) ceilf(y1) };
+	}
+	tinyengine_addWindowDamage(window, damage.x0, damage.y0, damage.x1 - damage.x0, damage.y1 - damage.y0);
+	scene->damage = (_tinyengine_damageRect){ 0, 0, 0, 0 };
+}
 
-	te_f32 vx0 = x;
-	te_f32 vy0 = y;
-	te_f32 vx1 = (width * scale) + x;
-	te_f32 vy1 = (height * scale) + y;
-
-	te_f32 vertices[] = {
-		// first triangle
-		 vx1,  vy0, ux1, uy0,  // top right
-		 vx1,  vy1, ux1, uy1,  // bottom right
-		 vx0,  vy0, ux0, uy0,  // top left
-		// second triangle
-		 vx1,  vy1, ux1, uy1,  // bottom right
-		 vx0,  vy1, ux0, uy1,  // bottom left
-		 vx0,  vy0, ux0, uy0   // top left
-	};
+void _tinyengine_gl3_drawScene(tinyengine_windowContext* window, _tinyengine_gl3_scene* scene) {
+	_tinyengine_gl3_damageScene(window, scene);
+	scene->drawCalls = 0;
+	if(scene->batchCount == 0) { return; }
+	_tinyengine_gl3_flushBatch(); // keeps immediate draws before the scene in order
 
-	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, window->render2D.spriteVBO);
-	te_gl3.glBufferSubData(TE_GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, 0);
+	if(!_tinyengine_gl3_bindProgram(window, &te_gl3_state.sceneProgram)) { return; }
+	te_gl3.glBindVertexArray(scene->vao);
+
+	for(te_u32 i = 0; i < scene->batchCount; i++) {
+		const _tinyengine_gl3_sceneBatch* batch = &scene->batches[i];
+		te_gl3.glBindTexture(TE_GL_TEXTURE_2D, batch->texture);
+		te_gl3.glMultiDrawArrays(TE_GL_TRIANGLES, scene->rangeFirsts + batch->firstRange, scene->rangeCounts + batch->firstRange, batch->rangeCount);
+		scene->drawCalls++;
+	}
 
-	te_gl3.glDrawArrays(TE_GL_TRIANGLES, 0, 6);
 	te_gl3.glBindVertexArray(0);
+	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, 0);
 }
 
-void _tinyengine_gl3_drawText(tinyengine_windowContext* window, _tinyengine_gl3_bitmapGlyphCache* font, const char* text, te_f32 x, te_f32 y, te_f32 scale, te_v3_f32 color) {
+//// Tilemaps
 
-	te_gl3.glUseProgram(window->render2D.textShader);
+// Layers of a tile grid are cut into square chunks, each baked into its own static vertex buffer in the batch
+// vertex format and drawn through the shared quad index buffer. Changing a tile marks its chunk, which is
+// rebuilt the next time it is drawn. A draw only touches chunks inside the visible area of the current space,
+// so scrolling a large map is one draw call per visible chunk and layer. Tile 0 is empty, tile n is the n-th
+// cell of the layer's tileset, counted left to right from the top left.
 
-	te_gl3.glUniform3f(te_gl3.glGetUniformLocation(window->render2D.textShader, "text_color"), color.x,color.y,color.z);
-	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, font->textureID);
-	te_gl3.glBindVertexArray(window->render2D.textVAO);
+#define TE_GL3_TILEMAP_CHUNK 32 // tiles along a chunk side
+#define TE_GL3_TILEMAP_MAX_LAYERS 16
 
-	const char* c = text;
+#if TE_GL3_TILEMAP_CHUNK * TE_GL3_TILEMAP_CHUNK > TE_GL3_BATCH_BUFFER_QUADS
+	#error "A tilemap chunk must fit the quad index buffer"
+#endif
 
-	while(*c != '\0'){
+typedef struct _tinyengine_gl3_tilemapChunk_t {
+	te_GLuint vao; // created with the first build
+	te_GLuint vbo;
+	te_u32 quadCount; // tiles that are not empty
+	te_bool_u8 dirty;
+} _tinyengine_gl3_tilemapChunk;
 
-		// TODO: Move this to GPU?
-		// TODO: Make this top down instead of down up
+typedef struct _tinyengine_gl3_tilemapLayer_t {
+	te_u16* tiles; // row major, columns * rows
+	_tinyengine_gl3_tilemapChunk* chunks; // row major, chunkColumns * chunkRows
+	te_GLuint texture;
+	te_u32 tilesetColumns;
+	te_u32 tilesetRows;
+	te_bool_u8 visible;
+} _tinyengine_gl3_tilemapLayer;
+
+typedef struct _tinyengine_gl3_tilemap_t {
+	te_f32 x, y; // top left corner
+	te_f32 tileWidth;
+	te_f32 tileHeight;
+	te_u32 columns;
+	te_u32 rows;
+	te_u32 chunkColumns;
+	te_u32 chunkRows;
+
+	_tinyengine_gl3_tilemapLayer layers[TE_GL3_TILEMAP_MAX_LAYERS];
+	te_u32 layerCount;
+
+	_tinyengine_gl3_vertex2D* scratch; // one chunk of vertices while building
+
+	// Last draw, for benchmarks
+	te_u32 drawCalls;
+	te_u32 chunksBuilt;
+	size_t bytesUploaded;
+} _tinyengine_gl3_tilemap;
+
+// Size in tiles, the tile size is in units of the space the map is drawn in
+_tinyengine_gl3_tilemap* _tinyengine_gl3_createTilemap(te_f32 x, te_f32 y, te_u32 columns, te_u32 rows, te_f32 tileWidth, te_f32 tileHeight) {
+	if(columns == 0 || rows == 0) { return NULL; }
+	_tinyengine_gl3_tilemap* map = malloc(sizeof(_tinyengine_gl3_tilemap));
+	if(map == NULL) { return NULL; }
+	memset(map, 0, sizeof(_tinyengine_gl3_tilemap));
+
+	map->scratch = malloc(TE_GL3_TILEMAP_CHUNK * TE_GL3_TILEMAP_CHUNK * 4 * sizeof(_tinyengine_gl3_vertex2D));
+	if(map->scratch == NULL) { free(map); return NULL; }
+
+	map->x = x;
+	map->y = y;
+	map->tileWidth = tileWidth;
+	map->tileHeight = tileHeight;
+	map->columns = columns;
+	map->rows = rows;
+	map->chunkColumns = (columns + TE_GL3_TILEMAP_CHUNK - 1) / TE_GL3_TILEMAP_CHUNK;
+	map->chunkRows = (rows + TE_GL3_TILEMAP_CHUNK - 1) / TE_GL3_TILEMAP_CHUNK;
+	return map;
+}
 
-		const _tinyengine_gl3_bitmapBakedCharcter *b = font->characterData + (*c >= 32 && *c <= 126 ? *c-32 : ' '-32);
+void _tinyengine_gl3_destroyTilemap(_tinyengine_gl3_tilemap* map) {
+	if(map == NULL) { return; }
+	for(te_u32 i = 0; i < map->layerCount; i++) {
+		_tinyengine_gl3_tilemapLayer* layer = &map->layers[i];
+		for(te_u32 chunk = 0; chunk < map->chunkColumns * map->chunkRows; chunk++) {
+			if(layer->chunks[chunk].vao == 0) { continue; }
+			te_gl3.glDeleteVertexArrays(1, &layer->chunks[chunk].vao);
+			te_gl3.glDeleteBuffers(1, &layer->chunks[chunk].vbo);
+		}
+		free(layer->tiles);
+		free(layer->chunks);
+	}
+	free(map->scratch);
+	free(map);
+}
 
-		int round_x = (int) floor((x + (b->xoff * scale)) + 0.5f);
-		int round_y = (int) floor((y + (b->yoff * scale)) + 0.5f);
+// Layers draw in the order they were added. Returns the layer index, or TE_GL3_TILEMAP_MAX_LAYERS on failure.
+te_u32 _tinyengine_gl3_addTilemapLayer(_tinyengine_gl3_tilemap* map, te_GLuint tileset, te_u32 tilesetColumns, te_u32 tilesetRows) {
+	if(map->layerCount == TE_GL3_TILEMAP_MAX_LAYERS || tilesetColumns == 0 || tilesetRows == 0) { return TE_GL3_TILEMAP_MAX_LAYERS; }
+
+	_tinyengine_gl3_tilemapLayer* layer = &map->layers[map->layerCount];
+	memset(layer, 0, sizeof(_tinyengine_gl3_tilemapLayer));
+	layer->tiles = calloc((size_t) map->columns * map->rows, sizeof(te_u16));
+	layer->chunks = calloc((size_t) map->chunkColumns * map->chunkRows, sizeof(_tinyengine_gl3_tilemapChunk));
+	if(layer->tiles == NULL || layer->chunks == NULL) {
+		free(layer->tiles);
+		free(layer->chunks);
+		return TE_GL3_TILEMAP_MAX_LAYERS;
+	}
+	layer->texture = tileset;
+	layer->tilesetColumns = tilesetColumns;
+	layer->tilesetRows = tilesetRows;
+	layer->visible = TE_TRUE;
+	return map->layerCount++;
+}
+
+void _tinyengine_gl3_setTilemapLayerVisible(_tinyengine_gl3_tilemap* map, te_u32 layer, te_bool_u8 visible) {
+	if(layer < map->layerCount) { map->layers[layer].visible = visible; }
+}
 
-		float x0 = round_x;
-		float y0 = round_y;
+// Copies a block of tiles, rows of width tiles each. Only chunks whose tiles really change are rebuilt.
+void _tinyengine_gl3_setTiles(_tinyengine_gl3_tilemap* map, te_u32 layerIndex, te_u32 x, te_u32 y, te_u32 width, te_u32 height, const te_u16* tiles) {
+	if(layerIndex >= map->layerCount || x >= map->columns || y >= map->rows) { return; }
+	_tinyengine_gl3_tilemapLayer* layer = &map->layers[layerIndex];
+	te_u32 clippedWidth = width < map->columns - x ? width : map->columns - x;
+	te_u32 clippedHeight = height < map->rows - y ? height : map->rows - y;
+
+	for(te_u32 row = 0; row < clippedHeight; row++) {
+		te_u16* destination = layer->tiles + (size_t)(y + row) * map->columns + x;
+		const te_u16* source = tiles + (size_t) row * width;
+		for(te_u32 column = 0; column < clippedWidth; column++) {
+			if(destination[column] == source[column]) { continue; }
+			destination[column] = source[column];
+			te_u32 chunk = ((y + row) / TE_GL3_TILEMAP_CHUNK) * map->chunkColumns + (x + column) / TE_GL3_TILEMAP_CHUNK;
+			layer->chunks[chunk].dirty = TE_TRUE;
+		}
+	}
+}
 
-		float x1 = round_x + ((b->x1 - b->x0) * scale);
-		float y1 = round_y + ((b->y1 - b->y0) * scale);
+void _tinyengine_gl3_setTile(_tinyengine_gl3_tilemap* map, te_u32 layer, te_u32 x, te_u32 y, te_u16 tile) {
+	_tinyengine_gl3_setTiles(map, layer, x, y, 1, 1, &tile);
+}
 
-		float ipw = 1.0f / font->resolution;
-		float iph = 1.0f / font->resolution;
+te_u16 _tinyengine_gl3_getTile(const _tinyengine_gl3_tilemap* map, te_u32 layer, te_u32 x, te_u32 y) {
+	if(layer >= map->layerCount || x >= map->columns || y >= map->rows) { return 0; }
+	return map->layers[layer].tiles[(size_t) y * map->columns + x];
+}
 
-		float s0 = b->x0 * ipw;
-		float t0 = b->y0 * iph;
-		float s1 = b->x1 * ipw;
-		float t1 = b->y1 * iph;
+void _tinyengine_gl3_buildTilemapChunk(_tinyengine_gl3_tilemap* map, _tinyengine_gl3_tilemapLayer* layer, te_u32 chunkX, te_u32 chunkY) {
+	_tinyengine_gl3_tilemapChunk* chunk = &layer->chunks[chunkY * map->chunkColumns + chunkX];
+	static const te_u8 white[4] = { 255, 255, 255, 255 };
+
+	te_u32 column0 = chunkX * TE_GL3_TILEMAP_CHUNK, row0 = chunkY * TE_GL3_TILEMAP_CHUNK;
+	te_u32 column1 = column0 + TE_GL3_TILEMAP_CHUNK < map->columns ? column0 + TE_GL3_TILEMAP_CHUNK : map->columns;
+	te_u32 row1 = row0 + TE_GL3_TILEMAP_CHUNK < map->rows ? row0 + TE_GL3_TILEMAP_CHUNK : map->rows;
+	te_f32 cellU = 1.0f / layer->tilesetColumns, cellV = 1.0f / layer->tilesetRows;
+	te_u32 cells = layer->tilesetColumns * layer->tilesetRows;
+
+	te_u32 quads = 0;
+	for(te_u32 row = row0; row < row1; row++) {
+		const te_u16* tiles = layer->tiles + (size_t) row * map->columns;
+		te_f32 y0 = map->y + row * map->tileHeight;
+		for(te_u32 column = column0; column < column1; column++) {
+			te_u32 tile = tiles[column];
+			if(tile == 0 || tile > cells) { continue; }
+			te_u32 cell = tile - 1;
+
+			// Rows count down from the top of the texture, like sprites
+			te_f32 u0 = (cell % layer->tilesetColumns) * cellU;
+			te_f32 v0 = 1.0f - (cell / layer->tilesetColumns) * cellV;
+			te_f32 x0 = map->x + column * map->tileWidth;
+			_tinyengine_gl3_writeQuad(map->scratch + quads * 4, x0, y0, x0 + map->tileWidth, y0 + map->tileHeight,
+				_tinyengine_gl3_unorm16(u0), _tinyengine_gl3_unorm16(v0), _tinyengine_gl3_unorm16(u0 + cellU), _tinyengine_gl3_unorm16(v0 - cellV), white);
+			quads++;
+		}
+	}
 
-		x += b->xadvance * scale;
+	if(chunk->vao == 0 && quads > 0) {
+		te_gl3.glGenVertexArrays(1, &chunk->vao);
+		te_gl3.glGenBuffers(1, &chunk->vbo);
+		te_gl3.glBindVertexArray(chunk->vao);
+		te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, chunk->vbo);
+		te_gl3.glEnableVertexAttribArray(0);
+		te_gl3.glVertexAttribPointer(0, 2, TE_GL_FLOAT, TE_GL_FALSE, sizeof(_tinyengine_gl3_vertex2D), (void*) offsetof(_tinyengine_gl3_vertex2D, x));
+		te_gl3.glEnableVertexAttribArray(1);
+		te_gl3.glVertexAttribPointer(1, 2, TE_GL_UNSIGNED_SHORT, TE_GL_TRUE, sizeof(_tinyengine_gl3_vertex2D), (void*) offsetof(_tinyengine_gl3_vertex2D, u));
+		te_gl3.glEnableVertexAttribArray(2);
+		te_gl3.glVertexAttribPointer(2, 4, TE_GL_UNSIGNED_BYTE, TE_GL_TRUE, sizeof(_tinyengine_gl3_vertex2D), (void*) offsetof(_tinyengine_gl3_vertex2D, color));
+		te_gl3.glBindBuffer(TE_GL_ELEMENT_ARRAY_BUFFER, te_gl3_state.quadIndexBuffer); // recorded in the VAO
+		te_gl3.glBindVertexArray(0);
+	}
 
-		GLfloat vertices[6][4] = {
-			{ s0,t0, x0,y0 },
-			{ s0,t1, x0,y1 },
-			{ s1,t1, x1,y1 },
-			{ s0,t0, x0,y0 },
-			{ s1,t1, x1,y1 },
-			{ s1,t0, x1,y0 }
-		};
-
-		te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, window->render2D.textVBO);
-		te_gl3.glBufferSubData(TE_GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
+	if(quads > 0) {
+		// Respecified at the new size, tile edits are rare enough that static storage wins
+		size_t size = (size_t) quads * 4 * sizeof(_tinyengine_gl3_vertex2D);
+		te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, chunk->vbo);
+		te_gl3.glBufferData(TE_GL_ARRAY_BUFFER, (te_GLsizeiptr) size, map->scratch, TE_GL_STATIC_DRAW);
 		te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, 0);
+		map->bytesUploaded += size;
+	}
+
+	chunk->quadCount = quads;
+	chunk->dirty = TE_FALSE;
+	map->chunksBuilt++;
+}
+
+// Chunk range overlapping the visible area, false when none does
+te_bool_u8 _tinyengine_gl3_visibleTilemapChunks(tinyengine_windowContext* window, const _tinyengine_gl3_tilemap* map, te_u32* chunkX0, te_u32* chunkY0, te_u32* chunkX1, te_u32* chunkY1) {
+	const _tinyengine_render2DWindowContext* render2D = &window->render2D;
+	*chunkX0 = 0;
+	*chunkY0 = 0;
+	*chunkX1 = map->chunkColumns - 1;
+	*chunkY1 = map->chunkRows - 1;
+	if(render2D->viewWidth == 0) { return TE_TRUE; }
+
+	te_f32 chunkWidth = map->tileWidth * TE_GL3_TILEMAP_CHUNK, chunkHeight = map->tileHeight * TE_GL3_TILEMAP_CHUNK;
+	te_f32 x0 = floorf((render2D->visibleX0 - map->x) / chunkWidth), x1 = floorf((render2D->visibleX1 - map->x) / chunkWidth);
+	te_f32 y0 = floorf((render2D->visibleY0 - map->y) / chunkHeight), y1 = floorf((render2D->visibleY1 - map->y) / chunkHeight);
+	if(x1 < 0.0f || y1 < 0.0f || x0 > (te_f32) *chunkX1 || y0 > (te_f32) *chunkY1) { return TE_FALSE; }
+	if(x0 > 0.0f) { *chunkX0 = (te_u32) x0; }
+	if(y0 > 0.0f) { *chunkY0 = (te_u32) y0; }
+	if(x1 < (te_f32) *chunkX1) { *chunkX1 = (te_u32) x1; }
+	if(y1 < (te_f32) *chunkY1) { *chunkY1 = (te_u32) y1; }
+	return TE_TRUE;
+}
+
+// Drawn in the space current at this call, chunks out of view are neither built nor drawn
+void _tinyengine_gl3_drawTilemap(tinyengine_windowContext* window, _tinyengine_gl3_tilemap* map) {
+	_tinyengine_gl3_warnNotCaptured(TE_CAPTURE_SKIPPED_TILEMAPS, "Tilemaps");
+	map->drawCalls = 0;
+	map->chunksBuilt = 0;
+	map->bytesUploaded = 0;
+
+	te_u32 chunkX0, chunkY0, chunkX1, chunkY1;
+	if(map->layerCount == 0 || !_tinyengine_gl3_visibleTilemapChunks(window, map, &chunkX0, &chunkY0, &chunkX1, &chunkY1)) { return; }
+
+	_tinyengine_gl3_flushBatch(); // keeps immediate draws before the map in order
+	if(!_tinyengine_gl3_bindProgram(window, &te_gl3_state.spriteProgram)) { return; }
+
+	for(te_u32 i = 0; i < map->layerCount; i++) {
+		_tinyengine_gl3_tilemapLayer* layer = &map->layers[i];
+		if(!layer->visible) { continue; }
+		te_gl3.glBindTexture(TE_GL_TEXTURE_2D, layer->texture);
+
+		for(te_u32 chunkY = chunkY0; chunkY <= chunkY1; chunkY++) {
+			for(te_u32 chunkX = chunkX0; chunkX <= chunkX1; chunkX++) {
+				_tinyengine_gl3_tilemapChunk* chunk = &layer->chunks[chunkY * map->chunkColumns + chunkX];
+				if(chunk->dirty) { _tinyengine_gl3_buildTilemapChunk(map, layer, chunkX, chunkY); }
+				if(chunk->quadCount == 0) { continue; }
+
+				te_gl3.glBindVertexArray(chunk->vao);
+				glDrawElements(TE_GL_TRIANGLES, (te_GLsizei) (chunk->quadCount * 6), TE_GL_UNSIGNED_SHORT, (const void*) 0);
+				map->drawCalls++;
+			}
+		}
+	}
+
+	te_gl3.glBindVertexArray(0);
+	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, 0);
+}
+
+//// Layered sprites
+
+// Sprites and rectangles collected between beginLayers and endLayers are drawn in two passes against the depth
+// buffer. Each one gets a depth from its painter's order, layer first and submission order within a layer.
+// Opaque quads go first, front to back with the depth test on and blending off, so anything they cover is
+// rejected before it is shaded. Translucent quads follow back to front with blending, tested against the
+// opaque ones but not writing depth. The picture is the one immediate mode would draw in that order.
+// Drawn in the space current at endLayers.
+
+void _tinyengine_gl3_beginLayers(tinyengine_windowContext* window) {
+	_tinyengine_gl3_flushBatch();
+	te_gl3_state.layers.window = window;
+	te_gl3_state.layers.count = 0;
+}
 
-		te_gl3.glDrawArrays(TE_GL_TRIANGLES, 0, 6);
+static _tinyengine_gl3_layerSprite* _tinyengine_gl3_layerSpriteSlot(tinyengine_windowContext* window) {
+	_tinyengine_gl3_layers* layers = &te_gl3_state.layers;
+	if(layers->window != window) { TE_WARN("Layered draw outside of beginLayers\n"); return NULL; }
+	if(layers->count == layers->capacity) {
+		te_u32 capacity = layers->capacity ? layers->capacity * 2 : 1024;
+		_tinyengine_gl3_layerSprite* sprites = realloc(layers->sprites, capacity * sizeof(_tinyengine_gl3_layerSprite));
+		if(sprites == NULL) { return NULL; }
+		layers->sprites = sprites;
+		layers->capacity = capacity;
+	}
+	_tinyengine_gl3_layerSprite* sprite = &layers->sprites[layers->count];
+	sprite->sequence = layers->count++;
+	return sprite;
+}
+
+// Same arguments as _tinyengine_gl3_drawSpriteTinted(), higher layers are in front
+void _tinyengine_gl3_drawLayerSprite(tinyengine_windowContext* window, te_i32 layer, te_GLuint texture, te_f32 x, te_f32 y, te_f32 width, te_f32 height, te_f32 scale, te_f32 tex_width, te_f32 tex_height, te_f32 tex_x, te_f32 tex_y, te_v4_f32 color, te_u32 flags) {
+	if(!_tinyengine_gl3_isVisible(window, x, y, x + width * scale, y + height * scale)) { return; }
+	_tinyengine_gl3_layerSprite* sprite = _tinyengine_gl3_layerSpriteSlot(window);
+	if(sprite == NULL) { return; }
+
+	te_f32 ux0 = tex_x / tex_width;
+	te_f32 uy0 = 1.0f - tex_y / tex_height;
+	sprite->x0 = x;
+	sprite->y0 = y;
+	sprite->x1 = x + width * scale;
+	sprite->y1 = y + height * scale;
+	sprite->u0 = _tinyengine_gl3_unorm16(ux0);
+	sprite->v0 = _tinyengine_gl3_unorm16(uy0);
+	sprite->u1 = _tinyengine_gl3_unorm16(ux0 + width / tex_width);
+	sprite->v1 = _tinyengine_gl3_unorm16(uy0 - height / tex_height);
+	sprite->color[0] = _tinyengine_gl3_unorm8(color.x);
+	sprite->color[1] = _tinyengine_gl3_unorm8(color.y);
+	sprite->color[2] = _tinyengine_gl3_unorm8(color.z);
+	sprite->color[3] = _tinyengine_gl3_unorm8(color.w);
+	sprite->texture = texture;
+	sprite->layer = layer;
+	sprite->opaque = flags == TE_LAYER_OPAQUE || (flags == TE_LAYER_AUTO && sprite->color[3] == 255 && _tinyengine_gl3_isTextureOpaque(texture));
+}
+
+void _tinyengine_gl3_drawLayerRectangle(tinyengine_windowContext* window, te_i32 layer, te_f32 x, te_f32 y, te_f32 width, te_f32 height, te_v4_f32 color) {
+	if(!_tinyengine_gl3_isVisible(window, x, y, x + width, y + height)) { return; }
+	_tinyengine_gl3_layerSprite* sprite = _tinyengine_gl3_layerSpriteSlot(window);
+	if(sprite == NULL) { return; }
+
+	sprite->x0 = x;
+	sprite->y0 = y;
+	sprite->x1 = x + width;
+	sprite->y1 = y + height;
+	sprite->u0 = sprite->v0 = sprite->u1 = sprite->v1 = 0;
+	sprite->color[0] = _tinyengine_gl3_unorm8(color.x);
+	sprite->color[1] = _tinyengine_gl3_unorm8(color.y);
+	sprite->color[2] = _tinyengine_gl3_unorm8(color.z);
+	sprite->color[3] = _tinyengine_gl3_unorm8(color.w);
+	sprite->texture = 0;
+	sprite->layer = layer;
+	sprite->opaque = sprite->color[3] == 255;
+}
+
+static int _tinyengine_gl3_comparePainterOrder(const void* a, const void* b) {
+	const _tinyengine_gl3_layerSprite* x = a;
+	const _tinyengine_gl3_layerSprite* y = b;
+	if(x->layer != y->layer) { return x->layer < y->layer ? -1 : 1; }
+	return (x->sequence > y->sequence) - (x->sequence < y->sequence);
+}
+
+// Front to back a layer at a time, by texture within a layer so runs stay long. Inside a layer the depth test
+// still rejects what is covered, the coarse order only loses some early rejections.
+static int _tinyengine_gl3_compareOpaqueOrder(const void* a, const void* b) {
+	const _tinyengine_gl3_layerSprite* sprites = te_gl3_state.layers.sprites;
+	const _tinyengine_gl3_layerSprite* x = &sprites[*(const te_u32*) a];
+	const _tinyengine_gl3_layerSprite* y = &sprites[*(const te_u32*) b];
+	if(x->layer != y->layer) { return x->layer > y->layer ? -1 : 1; }
+	if(x->texture != y->texture) { return x->texture < y->texture ? -1 : 1; }
+	return (x->sequence < y->sequence) - (x->sequence > y->sequence);
+}
+
+// Draws order[first, first + count) from the uploaded vertices, one call per texture run
+static void _tinyengine_gl3_drawLayerRuns(tinyengine_windowContext* window, te_u32 first, te_u32 count) {
+	_tinyengine_gl3_layers* layers = &te_gl3_state.layers;
+	te_u32 end = first + count;
+	while(first < end) {
+		te_GLuint texture = layers->sprites[layers->order[first]].texture;
+		te_u32 run = 1;
+		while(first + run < end && run < TE_GL3_BATCH_BUFFER_QUADS && layers->sprites[layers->order[first + run]].texture == texture) { run++; }
+
+		_tinyengine_gl3_program* program = texture ? &te_gl3_state.spriteProgram : &te_gl3_state.flatProgram;
+		if(_tinyengine_gl3_bindProgram(window, program)) {
+			if(texture) { te_gl3.glBindTexture(TE_GL_TEXTURE_2D, texture); }
+
+			// Indices restart at 0 for every run, so the attributes point at its first vertex
+			size_t offset = (size_t) first * 4 * sizeof(_tinyengine_gl3_layerVertex);
+			te_gl3.glVertexAttribPointer(0, 3, TE_GL_FLOAT, TE_GL_FALSE, sizeof(_tinyengine_gl3_layerVertex), (void*) (offset + offsetof(_tinyengine_gl3_layerVertex, x)));
+			te_gl3.glVertexAttribPointer(1, 2, TE_GL_UNSIGNED_SHORT, TE_GL_TRUE, sizeof(_tinyengine_gl3_layerVertex), (void*) (offset + offsetof(_tinyengine_gl3_layerVertex, u)));
+			te_gl3.glVertexAttribPointer(2, 4, TE_GL_UNSIGNED_BYTE, TE_GL_TRUE, sizeof(_tinyengine_gl3_layerVertex), (void*) (offset + offsetof(_tinyengine_gl3_layerVertex, color)));
+			glDrawElements(TE_GL_TRIANGLES, (te_GLsizei) (run * 6), TE_GL_UNSIGNED_SHORT, (const void*) 0);
+			layers->drawCalls++;
+		}
+		first += run;
+	}
+}
 
-		c++;
+void _tinyengine_gl3_endLayers(tinyengine_windowContext* window) {
+	_tinyengine_gl3_layers* layers = &te_gl3_state.layers;
+	if(layers->window != window) { return; }
+	layers->window = NULL;
+	layers->opaqueCount = 0;
+	layers->translucentCount = 0;
+	layers->drawCalls = 0;
+	layers->bytesUploaded = 0;
+	te_u32 count = layers->count;
+	if(count == 0) { return; }
+
+	_tinyengine_gl3_warnNotCaptured(TE_CAPTURE_SKIPPED_LAYERS, "Layered sprites");
+	_tinyengine_gl3_flushBatch(); // immediate draws made since beginLayers end up underneath
+
+	te_u32* order = realloc(layers->order, count * sizeof(te_u32));
+	if(order == NULL) { return; }
+	layers->order = order;
+	_tinyengine_gl3_layerVertex* vertices = realloc(layers->vertices, (size_t) count * 4 * sizeof(_tinyengine_gl3_layerVertex));
+	if(vertices == NULL) { return; }
+	layers->vertices = vertices;
+
+	// Painter's rank, the sequence is kept unique so the sort is stable
+	qsort(layers->sprites, count, sizeof(_tinyengine_gl3_layerSprite), &_tinyengine_gl3_comparePainterOrder);
+	te_u32 opaque = 0;
+	for(te_u32 i = 0; i < count; i++) {
+		layers->sprites[i].sequence = i;
+		if(layers->sprites[i].opaque) { order[opaque++] = i; }
+	}
+	te_u32 translucent = opaque;
+	for(te_u32 i = 0; i < count; i++) {
+		if(!layers->sprites[i].opaque) { order[translucent++] = i; }
+	}
+	qsort(order, opaque, sizeof(te_u32), &_tinyengine_gl3_compareOpaqueOrder);
+
+	// The orthographic projection maps z to -z, so a larger z is nearer. Ranks stay inside (-1, 1).
+	te_f32 step = 2.0f / (te_f32)(count + 1);
+	for(te_u32 i = 0; i < count; i++) {
+		const _tinyengine_gl3_layerSprite* sprite = &layers->sprites[order[i]];
+		_tinyengine_gl3_layerVertex* quad = vertices + (size_t) i * 4;
+		const te_f32 xs[4] = { sprite->x0, sprite->x1, sprite->x1, sprite->x0 };
+		const te_f32 ys[4] = { sprite->y0, sprite->y0, sprite->y1, sprite->y1 };
+		const te_u16 us[4] = { sprite->u0, sprite->u1, sprite->u1, sprite->u0 };
+		const te_u16 vs[4] = { sprite->v0, sprite->v0, sprite->v1, sprite->v1 };
+		te_f32 z = -1.0f + step * (te_f32)(sprite->sequence + 1);
+		for(te_u32 corner = 0; corner < 4; corner++) {
+			quad[corner].x = xs[corner];
+			quad[corner].y = ys[corner];
+			quad[corner].z = z;
+			quad[corner].u = us[corner];
+			quad[corner].v = vs[corner];
+			memcpy(quad[corner].color, sprite->color, 4);
+		}
+	}
+
+	// One upload for the whole pass, the window's VAO keeps the index buffer and attribute setup
+	size_t size = (size_t) count * 4 * sizeof(_tinyengine_gl3_layerVertex);
+	if(layers->vbo == 0) { te_gl3.glGenBuffers(1, &layers->vbo); }
+	if(window->render2D.layerVAO == 0) {
+		te_gl3.glGenVertexArrays(1, &window->render2D.layerVAO);
+		te_gl3.glBindVertexArray(window->render2D.layerVAO);
+		te_gl3.glEnableVertexAttribArray(0);
+		te_gl3.glEnableVertexAttribArray(1);
+		te_gl3.glEnableVertexAttribArray(2);
+		te_gl3.glBindBuffer(TE_GL_ELEMENT_ARRAY_BUFFER, te_gl3_state.quadIndexBuffer); // recorded in the VAO
+	} else {
+		te_gl3.glBindVertexArray(window->render2D.layerVAO);
+	}
+	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, layers->vbo);
+	te_gl3.glBufferData(TE_GL_ARRAY_BUFFER, (te_GLsizeiptr) size, vertices, TE_GL_STREAM_DRAW);
+	layers->bytesUploaded = size;
+
+	glClear(GL_DEPTH_BUFFER_BIT);
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+
+	if(opaque > 0) {
+		glDisable(GL_BLEND);
+		_tinyengine_gl3_drawLayerRuns(window, 0, opaque);
+		glEnable(GL_BLEND);
+	}
+	if(count > opaque) {
+		glDepthMask(GL_FALSE);
+		_tinyengine_gl3_drawLayerRuns(window, opaque, count - opaque);
+		glDepthMask(GL_TRUE);
 	}
 
+	glDisable(GL_DEPTH_TEST);
+	te_gl3.glBindBuffer(TE_GL_ARRAY_BUFFER, 0);
 	te_gl3.glBindVertexArray(0);
 	te_gl3.glBindTexture(TE_GL_TEXTURE_2D, 0);
+
+	layers->opaqueCount = opaque;
+	layers->translucentCount = count - opaque;
+	layers->count = 0;
 }
 
 
@@ -1888,12 +8944,27 @@ te_bool_u8 tinyengine_init() {
 		TE_WARN("tinyengine compiled for unknown platform!\n");
 	#endif
 
+	// Any application can be recorded or driven unattended without code changes
+	const char* inputLog = getenv("TINYENGINE_REPLAY_INPUT");
+	if(inputLog && *inputLog) { tinyengine_replayInput(inputLog); }
+	else if((inputLog = getenv("TINYENGINE_RECORD_INPUT")) != NULL && *inputLog) { tinyengine_recordInput(inputLog); }
 
 	return TE_TRUE;
 }
 
 void tinyengine_terminate() {
+	tinyengine_stopInputLog();
 	tinyengine_destroyAllWindows();
+
+	#if defined(TE_LINUX) || defined(TE_WIN32)
+		_tinyengine_gl3_terminate();
+	#endif
+
+	#if defined(TE_LINUX)
+		_tinyengine_x11_terminate();
+	#elif defined(TE_WIN32)
+		_tinyengine_win32_terminate();
+	#endif
 }
 
 #endif /* TE_HEADER_ONLY */